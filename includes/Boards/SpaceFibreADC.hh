@@ -180,6 +180,10 @@
 #include "SpaceWireRMAPLibrary/Boards/SpaceFibreADCBoardModules/SemaphoreRegister.hh"
 #include "SpaceWireRMAPLibrary/Boards/SpaceFibreADCBoardModules/ConsumerManagerSocketFIFO.hh"
 #include "SpaceWireRMAPLibrary/Boards/SpaceFibreADCBoardModules/EventDecoder.hh"
+#include "SpaceWireRMAPLibrary/Boards/SpaceFibreADCBoardModules/AcquisitionPipeline.hh"
+#include "SpaceWireRMAPLibrary/Boards/SpaceFibreADCBoardModules/EventRecorder.hh"
+#include "SpaceWireRMAPLibrary/Boards/SpaceFibreADCBoardModules/EventFileReader.hh"
+#include "SpaceWireRMAPLibrary/Boards/SpaceFibreADCBoardModules/OnlineHistogram.hh"
 #include "SpaceWireRMAPLibrary/Boards/SpaceFibreADCBoardModules/ChannelModule.hh"
 #include "SpaceWireRMAPLibrary/Boards/SpaceFibreADCBoardModules/ChannelManager.hh"
 #include "SpaceWireRMAPLibrary/Boards/SpaceFibreADCBoardModules/RMAPHandler.hh"
@@ -247,6 +251,8 @@ private:
 	ChannelModule* channelModules[SpaceFibreADC::NumberOfChannels];
 	EventDecoder* eventDecoder;
 	SpaceFibreADCBoardDumpThread* dumpThread;
+	AcquisitionPipeline* acquisitionPipeline;
+	OnlineHistogram* onlineHistogram;
 
 public:
 	size_t nReceivedEvents = 0;
@@ -283,6 +289,10 @@ public:
 
 		//event decoder
 		this->eventDecoder = new EventDecoder();
+		this->onlineHistogram = new OnlineHistogram(OnlineHistogram::DefaultNumberOfPHABins,
+				OnlineHistogram::DefaultNumberOfTimeBins, OnlineHistogram::DefaultTimeBinWidthInSec, ClockFrequency * 1e6);
+		this->eventDecoder->setOnlineHistogram(onlineHistogram);
+		this->acquisitionPipeline = new AcquisitionPipeline(consumerManager, eventDecoder);
 
 		//dump thread
 		this->dumpThread = new SpaceFibreADCBoardDumpThread(this);
@@ -296,6 +306,7 @@ public:
 		cout << "SpaceFibreADCBoard::~SpaceFibreADCBoard(): Stopping dump thread." << endl;
 		this->dumpThread->stop();
 		delete this->dumpThread;
+		delete this->acquisitionPipeline;
 
 		cout << "SpaceFibreADCBoard::~SpaceFibreADCBoard(): Deleting RMAP Handler." << endl;
 		delete rmapHandler;
@@ -307,6 +318,7 @@ public:
 			delete this->channelModules[i];
 		}
 		delete eventDecoder;
+		delete onlineHistogram;
 		cout << "SpaceFibreADCBoard::~SpaceFibreADCBoard(): Completed." << endl;
 	}
 
@@ -402,8 +414,12 @@ public:
 			cout << "#stopping dump thread" << endl;
 			consumerManager->stopDumpThread();
 			this->dumpThread->stop();
+			cout << "#stopping acquisition pipeline" << endl;
+			this->stopAcquisitionPipeline();
 			cout << "#closing sockets" << endl;
 			consumerManager->closeSocket();
+			//a partially received event is not continued by a new connection
+			eventDecoder->reset();
 			cout << "#disconnecting SpaceWire-to-GigabitEther" << endl;
 			rmapHandler->disconnectSpWGbE();
 		} catch (...) {
@@ -424,15 +440,143 @@ public:
 	 */
 	std::vector<SpaceFibreADC::Event*> getEvent() {
 		std::vector<SpaceFibreADC::Event*> events;
-		std::vector<uint8_t> data = consumerManager->getEventData();
-		if (data.size() != 0) {
-			eventDecoder->decodeEvent(&data);
-			events = eventDecoder->getDecodedEvents();
+		if (acquisitionPipeline->isRunning()) {
+			acquisitionPipeline->getEvents(events, ConsumerManagerSocketFIFO::TCPSocketTimeoutDurationInMilliSec);
+		} else if (acquisitionPipeline->hasEvents()) {
+			//events left in the pipeline output after it was stopped are returned first
+			acquisitionPipeline->getEvents(events, 0);
+		} else {
+			eventDecoder->setBatchMode(false);
+			ConsumerManagerSocketFIFO::EventDataSpan data = consumerManager->getEventDataSpan();
+			if (data.size != 0) {
+				eventDecoder->decodeEvent(data.data, data.size);
+				eventDecoder->getDecodedEvents(events);
+			}
 		}
 		nReceivedEvents += events.size();
 		return events;
 	}
 
+public:
+	/** Gets events as a columnar batch (see EventBatch) instead of SpaceFibreADC::Event instances.
+	 * Events are decoded directly into the batch, so nothing has to be freed after use.
+	 * While the acquisition pipeline is running, events decoded by the pipeline are
+	 * copied into the batch and freed (baseline is not available in that case).
+	 * getEvent() and getEventBatch() can be mixed without losing events.
+	 * @param[out] batch decoded events (previous content is replaced)
+	 * @return the number of events in the batch
+	 */
+	size_t getEventBatch(EventBatch& batch) {
+		if (acquisitionPipeline->isRunning() || acquisitionPipeline->hasEvents()) {
+			batch.clear();
+			std::vector<SpaceFibreADC::Event*> events;
+			//events left in the pipeline output after it was stopped are returned without waiting
+			double timeoutDuration =
+					acquisitionPipeline->isRunning() ? ConsumerManagerSocketFIFO::TCPSocketTimeoutDurationInMilliSec : 0;
+			acquisitionPipeline->getEvents(events, timeoutDuration);
+			for (size_t i = 0; i < events.size(); i++) {
+				batch.append(events[i]);
+				eventDecoder->freeEvent(events[i]);
+			}
+		} else {
+			eventDecoder->setBatchMode(true);
+			ConsumerManagerSocketFIFO::EventDataSpan data = consumerManager->getEventDataSpan();
+			if (data.size != 0) {
+				eventDecoder->decodeEvent(data.data, data.size);
+			}
+			eventDecoder->getDecodedEventBatch(batch);
+		}
+		nReceivedEvents += batch.size();
+		return batch.size();
+	}
+
+public:
+	/** Takes one decoded event without blocking.
+	 * This can be used only while the acquisition pipeline is running
+	 * (see startAcquisitionPipeline()), and only from one user thread.
+	 * @param[out] event a decoded event (should be freed via freeEvent() after use)
+	 * @return false if no decoded event is available
+	 */
+	bool tryGetEvent(SpaceFibreADC::Event*& event) {
+		if (acquisitionPipeline->tryGetEvent(event)) {
+			nReceivedEvents++;
+			return true;
+		}
+		return false;
+	}
+
+public:
+	/** Starts pipelined acquisition.
+	 * Socket reception and event decoding run in their own threads (see AcquisitionPipeline),
+	 * and getEvent()/tryGetEvent() return events decoded by the pipeline.
+	 * Events are handed over via lock-free rings without being copied,
+	 * and freeEvent() can be called from the user thread at any time.
+	 * @param[in] receiveThreadCPU CPU core for the receive thread (-1: not pinned)
+	 * @param[in] decodeThreadCPU CPU core for the decode thread (-1: not pinned)
+	 */
+	void startAcquisitionPipeline(int receiveThreadCPU = -1, int decodeThreadCPU = -1) {
+		acquisitionPipeline->setCPUAffinity(receiveThreadCPU, decodeThreadCPU);
+		acquisitionPipeline->start();
+	}
+
+public:
+	/** Stops pipelined acquisition. Events remaining in the pipeline output
+	 * can still be obtained via tryGetEvent() or getEvent(). Data which have been
+	 * received but not decoded are decoded, and returned by subsequent getEvent() calls.
+	 */
+	void stopAcquisitionPipeline() {
+		acquisitionPipeline->stop();
+	}
+
+public:
+	/** Starts receiving and decoding event data in background.
+	 * While running, getEvent() and tryGetEvent() return events decoded in background
+	 * without locks or copies. This is equivalent to startAcquisitionPipeline() without
+	 * pinning threads to CPU cores.
+	 */
+	void startEventDecodeThread() {
+		startAcquisitionPipeline();
+	}
+
+public:
+	/** Stops background reception and decoding started by startEventDecodeThread().
+	 * Events remaining in the pipeline output can still be obtained via tryGetEvent().
+	 */
+	void stopEventDecodeThread() {
+		stopAcquisitionPipeline();
+	}
+
+public:
+	/** Returns throughput/backlog counters of the acquisition pipeline stages.
+	 */
+	AcquisitionPipelineStatistics getAcquisitionPipelineStatistics() {
+		return acquisitionPipeline->getStatistics();
+	}
+
+public:
+	/** Returns quick-look histograms (phaMax spectra and event-rate time series)
+	 * of all events decoded so far. Histograms are filled by the event decoder,
+	 * so this does not require the user to pass events, and can be called from any thread.
+	 */
+	OnlineHistogramSnapshot getOnlineHistogramSnapshot() {
+		return onlineHistogram->getSnapshot();
+	}
+
+public:
+	/** Clears quick-look histograms (see getOnlineHistogramSnapshot()).
+	 */
+	void resetOnlineHistogram() {
+		onlineHistogram->reset();
+	}
+
+public:
+	/** Returns the OnlineHistogram instance filled by the event decoder.
+	 * Other threads (e.g. replaying recorded events) can fill it via OnlineHistogram::createFiller().
+	 */
+	OnlineHistogram* getOnlineHistogram() {
+		return onlineHistogram;
+	}
+
 public:
 	/** Frees an event instance so that buffer area can be reused in the following commands.
 	 * @param[in] event event instance to be freed
@@ -629,6 +773,21 @@ public:
 		channelManager->startAcquisition(channelsToBeStarted);
 	}
 
+public:
+	/** Starts data acquisition of a single channel while other channels keep running.
+	 * @param[in] chNumber channel to be started
+	 */
+	void startAcquisitionOfChannel(size_t chNumber) {
+		if (chNumber < SpaceFibreADC::NumberOfChannels) {
+			consumerManager->enableEventDataOutput();
+			channelManager->startAcquisitionOfChannel(chNumber);
+		} else {
+			using namespace std;
+			cerr << "Error in startAcquisitionOfChannel(): invalid channel number " << chNumber << endl;
+			throw SpaceFibreADCException::InvalidChannelNumber;
+		}
+	}
+
 public:
 	/** Checks if all data acquisition is completed in all channels.
 	 * 	return true if data acquisition is stopped.
@@ -653,6 +812,20 @@ public:
 		channelManager->stopAcquisition();
 	}
 
+public:
+	/** Stops data acquisition of a single channel while other channels keep running.
+	 * @param[in] chNumber channel to be stopped
+	 */
+	void stopAcquisitionOfChannel(size_t chNumber) {
+		if (chNumber < SpaceFibreADC::NumberOfChannels) {
+			channelManager->stopAcquisitionOfChannel(chNumber);
+		} else {
+			using namespace std;
+			cerr << "Error in stopAcquisitionOfChannel(): invalid channel number " << chNumber << endl;
+			throw SpaceFibreADCException::InvalidChannelNumber;
+		}
+	}
+
 public:
 	/** Sends CPU Trigger to force triggering in the specified channel.
 	 * @param[in] chNumber channel to be CPU-triggered
@@ -0,0 +1,403 @@
+/*
+ * AcquisitionPipeline.hh
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef SPACEFIBREADC_ACQUISITIONPIPELINE_HH_
+#define SPACEFIBREADC_ACQUISITIONPIPELINE_HH_
+
+#include "SpaceWireRMAPLibrary/Boards/SpaceFibreADCBoardModules/ConsumerManagerSocketFIFO.hh"
+#include "SpaceWireRMAPLibrary/Boards/SpaceFibreADCBoardModules/EventDecoder.hh"
+#include "SpaceWireRMAPLibrary/Boards/SpaceFibreADCBoardModules/EventRing.hh"
+#include "CxxUtilities/CxxUtilities.hh"
+#include <atomic>
+#include <deque>
+#include <sstream>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+/** Counters of AcquisitionPipeline stages.
+ * Backlogs are snapshots at the time of AcquisitionPipeline::getStatistics().
+ */
+struct AcquisitionPipelineStatistics {
+	//receive stage
+	size_t nReceivedBytes;
+	size_t nReceiveCalls;
+	size_t nReceiveStalls; //the receive thread waited for a free buffer (decode stage is behind)
+	//decode stage
+	size_t nDecodedBytes;
+	size_t nDecodedEvents;
+	size_t receiveBufferBacklog; //received buffers waiting to be decoded
+	size_t nDecodeStalls; //the decode thread waited for free space in the event ring (user is behind)
+	//output
+	size_t nDeliveredEvents;
+	size_t eventBacklog; //decoded events waiting to be taken by the user (including those kept by stop())
+
+	std::string toString() const {
+		std::stringstream ss;
+		ss << "receive: " << nReceivedBytes << " bytes in " << nReceiveCalls << " reads (" << nReceiveStalls << " stalls), "
+				<< "decode: " << nDecodedBytes << " bytes " << nDecodedEvents << " events (backlog " << receiveBufferBacklog
+				<< " buffers, " << nDecodeStalls << " stalls), " << "output: " << nDeliveredEvents << " events (backlog "
+				<< eventBacklog << " events)";
+		return ss.str();
+	}
+};
+
+/** Pipelined event acquisition.
+ * Three stages run concurrently:
+ * -# a receive thread reads event data from the socket with large reads into a ring of buffers,
+ * -# a decode thread decodes filled buffers with EventDecoder,
+ * -# the user thread takes decoded events from a bounded EventRing.
+ *
+ * Stages are connected by lock-free single-producer/single-consumer rings,
+ * and a stage which has nothing to do (or no space to put its output) sleeps briefly.
+ * When the user thread falls behind, the decode thread stops, the receive thread
+ * stops after all buffers are filled, and TCP flow control lets data accumulate
+ * in the board's SDRAM.
+ */
+class AcquisitionPipeline {
+public:
+	static const size_t DefaultNumberOfReceiveBuffers = 8;
+	static const size_t DefaultReceiveBufferSize = 1024 * 1024;
+	static const size_t DefaultEventRingCapacity = 8192;
+	static constexpr double WaitDurationInMilliSecWhenIdle = 1.0;
+	static constexpr double WaitDurationInMilliSecAfterReceiveError = 100.0;
+
+private:
+	struct ReceiveBuffer {
+		uint8_t* data;
+		size_t size;
+	};
+
+private:
+	class ReceiveThread: public CxxUtilities::StoppableThread {
+	private:
+		AcquisitionPipeline* parent;
+
+	public:
+		ReceiveThread(AcquisitionPipeline* parent) {
+			this->parent = parent;
+		}
+
+	public:
+		void run() {
+			parent->runReceiveStage(this);
+		}
+	};
+
+private:
+	class DecodeThread: public CxxUtilities::StoppableThread {
+	private:
+		AcquisitionPipeline* parent;
+
+	public:
+		DecodeThread(AcquisitionPipeline* parent) {
+			this->parent = parent;
+		}
+
+	public:
+		void run() {
+			parent->runDecodeStage(this);
+		}
+	};
+
+private:
+	ConsumerManagerSocketFIFO* consumerManager;
+	EventDecoder* eventDecoder;
+	size_t receiveBufferSize;
+	std::vector<ReceiveBuffer> receiveBuffers;
+	SpaceWireRRingBuffer<ReceiveBuffer*> freeReceiveBuffers; //decode stage -> receive stage
+	SpaceWireRRingBuffer<ReceiveBuffer*> filledReceiveBuffers; //receive stage -> decode stage
+	EventRing eventRing; //decode stage -> user
+	std::vector<SpaceFibreADC::Event*> undeliveredEvents; //decoded events which did not fit in eventRing when stopped
+	std::deque<SpaceFibreADC::Event*> pendingEvents; //events kept by stop(), taken before eventRing (user thread only)
+	ReceiveThread* receiveThread;
+	DecodeThread* decodeThread;
+	int receiveThreadCPU;
+	int decodeThreadCPU;
+
+private:
+	std::atomic<size_t> nReceivedBytes;
+	std::atomic<size_t> nReceiveCalls;
+	std::atomic<size_t> nReceiveStalls;
+	std::atomic<size_t> nDecodedBytes;
+	std::atomic<size_t> nDecodedEvents;
+	std::atomic<size_t> nDecodeStalls;
+	std::atomic<size_t> nDeliveredEvents;
+	std::atomic<size_t> nPendingEvents;
+
+public:
+	/** Constructor.
+	 * @param[in] consumerManager source of event data
+	 * @param[in] eventDecoder decoder used by the decode thread (should not be used by other threads while running)
+	 * @param[in] eventRingCapacity maximum number of decoded events buffered for the user
+	 * @param[in] nReceiveBuffers number of receive buffers
+	 * @param[in] receiveBufferSize size of each receive buffer in bytes
+	 */
+	AcquisitionPipeline(ConsumerManagerSocketFIFO* consumerManager, EventDecoder* eventDecoder,
+			size_t eventRingCapacity = DefaultEventRingCapacity, size_t nReceiveBuffers = DefaultNumberOfReceiveBuffers,
+			size_t receiveBufferSize = DefaultReceiveBufferSize) :
+			receiveBuffers(nReceiveBuffers), freeReceiveBuffers(nReceiveBuffers), filledReceiveBuffers(nReceiveBuffers), eventRing(
+					eventRingCapacity) {
+		this->consumerManager = consumerManager;
+		this->eventDecoder = eventDecoder;
+		this->receiveBufferSize = receiveBufferSize;
+		for (size_t i = 0; i < receiveBuffers.size(); i++) {
+			receiveBuffers[i].data = new uint8_t[receiveBufferSize];
+			receiveBuffers[i].size = 0;
+			freeReceiveBuffers.push(&receiveBuffers[i]);
+		}
+		receiveThread = NULL;
+		decodeThread = NULL;
+		receiveThreadCPU = -1;
+		decodeThreadCPU = -1;
+		nPendingEvents = 0;
+		resetStatistics();
+	}
+
+public:
+	virtual ~AcquisitionPipeline() {
+		stop();
+		SpaceFibreADC::Event* event;
+		while (takeEvent(event)) {
+			eventDecoder->freeEvent(event);
+		}
+		for (size_t i = 0; i < receiveBuffers.size(); i++) {
+			delete[] receiveBuffers[i].data;
+		}
+	}
+
+public:
+	/** Pins the receive and decode threads to CPU cores (Linux only).
+	 * This should be called before start(). A negative value means no pinning.
+	 */
+	void setCPUAffinity(int receiveThreadCPU, int decodeThreadCPU) {
+		this->receiveThreadCPU = receiveThreadCPU;
+		this->decodeThreadCPU = decodeThreadCPU;
+	}
+
+public:
+	void start() {
+		if (isRunning()) {
+			return;
+		}
+		receiveThread = new ReceiveThread(this);
+		decodeThread = new DecodeThread(this);
+		decodeThread->start();
+		receiveThread->start();
+	}
+
+public:
+	/** Stops the receive and decode threads.
+	 * Data which have been received but not decoded yet are decoded here, so that
+	 * no data are lost and the decoder state (including an incomplete 16-bit word)
+	 * continues seamlessly with synchronous decoding or a restarted pipeline.
+	 * Events decoded here stay in the EventDecoder's queue (see EventDecoder::getDecodedEvents()).
+	 * Decoded events remaining in the event ring, and those which the decode thread could not put
+	 * into the full event ring, are kept in order and can still be taken via tryGetEvent()/getEvents().
+	 */
+	void stop() {
+		if (!isRunning()) {
+			return;
+		}
+		receiveThread->stop();
+		receiveThread->waitUntilRunMethodComplets();
+		decodeThread->stop();
+		decodeThread->waitUntilRunMethodComplets();
+		delete receiveThread;
+		delete decodeThread;
+		receiveThread = NULL;
+		decodeThread = NULL;
+		//keep undelivered events after those in the ring, so that a restarted pipeline does not reorder them
+		SpaceFibreADC::Event* event;
+		while (eventRing.pop(event)) {
+			pendingEvents.push_back(event);
+		}
+		pendingEvents.insert(pendingEvents.end(), undeliveredEvents.begin(), undeliveredEvents.end());
+		undeliveredEvents.clear();
+		nPendingEvents = pendingEvents.size();
+		ReceiveBuffer* buffer;
+		while (filledReceiveBuffers.pop(buffer)) {
+			eventDecoder->decodeEvent(buffer->data, buffer->size);
+			nDecodedBytes += buffer->size;
+			freeReceiveBuffers.push(buffer);
+		}
+	}
+
+public:
+	bool isRunning() const {
+		return receiveThread != NULL;
+	}
+
+public:
+	/** Returns true if decoded events are waiting to be taken.
+	 */
+	bool hasEvents() const {
+		return !pendingEvents.empty() || !eventRing.isEmpty();
+	}
+
+public:
+	/** Takes one decoded event without blocking (from one user thread only).
+	 * @param[out] event a decoded event (should be freed via EventDecoder::freeEvent() after use)
+	 * @return false if no decoded event is available
+	 */
+	bool tryGetEvent(SpaceFibreADC::Event*& event) {
+		if (takeEvent(event)) {
+			nDeliveredEvents++;
+			return true;
+		}
+		return false;
+	}
+
+public:
+	/** Takes all decoded events available, waiting up to the timeout duration if there is none.
+	 * @param[out] events decoded events are appended
+	 * @param[in] timeoutDurationInMilliSec timeout duration
+	 * @return the number of appended events
+	 */
+	size_t getEvents(std::vector<SpaceFibreADC::Event*>& events, double timeoutDurationInMilliSec) {
+		CxxUtilities::Condition c;
+		double waitedDuration = 0;
+		while (!hasEvents() && waitedDuration < timeoutDurationInMilliSec) {
+			c.wait(WaitDurationInMilliSecWhenIdle);
+			waitedDuration += WaitDurationInMilliSecWhenIdle;
+		}
+		size_t nEvents = 0;
+		SpaceFibreADC::Event* event;
+		while (takeEvent(event)) {
+			events.push_back(event);
+			nEvents++;
+		}
+		nDeliveredEvents += nEvents;
+		return nEvents;
+	}
+
+public:
+	AcquisitionPipelineStatistics getStatistics() const {
+		AcquisitionPipelineStatistics statistics;
+		statistics.nReceivedBytes = nReceivedBytes;
+		statistics.nReceiveCalls = nReceiveCalls;
+		statistics.nReceiveStalls = nReceiveStalls;
+		statistics.nDecodedBytes = nDecodedBytes;
+		statistics.nDecodedEvents = nDecodedEvents;
+		statistics.receiveBufferBacklog = filledReceiveBuffers.size();
+		statistics.nDecodeStalls = nDecodeStalls;
+		statistics.nDeliveredEvents = nDeliveredEvents;
+		statistics.eventBacklog = nPendingEvents + eventRing.size();
+		return statistics;
+	}
+
+public:
+	void resetStatistics() {
+		nReceivedBytes = 0;
+		nReceiveCalls = 0;
+		nReceiveStalls = 0;
+		nDecodedBytes = 0;
+		nDecodedEvents = 0;
+		nDecodeStalls = 0;
+		nDeliveredEvents = 0;
+	}
+
+private:
+	/** Takes an event kept by stop() if any, otherwise one from the event ring. */
+	bool takeEvent(SpaceFibreADC::Event*& event) {
+		if (!pendingEvents.empty()) {
+			event = pendingEvents.front();
+			pendingEvents.pop_front();
+			nPendingEvents = pendingEvents.size();
+			return true;
+		}
+		return eventRing.pop(event);
+	}
+
+private:
+	static void pinCurrentThread(int cpu) {
+#ifdef __linux__
+		if (cpu < 0) {
+			return;
+		}
+		cpu_set_t cpuSet;
+		CPU_ZERO(&cpuSet);
+		CPU_SET(cpu, &cpuSet);
+		pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet);
+#endif
+	}
+
+private:
+	void runReceiveStage(CxxUtilities::StoppableThread* thread) {
+		using namespace std;
+		pinCurrentThread(receiveThreadCPU);
+		CxxUtilities::Condition c;
+		ReceiveBuffer* buffer = NULL;
+		//buffers may end in the middle of a 16-bit word (EventDecoder keeps the incomplete word)
+		while (!thread->isStopped()) {
+			if (buffer == NULL) {
+				if (!freeReceiveBuffers.pop(buffer)) {
+					nReceiveStalls++;
+					c.wait(WaitDurationInMilliSecWhenIdle);
+					continue;
+				}
+				buffer->size = 0;
+			}
+			size_t receivedSize;
+			try {
+				receivedSize = consumerManager->receiveEventData(buffer->data + buffer->size,
+						receiveBufferSize - buffer->size);
+			} catch (CxxUtilities::TCPSocketException& e) {
+				cerr << "AcquisitionPipeline::runReceiveStage(): TCPSocketException " << e.toString() << endl;
+				c.wait(WaitDurationInMilliSecAfterReceiveError);
+				continue;
+			}
+			nReceiveCalls++;
+			nReceivedBytes += receivedSize;
+			buffer->size += receivedSize;
+			if (buffer->size == 0) {
+				continue;
+			}
+			//the ring can hold all buffers, so this never fails
+			filledReceiveBuffers.push(buffer);
+			buffer = NULL;
+		}
+		if (buffer != NULL) {
+			//received data are decoded by stop()
+			filledReceiveBuffers.push(buffer);
+		}
+	}
+
+private:
+	void runDecodeStage(CxxUtilities::StoppableThread* thread) {
+		pinCurrentThread(decodeThreadCPU);
+		CxxUtilities::Condition c;
+		std::vector<SpaceFibreADC::Event*> events;
+		while (!thread->isStopped()) {
+			ReceiveBuffer* buffer;
+			if (!filledReceiveBuffers.pop(buffer)) {
+				c.wait(WaitDurationInMilliSecWhenIdle);
+				continue;
+			}
+			eventDecoder->decodeEvent(buffer->data, buffer->size);
+			nDecodedBytes += buffer->size;
+			freeReceiveBuffers.push(buffer);
+
+			eventDecoder->getDecodedEvents(events);
+			nDecodedEvents += events.size();
+			for (size_t i = 0; i < events.size(); i++) {
+				while (!eventRing.push(events[i])) {
+					if (thread->isStopped()) {
+						//stop() keeps these events
+						undeliveredEvents.insert(undeliveredEvents.end(), events.begin() + i, events.end());
+						return;
+					}
+					nDecodeStalls++;
+					c.wait(WaitDurationInMilliSecWhenIdle);
+				}
+			}
+		}
+	}
+};
+
+#endif /* SPACEFIBREADC_ACQUISITIONPIPELINE_HH_ */
@@ -74,14 +74,64 @@ public:
 			tmp = tmp * 2;
 		}
 		//write the StartStopRegister (semaphore is needed)
-		startStopSemaphore->request();
-		rmapHandler->write(adcRMAPTargetNode, ChannelManager::AddressOf_StartStopRegister, &writeData[0], writeData.size());
-		startStopSemaphore->release();
+		{
+			SemaphoreRegister::CriticalSection criticalSection(startStopSemaphore);
+			criticalSection.write(ChannelManager::AddressOf_StartStopRegister, &writeData[0], writeData.size());
+			criticalSection.commit();
+		}
+		if (Debug::channelmanager()) {
+			cout << "done" << endl;
+		}
+	}
+
+public:
+	/** Starts data acquisition of a single channel without changing the other channels.
+	 * @param chNumber channel to be started
+	 */
+	void startAcquisitionOfChannel(size_t chNumber) {
+		using namespace std;
+		if (Debug::channelmanager()) {
+			cout << "ChannelManager::startAcquisitionOfChannel(" << chNumber << ")...";
+		}
+		if (chNumber < NumberOfChannels) {
+			setStartStopRegisterBits(1 << chNumber, 1 << chNumber);
+		}
 		if (Debug::channelmanager()) {
 			cout << "done" << endl;
 		}
 	}
 
+public:
+	/** Stops data acquisition of a single channel without changing the other channels.
+	 * @param chNumber channel to be stopped
+	 */
+	void stopAcquisitionOfChannel(size_t chNumber) {
+		using namespace std;
+		if (Debug::channelmanager()) {
+			cout << "ChannelManager::stopAcquisitionOfChannel(" << chNumber << ")...";
+		}
+		if (chNumber < NumberOfChannels) {
+			setStartStopRegisterBits(0x0000, 1 << chNumber);
+		}
+		if (Debug::channelmanager()) {
+			cout << "done" << endl;
+		}
+	}
+
+private:
+	/** Modifies bits of StartStopRegister. RMAP RMW is tried first (a single atomic transaction);
+	 * if it was not executed, the register is read and written while holding the semaphore.
+	 */
+	void setStartStopRegisterBits(uint16_t value, uint16_t mask) {
+		uint16_t previousValue;
+		if (rmapHandler->trySetRegisterBits(AddressOf_StartStopRegister, value, mask, previousValue)) {
+			return;
+		}
+		SemaphoreRegister::CriticalSection criticalSection(startStopSemaphore);
+		previousValue = rmapHandler->getRegister(AddressOf_StartStopRegister);
+		rmapHandler->setRegister(AddressOf_StartStopRegister, (value & mask) | (previousValue & ~mask));
+	}
+
 public:
 	/** Checks if all data acquisition is completed in all channels.
 	 * 	return true if data acquisition is stopped.
@@ -140,9 +190,11 @@ public:
 			cout << "ChannelManager::stopAcquisition()...";
 		}
 		vector<uint8_t> writeData = { 0x00, 0x00 };
-		startStopSemaphore->request();
-		rmapHandler->write(adcRMAPTargetNode, ChannelManager::AddressOf_StartStopRegister, &writeData[0], 2);
-		startStopSemaphore->release();
+		{
+			SemaphoreRegister::CriticalSection criticalSection(startStopSemaphore);
+			criticalSection.write(ChannelManager::AddressOf_StartStopRegister, &writeData[0], 2);
+			criticalSection.commit();
+		}
 		if (Debug::channelmanager()) {
 			cout << "done" << endl;
 		}
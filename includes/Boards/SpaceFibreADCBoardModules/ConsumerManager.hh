@@ -8,7 +8,8 @@
 #ifndef CONSUMERMANAGER_HH_
 #define CONSUMERMANAGER_HH_
 
-#include "../RMAPHandler.hh"
+#include "SpaceWireRMAPLibrary/Boards/SpaceFibreADCBoardModules/RMAPHandler.hh"
+#include "SpaceWireRMAPLibrary/Boards/SpaceFibreADCBoardModules/SemaphoreRegister.hh"
 
 /** A class which represents ConsumerManager module in the VHDL logic.
  * It also holds information on a ring buffer constructed on SDRAM.
@@ -46,6 +47,33 @@ private:
 	uint32_t nextreadfrom;
 	uint32_t guardbit;
 
+public:
+	//parameters of drain()
+	static const size_t DefaultDrainChunkSize = 32768; //bytes per SDRAM read
+	static const size_t DefaultNumberOfDrainChunksInFlight = 4;
+	static const size_t DefaultMaximumDrainSize = 1024 * 1024; //bytes per drain() call
+	static const size_t DefaultReadPointerUpdateInterval = 1024 * 1024; //bytes
+	static constexpr double DrainTimeoutDurationInMilliSec = 1000;
+	static constexpr double DrainPollingIntervalInMilliSec = 0.05;
+
+private:
+	/** One SDRAM read issued by drain(). */
+	struct DrainChunk {
+		uint32_t address;
+		uint32_t length;
+		size_t offset; //offset in the drained data
+	};
+
+private:
+	//variables for drain()
+	std::vector<RMAPInitiator*> drainInitiators;
+	size_t drainInitiatorsRMAPEngineGeneration = 0; //RMAPHandler::getRMAPEngineGeneration() when created
+	std::vector<DrainChunk> drainChunks;
+	size_t drainChunkSize = DefaultDrainChunkSize;
+	size_t nDrainChunksInFlight = DefaultNumberOfDrainChunksInFlight;
+	size_t readPointerUpdateInterval = DefaultReadPointerUpdateInterval;
+	size_t nBytesDrainedSinceReadPointerUpdate;
+
 public:
 	/** Constructor.
 	 * @param rmaphandler a pointer to RMAPHandler which is connected to SpaceWire ADC Box
@@ -53,13 +81,15 @@ public:
 	ConsumerManager(RMAPHandler* handler) {
 		this->rmaphandler = handler;
 		adcboxRMAPNode = handler->getRMAPTargetNode("ADCBox");
-		writepointersemaphore = new SemaphoreRegister(this->rmaphandler,
+		writepointersemaphore = new SemaphoreRegister(this->rmaphandler, adcboxRMAPNode,
 				ConsumerManager::AddressOf_Writepointer_Semaphore_Register);
 		initialize();
 	}
 
 public:
-	virtual  ~ConsumerManager(){}
+	virtual  ~ConsumerManager(){
+		deleteDrainInitiators();
+	}
 
 public:
 	/** Initialize internal variables.
@@ -70,6 +100,7 @@ public:
 		writepointer = 0;
 		nextreadfrom = 0;
 		guardbit = 0;
+		nBytesDrainedSinceReadPointerUpdate = 0;
 	}
 
 public:
@@ -102,6 +133,34 @@ public:
 		return writepointer;
 	}
 
+public:
+	/** Reads WritePointer and GuardBit with a single RMAP read.
+	 * The two registers are adjacent, so this costs one round trip instead of
+	 * two (getWritePointer() and getGuardBit()).
+	 * @param[out] writepointer address of SDRAM which corresponds to WritePointer of the ring buffer
+	 * @param[out] guardbit guard bit value
+	 */
+	virtual void getWritePointerAndGuardBit(uint32_t& writepointer, uint32_t& guardbit) {
+		using namespace std;
+		if (Debug::consumermanager()) {
+			cout << "ConsumerManager::getWritePointerAndGuardBit()...";
+		}
+		uint8_t readdata[6];
+		//semaphore request
+		writepointersemaphore->request();
+		rmaphandler->read(adcboxRMAPNode, AddressOf_WritePointerRegister_High, 6, readdata);
+		//semaphore release
+		writepointersemaphore->release();
+		writepointer = readdata[1] * 0x01000000 + readdata[0] * 0x00010000 + readdata[3] * 0x00000100
+				+ readdata[2] * 0x00000001;
+		writepointer += ConsumerManager::InitialAddressOf_Sdram_EventList;
+		guardbit = readdata[4];
+		if (Debug::consumermanager()) {
+			cout << "done(writepointer=" << hex << setw(8) << setfill('0') << writepointer << dec << " guardbit="
+					<< guardbit << ")" << endl;
+		}
+	}
+
 public:
 	/** Returns ReadPointer maintained inside this module.
 	 * @return address of SDRAM which corresponds to ReadPointer of the ring buffer.
@@ -301,6 +360,174 @@ public:
 		return returneddata;
 	}
 
+public:
+	/** Sets parameters of drain().
+	 * @param[in] chunkSize size of one SDRAM read in bytes (rounded down to an even number)
+	 * @param[in] nChunksInFlight number of SDRAM reads kept in flight
+	 * @param[in] readPointerUpdateInterval ReadPointer on FPGA is updated at least once per this many drained bytes
+	 */
+	void setDrainParameters(size_t chunkSize, size_t nChunksInFlight,
+			size_t readPointerUpdateInterval = DefaultReadPointerUpdateInterval) {
+		deleteDrainInitiators();
+		this->drainChunkSize = (chunkSize < 2) ? 2 : (chunkSize & ~(size_t) 1);
+		this->nDrainChunksInFlight = (nChunksInFlight == 0) ? 1 : nChunksInFlight;
+		this->readPointerUpdateInterval = readPointerUpdateInterval;
+	}
+
+public:
+	/** Retrieves data stored in the SDRAM as one contiguous block.
+	 * Unlike read(), the readable part of the ring buffer is split into large chunks
+	 * which are read with multiple RMAP transactions in flight, and the wrap
+	 * at FinalAddressOf_Sdram_EventList is handled in the same call.
+	 * WritePointer and GuardBit are fetched in one RMAP read only when all known data
+	 * have been read out, and ReadPointer on FPGA is updated lazily (when caught up with
+	 * WritePointer, at the wrap, or every readPointerUpdateInterval bytes).
+	 * If an SDRAM read fails, data read before the failure are returned and
+	 * the rest will be read again in the next call.
+	 * @param[out] data drained data (empty if there is no data)
+	 * @param[in] maximumSize maximum data size to be drained (in bytes)
+	 */
+	virtual void drain(std::vector<uint8_t>& data, size_t maximumSize = DefaultMaximumDrainSize) {
+		using namespace std;
+		data.clear();
+		if (drainInitiators.size() != 0 && drainInitiatorsRMAPEngineGeneration != rmaphandler->getRMAPEngineGeneration()) {
+			//the RMAPEngine of the initiators was deleted (RMAPHandler was disconnected/reconnected)
+			deleteDrainInitiators();
+		}
+		if (drainInitiators.size() == 0) {
+			createDrainInitiators();
+			if (drainInitiators.size() == 0) {
+				return;
+			}
+		}
+
+		//update writepointer and guardbit if all known data have been read out
+		if (readpointer == writepointer) {
+			getWritePointerAndGuardBit(writepointer, guardbit);
+		}
+
+		//split readable region(s) into chunks
+		drainChunks.clear();
+		size_t totalSize = 0;
+		maximumSize &= ~(size_t) 1;
+		if (writepointer <= nextreadfrom && guardbit == 0) {
+			//there is no data to be read out from SDRAM
+			return;
+		} else if (writepointer >= nextreadfrom) {
+			appendDrainChunks(nextreadfrom, writepointer, maximumSize, totalSize);
+		} else {
+			//writepointer<nextreadfrom && guardbit==1
+			appendDrainChunks(nextreadfrom, FinalAddressOf_Sdram_EventList, maximumSize, totalSize);
+			appendDrainChunks(InitialAddressOf_Sdram_EventList, writepointer, maximumSize, totalSize);
+		}
+		if (Debug::ringbuffer()) {
+			cout << "ConsumerManager::drain() nextreadfrom:" << setfill('0') << setw(8) << hex << nextreadfrom
+					<< " writepointer:" << setfill('0') << setw(8) << writepointer << dec << " guardbit:" << guardbit
+					<< " " << drainChunks.size() << " chunks (" << totalSize << " bytes)" << endl;
+		}
+
+		//read chunks keeping nDrainChunksInFlight transactions in flight
+		data.resize(totalSize);
+		const size_t nInitiators = drainInitiators.size();
+		size_t nIssued = 0;
+		size_t nCompleted = 0;
+		try {
+			while (nCompleted < drainChunks.size()) {
+				while (nIssued < drainChunks.size() && nIssued - nCompleted < nInitiators) {
+					drainInitiators[nIssued % nInitiators]->nonblockingRead(adcboxRMAPNode, drainChunks[nIssued].address,
+							drainChunks[nIssued].length);
+					nIssued++;
+				}
+				RMAPInitiator* initiator = drainInitiators[nCompleted % nInitiators];
+				waitForNonblockingRead(initiator);
+				initiator->getNonblockingReadData(&data[drainChunks[nCompleted].offset], drainChunks[nCompleted].length);
+				nCompleted++;
+			}
+		} catch (CxxUtilities::Exception& e) {
+			cerr << "ConsumerManager::drain(): SDRAM read failed (" << e.toString() << "). Try later." << endl;
+			for (size_t i = nCompleted; i < nIssued; i++) {
+				drainInitiators[i % nInitiators]->cancelNonblockingRead();
+			}
+		}
+		if (nCompleted == 0) {
+			data.clear();
+			return;
+		}
+		const DrainChunk& lastChunk = drainChunks[nCompleted - 1];
+		data.resize(lastChunk.offset + lastChunk.length);
+
+		//advance ring buffer pointers
+		bool wrapped = false;
+		for (size_t i = 0; i < nCompleted; i++) {
+			if (drainChunks[i].address + drainChunks[i].length - 2 == FinalAddressOf_Sdram_EventList) {
+				wrapped = true;
+			}
+		}
+		readpointer = lastChunk.address + lastChunk.length - 2;
+		nextreadfrom = increment_address(readpointer);
+		nBytesDrainedSinceReadPointerUpdate += data.size();
+		if (wrapped) {
+			//let ConsumerManager module see the wrap as read() does
+			setReadPointer(FinalAddressOf_Sdram_EventList);
+			guardbit = 0;
+		}
+		if (readpointer == writepointer || nBytesDrainedSinceReadPointerUpdate >= readPointerUpdateInterval) {
+			setReadPointer(readpointer);
+			nBytesDrainedSinceReadPointerUpdate = 0;
+		}
+	}
+
+private:
+	/** Appends chunks covering SDRAM addresses [from, to] (both inclusive) to drainChunks.
+	 */
+	void appendDrainChunks(uint32_t from, uint32_t to, size_t maximumSize, size_t& totalSize) {
+		size_t address = from;
+		while (address <= to && totalSize < maximumSize) {
+			size_t length = to + 2 - address;
+			length = (length < drainChunkSize) ? length : drainChunkSize;
+			length = (length < maximumSize - totalSize) ? length : maximumSize - totalSize;
+			DrainChunk chunk = { (uint32_t) address, (uint32_t) length, totalSize };
+			drainChunks.push_back(chunk);
+			totalSize += length;
+			address += length;
+		}
+	}
+
+private:
+	void waitForNonblockingRead(RMAPInitiator* initiator) {
+		CxxUtilities::Condition c;
+		double waitedDuration = 0;
+		while (!initiator->isNonblockingReadCompleted()) {
+			if (waitedDuration >= DrainTimeoutDurationInMilliSec) {
+				throw RMAPInitiatorException(RMAPInitiatorException::Timeout);
+			}
+			c.wait(DrainPollingIntervalInMilliSec);
+			waitedDuration += DrainPollingIntervalInMilliSec;
+		}
+	}
+
+private:
+	void createDrainInitiators() {
+		drainInitiatorsRMAPEngineGeneration = rmaphandler->getRMAPEngineGeneration();
+		for (size_t i = 0; i < nDrainChunksInFlight; i++) {
+			RMAPInitiator* initiator = rmaphandler->createRMAPInitiator();
+			if (initiator == NULL) {
+				std::cerr << "ConsumerManager::drain(): RMAPHandler is not connected" << std::endl;
+				deleteDrainInitiators();
+				return;
+			}
+			drainInitiators.push_back(initiator);
+		}
+	}
+
+private:
+	void deleteDrainInitiators() {
+		for (size_t i = 0; i < drainInitiators.size(); i++) {
+			delete drainInitiators[i];
+		}
+		drainInitiators.clear();
+	}
+
 public:
 	/** Sets NumberOfBaselineSample_Register
 	 * @param numberofsamples number of data points to be sampled
@@ -120,19 +120,60 @@ public:
 		}
 	}
 
+public:
+	/** Default size of the receive buffer used by getEventData()/getEventDataSpan().
+	 * A large buffer lets one socket read drain everything the kernel has buffered.
+	 */
+	static const size_t DefaultReceiveBufferSize = 1024 * 1024;
+
+public:
+	/** A view of received event data.
+	 * The pointed memory belongs to ConsumerManagerSocketFIFO, and is valid
+	 * until the next call of getEventDataSpan() or getEventData().
+	 */
+	struct EventDataSpan {
+		const uint8_t* data;
+		size_t size;
+	};
+
 private:
 	std::vector<uint8_t> receiveBuffer;
-	static const size_t ReceiveBufferSize = 4096;
+	size_t receiveBufferSize = DefaultReceiveBufferSize;
+	uint8_t carriedByte = 0; //the first byte of an incomplete 16-bit word, returned by the next read
+	bool hasCarriedByte = false;
 
 public:
-	/** Retrieve data stored in the SDRAM (via ConsumerManager module).
-	 * The size of data varies depending on the event data in the SDRAM.
-	 * @param maximumsize maximum data size to be returned (in bytes)
+	/** Sets the size of the receive buffer (the maximum size returned by one getEventDataSpan() call).
+	 * @param[in] size receive buffer size in bytes (at least 2)
 	 */
-	std::vector<uint8_t> getEventData(uint32_t maximumsize = 4000) throw (CxxUtilities::TCPSocketException) {
+	void setReceiveBufferSize(size_t size) {
+		receiveBufferSize = (size < 2) ? 2 : size;
+	}
+
+public:
+	size_t getReceiveBufferSize() const {
+		return receiveBufferSize;
+	}
+
+public:
+	/** Retrieve data stored in the SDRAM (via ConsumerManager module) without copying.
+	 * Data are received with a single socket read of up to getReceiveBufferSize() bytes.
+	 * The returned size is always even (whole 16-bit words). When an odd number of bytes
+	 * arrives, the last byte is held back and returned at the head of the next read.
+	 * @return received data (size is 0 on timeout), valid until the next call
+	 */
+	EventDataSpan getEventDataSpan() throw (CxxUtilities::TCPSocketException) {
+		return getEventDataSpan(receiveBufferSize);
+	}
+
+private:
+	EventDataSpan getEventDataSpan(size_t maximumSize) throw (CxxUtilities::TCPSocketException) {
 		using namespace std;
 
-		receiveBuffer.resize(ReceiveBufferSize);
+		maximumSize = (maximumSize < 2) ? 2 : (maximumSize & ~static_cast<size_t>(1));
+		if (receiveBuffer.size() < maximumSize) {
+			receiveBuffer.resize(maximumSize);
+		}
 
 		//open socket if necessary
 		if (socket == NULL) {
@@ -151,43 +192,77 @@ public:
 		}
 
 		//receive via TCP socket (ConsumerManagerSocketFIFO in the FPGA will send event packets byte-by-byte)
+		if (Debug::consumermanager()) {
+			cout << "ConsumerManagerSocketFIFO::getEventDataSpan(): trying to receive data" << endl;
+		}
+		socket->setTimeout(TCPSocketTimeoutDurationInMilliSec);
+		size_t receivedSize = receiveEventData(&(receiveBuffer[0]), maximumSize);
+		if (Debug::consumermanager()) {
+			cout << "ConsumerManagerSocketFIFO::getEventDataSpan(): received " << receivedSize << " bytes" << endl;
+		}
+		//hold back the first byte of an incomplete 16-bit word
+		if (receivedSize % 2 == 1) {
+			receivedSize--;
+			carriedByte = receiveBuffer[receivedSize];
+			hasCarriedByte = true;
+		}
+
+		EventDataSpan span = { &(receiveBuffer[0]), receivedSize };
+		return span;
+	}
+
+public:
+	/** Retrieve data stored in the SDRAM (via ConsumerManager module).
+	 * The size of data varies depending on the event data in the SDRAM, and is always even
+	 * (see getEventDataSpan()). This copies received data; use getEventDataSpan() at high event rates.
+	 * @param maximumsize maximum size of returned data in bytes (rounded down to an even number, at least 2)
+	 */
+	std::vector<uint8_t> getEventData(uint32_t maximumsize = 4000) throw (CxxUtilities::TCPSocketException) {
+		EventDataSpan span = getEventDataSpan(maximumsize);
+		return std::vector<uint8_t>(span.data, span.data + span.size);
+	}
+
+public:
+	/** Receives event data into a user buffer with a single socket read.
+	 * A byte held back by getEventDataSpan()/getEventData() is written first.
+	 * Unlike getEventDataSpan(), the received size may be odd (EventDecoder keeps an incomplete
+	 * 16-bit word until the next call).
+	 * @param[out] buffer buffer to which received data are written
+	 * @param[in] maximumSize size of the buffer in bytes
+	 * @return received size in bytes (0 on timeout)
+	 */
+	size_t receiveEventData(uint8_t* buffer, size_t maximumSize) throw (CxxUtilities::TCPSocketException) {
+		using namespace std;
+		if (socket == NULL) {
+			this->openSocket();
+		}
+		if (maximumSize == 0) {
+			return 0;
+		}
+		size_t carriedSize = 0;
+		if (hasCarriedByte) {
+			buffer[0] = carriedByte;
+			hasCarriedByte = false;
+			carriedSize = 1;
+		}
+		size_t receivedSize = 0;
 		try {
-			if (Debug::consumermanager()) {
-				cout << "ConsumerManagerSocketFIFO::getEventData(): trying to receive data" << endl;
-			}
-			socket->setTimeout(TCPSocketTimeoutDurationInMilliSec);
-			size_t receivedSize = socket->receive(&(receiveBuffer[0]), ReceiveBufferSize);
-			if (Debug::consumermanager()) {
-				cout << "ConsumerManagerSocketFIFO::getEventData(): received " << receivedSize << " bytes" << endl;
-			}
-			//if odd byte is received, wait until the following 1 byte is received.
-			if (receivedSize % 2 == 1) {
-				cout << "ConsumerManagerSocketFIFO::getEventData(): odd bytes. wait for another byte." << endl;
-				size_t receivedSizeOneByte = 0;
-				while (receivedSizeOneByte == 0) {
-					try {
-						receivedSizeOneByte = socket->receive(&(receiveBuffer[receivedSize]), 1);
-					} catch (...) {
-						cerr << "ConsumerManagerSocketFIFO::getEventData(): receive 1 byte timeout. continues." << endl;
-					}
-				}
-				//increment by 1 to make receivedSize even
-				receivedSize++;
+			if (maximumSize > carriedSize) {
+				receivedSize = socket->receive(buffer + carriedSize, maximumSize - carriedSize);
 			}
-			receiveBuffer.resize(receivedSize);
 		} catch (CxxUtilities::TCPSocketException& e) {
-			if (e.getStatus() == CxxUtilities::TCPSocketException::Timeout) {
-				cerr << "ConsumerManagerSocketFIFO::getEventData(): timeout" << endl;
-				receiveBuffer.resize(0);
-			} else {
-				cerr << "ConsumerManagerSocketFIFO::getEventData(): TCPSocketException on receive()" << e.toString() << endl;
+			if (e.getStatus() != CxxUtilities::TCPSocketException::Timeout) {
+				cerr << "ConsumerManagerSocketFIFO::receiveEventData(): TCPSocketException on receive()" << e.toString()
+						<< endl;
+				if (carriedSize != 0) {
+					carriedByte = buffer[0];
+					hasCarriedByte = true;
+				}
 				throw e;
 			}
 		}
-
-		//return result
-		receivedBytes += receiveBuffer.size();
-		return receiveBuffer;
+		receivedBytes += receivedSize;
+		return carriedSize + receivedSize;
 	}
 
 public:
@@ -243,6 +318,7 @@ public:
 			delete socket;
 			socket = NULL;
 		}
+		hasCarriedByte = false;
 	}
 
 public:
@@ -0,0 +1,132 @@
+/*
+ * EventBatch.hh
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef SPACEFIBREADC_EVENTBATCH_HH_
+#define SPACEFIBREADC_EVENTBATCH_HH_
+
+#include "SpaceWireRMAPLibrary/Boards/SpaceFibreADCBoardModules/Types.hh"
+#include <cstring>
+#include <vector>
+
+/** A batch of decoded events stored column by column (struct of arrays).
+ * The i-th event consists of ch[i], timeTag[i], triggerCount[i], ... and
+ * its waveform is nSamples[i] samples starting at waveforms[waveformOffset[i]].
+ * Waveforms of all events are packed in one buffer, and waveformOffset has size()+1 entries
+ * so that waveformOffset[i+1]-waveformOffset[i] also gives the waveform length.
+ * Columns can be processed over many events at once without following per-event pointers,
+ * e.g. a phaMax spectrum is a loop over phaMax.data().
+ * clear() keeps allocated memory, so a batch instance can be reused without allocation.
+ */
+class EventBatch {
+public:
+	std::vector<uint8_t> ch;
+	std::vector<uint64_t> timeTag;
+	std::vector<uint32_t> triggerCount;
+	std::vector<uint32_t> livetime;
+	std::vector<uint16_t> phaMax;
+	std::vector<uint16_t> baseline;
+	std::vector<uint16_t> nSamples;
+	std::vector<uint32_t> waveformOffset;
+	std::vector<uint16_t> waveforms;
+
+public:
+	EventBatch() {
+		waveformOffset.push_back(0);
+	}
+
+public:
+	/** Returns the number of events in this batch.
+	 */
+	inline size_t size() const {
+		return ch.size();
+	}
+
+public:
+	inline bool isEmpty() const {
+		return ch.size() == 0;
+	}
+
+public:
+	/** Removes all events (allocated memory is kept).
+	 */
+	void clear() {
+		ch.clear();
+		timeTag.clear();
+		triggerCount.clear();
+		livetime.clear();
+		phaMax.clear();
+		baseline.clear();
+		nSamples.clear();
+		waveformOffset.resize(1);
+		waveforms.clear();
+	}
+
+public:
+	/** Reserves memory.
+	 * @param[in] nEvents expected number of events
+	 * @param[in] nTotalSamples expected number of waveform samples of all events
+	 */
+	void reserve(size_t nEvents, size_t nTotalSamples) {
+		ch.reserve(nEvents);
+		timeTag.reserve(nEvents);
+		triggerCount.reserve(nEvents);
+		livetime.reserve(nEvents);
+		phaMax.reserve(nEvents);
+		baseline.reserve(nEvents);
+		nSamples.reserve(nEvents);
+		waveformOffset.reserve(nEvents + 1);
+		waveforms.reserve(nTotalSamples);
+	}
+
+public:
+	/** Returns a pointer to the waveform of the i-th event.
+	 */
+	inline const uint16_t* getWaveform(size_t i) const {
+		return waveforms.data() + waveformOffset[i];
+	}
+
+public:
+	/** Appends an event (copies its waveform).
+	 */
+	void append(const SpaceFibreADC::Event* event, uint16_t baseline = 0) {
+		size_t offset = waveforms.size();
+		waveforms.resize(offset + event->nSamples);
+		std::memcpy(waveforms.data() + offset, event->waveform, event->nSamples * sizeof(uint16_t));
+		appendRow(event->ch, event->timeTag, event->triggerCount, event->livetime, event->phaMax, baseline);
+	}
+
+public:
+	/** Fills an Event structure which refers to the i-th event.
+	 * event.waveform points into this batch, and is valid until the batch is modified.
+	 */
+	void getEvent(size_t i, SpaceFibreADC::Event& event) const {
+		event.ch = ch[i];
+		event.timeTag = timeTag[i];
+		event.triggerCount = triggerCount[i];
+		event.livetime = livetime[i];
+		event.phaMax = phaMax[i];
+		event.nSamples = nSamples[i];
+		event.waveform = const_cast<uint16_t*>(getWaveform(i));
+	}
+
+public:
+	/** Appends an event whose waveform has already been appended to waveforms
+	 * (samples after the last event's waveform become this event's waveform).
+	 */
+	inline void appendRow(uint8_t ch, uint64_t timeTag, uint32_t triggerCount, uint32_t livetime, uint16_t phaMax,
+			uint16_t baseline) {
+		this->ch.push_back(ch);
+		this->timeTag.push_back(timeTag);
+		this->triggerCount.push_back(triggerCount);
+		this->livetime.push_back(livetime);
+		this->phaMax.push_back(phaMax);
+		this->baseline.push_back(baseline);
+		this->nSamples.push_back(static_cast<uint16_t>(waveforms.size() - waveformOffset.back()));
+		this->waveformOffset.push_back(static_cast<uint32_t>(waveforms.size()));
+	}
+};
+
+#endif /* SPACEFIBREADC_EVENTBATCH_HH_ */
@@ -9,16 +9,37 @@
 #define EVENTDECODER_HH_
 
 #include "SpaceWireRMAPLibrary/Boards/SpaceFibreADCBoardModules/Types.hh"
-#include <queue>
-#include <stack>
+#include "SpaceWireRMAPLibrary/Boards/SpaceFibreADCBoardModules/EventPool.hh"
+#include "SpaceWireRMAPLibrary/Boards/SpaceFibreADCBoardModules/EventBatch.hh"
+#include "SpaceWireRMAPLibrary/Boards/SpaceFibreADCBoardModules/OnlineHistogram.hh"
+#include <cstring>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
 
 /** Decodes event data received from the SpaceFibre ADC Board.
  * Decoded event instances will be stored in a queue.
+ *
+ * Event data is a sequence of little-endian 16-bit words:
+ * 0xFFF0, ch, consumerID, phaMax, timeH, timeM, timeL, triggerCountH, triggerCountL,
+ * baseline, 0xFFF1, waveform..., 0xFFF2, 0xFFFF.
+ * Words are read directly from the received byte array. Delimiters are searched
+ * several words at a time with SIMD compare instructions (when available),
+ * and waveform samples between 0xFFF1 and 0xFFF2 are copied to the event in bulk.
+ * An event, and even a 16-bit word, may span more than one call of decodeEvent();
+ * call reset() when the data stream is interrupted.
+ * Event instances are taken from a lock-free EventPool, so freeEvent() can be
+ * called from a thread other than the one which calls decodeEvent().
+ * In batch mode (see setBatchMode()), decoded events are appended to an EventBatch
+ * instead, and waveforms are copied directly into the batch's packed waveform buffer.
+ * Decoded events can also be filled to an OnlineHistogram as they are decoded (see setOnlineHistogram()).
  */
 class EventDecoder {
 private:
 	struct RawEvent {
-		uint16_t flag_FFF0;
 		uint16_t ch;
 		uint16_t consumerID;
 		uint16_t phaMax;
@@ -28,12 +49,14 @@ private:
 		uint16_t triggerCountH;
 		uint16_t triggerCountL;
 		uint16_t baseline;
-		uint16_t flag_FFF1;
-		uint16_t* waveform;
-		uint16_t flag_FFF2;
-		uint16_t flag_FFFF;
 	} rawEvent;
 
+public:
+	static const uint16_t StartFlag = 0xfff0;
+	static const uint16_t WaveformStartFlag = 0xfff1;
+	static const uint16_t WaveformEndFlag = 0xfff2;
+	static const uint16_t EndFlag = 0xffff;
+
 private:
 	enum class EventDecoderState {
 		state_flag_FFF0,
@@ -55,173 +78,365 @@ private:
 private:
 	EventDecoderState state;
 	std::vector<SpaceFibreADC::Event*> eventQueue;
-	std::vector<uint16_t> readDataUint16Array;
-	std::stack<SpaceFibreADC::Event*> eventInstanceResavoir;
+	EventPool eventPool;
+	//event instance which is being decoded (its waveform is filled directly)
+	SpaceFibreADC::Event* currentEvent;
 	size_t waveformLength;
+	size_t nTruncatedSamples;
+	//the first byte of a 16-bit word split between decodeEvent() calls
+	uint8_t pendingByte;
+	bool hasPendingByte;
+
+private:
+	//batch mode
+	bool batchMode;
+	EventBatch eventBatch;
+	//the waveform of the event being decoded follows the last committed waveform in eventBatch
+	bool isBatchEventInProgress;
+
+private:
+	OnlineHistogram::Filler* histogramFiller;
 
 public:
 	/** Constructor.
 	 */
-	EventDecoder() {
+	EventDecoder() :
+			eventPool(InitialEventInstanceNumber) {
 		state = EventDecoderState::state_flag_FFF0;
-		rawEvent.waveform = new uint16_t[SpaceFibreADC::MaxWaveformLength];
-		prepareEventInstances();
+		currentEvent = NULL;
+		waveformLength = 0;
+		nTruncatedSamples = 0;
+		pendingByte = 0;
+		hasPendingByte = false;
+		batchMode = false;
+		isBatchEventInProgress = false;
+		histogramFiller = NULL;
 	}
 
 public:
 	virtual ~EventDecoder() {
-		while (eventInstanceResavoir.size() != 0) {
-			SpaceFibreADC::Event* event = eventInstanceResavoir.top();
-			eventInstanceResavoir.pop();
-			delete event->waveform;
-			delete event;
+		if (currentEvent != NULL) {
+			eventPool.free(currentEvent);
+		}
+		for (size_t i = 0; i < eventQueue.size(); i++) {
+			eventPool.free(eventQueue[i]);
 		}
-		delete rawEvent.waveform;
 	}
 
 public:
 	void decodeEvent(std::vector<uint8_t>* readDataUint8Array) {
-		using namespace std;
-
-		size_t size = readDataUint8Array->size();
-		if(size%2==1){
-			cerr << "EventDecoder::decodeEvent(): odd data length " << size << " bytes" << endl;
-			exit(-1);
+		if (readDataUint8Array->size() == 0) {
+			return;
 		}
+		decodeEvent(&(readDataUint8Array->at(0)), readDataUint8Array->size());
+	}
 
-		size_t size_half = size / 2;
-
-		if (Debug::eventdecoder()) {
-			cout << "EventDecoder::decodeEvent() read " << size << " bytes (state = " << stateToString() << ")" << endl;
+public:
+	/** Decodes event data.
+	 * Data can be split at any byte. When the data end in the middle of a 16-bit word,
+	 * the first byte of the word is kept and decoded with the next call.
+	 * @param[in] data pointer to received data
+	 * @param[in] size data size in bytes
+	 */
+	void decodeEvent(const uint8_t* data, size_t size) {
+		if (size == 0) {
+			return;
+		}
+		if (hasPendingByte) {
+			const uint8_t word[2] = { pendingByte, data[0] };
+			hasPendingByte = false;
+			decodeWords(word, 1);
+			data++;
+			size--;
 		}
+		if (size % 2 == 1) {
+			size--;
+			pendingByte = data[size];
+			hasPendingByte = true;
+		}
+		decodeWords(data, size / 2);
+	}
 
-		//resize if necessary
-		if (size_half > readDataUint16Array.size()) {
-			readDataUint16Array.resize(size_half);
+public:
+	/** Discards the event being decoded and an incomplete 16-bit word, and restarts
+	 * decoding from the next start flag. This should be called when the data stream
+	 * is interrupted (e.g. the socket is reconnected). Decoded events are kept.
+	 */
+	void reset() {
+		state = EventDecoderState::state_flag_FFF0;
+		hasPendingByte = false;
+		waveformLength = 0;
+		if (currentEvent != NULL) {
+			eventPool.free(currentEvent);
+			currentEvent = NULL;
+		}
+		if (isBatchEventInProgress) {
+			eventBatch.waveforms.resize(eventBatch.waveformOffset.back());
+			isBatchEventInProgress = false;
 		}
+	}
+
+private:
+	void decodeWords(const uint8_t* data, size_t nWords) {
+		using namespace std;
 
-		//fill data
-		for (size_t i = 0; i < size_half; i++) {
-			readDataUint16Array[i] = (readDataUint8Array->at((i << 1) + 1) << 8) + readDataUint8Array->at((i << 1));
+		if (Debug::eventdecoder()) {
+			cout << "EventDecoder::decodeEvent() read " << nWords * 2 << " bytes (state = " << stateToString() << ")" << endl;
 		}
 
 		//decode the data
-		for (size_t i = 0; i < size_half; i++) {
+		size_t i = 0;
+		while (i < nWords) {
+			const uint8_t* p = data + (i << 1);
 			switch (state) {
-			case EventDecoderState::state_flag_FFF0:
-				waveformLength = 0;
-				if (readDataUint16Array[i] == 0xfff0) {
-					state = EventDecoderState::state_ch;
-				}else{
-					cerr << "EventDecoder::decodeEvent(): invalid start flag (" << "0x" << hex << right << setw(4) << setfill('0')  << (uint32_t)readDataUint16Array[i] << ")" << endl;
+			case EventDecoderState::state_flag_FFF0: {
+				size_t nSkippedWords = findWord(p, nWords - i, StartFlag);
+				if (nSkippedWords != 0) {
+					cerr << "EventDecoder::decodeEvent(): invalid start flag (" << "0x" << hex << right << setw(4)
+							<< setfill('0') << readWord(p) << dec << "), " << nSkippedWords << " words skipped" << endl;
+					i += nSkippedWords;
+					if (i == nWords) {
+						break;
+					}
+				}
+				startNewEvent();
+				state = EventDecoderState::state_ch;
+				i++;
+				//when the whole header is in this buffer, decode it at once
+				if (i + NumberOfHeaderWords <= nWords) {
+					decodeHeader(data + (i << 1));
+					i += NumberOfHeaderWords;
+					state = EventDecoderState::state_flag_FFF1;
 				}
 				break;
+			}
 			case EventDecoderState::state_ch:
-				rawEvent.ch = readDataUint16Array[i];
+				rawEvent.ch = readWord(p);
 				state = EventDecoderState::state_consumerID;
+				i++;
 				break;
 			case EventDecoderState::state_consumerID:
-				rawEvent.consumerID = readDataUint16Array[i];
+				rawEvent.consumerID = readWord(p);
 				state = EventDecoderState::state_phaMax;
+				i++;
 				break;
 			case EventDecoderState::state_phaMax:
-				rawEvent.phaMax = readDataUint16Array[i];
+				rawEvent.phaMax = readWord(p);
 				state = EventDecoderState::state_timeH;
+				i++;
 				break;
 			case EventDecoderState::state_timeH:
-				rawEvent.timeH = readDataUint16Array[i];
+				rawEvent.timeH = readWord(p);
 				state = EventDecoderState::state_timeM;
+				i++;
 				break;
 			case EventDecoderState::state_timeM:
-				rawEvent.timeM = readDataUint16Array[i];
+				rawEvent.timeM = readWord(p);
 				state = EventDecoderState::state_timeL;
+				i++;
 				break;
 			case EventDecoderState::state_timeL:
-				rawEvent.timeL = readDataUint16Array[i];
+				rawEvent.timeL = readWord(p);
 				state = EventDecoderState::state_triggerCountH;
+				i++;
 				break;
 			case EventDecoderState::state_triggerCountH:
-				rawEvent.triggerCountH = readDataUint16Array[i];
+				rawEvent.triggerCountH = readWord(p);
 				state = EventDecoderState::state_triggerCountL;
+				i++;
 				break;
 			case EventDecoderState::state_triggerCountL:
-				rawEvent.triggerCountL = readDataUint16Array[i];
+				rawEvent.triggerCountL = readWord(p);
 				state = EventDecoderState::state_baseline;
+				i++;
 				break;
 			case EventDecoderState::state_baseline:
-				rawEvent.baseline = readDataUint16Array[i];
+				rawEvent.baseline = readWord(p);
 				state = EventDecoderState::state_flag_FFF1;
+				i++;
 				break;
-			case EventDecoderState::state_flag_FFF1:
-				if (readDataUint16Array[i] == 0xfff1) {
+			case EventDecoderState::state_flag_FFF1: {
+				size_t nSkippedWords = findWord(p, nWords - i, WaveformStartFlag);
+				i += nSkippedWords;
+				if (i < nWords) {
 					state = EventDecoderState::state_pha_list;
+					i++;
 				}
 				break;
-			case EventDecoderState::state_pha_list:
-				if (readDataUint16Array[i] == 0xfff2) {
+			}
+			case EventDecoderState::state_pha_list: {
+				size_t nSamples = findWord(p, nWords - i, WaveformEndFlag);
+				appendWaveform(p, nSamples);
+				i += nSamples;
+				if (i < nWords) {
 					state = EventDecoderState::state_flag_FFFF;
-				} else {
-					rawEvent.waveform[waveformLength] = readDataUint16Array[i];
-					waveformLength++;
+					i++;
 				}
 				break;
+			}
 			case EventDecoderState::state_flag_FFFF:
-				//if (0 <= ch && ch < SpaceWireADCBox::NumberOfChannels) {
-				//tree->SetBranchAddress("pha_list", &(waveforms[ch]->at(0)));
-				//}
-
 				//push SpaceFibreADC::Event to a queue
 				pushEventToQueue();
 
 				//move to the idle state
 				state = EventDecoderState::state_flag_FFF0;
+				i++;
 				break;
 			}
 		}
 	}
 
+private:
+	/** The number of header words between 0xFFF0 and 0xFFF1. */
+	static const size_t NumberOfHeaderWords = 9;
+
+private:
+	static inline uint16_t readWord(const uint8_t* p) {
+		return static_cast<uint16_t>(p[0] | (p[1] << 8));
+	}
+
+private:
+	void decodeHeader(const uint8_t* p) {
+		rawEvent.ch = readWord(p);
+		rawEvent.consumerID = readWord(p + 2);
+		rawEvent.phaMax = readWord(p + 4);
+		rawEvent.timeH = readWord(p + 6);
+		rawEvent.timeM = readWord(p + 8);
+		rawEvent.timeL = readWord(p + 10);
+		rawEvent.triggerCountH = readWord(p + 12);
+		rawEvent.triggerCountL = readWord(p + 14);
+		rawEvent.baseline = readWord(p + 16);
+	}
+
+public:
+	/** Returns the index of the first word which equals to the specified value.
+	 * @param[in] p pointer to little-endian 16-bit words
+	 * @param[in] nWords the number of words to be searched
+	 * @param[in] word the value to be searched
+	 * @return index of the found word, or nWords if not found
+	 */
+	static size_t findWord(const uint8_t* p, size_t nWords, uint16_t word) {
+		size_t i = 0;
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#if defined(__AVX2__)
+		const __m256i pattern256 = _mm256_set1_epi16(static_cast<short>(word));
+		for (; i + 16 <= nWords; i += 16) {
+			__m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + (i << 1)));
+			uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi16(v, pattern256)));
+			if (mask != 0) {
+				return i + (__builtin_ctz(mask) >> 1);
+			}
+		}
+#endif
+#if defined(__SSE2__)
+		const __m128i pattern = _mm_set1_epi16(static_cast<short>(word));
+		for (; i + 8 <= nWords; i += 8) {
+			__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + (i << 1)));
+			uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi16(v, pattern)));
+			if (mask != 0) {
+				return i + (__builtin_ctz(mask) >> 1);
+			}
+		}
+#elif defined(__ARM_NEON)
+		const uint16x8_t pattern = vdupq_n_u16(word);
+		for (; i + 8 <= nWords; i += 8) {
+			uint16x8_t equal = vceqq_u16(vld1q_u16(reinterpret_cast<const uint16_t*>(p + (i << 1))), pattern);
+			//narrow each 16-bit lane to 8 bits so that the result fits in a 64-bit mask
+			uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(equal, 4)), 0);
+			if (mask != 0) {
+				return i + (__builtin_ctzll(mask) >> 3);
+			}
+		}
+#endif
+#endif
+		for (; i < nWords; i++) {
+			if (readWord(p + (i << 1)) == word) {
+				return i;
+			}
+		}
+		return nWords;
+	}
+
+private:
+	void appendWaveform(const uint8_t* p, size_t nSamples) {
+		size_t nCopiedSamples = nSamples;
+		if (waveformLength + nCopiedSamples > SpaceFibreADC::MaxWaveformLength) {
+			nCopiedSamples = SpaceFibreADC::MaxWaveformLength - waveformLength;
+			nTruncatedSamples += nSamples - nCopiedSamples;
+		}
+		uint16_t* destination;
+		if (batchMode) {
+			size_t offset = eventBatch.waveforms.size();
+			eventBatch.waveforms.resize(offset + nCopiedSamples);
+			destination = eventBatch.waveforms.data() + offset;
+		} else {
+			destination = currentEvent->waveform + waveformLength;
+		}
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+		std::memcpy(destination, p, nCopiedSamples * sizeof(uint16_t));
+#else
+		for (size_t i = 0; i < nCopiedSamples; i++) {
+			destination[i] = readWord(p + (i << 1));
+		}
+#endif
+		waveformLength += nCopiedSamples;
+	}
+
 public:
 	static const size_t InitialEventInstanceNumber = 10000;
 
 private:
-	void prepareEventInstances() {
-		for (size_t i = 0; i < InitialEventInstanceNumber; i++) {
-			SpaceFibreADC::Event* event = new SpaceFibreADC::Event;
-			event->waveform = new uint16_t[SpaceFibreADC::MaxWaveformLength];
-			eventInstanceResavoir.push(event);
+	void startNewEvent() {
+		waveformLength = 0;
+		if (batchMode) {
+			//discard samples of the previous event if it was not terminated
+			eventBatch.waveforms.resize(eventBatch.waveformOffset.back());
+			isBatchEventInProgress = true;
+			return;
+		}
+		if (currentEvent != NULL) {
+			//the previous event was not terminated; reuse its instance
+			return;
+		}
+		//debug dump
+		if (Debug::eventdecoder() && eventPool.getNFreeEvents() == 0) {
+			using namespace std;
+			cerr << "EventDecoder::startNewEvent() new Event instance was created." << endl;
 		}
+		currentEvent = eventPool.allocate();
 	}
 
 public:
 	void pushEventToQueue() {
-		SpaceFibreADC::Event* event;
-		if (eventInstanceResavoir.size() == 0) {
-			event = new SpaceFibreADC::Event;
-			//debug dump
-			if (Debug::eventdecoder()) {
-				using namespace std;
-				cerr << "EventDecoder::pushEventToQueue() new Event instance was created." << endl;
+		uint64_t timeTag = (static_cast<uint64_t>(rawEvent.timeH) << 32) + (static_cast<uint64_t>(rawEvent.timeM) << 16)
+				+ (rawEvent.timeL);
+		uint32_t triggerCount = ((static_cast<uint32_t>(rawEvent.triggerCountH)) << 16)
+				+ (static_cast<uint32_t>(rawEvent.triggerCountL));
+		uint32_t livetime = 0; //todo: implement event livetime
+		if (histogramFiller != NULL && (batchMode ? isBatchEventInProgress : currentEvent != NULL)) {
+			histogramFiller->fill(rawEvent.ch, timeTag, rawEvent.phaMax);
+		}
+		if (batchMode) {
+			if (!isBatchEventInProgress) {
+				return;
 			}
-			event->waveform = new uint16_t[SpaceFibreADC::MaxWaveformLength];
-		} else {
-			//reuse already created instance
-			event = eventInstanceResavoir.top();
-			eventInstanceResavoir.pop();
+			isBatchEventInProgress = false;
+			//waveform has been already written to eventBatch.waveforms
+			eventBatch.appendRow(rawEvent.ch, timeTag, triggerCount, livetime, rawEvent.phaMax, rawEvent.baseline);
+			return;
+		}
+		if (currentEvent == NULL) {
+			return;
 		}
+		SpaceFibreADC::Event* event = currentEvent;
+		currentEvent = NULL;
 		event->ch = rawEvent.ch;
-		event->timeTag = (static_cast<uint64_t>(rawEvent.timeH) << 32) + (static_cast<uint64_t>(rawEvent.timeM) << 16)
-				+ (rawEvent.timeL);
+		event->timeTag = timeTag;
 		event->phaMax = rawEvent.phaMax;
 		event->nSamples = waveformLength;
-		event->livetime = 0; //todo: implement event livetime
-		event->triggerCount = ((static_cast<uint32_t>(rawEvent.triggerCountH)) << 16)
-				+ (static_cast<uint32_t>(rawEvent.triggerCountL));
-
-		//copy waveform
-		for (size_t i = 0; i < waveformLength; i++) {
-			event->waveform[i] = rawEvent.waveform[i];
-		}
-
+		event->livetime = livetime;
+		event->triggerCount = triggerCount;
+		//waveform has been already written to event->waveform
 		eventQueue.push_back(event);
 	}
 
@@ -232,17 +447,99 @@ public:
 	 * @return std::queue containing pointers to decoded events
 	 */
 	std::vector<SpaceFibreADC::Event*> getDecodedEvents() {
-		std::vector<SpaceFibreADC::Event*> eventQueueCopied = eventQueue;
-		eventQueue.clear();
-		return eventQueueCopied;
+		std::vector<SpaceFibreADC::Event*> decodedEvents;
+		decodedEvents.swap(eventQueue);
+		return decodedEvents;
+	}
+
+public:
+	/** Moves decoded events to the given vector without copying the queue.
+	 * The content of the vector is replaced; its capacity is recycled as
+	 * the internal queue, so that repeated calls do not allocate memory.
+	 * @param[out] events decoded events
+	 */
+	void getDecodedEvents(std::vector<SpaceFibreADC::Event*>& events) {
+		events.clear();
+		events.swap(eventQueue);
+	}
+
+public:
+	/** Switches between event mode (decoded events are queued as SpaceFibreADC::Event instances,
+	 * see getDecodedEvents()) and batch mode (decoded events are appended to a columnar EventBatch,
+	 * see getDecodedEventBatch()). An event which is being decoded when the mode is switched
+	 * is carried over to the new mode. Events already decoded stay where they are.
+	 * @param[in] enable true for batch mode
+	 */
+	void setBatchMode(bool enable) {
+		if (enable == batchMode) {
+			return;
+		}
+		size_t committedSamples = eventBatch.waveformOffset.back();
+		if (enable && currentEvent != NULL) {
+			eventBatch.waveforms.resize(committedSamples + waveformLength);
+			std::memcpy(eventBatch.waveforms.data() + committedSamples, currentEvent->waveform,
+					waveformLength * sizeof(uint16_t));
+			eventPool.free(currentEvent);
+			currentEvent = NULL;
+			isBatchEventInProgress = true;
+		} else if (!enable && isBatchEventInProgress) {
+			currentEvent = eventPool.allocate();
+			std::memcpy(currentEvent->waveform, eventBatch.waveforms.data() + committedSamples,
+					waveformLength * sizeof(uint16_t));
+			eventBatch.waveforms.resize(committedSamples);
+			isBatchEventInProgress = false;
+		}
+		batchMode = enable;
+	}
+
+public:
+	/** Fills decoded events to an OnlineHistogram (in both event and batch modes).
+	 * This decoder has its own Filler, so the histogram can be shared with other decoders/threads.
+	 * The Filler is kept while the same histogram is set again, and is returned to the histogram
+	 * when another histogram (or NULL) is set.
+	 * This should not be called while another thread is decoding with this instance.
+	 * @param[in] histogram histogram to be filled (NULL to stop filling); it should outlive this decoder
+	 * or be detached before being deleted
+	 */
+	void setOnlineHistogram(OnlineHistogram* histogram) {
+		if (histogramFiller != NULL) {
+			if (histogramFiller->getHistogram() == histogram) {
+				return;
+			}
+			histogramFiller->getHistogram()->releaseFiller(histogramFiller);
+		}
+		histogramFiller = (histogram != NULL) ? histogram->createFiller() : NULL;
+	}
+
+public:
+	bool isBatchMode() const {
+		return batchMode;
+	}
+
+public:
+	/** Moves events decoded in batch mode to the given batch.
+	 * The content of the batch is replaced; its memory is recycled as the internal batch,
+	 * so that repeated calls do not allocate memory.
+	 * @param[out] batch decoded events
+	 */
+	void getDecodedEventBatch(EventBatch& batch) {
+		batch.clear();
+		std::swap(batch, eventBatch);
+		//the event being decoded stays in the internal batch
+		size_t committedSamples = batch.waveformOffset.back();
+		if (batch.waveforms.size() != committedSamples) {
+			eventBatch.waveforms.assign(batch.waveforms.begin() + committedSamples, batch.waveforms.end());
+			batch.waveforms.resize(committedSamples);
+		}
 	}
 
 public:
 	/** Frees event instance so that buffer area can be reused in the following commands.
+	 * This method can be called from any thread.
 	 * @param event event instance to be freed
 	 */
 	void freeEvent(SpaceFibreADC::Event* event) {
-		eventInstanceResavoir.push(event);
+		eventPool.free(event);
 	}
 
 public:
@@ -250,7 +547,20 @@ public:
 	 * @return the number of Event instances
 	 */
 	size_t getNAllocatedEventInstances() {
-		return eventInstanceResavoir.size();
+		return eventPool.getNFreeEvents();
+	}
+
+public:
+	EventPool* getEventPool() {
+		return &eventPool;
+	}
+
+public:
+	/** Returns the number of waveform samples discarded because a waveform
+	 * was longer than SpaceFibreADC::MaxWaveformLength.
+	 */
+	size_t getNTruncatedSamples() {
+		return nTruncatedSamples;
 	}
 
 public:
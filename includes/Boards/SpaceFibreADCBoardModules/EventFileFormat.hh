@@ -0,0 +1,191 @@
+/*
+ * EventFileFormat.hh
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef SPACEFIBREADC_EVENTFILEFORMAT_HH_
+#define SPACEFIBREADC_EVENTFILEFORMAT_HH_
+
+#include "SpaceWireRMAPLibrary/Boards/SpaceFibreADCBoardModules/Types.hh"
+#include "CxxUtilities/CxxUtilities.hh"
+#include <string.h>
+
+/** Binary event file format of SpaceFibre ADC events (written by EventRecorder, read by EventFileReader).
+ *
+ * A file consists of a file header padded to EventFileFormat::Alignment bytes, followed by blocks.
+ * Each block consists of an EventFileBlockHeader and length-prefixed event records,
+ * padded to a multiple of EventFileFormat::Alignment bytes so that blocks can be
+ * written with direct I/O. An event record is a uint32_t record size (excluding itself),
+ * an EventFileRecordHeader, and the waveform encoded as specified in the block header.
+ * Headers and uncompressed samples are stored in the byte order of the host which wrote the file
+ * (little endian on x86 and ARM hosts). A file written on a host of the other byte order does not
+ * match the version and block magic, and is rejected by EventFileReader as InvalidFormat.
+ */
+class EventFileFormat {
+public:
+	static const uint32_t Version = 1;
+	static const size_t Alignment = 4096;
+	static const uint32_t BlockMagic = 0x4B4C4246; //"FBLK"
+
+public:
+	/** Waveform encodings. */
+	enum {
+		Uncompressed = 0, //uint16_t samples as they are
+		DeltaVarint = 1 //differences between successive samples, zigzag-encoded and stored as LEB128 varints
+	};
+
+public:
+	static std::string compressionToString(uint32_t compression) {
+		switch (compression) {
+		case Uncompressed:
+			return "Uncompressed";
+		case DeltaVarint:
+			return "DeltaVarint";
+		default:
+			return "Unknown";
+		}
+	}
+
+public:
+	static const char* fileMagic() {
+		return "SFADCEVT";
+	}
+
+public:
+	static size_t alignUp(size_t size) {
+		return (size + Alignment - 1) & ~(Alignment - 1);
+	}
+
+public:
+	/** Returns the maximum encoded size of a waveform in bytes.
+	 */
+	static size_t maximumEncodedWaveformSize(size_t nSamples, uint32_t compression) {
+		return (compression == DeltaVarint) ? nSamples * 3 : nSamples * 2;
+	}
+
+public:
+	/** Encodes a waveform.
+	 * @param[in] waveform samples
+	 * @param[in] nSamples number of samples
+	 * @param[in] compression EventFileFormat::Uncompressed or EventFileFormat::DeltaVarint
+	 * @param[out] output buffer of at least maximumEncodedWaveformSize() bytes
+	 * @return encoded size in bytes
+	 */
+	static size_t encodeWaveform(const uint16_t* waveform, size_t nSamples, uint32_t compression, uint8_t* output) {
+		if (compression != DeltaVarint) {
+			memcpy(output, waveform, nSamples * sizeof(uint16_t));
+			return nSamples * sizeof(uint16_t);
+		}
+		uint8_t* p = output;
+		int32_t previous = 0;
+		for (size_t i = 0; i < nSamples; i++) {
+			int32_t delta = (int32_t) waveform[i] - previous;
+			previous = waveform[i];
+			uint32_t zigzag = ((uint32_t) delta << 1) ^ (uint32_t) (delta >> 31);
+			while (zigzag >= 0x80) {
+				*p++ = (uint8_t) (zigzag | 0x80);
+				zigzag >>= 7;
+			}
+			*p++ = (uint8_t) zigzag;
+		}
+		return p - output;
+	}
+
+public:
+	/** Decodes a waveform encoded by encodeWaveform().
+	 * @return false if the encoded data are shorter than nSamples samples
+	 */
+	static bool decodeWaveform(const uint8_t* input, size_t size, uint32_t compression, uint16_t* waveform,
+			size_t nSamples) {
+		if (compression != DeltaVarint) {
+			if (size < nSamples * sizeof(uint16_t)) {
+				return false;
+			}
+			memcpy(waveform, input, nSamples * sizeof(uint16_t));
+			return true;
+		}
+		const uint8_t* p = input;
+		const uint8_t* end = input + size;
+		int32_t previous = 0;
+		for (size_t i = 0; i < nSamples; i++) {
+			uint32_t zigzag = 0;
+			uint32_t shift = 0;
+			do {
+				if (p == end || shift > 28) {
+					return false;
+				}
+				zigzag |= (uint32_t) (*p & 0x7F) << shift;
+				shift += 7;
+			} while (*p++ & 0x80);
+			previous += (int32_t) (zigzag >> 1) ^ -(int32_t) (zigzag & 1);
+			waveform[i] = (uint16_t) previous;
+		}
+		return true;
+	}
+};
+
+/** File header (padded to EventFileFormat::Alignment bytes in the file). */
+struct EventFileHeader {
+	char magic[8];
+	uint32_t version;
+	uint32_t headerSize;
+	uint32_t alignment;
+	uint32_t compression;
+	uint64_t creationTimeInSec;
+};
+
+/** Block header placed at the head of every block. */
+struct EventFileBlockHeader {
+	uint32_t magic;
+	uint32_t compression;
+	uint32_t nEvents;
+	uint32_t payloadSize; //bytes of event records following this header (excluding padding)
+	uint64_t firstEventIndex;
+	uint64_t reserved;
+};
+
+/** Fixed part of an event record. */
+struct EventFileRecordHeader {
+	uint64_t timeTag;
+	uint32_t triggerCount;
+	uint32_t livetime;
+	uint16_t phaMax;
+	uint16_t nSamples;
+	uint8_t ch;
+	uint8_t reserved[3];
+};
+
+class EventFileException: public CxxUtilities::Exception {
+public:
+	enum {
+		OpenFailed, WriteFailed, InvalidFormat, RecorderClosed
+	};
+
+public:
+	EventFileException(int status) :
+			CxxUtilities::Exception(status) {
+	}
+
+public:
+	virtual ~EventFileException() {
+	}
+
+public:
+	std::string toString() {
+		switch (status) {
+		case OpenFailed:
+			return "OpenFailed";
+		case WriteFailed:
+			return "WriteFailed";
+		case InvalidFormat:
+			return "InvalidFormat";
+		case RecorderClosed:
+			return "RecorderClosed";
+		default:
+			return "Undefined status";
+		}
+	}
+};
+
+#endif /* SPACEFIBREADC_EVENTFILEFORMAT_HH_ */
@@ -0,0 +1,225 @@
+/*
+ * EventFileReader.hh
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef SPACEFIBREADC_EVENTFILEREADER_HH_
+#define SPACEFIBREADC_EVENTFILEREADER_HH_
+
+#include "SpaceWireRMAPLibrary/Boards/SpaceFibreADCBoardModules/EventFileFormat.hh"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/** An event read by EventFileReader.
+ * The fields are the same as SpaceFibreADC::Event, but the waveform is read-only
+ * because it may point into the read-only mapping of the file.
+ */
+struct ReplayedEvent {
+	uint8_t ch;
+	uint64_t timeTag;
+	uint32_t triggerCount;
+	uint32_t livetime;
+	uint16_t phaMax;
+	uint16_t nSamples;
+	const uint16_t* waveform;
+};
+
+/** Reads a binary event file written by EventRecorder for offline replay.
+ * The file is memory-mapped, so events are read without read() calls and,
+ * for uncompressed files, waveforms are not copied (ReplayedEvent::waveform points into the mapped file).
+ *
+ * @code
+ * EventFileReader reader("run001.sfadc");
+ * ReplayedEvent event;
+ * while (reader.next(event)) {
+ *   //event.waveform is valid until the next call of next()
+ * }
+ * @endcode
+ */
+class EventFileReader {
+private:
+	std::string fileName;
+	int fd;
+	const uint8_t* mappedData;
+	size_t fileSize;
+	EventFileHeader fileHeader;
+
+private:
+	//read position
+	size_t blockOffset;
+	const EventFileBlockHeader* currentBlock;
+	size_t recordOffset; //offset in the current block payload
+	uint32_t nRemainingEventsInBlock;
+	uint64_t nReadEvents;
+	std::vector<uint16_t> waveformBuffer; //decoded waveform of compressed records
+
+public:
+	/** Constructor. Maps the file and checks the file header.
+	 * @param[in] fileName event file name
+	 */
+	EventFileReader(std::string fileName) throw (EventFileException) {
+		using namespace std;
+		this->fileName = fileName;
+		mappedData = NULL;
+		fileSize = 0;
+		fd = ::open(fileName.c_str(), O_RDONLY);
+		if (fd < 0) {
+			cerr << "EventFileReader::EventFileReader(): could not open " << fileName << endl;
+			throw EventFileException(EventFileException::OpenFailed);
+		}
+		struct stat fileStatus;
+		if (fstat(fd, &fileStatus) != 0 || (size_t) fileStatus.st_size < EventFileFormat::Alignment) {
+			::close(fd);
+			throw EventFileException(EventFileException::InvalidFormat);
+		}
+		fileSize = fileStatus.st_size;
+		void* memory = mmap(NULL, fileSize, PROT_READ, MAP_SHARED, fd, 0);
+		if (memory == MAP_FAILED) {
+			::close(fd);
+			throw EventFileException(EventFileException::OpenFailed);
+		}
+		mappedData = (const uint8_t*) memory;
+		madvise(memory, fileSize, MADV_SEQUENTIAL);
+		memcpy(&fileHeader, mappedData, sizeof(fileHeader));
+		if (memcmp(fileHeader.magic, EventFileFormat::fileMagic(), sizeof(fileHeader.magic)) != 0
+				|| fileHeader.version != EventFileFormat::Version || fileHeader.alignment == 0
+				|| fileHeader.headerSize > fileSize) {
+			cerr << "EventFileReader::EventFileReader(): " << fileName << " is not an event file" << endl;
+			closeFile();
+			throw EventFileException(EventFileException::InvalidFormat);
+		}
+		rewind();
+	}
+
+public:
+	virtual ~EventFileReader() {
+		closeFile();
+	}
+
+public:
+	/** Moves the read position back to the first event.
+	 */
+	void rewind() {
+		blockOffset = fileHeader.headerSize;
+		currentBlock = NULL;
+		nRemainingEventsInBlock = 0;
+		nReadEvents = 0;
+	}
+
+public:
+	/** Reads the next event.
+	 * @param[out] event read event; event.waveform is valid until the next call of next() or rewind()
+	 * @return false at the end of the file
+	 */
+	bool next(ReplayedEvent& event) throw (EventFileException) {
+		while (nRemainingEventsInBlock == 0) {
+			if (!moveToNextBlock()) {
+				return false;
+			}
+		}
+		const uint8_t* payload = (const uint8_t*) (currentBlock + 1);
+		uint32_t recordSize;
+		memcpy(&recordSize, payload + recordOffset, sizeof(recordSize));
+		if (recordSize < sizeof(EventFileRecordHeader)
+				|| recordOffset + sizeof(recordSize) + recordSize > currentBlock->payloadSize) {
+			throw EventFileException(EventFileException::InvalidFormat);
+		}
+		const uint8_t* record = payload + recordOffset + sizeof(recordSize);
+		EventFileRecordHeader header;
+		memcpy(&header, record, sizeof(header));
+		event.ch = header.ch;
+		event.timeTag = header.timeTag;
+		event.triggerCount = header.triggerCount;
+		event.livetime = header.livetime;
+		event.phaMax = header.phaMax;
+		event.nSamples = header.nSamples;
+		const uint8_t* encodedWaveform = record + sizeof(header);
+		size_t encodedWaveformSize = recordSize - sizeof(header);
+		if (currentBlock->compression == EventFileFormat::Uncompressed
+				&& ((uintptr_t) encodedWaveform % sizeof(uint16_t)) == 0) {
+			if (encodedWaveformSize < header.nSamples * sizeof(uint16_t)) {
+				throw EventFileException(EventFileException::InvalidFormat);
+			}
+			event.waveform = (const uint16_t*) encodedWaveform;
+		} else {
+			if (waveformBuffer.size() < header.nSamples) {
+				waveformBuffer.resize(header.nSamples);
+			}
+			if (!EventFileFormat::decodeWaveform(encodedWaveform, encodedWaveformSize, currentBlock->compression,
+					waveformBuffer.data(), header.nSamples)) {
+				throw EventFileException(EventFileException::InvalidFormat);
+			}
+			event.waveform = waveformBuffer.data();
+		}
+		recordOffset += sizeof(recordSize) + recordSize;
+		nRemainingEventsInBlock--;
+		nReadEvents++;
+		return true;
+	}
+
+public:
+	/** Returns the number of events read since the file was opened (or rewound).
+	 */
+	uint64_t getNReadEvents() const {
+		return nReadEvents;
+	}
+
+public:
+	size_t getFileSize() const {
+		return fileSize;
+	}
+
+public:
+	/** Returns the waveform encoding specified when the file was recorded.
+	 */
+	uint32_t getCompression() const {
+		return fileHeader.compression;
+	}
+
+public:
+	/** Returns the time when the file was created (UNIX time).
+	 */
+	uint64_t getCreationTimeInSec() const {
+		return fileHeader.creationTimeInSec;
+	}
+
+private:
+	bool moveToNextBlock() throw (EventFileException) {
+		if (currentBlock != NULL) {
+			blockOffset += EventFileFormat::alignUp(sizeof(EventFileBlockHeader) + currentBlock->payloadSize);
+			currentBlock = NULL;
+		}
+		if (blockOffset + sizeof(EventFileBlockHeader) > fileSize) {
+			return false;
+		}
+		const EventFileBlockHeader* block = (const EventFileBlockHeader*) (mappedData + blockOffset);
+		if (block->magic != EventFileFormat::BlockMagic) {
+			//a block which was not completely written (e.g. the recorder was killed)
+			return false;
+		}
+		if (blockOffset + sizeof(EventFileBlockHeader) + block->payloadSize > fileSize) {
+			throw EventFileException(EventFileException::InvalidFormat);
+		}
+		currentBlock = block;
+		recordOffset = 0;
+		nRemainingEventsInBlock = block->nEvents;
+		return true;
+	}
+
+private:
+	void closeFile() {
+		if (mappedData != NULL) {
+			munmap((void*) mappedData, fileSize);
+			mappedData = NULL;
+		}
+		if (fd >= 0) {
+			::close(fd);
+			fd = -1;
+		}
+	}
+};
+
+#endif /* SPACEFIBREADC_EVENTFILEREADER_HH_ */
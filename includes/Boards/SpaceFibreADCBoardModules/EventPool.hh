@@ -0,0 +1,150 @@
+/*
+ * EventPool.hh
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef SPACEFIBREADC_EVENTPOOL_HH_
+#define SPACEFIBREADC_EVENTPOOL_HH_
+
+#include "SpaceWireRMAPLibrary/Boards/SpaceFibreADCBoardModules/Types.hh"
+#include <atomic>
+
+/** A thread-safe pool of SpaceFibreADC::Event instances.
+ * All Event instances and their waveform buffers are allocated at once as
+ * two contiguous arrays (slabs). Free instances are kept in a lock-free stack,
+ * so that allocate() and free() can be called from different threads
+ * (e.g. EventDecoder in a decode thread and a user analysis thread) without locks.
+ * When the pool is exhausted, allocate() falls back to heap allocation, and such an
+ * instance is deleted (instead of being returned to the pool) when it is freed.
+ */
+class EventPool {
+public:
+	static const size_t DefaultNumberOfEvents = 10000;
+
+public:
+	/** Distance between waveform buffers in the slab (in samples).
+	 * One cache line is added to MaxWaveformLength so that consecutive buffers
+	 * do not start at the same offset in a 4-KiB page, which slows down bulk copies
+	 * into the buffers due to 4K aliasing.
+	 */
+	static const size_t WaveformStrideInSamples = SpaceFibreADC::MaxWaveformLength + 32;
+	static const size_t WaveformAlignmentInBytes = 64;
+
+private:
+	size_t nEvents;
+	SpaceFibreADC::Event* events;
+	uint16_t* waveformSlab;
+
+private:
+	//next[i] holds (index of the next free instance + 1), or 0 at the bottom of the stack
+	std::atomic<uint32_t>* next;
+	//lower 32 bits: (index of the top free instance + 1); upper 32 bits: tag to avoid ABA
+	std::atomic<uint64_t> top;
+	std::atomic<size_t> nFreeEvents;
+	std::atomic<size_t> nHeapAllocatedEvents;
+
+private:
+	static const uint64_t IndexMask = 0xFFFFFFFFULL;
+
+public:
+	/** Constructor.
+	 * @param[in] nEvents the number of Event instances allocated in the pool
+	 */
+	EventPool(size_t nEvents = DefaultNumberOfEvents) {
+		this->nEvents = nEvents;
+		events = new SpaceFibreADC::Event[nEvents];
+		waveformSlab = new uint16_t[nEvents * WaveformStrideInSamples + WaveformAlignmentInBytes / sizeof(uint16_t)];
+		//align the first waveform to a cache line
+		uint16_t* alignedSlab = reinterpret_cast<uint16_t*>((reinterpret_cast<uintptr_t>(waveformSlab)
+				+ WaveformAlignmentInBytes - 1) & ~static_cast<uintptr_t>(WaveformAlignmentInBytes - 1));
+		next = new std::atomic<uint32_t>[nEvents];
+		for (size_t i = 0; i < nEvents; i++) {
+			events[i].waveform = alignedSlab + i * WaveformStrideInSamples;
+			next[i] = (i + 1 < nEvents) ? i + 2 : 0;
+		}
+		top = (nEvents != 0) ? 1 : 0;
+		nFreeEvents = nEvents;
+		nHeapAllocatedEvents = 0;
+	}
+
+public:
+	virtual ~EventPool() {
+		delete[] next;
+		delete[] waveformSlab;
+		delete[] events;
+	}
+
+public:
+	/** Takes an Event instance from the pool.
+	 * @return an Event instance whose waveform can hold SpaceFibreADC::MaxWaveformLength samples
+	 */
+	SpaceFibreADC::Event* allocate() {
+		uint64_t oldTop = top.load(std::memory_order_acquire);
+		while (true) {
+			uint64_t index = oldTop & IndexMask;
+			if (index == 0) {
+				//the pool is exhausted
+				SpaceFibreADC::Event* event = new SpaceFibreADC::Event;
+				event->waveform = new uint16_t[SpaceFibreADC::MaxWaveformLength];
+				nHeapAllocatedEvents++;
+				return event;
+			}
+			uint64_t newTop = (((oldTop >> 32) + 1) << 32) | next[index - 1].load(std::memory_order_relaxed);
+			if (top.compare_exchange_weak(oldTop, newTop, std::memory_order_acquire, std::memory_order_acquire)) {
+				nFreeEvents--;
+				return &events[index - 1];
+			}
+		}
+	}
+
+public:
+	/** Returns an Event instance to the pool.
+	 * @param[in] event an Event instance obtained via allocate()
+	 */
+	void free(SpaceFibreADC::Event* event) {
+		if (!isPooledEvent(event)) {
+			delete[] event->waveform;
+			delete event;
+			nHeapAllocatedEvents--;
+			return;
+		}
+		uint64_t index = (event - events) + 1;
+		uint64_t oldTop = top.load(std::memory_order_relaxed);
+		uint64_t newTop;
+		do {
+			next[index - 1].store(oldTop & IndexMask, std::memory_order_relaxed);
+			newTop = (((oldTop >> 32) + 1) << 32) | index;
+		} while (!top.compare_exchange_weak(oldTop, newTop, std::memory_order_release, std::memory_order_relaxed));
+		nFreeEvents++;
+	}
+
+public:
+	/** Returns true if the instance belongs to the slab of this pool.
+	 */
+	bool isPooledEvent(const SpaceFibreADC::Event* event) const {
+		return events <= event && event < events + nEvents;
+	}
+
+public:
+	/** Returns the number of free Event instances in the pool.
+	 */
+	size_t getNFreeEvents() const {
+		return nFreeEvents;
+	}
+
+public:
+	/** Returns the number of instances allocated on the heap because the pool was exhausted
+	 * (and not freed yet).
+	 */
+	size_t getNHeapAllocatedEvents() const {
+		return nHeapAllocatedEvents;
+	}
+
+public:
+	size_t getNEvents() const {
+		return nEvents;
+	}
+};
+
+#endif /* SPACEFIBREADC_EVENTPOOL_HH_ */
@@ -0,0 +1,379 @@
+/*
+ * EventRecorder.hh
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef SPACEFIBREADC_EVENTRECORDER_HH_
+#define SPACEFIBREADC_EVENTRECORDER_HH_
+
+#include "SpaceWireRMAPLibrary/Boards/SpaceFibreADCBoardModules/EventFileFormat.hh"
+#include "SpaceWireRMAPLibrary/SpaceWireR/SpaceWireRRingBuffer.hh"
+#include "CxxUtilities/CxxUtilities.hh"
+#include <atomic>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+/** Records SpaceFibreADC::Event instances to a binary event file (see EventFileFormat).
+ * write() encodes an event into an in-memory block; filled blocks are written to the file
+ * by a writer thread, so the thread which calls write() does not wait for disk I/O
+ * unless all block buffers are waiting to be written.
+ * Blocks are aligned and written with O_DIRECT when the file system supports it,
+ * bypassing the page cache. If the file system accepts O_DIRECT on open() but rejects
+ * direct writes, the writer switches to buffered I/O and retries.
+ * write(), flush() and close() should be called from one thread.
+ *
+ * @code
+ * EventRecorder recorder("run001.sfadc", EventFileFormat::DeltaVarint);
+ * while(running){
+ *   std::vector<SpaceFibreADC::Event*> events = adc->getEvent();
+ *   for (auto event : events) {
+ *     recorder.write(event);
+ *     adc->freeEvent(event);
+ *   }
+ * }
+ * recorder.close();
+ * @endcode
+ */
+class EventRecorder {
+public:
+	static const size_t DefaultBlockSize = 4 * 1024 * 1024;
+	static const size_t DefaultNumberOfBlockBuffers = 4;
+	static constexpr double WaitDurationInMilliSecWhenIdle = 1.0;
+
+private:
+	struct BlockBuffer {
+		uint8_t* data;
+		size_t size; //bytes to be written (multiple of EventFileFormat::Alignment)
+	};
+
+private:
+	class WriterThread: public CxxUtilities::StoppableThread {
+	private:
+		EventRecorder* parent;
+
+	public:
+		WriterThread(EventRecorder* parent) {
+			this->parent = parent;
+		}
+
+	public:
+		void run() {
+			parent->runWriter(this);
+		}
+	};
+
+private:
+	std::string fileName;
+	int fd;
+	std::atomic<bool> isDirectIOUsed;
+	uint32_t compression;
+	size_t blockSize;
+	std::vector<BlockBuffer> blockBuffers;
+	SpaceWireRRingBuffer<BlockBuffer*> freeBlockBuffers; //writer thread -> user
+	SpaceWireRRingBuffer<BlockBuffer*> filledBlockBuffers; //user -> writer thread
+	WriterThread* writerThread;
+
+private:
+	//block being filled by write()
+	BlockBuffer* currentBlock;
+	size_t currentBlockPayloadSize;
+	uint32_t currentBlockNEvents;
+	uint64_t nEvents;
+
+private:
+	std::atomic<bool> writeFailed;
+	std::atomic<size_t> nWrittenBytes;
+	size_t nRecordedBytes;
+	size_t nStalls;
+
+public:
+	/** Constructor. Creates (truncates) the file and starts the writer thread.
+	 * @param[in] fileName output file name
+	 * @param[in] compression waveform encoding (EventFileFormat::Uncompressed or EventFileFormat::DeltaVarint)
+	 * @param[in] blockSize size of a block in bytes (rounded up to EventFileFormat::Alignment)
+	 * @param[in] nBlockBuffers number of block buffers
+	 * @param[in] useDirectIO try O_DIRECT (falls back to buffered I/O if not supported)
+	 */
+	EventRecorder(std::string fileName, uint32_t compression = EventFileFormat::Uncompressed, size_t blockSize =
+			DefaultBlockSize, size_t nBlockBuffers = DefaultNumberOfBlockBuffers, bool useDirectIO = true)
+			throw (EventFileException) :
+			blockBuffers(nBlockBuffers), freeBlockBuffers(nBlockBuffers), filledBlockBuffers(nBlockBuffers) {
+		using namespace std;
+		this->fileName = fileName;
+		this->compression = compression;
+		this->blockSize = EventFileFormat::alignUp(blockSize);
+		this->fd = -1;
+		this->isDirectIOUsed = false;
+#ifdef O_DIRECT
+		if (useDirectIO) {
+			fd = ::open(fileName.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_DIRECT, 0644);
+			isDirectIOUsed = (fd >= 0);
+		}
+#endif
+		if (fd < 0) {
+			fd = ::open(fileName.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+		}
+		if (fd < 0) {
+			cerr << "EventRecorder::EventRecorder(): could not open " << fileName << endl;
+			throw EventFileException(EventFileException::OpenFailed);
+		}
+		for (size_t i = 0; i < blockBuffers.size(); i++) {
+			void* memory = NULL;
+			if (posix_memalign(&memory, EventFileFormat::Alignment, this->blockSize) != 0) {
+				cerr << "EventRecorder::EventRecorder(): could not allocate block buffers" << endl;
+				for (size_t j = 0; j < i; j++) {
+					free(blockBuffers[j].data);
+				}
+				::close(fd);
+				throw EventFileException(EventFileException::OpenFailed);
+			}
+			blockBuffers[i].data = (uint8_t*) memory;
+			blockBuffers[i].size = 0;
+			freeBlockBuffers.push(&blockBuffers[i]);
+		}
+		writeFailed = false;
+		nWrittenBytes = 0;
+		nRecordedBytes = 0;
+		nStalls = 0;
+		nEvents = 0;
+		currentBlock = NULL;
+		writerThread = new WriterThread(this);
+		writerThread->start();
+		writeFileHeader();
+	}
+
+public:
+	virtual ~EventRecorder() {
+		try {
+			close();
+		} catch (...) {
+		}
+		for (size_t i = 0; i < blockBuffers.size(); i++) {
+			free(blockBuffers[i].data);
+		}
+	}
+
+public:
+	/** Appends an event. The event can be freed/reused immediately after this method returns.
+	 */
+	void write(const SpaceFibreADC::Event* event) throw (EventFileException) {
+		size_t maximumRecordSize = sizeof(uint32_t) + sizeof(EventFileRecordHeader)
+				+ EventFileFormat::maximumEncodedWaveformSize(event->nSamples, compression);
+		if (currentBlock != NULL
+				&& sizeof(EventFileBlockHeader) + currentBlockPayloadSize + maximumRecordSize > blockSize) {
+			submitCurrentBlock();
+		}
+		if (currentBlock == NULL) {
+			beginBlock();
+		}
+		if (sizeof(EventFileBlockHeader) + maximumRecordSize > blockSize) {
+			//an event larger than a block cannot be recorded
+			throw EventFileException(EventFileException::WriteFailed);
+		}
+		uint8_t* record = currentBlock->data + sizeof(EventFileBlockHeader) + currentBlockPayloadSize;
+		EventFileRecordHeader header;
+		header.timeTag = event->timeTag;
+		header.triggerCount = event->triggerCount;
+		header.livetime = event->livetime;
+		header.phaMax = event->phaMax;
+		header.nSamples = event->nSamples;
+		header.ch = event->ch;
+		header.reserved[0] = header.reserved[1] = header.reserved[2] = 0;
+		memcpy(record + sizeof(uint32_t), &header, sizeof(header));
+		size_t waveformSize = EventFileFormat::encodeWaveform(event->waveform, event->nSamples, compression,
+				record + sizeof(uint32_t) + sizeof(header));
+		uint32_t recordSize = sizeof(header) + waveformSize;
+		memcpy(record, &recordSize, sizeof(recordSize));
+		currentBlockPayloadSize += sizeof(uint32_t) + recordSize;
+		currentBlockNEvents++;
+		nEvents++;
+		nRecordedBytes += sizeof(uint32_t) + recordSize;
+	}
+
+public:
+	/** Passes the block being filled to the writer thread.
+	 * Every flush() ends a block, so calling this frequently wastes file space for padding.
+	 */
+	void flush() throw (EventFileException) {
+		if (currentBlock != NULL && currentBlockNEvents != 0) {
+			submitCurrentBlock();
+		}
+	}
+
+public:
+	/** Writes all remaining events, stops the writer thread, and closes the file.
+	 */
+	void close() throw (EventFileException) {
+		if (fd < 0) {
+			return;
+		}
+		flush();
+		writerThread->stop();
+		writerThread->waitUntilRunMethodComplets();
+		delete writerThread;
+		writerThread = NULL;
+		//freeBlockBuffers is pushed only by the writer thread while it is running
+		if (currentBlock != NULL) {
+			freeBlockBuffers.push(currentBlock);
+			currentBlock = NULL;
+		}
+		::close(fd);
+		fd = -1;
+		if (writeFailed) {
+			throw EventFileException(EventFileException::WriteFailed);
+		}
+	}
+
+public:
+	std::string getFileName() const {
+		return fileName;
+	}
+
+public:
+	bool isDirectIO() const {
+		return isDirectIOUsed;
+	}
+
+public:
+	/** Returns the number of events passed to write(). */
+	uint64_t getNEvents() const {
+		return nEvents;
+	}
+
+public:
+	/** Returns the number of bytes written to the file (including headers and padding). */
+	size_t getNWrittenBytes() const {
+		return nWrittenBytes;
+	}
+
+public:
+	/** Returns the size of event records passed to the writer (excluding headers and padding). */
+	size_t getNRecordedBytes() const {
+		return nRecordedBytes;
+	}
+
+public:
+	/** Returns the number of times write() waited for the writer thread (disk is slower than the event rate). */
+	size_t getNStalls() const {
+		return nStalls;
+	}
+
+private:
+	void writeFileHeader() {
+		BlockBuffer* block = takeFreeBlock();
+		memset(block->data, 0, EventFileFormat::Alignment);
+		EventFileHeader header;
+		memset(&header, 0, sizeof(header));
+		memcpy(header.magic, EventFileFormat::fileMagic(), sizeof(header.magic));
+		header.version = EventFileFormat::Version;
+		header.headerSize = EventFileFormat::Alignment;
+		header.alignment = EventFileFormat::Alignment;
+		header.compression = compression;
+		header.creationTimeInSec = time(NULL);
+		memcpy(block->data, &header, sizeof(header));
+		block->size = EventFileFormat::Alignment;
+		filledBlockBuffers.push(block);
+	}
+
+private:
+	BlockBuffer* takeFreeBlock() throw (EventFileException) {
+		CxxUtilities::Condition c;
+		BlockBuffer* block;
+		while (!freeBlockBuffers.pop(block)) {
+			if (writeFailed) {
+				throw EventFileException(EventFileException::WriteFailed);
+			}
+			nStalls++;
+			c.wait(WaitDurationInMilliSecWhenIdle);
+		}
+		return block;
+	}
+
+private:
+	void beginBlock() throw (EventFileException) {
+		if (fd < 0) {
+			throw EventFileException(EventFileException::RecorderClosed);
+		}
+		currentBlock = takeFreeBlock();
+		currentBlockPayloadSize = 0;
+		currentBlockNEvents = 0;
+	}
+
+private:
+	void submitCurrentBlock() {
+		EventFileBlockHeader header;
+		header.magic = EventFileFormat::BlockMagic;
+		header.compression = compression;
+		header.nEvents = currentBlockNEvents;
+		header.payloadSize = currentBlockPayloadSize;
+		header.firstEventIndex = nEvents - currentBlockNEvents;
+		header.reserved = 0;
+		memcpy(currentBlock->data, &header, sizeof(header));
+		size_t usedSize = sizeof(header) + currentBlockPayloadSize;
+		currentBlock->size = EventFileFormat::alignUp(usedSize);
+		memset(currentBlock->data + usedSize, 0, currentBlock->size - usedSize);
+		//the ring can hold all buffers, so this never fails
+		filledBlockBuffers.push(currentBlock);
+		currentBlock = NULL;
+	}
+
+private:
+	void runWriter(CxxUtilities::StoppableThread* thread) {
+		using namespace std;
+		CxxUtilities::Condition c;
+		while (true) {
+			BlockBuffer* block;
+			if (!filledBlockBuffers.pop(block)) {
+				//exit only after all submitted blocks are written
+				if (thread->isStopped()) {
+					break;
+				}
+				c.wait(WaitDurationInMilliSecWhenIdle);
+				continue;
+			}
+			size_t offset = 0;
+			while (offset < block->size && !writeFailed) {
+				ssize_t result = ::write(fd, block->data + offset, block->size - offset);
+				if (result < 0) {
+					if (errno == EINTR) {
+						continue;
+					}
+					if (errno == EINVAL && isDirectIOUsed && disableDirectIO()) {
+						continue;
+					}
+					cerr << "EventRecorder: write to " << fileName << " failed (" << strerror(errno) << ")" << endl;
+					writeFailed = true;
+					break;
+				}
+				offset += result;
+			}
+			nWrittenBytes += offset;
+			freeBlockBuffers.push(block);
+		}
+	}
+
+private:
+	/** Clears O_DIRECT of the file so that subsequent writes go through the page cache.
+	 * @return true if O_DIRECT was cleared
+	 */
+	bool disableDirectIO() {
+#ifdef O_DIRECT
+		using namespace std;
+		int flags = fcntl(fd, F_GETFL);
+		if (flags < 0 || fcntl(fd, F_SETFL, flags & ~O_DIRECT) < 0) {
+			return false;
+		}
+		cerr << "EventRecorder: direct write to " << fileName << " was rejected; using buffered I/O" << endl;
+		isDirectIOUsed = false;
+		return true;
+#else
+		return false;
+#endif
+	}
+};
+
+#endif /* SPACEFIBREADC_EVENTRECORDER_HH_ */
@@ -0,0 +1,19 @@
+/*
+ * EventRing.hh
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef SPACEFIBREADC_EVENTRING_HH_
+#define SPACEFIBREADC_EVENTRING_HH_
+
+#include "SpaceWireRMAPLibrary/Boards/SpaceFibreADCBoardModules/Types.hh"
+#include "SpaceWireRMAPLibrary/SpaceWireR/SpaceWireRRingBuffer.hh"
+
+/** Decoded events passed from the decode thread to the user analysis thread.
+ * This is the bounded single-producer/single-consumer ring used by SpaceWire-R.
+ * Only pointers are passed; Event instances are not copied.
+ */
+typedef SpaceWireRRingBuffer<SpaceFibreADC::Event*> EventRing;
+
+#endif /* SPACEFIBREADC_EVENTRING_HH_ */
@@ -0,0 +1,452 @@
+/*
+ * OnlineHistogram.hh
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef SPACEFIBREADC_ONLINEHISTOGRAM_HH_
+#define SPACEFIBREADC_ONLINEHISTOGRAM_HH_
+
+#include "SpaceWireRMAPLibrary/Boards/SpaceFibreADCBoardModules/Types.hh"
+#include "SpaceWireRMAPLibrary/Boards/SpaceFibreADCBoardModules/EventBatch.hh"
+#include "SpaceWireRMAPLibrary/Boards/SpaceFibreADCBoardModules/EventFileFormat.hh"
+#include "CxxUtilities/CxxUtilities.hh"
+#include <atomic>
+#include <fstream>
+#include <time.h>
+
+/** Header of a binary histogram snapshot file (see OnlineHistogramSnapshot::save()).
+ * It is followed by uint64_t arrays in the order of the OnlineHistogramSnapshot members:
+ * nEvents, nOverflowEvents, nOutOfTimeRangeEvents (nChannels entries each),
+ * spectra (nChannels*nPHABins) and eventCounts (nChannels*nTimeBins).
+ * All values are stored in little endian.
+ */
+struct OnlineHistogramSnapshotHeader {
+	char magic[8];
+	uint32_t version;
+	uint32_t nChannels;
+	uint32_t nPHABins;
+	uint32_t nTimeBins;
+	double timeBinWidthInSec;
+	double timeTagClockFrequency;
+	uint64_t firstTimeTag;
+	uint64_t snapshotTimeInSec;
+};
+
+/** Merged content of an OnlineHistogram at a certain time.
+ * Arrays are indexed as [ch * nPHABins + phaMax] and [ch * nTimeBins + timeBin].
+ */
+class OnlineHistogramSnapshot {
+public:
+	static const uint32_t Version = 2;
+	static const uint64_t NoTimeTag = ~0ULL;
+
+public:
+	size_t nPHABins;
+	size_t nTimeBins;
+	double timeBinWidthInSec;
+	double timeTagClockFrequency;
+	uint64_t firstTimeTag; //time tag of time bin 0 (NoTimeTag if no event has been filled)
+	uint64_t snapshotTimeInSec; //UNIX time when the snapshot was taken
+	std::vector<uint64_t> nEvents; //per channel
+	std::vector<uint64_t> nOverflowEvents; //per channel, phaMax >= nPHABins (not in spectra)
+	std::vector<uint64_t> nOutOfTimeRangeEvents; //per channel, not in eventCounts
+	std::vector<uint64_t> spectra; //phaMax spectra
+	std::vector<uint64_t> eventCounts; //number of events in each time bin
+
+public:
+	OnlineHistogramSnapshot(size_t nPHABins = 0, size_t nTimeBins = 0, double timeBinWidthInSec = 1.0,
+			double timeTagClockFrequency = 1.0) {
+		resize(nPHABins, nTimeBins);
+		this->timeBinWidthInSec = timeBinWidthInSec;
+		this->timeTagClockFrequency = timeTagClockFrequency;
+		this->firstTimeTag = NoTimeTag;
+		this->snapshotTimeInSec = 0;
+	}
+
+public:
+	/** Resizes and zero-clears all arrays.
+	 */
+	void resize(size_t nPHABins, size_t nTimeBins) {
+		this->nPHABins = nPHABins;
+		this->nTimeBins = nTimeBins;
+		nEvents.assign(SpaceFibreADC::NumberOfChannels, 0);
+		nOverflowEvents.assign(SpaceFibreADC::NumberOfChannels, 0);
+		nOutOfTimeRangeEvents.assign(SpaceFibreADC::NumberOfChannels, 0);
+		spectra.assign(SpaceFibreADC::NumberOfChannels * nPHABins, 0);
+		eventCounts.assign(SpaceFibreADC::NumberOfChannels * nTimeBins, 0);
+	}
+
+public:
+	/** Returns the phaMax spectrum of a channel (nPHABins entries).
+	 */
+	const uint64_t* getSpectrum(size_t ch) const {
+		return spectra.data() + ch * nPHABins;
+	}
+
+public:
+	/** Returns the event rate of a channel in a time bin in counts/s.
+	 */
+	double getEventRate(size_t ch, size_t timeBin) const {
+		return eventCounts[ch * nTimeBins + timeBin] / timeBinWidthInSec;
+	}
+
+public:
+	/** Returns the number of time bins up to the last bin which contains an event.
+	 */
+	size_t getNFilledTimeBins() const {
+		size_t n = 0;
+		for (size_t ch = 0; ch < SpaceFibreADC::NumberOfChannels; ch++) {
+			for (size_t i = nTimeBins; i > n; i--) {
+				if (eventCounts[ch * nTimeBins + i - 1] != 0) {
+					n = i;
+					break;
+				}
+			}
+		}
+		return n;
+	}
+
+public:
+	/** Saves this snapshot to a binary file.
+	 */
+	void save(std::string fileName) const throw (EventFileException) {
+		std::ofstream ofs(fileName.c_str(), std::ios::binary | std::ios::trunc);
+		if (!ofs) {
+			throw EventFileException(EventFileException::OpenFailed);
+		}
+		OnlineHistogramSnapshotHeader header;
+		memset(&header, 0, sizeof(header));
+		memcpy(header.magic, fileMagic(), sizeof(header.magic));
+		header.version = Version;
+		header.nChannels = SpaceFibreADC::NumberOfChannels;
+		header.nPHABins = nPHABins;
+		header.nTimeBins = nTimeBins;
+		header.timeBinWidthInSec = timeBinWidthInSec;
+		header.timeTagClockFrequency = timeTagClockFrequency;
+		header.firstTimeTag = firstTimeTag;
+		header.snapshotTimeInSec = snapshotTimeInSec;
+		ofs.write((const char*) &header, sizeof(header));
+		const std::vector<uint64_t>* arrays[] = { &nEvents, &nOverflowEvents, &nOutOfTimeRangeEvents, &spectra,
+				&eventCounts };
+		for (auto array : arrays) {
+			ofs.write((const char*) array->data(), array->size() * sizeof(uint64_t));
+		}
+		if (!ofs) {
+			throw EventFileException(EventFileException::WriteFailed);
+		}
+	}
+
+public:
+	/** Loads a snapshot saved by save().
+	 */
+	void load(std::string fileName) throw (EventFileException) {
+		std::ifstream ifs(fileName.c_str(), std::ios::binary);
+		if (!ifs) {
+			throw EventFileException(EventFileException::OpenFailed);
+		}
+		OnlineHistogramSnapshotHeader header;
+		ifs.read((char*) &header, sizeof(header));
+		if (!ifs || memcmp(header.magic, fileMagic(), sizeof(header.magic)) != 0 || header.version != Version
+				|| header.nChannels != SpaceFibreADC::NumberOfChannels) {
+			throw EventFileException(EventFileException::InvalidFormat);
+		}
+		resize(header.nPHABins, header.nTimeBins);
+		timeBinWidthInSec = header.timeBinWidthInSec;
+		timeTagClockFrequency = header.timeTagClockFrequency;
+		firstTimeTag = header.firstTimeTag;
+		snapshotTimeInSec = header.snapshotTimeInSec;
+		std::vector<uint64_t>* arrays[] = { &nEvents, &nOverflowEvents, &nOutOfTimeRangeEvents, &spectra, &eventCounts };
+		for (auto array : arrays) {
+			ifs.read((char*) array->data(), array->size() * sizeof(uint64_t));
+		}
+		if (!ifs) {
+			throw EventFileException(EventFileException::InvalidFormat);
+		}
+	}
+
+public:
+	static const char* fileMagic() {
+		return "SFADCHST";
+	}
+};
+
+/** Lock-free online histogramming of decoded events for quick-look monitoring.
+ * It accumulates per-channel phaMax spectra and event-rate time series
+ * (time bins are counted from the time tag of the first event).
+ * Event data do not carry livetime; use SpaceFibreADCBoard::getLivetime() for it.
+ *
+ * Each thread which fills events uses its own Filler (see createFiller()), so filling
+ * needs neither locks nor atomic read-modify-write instructions.
+ * getSnapshot() merges all fillers and can be called from any thread while events are being filled.
+ * EventDecoder fills events while decoding them (see EventDecoder::setOnlineHistogram()),
+ * so no extra pass over event data is needed.
+ *
+ * @code
+ * OnlineHistogram histogram;
+ * decoder.setOnlineHistogram(&histogram);
+ * ...
+ * OnlineHistogramSnapshot snapshot = histogram.getSnapshot();
+ * snapshot.save("quicklook.hist");
+ * @endcode
+ */
+class OnlineHistogram {
+public:
+	static const size_t DefaultNumberOfPHABins = 16384;
+	static const size_t DefaultNumberOfTimeBins = 3600;
+	static constexpr double DefaultTimeBinWidthInSec = 1.0;
+	static constexpr double DefaultTimeTagClockFrequency = 50e6; //Hz
+
+public:
+	/** Per-thread histogram. Only the owner thread writes to the counters,
+	 * so they are updated with relaxed loads/stores, and read concurrently by getSnapshot().
+	 */
+	class Filler {
+	private:
+		OnlineHistogram* parent;
+		size_t nPHABins;
+		size_t nTimeBins;
+		uint64_t timeTagsPerTimeBin;
+		std::vector<std::atomic<uint64_t> > nEvents;
+		std::vector<std::atomic<uint64_t> > nOverflowEvents;
+		std::vector<std::atomic<uint64_t> > nOutOfTimeRangeEvents;
+		std::vector<std::atomic<uint64_t> > spectra;
+		std::vector<std::atomic<uint64_t> > eventCounts;
+		uint32_t filledGeneration;
+		bool isInUse; //false after released by releaseFiller() (protected by OnlineHistogram::fillersMutex)
+		std::atomic<uint32_t> generation; //published after counters are cleared for a new generation
+
+	private:
+		friend class OnlineHistogram;
+
+	private:
+		Filler(OnlineHistogram* parent) :
+				nEvents(SpaceFibreADC::NumberOfChannels), nOverflowEvents(SpaceFibreADC::NumberOfChannels), nOutOfTimeRangeEvents(
+						SpaceFibreADC::NumberOfChannels), spectra(SpaceFibreADC::NumberOfChannels * parent->nPHABins), eventCounts(
+						SpaceFibreADC::NumberOfChannels * parent->nTimeBins) {
+			this->parent = parent;
+			this->nPHABins = parent->nPHABins;
+			this->nTimeBins = parent->nTimeBins;
+			this->timeTagsPerTimeBin = parent->timeTagsPerTimeBin;
+			isInUse = true;
+			filledGeneration = parent->generation.load(std::memory_order_acquire);
+			clearCounters();
+			generation.store(filledGeneration, std::memory_order_release);
+		}
+
+	public:
+		/** Fills an event.
+		 */
+		inline void fill(uint8_t ch, uint64_t timeTag, uint16_t phaMax) {
+			uint32_t currentGeneration = parent->generation.load(std::memory_order_acquire);
+			if (currentGeneration != filledGeneration) {
+				//reset() was called; counters are cleared by this (owner) thread
+				clearCounters();
+				filledGeneration = currentGeneration;
+				generation.store(currentGeneration, std::memory_order_release);
+			}
+			if (ch >= SpaceFibreADC::NumberOfChannels) {
+				return;
+			}
+			increment(nEvents[ch]);
+			if (phaMax < nPHABins) {
+				increment(spectra[ch * nPHABins + phaMax]);
+			} else {
+				increment(nOverflowEvents[ch]);
+			}
+			uint64_t origin = parent->getTimeOrigin(timeTag);
+			uint64_t timeBin = (timeTag - origin) / timeTagsPerTimeBin;
+			if (timeTag < origin || timeBin >= nTimeBins) {
+				increment(nOutOfTimeRangeEvents[ch]);
+				return;
+			}
+			increment(eventCounts[ch * nTimeBins + timeBin]);
+		}
+
+	public:
+		inline void fill(const SpaceFibreADC::Event* event) {
+			fill(event->ch, event->timeTag, event->phaMax);
+		}
+
+	public:
+		void fill(const EventBatch& batch) {
+			for (size_t i = 0; i < batch.size(); i++) {
+				fill(batch.ch[i], batch.timeTag[i], batch.phaMax[i]);
+			}
+		}
+
+	public:
+		/** Returns the histogram which owns this filler.
+		 */
+		OnlineHistogram* getHistogram() const {
+			return parent;
+		}
+
+	private:
+		static inline void increment(std::atomic<uint64_t>& counter) {
+			counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+		}
+
+	private:
+		void clearCounters() {
+			std::vector<std::atomic<uint64_t> >* arrays[] = { &nEvents, &nOverflowEvents, &nOutOfTimeRangeEvents,
+					&spectra, &eventCounts };
+			for (auto array : arrays) {
+				for (size_t i = 0; i < array->size(); i++) {
+					(*array)[i].store(0, std::memory_order_relaxed);
+				}
+			}
+		}
+
+	private:
+		/** Adds counters to a snapshot (called by OnlineHistogram::getSnapshot()).
+		 * @return false if this filler has not filled any event since the last reset()
+		 */
+		bool addTo(OnlineHistogramSnapshot& snapshot, uint32_t currentGeneration) const {
+			if (generation.load(std::memory_order_acquire) != currentGeneration) {
+				return false;
+			}
+			for (size_t i = 0; i < SpaceFibreADC::NumberOfChannels; i++) {
+				snapshot.nEvents[i] += nEvents[i].load(std::memory_order_relaxed);
+				snapshot.nOverflowEvents[i] += nOverflowEvents[i].load(std::memory_order_relaxed);
+				snapshot.nOutOfTimeRangeEvents[i] += nOutOfTimeRangeEvents[i].load(std::memory_order_relaxed);
+			}
+			for (size_t i = 0; i < spectra.size(); i++) {
+				snapshot.spectra[i] += spectra[i].load(std::memory_order_relaxed);
+			}
+			for (size_t i = 0; i < eventCounts.size(); i++) {
+				snapshot.eventCounts[i] += eventCounts[i].load(std::memory_order_relaxed);
+			}
+			return true;
+		}
+	};
+
+private:
+	size_t nPHABins;
+	size_t nTimeBins;
+	double timeBinWidthInSec;
+	double timeTagClockFrequency;
+	uint64_t timeTagsPerTimeBin;
+	std::atomic<uint32_t> generation;
+	std::atomic<uint64_t> timeOrigin;
+	std::vector<Filler*> fillers;
+	CxxUtilities::Mutex fillersMutex; //protects only the list of fillers
+
+public:
+	/** Constructor.
+	 * @param[in] nPHABins number of phaMax bins (bin width is 1 ADC channel)
+	 * @param[in] nTimeBins number of time bins of the event-rate time series
+	 * @param[in] timeBinWidthInSec width of a time bin in seconds
+	 * @param[in] timeTagClockFrequency frequency of the time tag counter in Hz
+	 */
+	OnlineHistogram(size_t nPHABins = DefaultNumberOfPHABins, size_t nTimeBins = DefaultNumberOfTimeBins,
+			double timeBinWidthInSec = DefaultTimeBinWidthInSec, double timeTagClockFrequency =
+					DefaultTimeTagClockFrequency) {
+		this->nPHABins = nPHABins;
+		this->nTimeBins = nTimeBins;
+		this->timeBinWidthInSec = timeBinWidthInSec;
+		this->timeTagClockFrequency = timeTagClockFrequency;
+		this->timeTagsPerTimeBin = static_cast<uint64_t>(timeBinWidthInSec * timeTagClockFrequency);
+		if (timeTagsPerTimeBin == 0) {
+			timeTagsPerTimeBin = 1;
+		}
+		generation = 0;
+		timeOrigin = OnlineHistogramSnapshot::NoTimeTag;
+	}
+
+public:
+	/** Destructor. Fillers created by this instance are deleted.
+	 */
+	virtual ~OnlineHistogram() {
+		for (size_t i = 0; i < fillers.size(); i++) {
+			delete fillers[i];
+		}
+	}
+
+public:
+	/** Returns a Filler for the calling thread. A filler released by releaseFiller()
+	 * is reused if any, otherwise a new one is created.
+	 * A Filler should be used by one thread at a time, and is owned by this instance.
+	 */
+	Filler* createFiller() {
+		fillersMutex.lock();
+		for (size_t i = 0; i < fillers.size(); i++) {
+			if (!fillers[i]->isInUse) {
+				fillers[i]->isInUse = true;
+				fillersMutex.unlock();
+				return fillers[i];
+			}
+		}
+		Filler* filler = new Filler(this);
+		fillers.push_back(filler);
+		fillersMutex.unlock();
+		return filler;
+	}
+
+public:
+	/** Returns a filler which is no longer used by the caller, so that createFiller() can reuse it.
+	 * Events filled by it remain in snapshots.
+	 */
+	void releaseFiller(Filler* filler) {
+		fillersMutex.lock();
+		filler->isInUse = false;
+		fillersMutex.unlock();
+	}
+
+public:
+	/** Merges all fillers. This can be called from any thread while events are being filled;
+	 * events filled concurrently may or may not be included.
+	 */
+	OnlineHistogramSnapshot getSnapshot() {
+		OnlineHistogramSnapshot snapshot(nPHABins, nTimeBins, timeBinWidthInSec, timeTagClockFrequency);
+		uint32_t currentGeneration = generation.load(std::memory_order_acquire);
+		snapshot.firstTimeTag = timeOrigin.load(std::memory_order_acquire);
+		snapshot.snapshotTimeInSec = time(NULL);
+		fillersMutex.lock();
+		for (size_t i = 0; i < fillers.size(); i++) {
+			fillers[i]->addTo(snapshot, currentGeneration);
+		}
+		fillersMutex.unlock();
+		return snapshot;
+	}
+
+public:
+	/** Clears all histograms. Each filler clears its counters when it fills the next event,
+	 * and fillers which have not been cleared yet are excluded from snapshots.
+	 * The time origin is set again by the next event.
+	 */
+	void reset() {
+		timeOrigin.store(OnlineHistogramSnapshot::NoTimeTag, std::memory_order_release);
+		generation.fetch_add(1, std::memory_order_acq_rel);
+	}
+
+public:
+	size_t getNPHABins() const {
+		return nPHABins;
+	}
+
+public:
+	size_t getNTimeBins() const {
+		return nTimeBins;
+	}
+
+public:
+	double getTimeBinWidthInSec() const {
+		return timeBinWidthInSec;
+	}
+
+private:
+	/** Returns the time tag of time bin 0; the first event sets it.
+	 */
+	inline uint64_t getTimeOrigin(uint64_t timeTag) {
+		uint64_t origin = timeOrigin.load(std::memory_order_acquire);
+		if (origin == OnlineHistogramSnapshot::NoTimeTag) {
+			if (timeOrigin.compare_exchange_strong(origin, timeTag, std::memory_order_acq_rel)) {
+				return timeTag;
+			}
+		}
+		return origin;
+	}
+};
+
+#endif /* SPACEFIBREADC_ONLINEHISTOGRAM_HH_ */
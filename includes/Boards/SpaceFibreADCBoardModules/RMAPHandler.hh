@@ -32,10 +32,28 @@ protected:
 	double timeOutDuration;
 	int maxNTrials;
 	bool useDraftECRC = false;
+	bool useReadModifyWrite = false;
 	bool _isConnectedToSpWGbE;
+	size_t rmapEngineGeneration = 0; //incremented when rmapEngine is created or deleted
 
 public:
 	static constexpr double DefaultTimeOut = 1000; //ms
+	static const size_t NumberOfPipelinedWrites = 4;
+	static constexpr double PipelinedWritePollingIntervalInMilliSec = 0.05;
+
+public:
+	/** One register write passed to write(RMAPTargetNode*, const std::vector<WriteRequest>&). */
+	struct WriteRequest {
+		uint32_t address;
+		std::vector<uint8_t> data;
+	};
+
+protected:
+	//initiators used by pipelined writes (created on demand)
+	std::vector<RMAPInitiator*> pipelinedWriteInitiators;
+	//protects pipelinedWriteInitiators; each initiator can have only one transaction in flight,
+	//so pipelined writes from different threads are serialized
+	CxxUtilities::Mutex pipelinedWriteMutex;
 
 public:
 	RMAPHandler(std::string ipAddress, uint32_t tcpPortNumber = 10030,
@@ -96,6 +114,7 @@ public:
 
 		//start RMAPEngine
 		rmapEngine = new RMAPEngine(spwif);
+		rmapEngineGeneration++;
 		if (useDraftECRC) {
 			cout << "RMAPHandler::connectoToSpaceWireToGigabitEther() setting DraftE CRC mode to RMAPEngine" << endl;
 			rmapEngine->setUseDraftECRC(true);
@@ -135,12 +154,19 @@ public:
 		rmapEngine->stop();
 
 		cout << "RMAPHandler::disconnectSpWGbE(): Deleting instances" << endl;
+		pipelinedWriteMutex.lock();
+		for (size_t i = 0; i < pipelinedWriteInitiators.size(); i++) {
+			delete pipelinedWriteInitiators[i];
+		}
+		pipelinedWriteInitiators.clear();
+		pipelinedWriteMutex.unlock();
 		delete rmapEngine;
 		delete rmapInitiator;
 		delete spwif;
 
 		spwif = NULL;
 		rmapEngine = NULL;
+		rmapEngineGeneration++;
 		rmapInitiator = NULL;
 		cout << "RMAPHandler::disconnectSpWGbE(): Completed" << endl;
 	}
@@ -166,6 +192,28 @@ public:
 		return rmapInitiator;
 	}
 
+public:
+	/** Creates an additional RMAPInitiator which shares the RMAPEngine with getRMAPInitiator().
+	 * Each RMAPInitiator can have one non-blocking transaction in flight, so this is used
+	 * to keep multiple transactions in flight. The returned instance should be deleted by the caller.
+	 * It refers to the current RMAPEngine, which is deleted by disconnectSpWGbE(), so it should not be
+	 * used once getRMAPEngineGeneration() has changed (deleting it is still safe).
+	 * @return a new RMAPInitiator configured in the same way as getRMAPInitiator(), or NULL if not connected
+	 */
+	RMAPInitiator* createRMAPInitiator() {
+		if (rmapEngine == NULL) {
+			return NULL;
+		}
+		RMAPInitiator* initiator = new RMAPInitiator(rmapEngine);
+		initiator->setInitiatorLogicalAddress(0xFE);
+		initiator->setVerifyMode(true);
+		initiator->setReplyMode(true);
+		if (useDraftECRC) {
+			initiator->setUseDraftECRC(true);
+		}
+		return initiator;
+	}
+
 public:
 	void setDraftECRC(bool useECRC = true) {
 		useDraftECRC = useECRC;
@@ -275,6 +323,23 @@ public:
 		}
 	}
 
+public:
+	/** Reads a memory object referred to by a handle (see RMAPTargetNode::getMemoryObjectHandle()).
+	 * The address and length are resolved without ID lookup, and the read is retried as read() with an address.
+	 */
+	virtual void read(RMAPTargetNode* rmapTargetNode, RMAPMemoryObjectHandle memoryObjectHandle, uint8_t *buffer) {
+		RMAPMemoryObject* memoryObject;
+		try {
+			memoryObject = rmapTargetNode->getMemoryObject(memoryObjectHandle);
+		} catch (...) {
+			throw RMAPHandlerException(RMAPHandlerException::LowerException);
+		}
+		if (!memoryObject->isReadable()) {
+			throw RMAPHandlerException(RMAPHandlerException::LowerException);
+		}
+		read(rmapTargetNode, memoryObject->getAddress(), memoryObject->getLength(), buffer);
+	}
+
 public:
 	virtual void write(std::string rmapTargetNodeID, uint32_t memoryAddress, uint8_t *data, uint32_t length) {
 		RMAPTargetNode* targetNode;
@@ -354,6 +419,122 @@ public:
 		}
 	}
 
+public:
+	/** Writes a memory object referred to by a handle (see RMAPTargetNode::getMemoryObjectHandle()).
+	 */
+	virtual void write(RMAPTargetNode *rmapTargetNode, RMAPMemoryObjectHandle memoryObjectHandle, uint8_t* data) {
+		RMAPMemoryObject* memoryObject;
+		try {
+			memoryObject = rmapTargetNode->getMemoryObject(memoryObjectHandle);
+		} catch (...) {
+			throw RMAPHandlerException(RMAPHandlerException::LowerException);
+		}
+		if (!memoryObject->isWritable()) {
+			throw RMAPHandlerException(RMAPHandlerException::LowerException);
+		}
+		write(rmapTargetNode, memoryObject->getAddress(), data, memoryObject->getLength());
+	}
+
+public:
+	/** Writes multiple registers keeping up to NumberOfPipelinedWrites transactions in flight,
+	 * instead of waiting for the reply of each write before sending the next one.
+	 * Commands are sent in the order of requests. Writes which failed in the pipeline
+	 * are retried one by one with write().
+	 * Pipelined writes called from multiple threads are executed one at a time.
+	 * @param[in] requests addresses and data to be written
+	 */
+	virtual void write(RMAPTargetNode* rmapTargetNode, const std::vector<WriteRequest>& requests) {
+		using namespace std;
+		if (rmapInitiator == NULL || requests.size() == 0) {
+			return;
+		}
+		pipelinedWriteMutex.lock();
+		while (pipelinedWriteInitiators.size() < NumberOfPipelinedWrites) {
+			RMAPInitiator* initiator = createRMAPInitiator();
+			if (initiator == NULL) {
+				break;
+			}
+			pipelinedWriteInitiators.push_back(initiator);
+		}
+		const size_t nInitiators = pipelinedWriteInitiators.size();
+		std::vector<bool> completed(requests.size(), false);
+		size_t nIssued = 0;
+		size_t nCompleted = 0;
+		try {
+			while (nCompleted < requests.size()) {
+				while (nIssued < requests.size() && nIssued - nCompleted < nInitiators) {
+					pipelinedWriteInitiators[nIssued % nInitiators]->nonblockingWrite(rmapTargetNode,
+							requests[nIssued].address, const_cast<uint8_t*>(requests[nIssued].data.data()),
+							requests[nIssued].data.size());
+					nIssued++;
+				}
+				RMAPInitiator* initiator = pipelinedWriteInitiators[nCompleted % nInitiators];
+				CxxUtilities::Condition c;
+				double waitedDuration = 0;
+				while (!initiator->isNonblockingWriteCompleted()) {
+					if (waitedDuration >= timeOutDuration) {
+						throw RMAPInitiatorException(RMAPInitiatorException::Timeout);
+					}
+					c.wait(PipelinedWritePollingIntervalInMilliSec);
+					waitedDuration += PipelinedWritePollingIntervalInMilliSec;
+				}
+				try {
+					initiator->checkNonblockingWriteReply();
+					completed[nCompleted] = true;
+				} catch (RMAPReplyException& e) {
+					cerr << "RMAPHandler::write(): RMAPReplyException " << e.toString() << endl;
+				}
+				nCompleted++;
+			}
+		} catch (CxxUtilities::Exception& e) {
+			cerr << "RMAPHandler::write(): pipelined write failed (" << e.toString() << "); retrying one by one" << endl;
+			for (size_t i = nCompleted; i < nIssued; i++) {
+				pipelinedWriteInitiators[i % nInitiators]->cancelNonblockingWrite();
+			}
+		} catch (...) {
+			for (size_t i = nCompleted; i < nIssued; i++) {
+				pipelinedWriteInitiators[i % nInitiators]->cancelNonblockingWrite();
+			}
+			pipelinedWriteMutex.unlock();
+			throw;
+		}
+		pipelinedWriteMutex.unlock();
+		for (size_t i = 0; i < requests.size(); i++) {
+			if (!completed[i]) {
+				write(rmapTargetNode, requests[i].address, const_cast<uint8_t*>(requests[i].data.data()),
+						requests[i].data.size());
+			}
+		}
+	}
+
+public:
+	/** Read-modify-writes a register with a single RMAP transaction.
+	 * Unlike read()/write(), this is not retried on timeout because an RMW command
+	 * may have been executed even if its reply was lost.
+	 * @param[in] data data to be written
+	 * @param[in] mask bits to be modified
+	 * @param[in] length number of bytes (1, 2, or 4)
+	 * @param[out] readData data before the modification
+	 * @throw RMAPReplyException if the target replied an error (e.g. the target does not support RMW)
+	 */
+	virtual void readModifyWrite(RMAPTargetNode* rmapTargetNode, uint32_t memoryAddress, uint8_t* data, uint8_t* mask,
+			uint32_t length, uint8_t* readData) {
+		using namespace std;
+		if (rmapInitiator == NULL) {
+			throw RMAPHandlerException(RMAPHandlerException::CouldNotConnect);
+		}
+		try {
+			rmapInitiator->readModifyWrite(rmapTargetNode, memoryAddress, data, mask, length, readData, timeOutDuration);
+		} catch (RMAPInitiatorException& e) {
+			cerr << "RMAPHandler::readModifyWrite(): RMAPInitiatorException::" << e.toString() << endl;
+			if (e.getStatus() == RMAPInitiatorException::Timeout) {
+				throw RMAPHandlerException(RMAPHandlerException::TimeOut);
+			} else {
+				throw RMAPHandlerException(RMAPHandlerException::LowerException);
+			}
+		}
+	}
+
 public:
 	RMAPTargetNode* getRMAPTargetNode(std::string rmapTargetNodeID) {
 		RMAPTargetNode* targetNode;
@@ -378,6 +559,81 @@ public:
 		return (uint16_t) (readData[0] * 0x100 + readData[1]);
 	}
 
+public:
+	/** Read-modify-writes a register with readModifyWrite() if RMW is used (see isReadModifyWriteUsed()).
+	 * If the target rejects the RMW or the RMW fails, RMW is disabled for this handler, so that
+	 * the caller and the following calls use another way (e.g. read and write under a semaphore).
+	 * @return true if the RMW was executed, false if RMW is not used
+	 */
+	virtual bool tryReadModifyWrite(RMAPTargetNode* rmapTargetNode, uint32_t memoryAddress, uint8_t* data,
+			uint8_t* mask, uint32_t length, uint8_t* readData) {
+		using namespace std;
+		if (!useReadModifyWrite) {
+			return false;
+		}
+		try {
+			this->readModifyWrite(rmapTargetNode, memoryAddress, data, mask, length, readData);
+			return true;
+		} catch (RMAPReplyException& e) {
+			cerr << "RMAPHandler::tryReadModifyWrite(): RMW was rejected (" << e.toString() << "); RMW is disabled"
+					<< endl;
+		} catch (RMAPHandlerException& e) {
+			cerr << "RMAPHandler::tryReadModifyWrite(): RMW failed; RMW is disabled" << endl;
+		}
+		useReadModifyWrite = false;
+		return false;
+	}
+
+public:
+	/** Modifies the bits of a 16-bit register selected by mask with a single RMAP RMW transaction,
+	 * which is atomic at the target. The register becomes (value & mask) | (previous value & ~mask).
+	 * @param[out] previousValue register value before the modification
+	 * @return true if the register was modified, false if RMW is not used (see tryReadModifyWrite())
+	 */
+	bool trySetRegisterBits(uint32_t address, uint16_t value, uint16_t mask, uint16_t& previousValue) {
+		uint8_t writeData[2] = { static_cast<uint8_t>(value / 0x100), static_cast<uint8_t>(value % 0x100) };
+		uint8_t maskData[2] = { static_cast<uint8_t>(mask / 0x100), static_cast<uint8_t>(mask % 0x100) };
+		uint8_t readData[2];
+		if (!tryReadModifyWrite(adcRMAPTargetNode, address, writeData, maskData, 2, readData)) {
+			return false;
+		}
+		previousValue = (uint16_t) (readData[0] * 0x100 + readData[1]);
+		return true;
+	}
+
+public:
+	/** Modifies the bits of a 16-bit register selected by mask, and returns the register value
+	 * before the modification. trySetRegisterBits() is used if RMW is used; otherwise
+	 * the register is read and then written (two transactions, not atomic, so the caller
+	 * should hold a semaphore if other initiators may modify the register).
+	 */
+	virtual uint16_t setRegisterBits(uint32_t address, uint16_t value, uint16_t mask) {
+		uint16_t previousValue;
+		if (trySetRegisterBits(address, value, mask, previousValue)) {
+			return previousValue;
+		}
+		previousValue = getRegister(address);
+		setRegister(address, (value & mask) | (previousValue & ~mask));
+		return previousValue;
+	}
+
+public:
+	/** Returns true if RMAP RMW is used. RMW is not used unless enabled with setUseReadModifyWrite(),
+	 * and is disabled again when it fails.
+	 * This is the only switch of RMW for this handler; SemaphoreRegister also follows it.
+	 */
+	bool isReadModifyWriteUsed() {
+		return useReadModifyWrite;
+	}
+
+public:
+	/** Enables/disables RMAP RMW (see tryReadModifyWrite()). RMW is disabled by default,
+	 * because not all targets support it; enable it only for targets which implement RMAP RMW.
+	 */
+	void setUseReadModifyWrite(bool useReadModifyWrite) {
+		this->useReadModifyWrite = useReadModifyWrite;
+	}
+
 	/*
 	 public:
 	 RMAPMemoryObject* getMemoryObject(std::string rmapTargetNodeID, std::string memoryObjectID) {
@@ -390,6 +646,14 @@ public:
 		return rmapEngine;
 	}
 
+public:
+	/** Returns a number which changes whenever the RMAPEngine is created (connectoToSpaceWireToGigabitEther())
+	 * or deleted (disconnectSpWGbE()). Users of createRMAPInitiator() re-create their instances when it changes.
+	 */
+	size_t getRMAPEngineGeneration() const {
+		return rmapEngineGeneration;
+	}
+
 public:
 	class RMAPHandlerException {
 	public:
@@ -44,41 +44,72 @@ public:
 		 */
 	}
 
+public:
+	static constexpr double InitialBackoffDurationInMilliSec = 0.1;
+	static constexpr double MaximumBackoffDurationInMilliSec = 100;
+
+private:
+	/** Doubles a backoff duration up to MaximumBackoffDurationInMilliSec.
+	 * (The constant is not passed to std::min() by reference, so that it needs no out-of-class definition.)
+	 */
+	static double nextBackoffDuration(double backoffDuration) {
+		backoffDuration *= 2;
+		return (backoffDuration < MaximumBackoffDurationInMilliSec) ? backoffDuration : MaximumBackoffDurationInMilliSec;
+	}
+
 private:
 	CxxUtilities::Condition condition;
+	bool useTestAndSet = false;
+
+public:
+	/** Tries to get the semaphore once.
+	 * By default, 0xFFFF is written and read back, and the semaphore is obtained if the read-back
+	 * value is not zero (the protocol of the semaphore logic in the FPGA).
+	 * If test-and-set is enabled by setUseTestAndSet(), the semaphore is requested with a single
+	 * RMAP read-modify-write command instead (write 0xFFFF, and the semaphore is obtained
+	 * if the value before the RMW was 0x0000). This is valid only for targets whose semaphore register
+	 * is a plain register. If RMW is not used by the RMAPHandler (e.g. the target rejected RMW;
+	 * see RMAPHandler::tryReadModifyWrite()), write and read-back is used.
+	 * @return true if the semaphore was obtained
+	 */
+	bool tryRequest() {
+		using namespace std;
+		uint8_t previousValue[2];
+		if (useTestAndSet && readModifyWrite(0xff, previousValue)) {
+			if (Debug::semaphore()) {
+				cout << "Semaphore::tryRequest(): semaphore value before RMW = " << (uint32_t) previousValue[0]
+						<< (uint32_t) previousValue[1] << endl;
+			}
+			return previousValue[0] == 0x00 && previousValue[1] == 0x00;
+		}
+		vector<uint8_t> writeData = { 0xff, 0xff };
+		rmaphandler->write(adcboxRMAPNode, address, &writeData[0], 2);
+		vector<uint8_t> readData(2);
+		rmaphandler->read(adcboxRMAPNode, address, 2, &readData[0]);
+		if (Debug::semaphore()) {
+			cout << "Semaphore::tryRequest(): semaphore value = " << (uint32_t) readData[0] << (uint32_t) readData[1]
+					<< endl;
+		}
+		return readData[0] != 0x00;
+	}
 
 public:
 	/** Requests the semaphore. This method will wait for
 	 * infinitely until it successfully gets the semaphore.
+	 * The interval between trials starts from InitialBackoffDurationInMilliSec
+	 * and doubles up to MaximumBackoffDurationInMilliSec.
 	 */
 	void request() {
 		using namespace std;
 		if (Debug::semaphore()) {
 			cout << "Semaphore::request(): request semaphore(0x" << hex << setw(8) << setfill('0') << address << ")..."
-					<< endl;
+					<< endl << dec;
+		}
+		double backoffDuration = InitialBackoffDurationInMilliSec;
+		while (!tryRequest()) {
+			condition.wait(backoffDuration);
+			backoffDuration = nextBackoffDuration(backoffDuration);
 		}
-
-		bool flag = true;
-		do {
-			if (Debug::semaphore()) {
-				cout << "Semaphore::request(): trying to get semaphore" << endl;
-			}
-			vector<uint8_t> writeData = { 0xff, 0xff };
-			rmaphandler->write(adcboxRMAPNode, address, &writeData[0], 2);
-
-			vector<uint8_t> readData(2);
-			rmaphandler->read(adcboxRMAPNode, address, 2, &readData[0]);
-			if (Debug::semaphore()) {
-				cout << "Semaphore::request(): semaphore value = " << (uint32_t) readData[0] << (uint32_t) readData[1] << endl;
-			}
-			if (readData[0] != 0x00) {
-				//exit from this loop
-				flag = false;
-			} else {
-				condition.wait(100); //wait 100ms
-			}
-		} while (flag);
-
 		if (Debug::semaphore()) {
 			cout << "Semaphore::request(): got semaphore" << endl;
 		}
@@ -88,32 +119,133 @@ public:
 	 */
 	void release() {
 		using namespace std;
-		bool flag = true;
-		do {
+		if (Debug::semaphore()) {
+			cout << "Semaphore::release(): release semaphore(" << hex << setw(4) << setfill('0') << address << ")..."
+					<< endl << dec;
+		}
+		uint8_t previousValue[2];
+		if (useTestAndSet && readModifyWrite(0x00, previousValue)) {
 			if (Debug::semaphore()) {
-				cout << "Semaphore::release(): release semaphore(" << hex << setw(4) << setfill('0') << address << ")..."
-						<< endl;
+				cout << "Semaphore::release(): released" << endl;
 			}
+			return;
+		}
+		double backoffDuration = InitialBackoffDurationInMilliSec;
+		while (true) {
 			vector<uint8_t> writeData = { 0x00, 0x00 };
 			rmaphandler->write(adcboxRMAPNode, address, &writeData[0], 2);
-
 			vector<uint8_t> readData(2);
 			rmaphandler->read(adcboxRMAPNode, address, 2, &readData[0]);
 			if (Debug::semaphore()) {
 				cout << "Semaphore::release(): semaphore value = " << (uint32_t) readData[0] << (uint32_t) readData[1] << endl;
 			}
 			if (readData[0] != 0xFF) {
-				//exit from this loop
-				flag = false;
-			} else {
-				condition.wait(100); //wait 100ms
+				break;
 			}
-		} while (flag);
-
+			condition.wait(backoffDuration);
+			backoffDuration = nextBackoffDuration(backoffDuration);
+		}
 		if (Debug::semaphore()) {
 			cout << "Semaphore::release(): released" << endl;
 		}
 	}
+
+private:
+	/** Writes a value to both bytes of the semaphore register with RMAP RMW.
+	 * @param[out] previousValue register value before the RMW
+	 * @return false if RMW is not used by the RMAPHandler, so that the caller uses write and read-back
+	 */
+	bool readModifyWrite(uint8_t value, uint8_t previousValue[2]) {
+		uint8_t data[2] = { value, value };
+		uint8_t mask[2] = { 0xff, 0xff };
+		return rmaphandler->tryReadModifyWrite(adcboxRMAPNode, address, data, mask, 2, previousValue);
+	}
+
+public:
+	/** Selects how the semaphore is requested/released.
+	 * @param[in] useTestAndSet true to use RMAP RMW test-and-set (only for targets whose semaphore
+	 * register is a plain register), false to use write and read-back (default)
+	 */
+	void setUseTestAndSet(bool useTestAndSet) {
+		this->useTestAndSet = useTestAndSet;
+	}
+
+public:
+	/** Returns true if the semaphore is requested with RMAP RMW test-and-set.
+	 */
+	bool isTestAndSetUsed() {
+		return useTestAndSet && rmaphandler->isReadModifyWriteUsed();
+	}
+
+public:
+	/** Holds the semaphore during its lifetime (requested in the constructor and
+	 * released in the destructor). Register writes queued via write() are sent
+	 * pipelined by commit() (or by the destructor before the semaphore is released),
+	 * instead of one round trip per register.
+	 * @code
+	 * {
+	 *   SemaphoreRegister::CriticalSection criticalSection(semaphore);
+	 *   criticalSection.write(AddressOf_RegisterA, valueA);
+	 *   criticalSection.write(AddressOf_RegisterB, valueB);
+	 *   criticalSection.commit(); //optional; errors are reported here
+	 * } //semaphore released
+	 * @endcode
+	 */
+	class CriticalSection {
+	private:
+		SemaphoreRegister* semaphore;
+		std::vector<RMAPHandler::WriteRequest> writeRequests;
+
+	public:
+		CriticalSection(SemaphoreRegister* semaphore) {
+			this->semaphore = semaphore;
+			semaphore->request();
+		}
+
+	public:
+		~CriticalSection() {
+			try {
+				commit();
+			} catch (...) {
+				std::cerr << "SemaphoreRegister::CriticalSection: writes could not be committed" << std::endl;
+			}
+			try {
+				semaphore->release();
+			} catch (...) {
+				std::cerr << "SemaphoreRegister::CriticalSection: semaphore could not be released" << std::endl;
+			}
+		}
+
+	public:
+		/** Queues a write.
+		 */
+		void write(uint32_t address, const uint8_t* data, size_t length) {
+			RMAPHandler::WriteRequest request;
+			request.address = address;
+			request.data.assign(data, data + length);
+			writeRequests.push_back(request);
+		}
+
+	public:
+		/** Queues a 16-bit register write (in the same byte order as RMAPHandler::setRegister()).
+		 */
+		void write(uint32_t address, uint16_t value) {
+			uint8_t data[2] = { static_cast<uint8_t>(value / 0x100), static_cast<uint8_t>(value % 0x100) };
+			write(address, data, 2);
+		}
+
+	public:
+		/** Sends queued writes while holding the semaphore.
+		 */
+		void commit() {
+			if (writeRequests.size() == 0) {
+				return;
+			}
+			std::vector<RMAPHandler::WriteRequest> requests;
+			requests.swap(writeRequests);
+			semaphore->rmaphandler->write(semaphore->adcboxRMAPNode, requests);
+		}
+	};
 };
 
 #endif /* SEMAPHOREREGISTER_HH_ */
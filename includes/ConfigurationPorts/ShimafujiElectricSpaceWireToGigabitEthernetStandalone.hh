@@ -44,13 +44,25 @@ public:
 	static const size_t MaximumPortNumber = 9;
 	static constexpr double MaximumLinkFrequency = 200;
 
+public:
+	/** Link control/status register of port 0 (that of port n is at Address + n * RegisterStride). */
+	typedef RMAPRegister<0x0000, uint32_t, RMAPMemoryObject::Readable | RMAPMemoryObject::Writable,
+			RMAPRegisterEndianness::LittleEndian> LinkControlStatusRegister;
+	typedef RMAPRegisterField<LinkControlStatusRegister, 4, 1, bool> LinkConnectedField;
+	typedef RMAPRegisterField<LinkControlStatusRegister, 24, 6> TxClockDividerField;
+	/** Routing table entry of logical address 0x20 (that of logical address n is at Address + (n - 0x20) * RegisterStride). */
+	typedef RMAPRegister<0x0080, uint32_t, RMAPMemoryObject::Readable | RMAPMemoryObject::Writable,
+			RMAPRegisterEndianness::LittleEndian> RoutingTableRegister;
+	static const uint32_t RegisterStride = 4;
+
 private:
 	RMAPTargetNode* routerConfigurationPort;
 
 public:
 	ShimafujiElectricSpaceWireToGigabitEthernetStandalone() {
 		setRMAPInitiator(NULL);
-		std::vector<RMAPTargetNode*> nodes = RMAPTargetNode::constructFromXMLString(getConfigurationFileAsString());
+		std::vector<RMAPTargetNode*> nodes = RMAPTargetNodeBinaryCache::getSharedInstance()->constructFromXMLString(
+				getConfigurationFileAsString());
 		for (size_t i = 0; i < nodes.size(); i++) {
 			if (nodes[i]->getID() == "SpW2GbE_ConfigurationPort") {
 				routerConfigurationPort = nodes[i];
@@ -73,6 +85,8 @@ public:
 		}
 		routerConfigurationPort->setTargetSpaceWireAddress(targetSpaceWireAddress);
 		routerConfigurationPort->setReplyAddress(replyAddress);
+		invalidateRoutingTableCache();
+		invalidateLinkControlStatusRegisterCache();
 	}
 
 public:
@@ -117,115 +131,39 @@ public:
 
 public:
 	uint32_t getRoutingTableAddress(uint8_t logicalAddress) throw (RouterConfigurationPortException) {
-		return getRoutingTableMemoryObject(logicalAddress)->getAddress();
-	}
-
-private:
-	std::vector<uint8_t> convertRoutingTableToPortNumbers(uint8_t* value) {
-		uint32_t register32bits;
-		register32bits = value[3];
-		register32bits = (register32bits << 8) + value[2];
-		register32bits = (register32bits << 8) + value[1];
-		register32bits = (register32bits << 8) + value[0];
-		uint32_t flag = 0;
-		std::vector<uint8_t> result;
-		for (size_t i = 0; i < 32; i++) {
-			flag = 0x01 << i;
-			if ((register32bits & flag) != 0) {
-				result.push_back(i);
-			}
-		}
-		return result;
-	}
-
-private:
-	uint8_t* convertPortNumbersToRoutingTable(std::vector<uint8_t> portNumbers) {
-		uint8_t* buffer = new uint8_t[4];
-		memset(buffer, 0, 4);
-		uint32_t flag = 0;
-		for (size_t i = 0; i < portNumbers.size(); i++) {
-			uint8_t port = portNumbers.at(i);
-			if (port < 8) { //Port 0-7
-				buffer[0] = (buffer[0] & ~(0x01 << port)) + (0x01 << port);
-			} else { //Port 8-9
-				buffer[1] = (buffer[1] & ~(0x01 << (port - 8))) + (0x01 << (port - 8));
-			}
-		}
-		return buffer;
-	}
-
-private:
-	std::vector<std::vector<uint8_t> > convertWholeRoutingTableToVector(uint8_t* buffer) {
-		std::vector<std::vector<uint8_t> > result;
-		size_t nLogicalAddresses = SpaceWireProtocol::MaximumLogicalAddress - SpaceWireProtocol::MinimumLogicalAddress
-				+ 1;
-		for (size_t i = 0; i < nLogicalAddresses; i++) {
-			result.push_back(convertRoutingTableToPortNumbers(buffer + i * 4));
+		if (logicalAddress < SpaceWireProtocol::MinimumLogicalAddress) {
+			throw RouterConfigurationPortException(RouterConfigurationPortException::NotImplemented);
 		}
-		return result;
+		return RoutingTableRegister::Address
+				+ (logicalAddress - SpaceWireProtocol::MinimumLogicalAddress) * RegisterStride;
 	}
 
 public:
 	std::vector<uint8_t> readRoutingTable(uint8_t logicalAddress) throw (RouterConfigurationPortException,
 			RMAPInitiatorException) {
-		RMAPMemoryObject* routingTableForALogicalAddress = getRoutingTableMemoryObject(logicalAddress);
+		uint32_t offset = getRoutingTableAddress(logicalAddress) - RoutingTableRegister::Address;
 		throwIfRMAPInitiatorIsNULL();
-		uint8_t value[4];
+		uint32_t entry;
 		try {
-			rmapInitiator->read(routerConfigurationPort, routingTableForALogicalAddress->getID(), value);
+			entry = rmapInitiator->readRegister<RoutingTableRegister>(routerConfigurationPort, offset);
 		} catch (RMAPEngineException& e) {
 			throw RouterConfigurationPortException(RouterConfigurationPortException::OperationFailed);
 		}
-		return convertRoutingTableToPortNumbers(value);
-	}
-
-public:
-	std::vector<std::vector<uint8_t> > readWholeRoutingTable() throw (RouterConfigurationPortException,
-			RMAPInitiatorException) {
-
-		RMAPMemoryObject* routingTableForALogicalAddress = getRoutingTableMemoryObject(
-				SpaceWireProtocol::MinimumLogicalAddress);
-		size_t length = (SpaceWireProtocol::MaximumLogicalAddress - SpaceWireProtocol::MinimumLogicalAddress + 1) * 4;
-		throwIfRMAPInitiatorIsNULL();
-		uint8_t* buffer = new uint8_t[length];
-		using namespace std;
-		try {
-			size_t o = 0;
-			for (size_t i = SpaceWireProtocol::MinimumLogicalAddress; i < SpaceWireProtocol::MaximumLogicalAddress;
-					i++) {
-				rmapInitiator->read(routerConfigurationPort, getRoutingTableAddress(i), 4, buffer + o * 4);
-				o++;
-			}
-		} catch (RMAPEngineException& e) {
-			delete buffer;
-			throw RouterConfigurationPortException(RouterConfigurationPortException::OperationFailed);
-		} catch (RMAPInitiatorException& e) {
-			using namespace std;
-			cout << e.toString() << endl;
-			delete buffer;
-			throw RouterConfigurationPortException(RouterConfigurationPortException::OperationFailed);
-		} catch (RMAPReplyException& e) {
-			using namespace std;
-			cout << e.toString() << endl;
-			delete buffer;
-			throw RouterConfigurationPortException(RouterConfigurationPortException::OperationFailed);
-		}
-		std::vector<std::vector<uint8_t> > result = convertWholeRoutingTableToVector(buffer);
-		delete buffer;
+		std::vector<uint8_t> result = convertRoutingTableEntryToPortNumbers(entry);
+		updateRoutingTableCache(logicalAddress, result);
 		return result;
 	}
 
 public:
 	void writeRoutingTable(uint8_t logicalAddress, std::vector<uint8_t> ports) throw (RouterConfigurationPortException,
 			RMAPInitiatorException) {
-		RMAPMemoryObject* routingTableForALogicalAddress = getRoutingTableMemoryObject(logicalAddress);
+		uint32_t offset = getRoutingTableAddress(logicalAddress) - RoutingTableRegister::Address;
 		throwIfRMAPInitiatorIsNULL();
-		uint8_t* buffer = convertPortNumbersToRoutingTable(ports);
 		try {
-			rmapInitiator->write(routerConfigurationPort, routingTableForALogicalAddress->getID(), buffer);
-			delete buffer;
+			rmapInitiator->writeRegister<RoutingTableRegister>(routerConfigurationPort,
+					convertPortNumbersToRoutingTableEntry(ports), offset);
+			updateRoutingTableCache(logicalAddress, ports);
 		} catch (RMAPEngineException& e) {
-			delete buffer;
 			throw RouterConfigurationPortException(RouterConfigurationPortException::OperationFailed);
 		}
 	}
@@ -300,20 +238,19 @@ public:
 			throw RouterConfigurationPortException(RouterConfigurationPortException::RMAPInitiatorIsNotAvailable);
 		}
 
-		RMAPMemoryObject* registerMemoryObject = getLinkFrequencyRegisterMemoryObject(port);
 		uint8_t value[4];
 
 		try {
 			//29:24 = Tx Clock Divider n. TxClock = 200MHz / (n + 1)
 
 			//first read the register
-			rmapInitiator->read(routerConfigurationPort, registerMemoryObject->getID(), value);
+			readLinkControlStatusRegister(port, value);
 
 			//change the register value
 			value[3] = txdivider;
 
 			//write back
-			rmapInitiator->write(routerConfigurationPort, registerMemoryObject->getID(), value);
+			writeLinkControlStatusRegister(port, value);
 		} catch (RMAPInitiatorException& e) {
 			throw e;
 		} catch (...) {
@@ -325,7 +262,7 @@ public:
 	double getLinkFrequency(uint8_t port) throw (RouterConfigurationPortException, RMAPInitiatorException) {
 		uint8_t value[4];
 		readLinkControlStatusRegister(port, value);
-		uint32_t txdiv = value[3] & 0x3F; /* 00111111*/
+		uint32_t txdiv = TxClockDividerField::extract(LinkControlStatusRegister::decode(value));
 		return MaximumLinkFrequency / (txdiv + 1);
 	}
 
@@ -336,27 +273,29 @@ private:
 		}
 	}
 
-private:
-	RMAPMemoryObject* getLinkControlStatusRegisterMemoryObject(uint8_t port) throw (RouterConfigurationPortException) {
-		if (port > MaximumPortNumber) {
-			throw RouterConfigurationPortException(RouterConfigurationPortException::InvalidPortNumber);
-		}
-		using namespace std;
-		stringstream ss;
-		ss << "Port" << (uint32_t) port << "ControlStatusRegister";
-		return routerConfigurationPort->findMemoryObject(ss.str());
-	}
-
 public:
 	void readLinkControlStatusRegister(uint8_t port, uint8_t* value) throw (RouterConfigurationPortException,
 			RMAPInitiatorException) {
-		RMAPMemoryObject* linkCSR = getLinkControlStatusRegisterMemoryObject(port);
+		uint32_t address = getLinkControlStatusRegisterAddress(port);
+		if (readLinkControlStatusRegisterFromCache(port, value)) {
+			return;
+		}
 		throwIfRMAPInitiatorIsNULL();
+		double readTime = CxxUtilities::Time::getClockValueInMilliSec();
 		try {
-			rmapInitiator->read(routerConfigurationPort, linkCSR->getID(), value);
+			rmapInitiator->read(routerConfigurationPort, address, LinkControlStatusRegister::Length, value);
 		} catch (RMAPEngineException& e) {
 			throw RouterConfigurationPortException(RouterConfigurationPortException::OperationFailed);
 		}
+		updateLinkControlStatusRegisterCache(port, value, readTime);
+	}
+
+public:
+	uint32_t getLinkControlStatusRegisterAddress(uint8_t port) throw (RouterConfigurationPortException) {
+		if (port > MaximumPortNumber) {
+			throw RouterConfigurationPortException(RouterConfigurationPortException::InvalidPortNumber);
+		}
+		return LinkControlStatusRegister::Address + port * RegisterStride;
 	}
 
 public:
@@ -377,24 +316,20 @@ public:
 	bool isConnected(uint8_t port) throw (RouterConfigurationPortException, RMAPInitiatorException) {
 		uint8_t value[4];
 		readLinkControlStatusRegister(port, value);
-		uint32_t connected = value[0] & 0x10; /* 00010000*/
-		if (connected == 0) {
-			return false;
-		} else {
-			return true;
-		}
+		return LinkConnectedField::extract(LinkControlStatusRegister::decode(value));
 	}
 
 public:
 	void writeLinkControlStatusRegister(uint8_t port, uint8_t* value) throw (RouterConfigurationPortException,
 			RMAPInitiatorException) {
-		RMAPMemoryObject* linkCSR = getLinkControlStatusRegisterMemoryObject(port);
+		uint32_t address = getLinkControlStatusRegisterAddress(port);
 		throwIfRMAPInitiatorIsNULL();
 		try {
-			rmapInitiator->write(routerConfigurationPort, linkCSR->getID(), value);
+			rmapInitiator->write(routerConfigurationPort, address, value, LinkControlStatusRegister::Length);
 		} catch (RMAPEngineException& e) {
 			throw RouterConfigurationPortException(RouterConfigurationPortException::OperationFailed);
 		}
+		writeThroughLinkControlStatusRegisterCache(port, value);
 	}
 
 	/* [29:24] Tx Clock Divider
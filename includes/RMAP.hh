@@ -34,18 +34,24 @@ SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #ifndef RMAP_HH_
 #define RMAP_HH_
 
+#include "RMAPAddressMap.hh"
+#include "RMAPCommandHeaderTemplate.hh"
 #include "RMAPEngine.hh"
 #include "RMAPInitiator.hh"
 #include "RMAPInitiatorOptions.hh"
+#include "RMAPMemoryTarget.hh"
 #include "RMAPPacket.hh"
 #include "RMAPProtocol.hh"
+#include "RMAPRegister.hh"
 #include "RMAPReplyException.hh"
 #include "RMAPReplyStatus.hh"
 #include "RMAPTarget.hh"
 #include "RMAPTargetNode.hh"
+#include "RMAPTargetNodeBinaryCache.hh"
 #include "RMAPTransaction.hh"
 #include "RMAPUtilities.hh"
 
 #include "RouterConfigurationPort.hh"
+#include "RouterNetworkDiscovery.hh"
 
 #endif /* RMAP_HH_ */
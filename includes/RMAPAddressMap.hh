@@ -0,0 +1,194 @@
+/* 
+============================================================================
+SpaceWire/RMAP Library is provided under the MIT License.
+============================================================================
+
+Copyright (c) 2006-2013 Takayuki Yuasa and The Open-source SpaceWire Project
+
+Permission is hereby granted, free of charge, to any person obtaining a 
+copy of this software and associated documentation files (the 
+"Software"), to deal in the Software without restriction, including 
+without limitation the rights to use, copy, modify, merge, publish, 
+distribute, sublicense, and/or sell copies of the Software, and to 
+permit persons to whom the Software is furnished to do so, subject to 
+the following conditions:
+
+The above copyright notice and this permission notice shall be included 
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. 
+*/
+/*
+ * RMAPAddressMap.hh
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef RMAPADDRESSMAP_HH_
+#define RMAPADDRESSMAP_HH_
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <set>
+#include <vector>
+
+class RMAPTargetAccessAction;
+
+/** An immutable address map compiled from registered address ranges, used to find
+ * the RMAPTargetAccessAction of a received command in O(log n), also when ranges overlap.
+ * Overlapping ranges are allowed; then the range with the smallest priority (i.e. registered first)
+ * among those containing the accessed range is used, as RMAPTarget did with its linear search.
+ *
+ * The address space is split at all range boundaries into disjoint segments. Each segment holds
+ * the candidates for accesses starting in it: the ranges covering the segment in priority order,
+ * excluding those which end no later than a range of smaller priority (they can never be selected).
+ * End addresses of the candidates therefore increase, and a lookup is a binary search for the
+ * segment followed by a binary search for the first candidate which reaches the end of the access.
+ * Compilation takes O(n log n) plus the total number of candidates, which is n for non-overlapping
+ * ranges and grows only with the nesting depth of overlapping ranges.
+ *
+ * Instances are never modified after construction. RMAPTarget and RMAPEngine publish
+ * a new instance with std::atomic_store() when ranges are added/removed, so a thread
+ * dispatching commands always sees a complete map without locking.
+ */
+class RMAPAddressMap {
+public:
+	struct Entry {
+		uint32_t addressFrom;
+		uint32_t addressTo; //inclusive
+		uint32_t priority; //smaller wins when ranges overlap
+		RMAPTargetAccessAction* action;
+	};
+
+private:
+	struct Candidate {
+		uint32_t addressTo;
+		RMAPTargetAccessAction* action;
+	};
+
+private:
+	std::vector<Entry> entries; //sorted by addressFrom
+	std::vector<uint32_t> segmentAddressFrom; //start address of each segment (sorted)
+	std::vector<size_t> segmentCandidatesBegin; //candidates of segment i are [begin[i], begin[i + 1])
+	std::vector<Candidate> candidates;
+	uint64_t generation;
+
+public:
+	/** Constructor.
+	 * @param[in] entries address ranges and actions (any order)
+	 * @param[in] generation value of getCurrentGeneration() when the entries were collected
+	 */
+	RMAPAddressMap(std::vector<Entry> entries, uint64_t generation) :
+			entries(entries), generation(generation) {
+		std::stable_sort(this->entries.begin(), this->entries.end(), [](const Entry& a, const Entry& b) {
+			return a.addressFrom < b.addressFrom;
+		});
+		compileSegments();
+	}
+
+public:
+	/** Returns the action of the range which contains [addressFrom, addressTo] (both inclusive).
+	 * Returns NULL if no range contains it.
+	 */
+	RMAPTargetAccessAction* find(uint32_t addressFrom, uint32_t addressTo) const {
+		size_t segment = std::upper_bound(segmentAddressFrom.begin(), segmentAddressFrom.end(), addressFrom)
+				- segmentAddressFrom.begin();
+		if (segment == 0) {
+			return NULL;
+		}
+		segment--;
+		auto begin = candidates.begin() + segmentCandidatesBegin[segment];
+		auto end = candidates.begin() + segmentCandidatesBegin[segment + 1];
+		auto found = std::lower_bound(begin, end, addressTo, [](const Candidate& candidate, uint32_t address) {
+			return candidate.addressTo < address;
+		});
+		return (found == end) ? NULL : found->action;
+	}
+
+public:
+	const std::vector<Entry>& getEntries() const {
+		return entries;
+	}
+
+public:
+	size_t size() const {
+		return entries.size();
+	}
+
+public:
+	/** Returns the generation at which this map was compiled.
+	 * The map is up to date as long as this equals getCurrentGeneration().
+	 */
+	uint64_t getGeneration() const {
+		return generation;
+	}
+
+public:
+	/** Returns the counter which is advanced whenever an address range is added to or
+	 * removed from any RMAPTarget.
+	 */
+	static uint64_t getCurrentGeneration() {
+		return generationCounter().load(std::memory_order_acquire);
+	}
+
+public:
+	static void advanceGeneration() {
+		generationCounter().fetch_add(1, std::memory_order_acq_rel);
+	}
+
+private:
+	/** Splits the address space into segments, and collects candidates of each segment
+	 * by sweeping over the segments while keeping the ranges which start at or before
+	 * the segment ordered by priority.
+	 */
+	void compileSegments() {
+		std::vector<uint64_t> boundaries;
+		for (auto& entry : entries) {
+			boundaries.push_back(entry.addressFrom);
+			boundaries.push_back((uint64_t) entry.addressTo + 1);
+		}
+		std::sort(boundaries.begin(), boundaries.end());
+		boundaries.erase(std::unique(boundaries.begin(), boundaries.end()), boundaries.end());
+		std::set<std::pair<uint32_t, size_t> > activeEntries; //(priority, index in entries)
+		size_t nextEntry = 0;
+		for (uint64_t boundary : boundaries) {
+			if (boundary > 0xffffffff) {
+				break;
+			}
+			uint32_t address = (uint32_t) boundary;
+			for (; nextEntry < entries.size() && entries[nextEntry].addressFrom <= address; nextEntry++) {
+				activeEntries.insert(std::make_pair(entries[nextEntry].priority, nextEntry));
+			}
+			segmentAddressFrom.push_back(address);
+			segmentCandidatesBegin.push_back(candidates.size());
+			for (auto it = activeEntries.begin(); it != activeEntries.end();) {
+				const Entry& entry = entries[it->second];
+				if (entry.addressTo < address) {
+					//ended before this segment
+					it = activeEntries.erase(it);
+					continue;
+				}
+				if (candidates.size() == segmentCandidatesBegin.back() || candidates.back().addressTo < entry.addressTo) {
+					candidates.push_back( { entry.addressTo, entry.action });
+				}
+				it++;
+			}
+		}
+		segmentCandidatesBegin.push_back(candidates.size());
+	}
+
+private:
+	static std::atomic<uint64_t>& generationCounter() {
+		static std::atomic<uint64_t> counter(0);
+		return counter;
+	}
+};
+
+#endif /* RMAPADDRESSMAP_HH_ */
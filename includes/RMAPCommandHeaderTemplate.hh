@@ -0,0 +1,159 @@
+/* 
+============================================================================
+SpaceWire/RMAP Library is provided under the MIT License.
+============================================================================
+
+Copyright (c) 2006-2013 Takayuki Yuasa and The Open-source SpaceWire Project
+
+Permission is hereby granted, free of charge, to any person obtaining a 
+copy of this software and associated documentation files (the 
+"Software"), to deal in the Software without restriction, including 
+without limitation the rights to use, copy, modify, merge, publish, 
+distribute, sublicense, and/or sell copies of the Software, and to 
+permit persons to whom the Software is furnished to do so, subject to 
+the following conditions:
+
+The above copyright notice and this permission notice shall be included 
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. 
+*/
+/*
+ * RMAPCommandHeaderTemplate.hh
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef RMAPCOMMANDHEADERTEMPLATE_HH_
+#define RMAPCOMMANDHEADERTEMPLATE_HH_
+
+#include <CxxUtilities/CommonHeader.hh>
+#include "RMAPProtocol.hh"
+#include "RMAPUtilities.hh"
+
+/** A pre-encoded command header prefix for one RMAP target, created by
+ * RMAPTargetNode::getCommandHeaderTemplate().
+ * The part of a command header which does not change from command to command
+ * (target logical address, protocol ID, key, and padded reply address) is encoded once,
+ * together with the CRC state after the prefix for each possible instruction.
+ * RMAPPacket::constructHeader() then only copies the prefix, patches the instruction, and
+ * appends initiator logical address, transaction ID, address and data length, calculating
+ * the header CRC only over those trailing bytes.
+ *
+ * The initiator logical address is not part of the prefix because it can be set either
+ * per RMAPTargetNode or per RMAPInitiator.
+ * Instances are never modified after construction, and are shared between RMAPTargetNode
+ * and RMAPPacket instances via std::shared_ptr.
+ */
+class RMAPCommandHeaderTemplate {
+public:
+	/** Bits of the instruction field which differ among commands
+	 * (write/read, verify, reply, and increment flags).
+	 */
+	static const uint8_t BitMaskForVariableInstructionBits = 0x3C;
+
+public:
+	/** Bit mask of the instruction field covering the packet type and reply path address length,
+	 * which are fixed for a template.
+	 */
+	static const uint8_t BitMaskForFixedInstructionBits = 0xC3;
+
+public:
+	static const size_t NumberOfInstructions = 16;
+
+private:
+	std::vector<uint8_t> targetSpaceWireAddress;
+	std::vector<uint8_t> replyAddress;
+	uint8_t targetLogicalAddress;
+	uint8_t key;
+	uint8_t protocolID;
+	uint8_t fixedInstructionBits;
+
+private:
+	std::vector<uint8_t> headerPrefix; //from target logical address up to the last reply address byte
+
+private:
+	uint8_t crcAfterPrefix[NumberOfInstructions];
+	uint8_t crcAfterPrefixDraftE[NumberOfInstructions];
+
+public:
+	RMAPCommandHeaderTemplate(std::vector<uint8_t> targetSpaceWireAddress, uint8_t targetLogicalAddress, uint8_t key,
+			std::vector<uint8_t> replyAddress) :
+			targetSpaceWireAddress(targetSpaceWireAddress), replyAddress(replyAddress), //
+			targetLogicalAddress(targetLogicalAddress), key(key) {
+		protocolID = RMAPProtocol::ProtocolIdentifier;
+		size_t paddedReplyAddressLength = (replyAddress.size() + 3) / 4 * 4;
+		fixedInstructionBits = 0x40 /* command */+ paddedReplyAddressLength / 4;
+		headerPrefix.push_back(targetLogicalAddress);
+		headerPrefix.push_back(protocolID);
+		headerPrefix.push_back(fixedInstructionBits);
+		headerPrefix.push_back(key);
+		headerPrefix.insert(headerPrefix.end(), paddedReplyAddressLength - replyAddress.size(), 0x00);
+		headerPrefix.insert(headerPrefix.end(), replyAddress.begin(), replyAddress.end());
+
+		std::vector<uint8_t> prefix = headerPrefix;
+		for (size_t i = 0; i < NumberOfInstructions; i++) {
+			prefix[2] = fixedInstructionBits | (i << 2);
+			crcAfterPrefix[i] = RMAPUtilities::calculateCRC(prefix);
+			crcAfterPrefixDraftE[i] = RMAPUtilities::calculateCRCBasedOnDraftESpecification(prefix);
+		}
+	}
+
+public:
+	/** Returns true if a command header with the given fields can be constructed from this template.
+	 */
+	inline bool isApplicable(uint8_t targetLogicalAddress, uint8_t protocolID, uint8_t instruction, uint8_t key) const {
+		return targetLogicalAddress == this->targetLogicalAddress && protocolID == this->protocolID && key == this->key
+				&& (instruction & BitMaskForFixedInstructionBits) == fixedInstructionBits;
+	}
+
+public:
+	/** Returns the CRC state after the header prefix with the instruction field set to instruction.
+	 */
+	inline uint8_t getCRCAfterPrefix(uint8_t instruction, bool useDraftECRC) const {
+		size_t index = (instruction & BitMaskForVariableInstructionBits) >> 2;
+		return useDraftECRC ? crcAfterPrefixDraftE[index] : crcAfterPrefix[index];
+	}
+
+public:
+	/** Returns the encoded header prefix (the instruction field holds only the fixed bits).
+	 */
+	const std::vector<uint8_t>& getHeaderPrefix() const {
+		return headerPrefix;
+	}
+
+public:
+	const std::vector<uint8_t>& getTargetSpaceWireAddress() const {
+		return targetSpaceWireAddress;
+	}
+
+public:
+	const std::vector<uint8_t>& getReplyAddress() const {
+		return replyAddress;
+	}
+
+public:
+	uint8_t getTargetLogicalAddress() const {
+		return targetLogicalAddress;
+	}
+
+public:
+	uint8_t getKey() const {
+		return key;
+	}
+
+public:
+	/** Returns the instruction field bits for the packet type (command) and reply path address length.
+	 */
+	uint8_t getFixedInstructionBits() const {
+		return fixedInstructionBits;
+	}
+};
+
+#endif /* RMAPCOMMANDHEADERTEMPLATE_HH_ */
@@ -155,7 +155,11 @@ public:
 			using namespace std;
 			isCompleted_ = false;
 			try {
-				rmapTargetAcessAction->processTransaction(&rmapTransaction);
+				if (rmapTransaction.commandPacket->isReadModifyWrite()) {
+					rmapTargetAcessAction->processReadModifyWriteTransaction(&rmapTransaction);
+				} else {
+					rmapTargetAcessAction->processTransaction(&rmapTransaction);
+				}
 				rmapTransaction.setState(RMAPTransaction::ReplySet);
 			} catch (...) {
 				delete rmapTransaction.commandPacket;
@@ -164,8 +168,11 @@ public:
 				return;
 			}
 			try {
-				rmapTransaction.replyPacket->constructPacket();
-				rmapEngine->sendPacket(rmapTransaction.replyPacket->getPacketBufferPointer());
+				//commands without the reply flag are executed without sending a reply
+				if (rmapTransaction.commandPacket->isReplyFlagSet()) {
+					rmapTransaction.replyPacket->constructPacket();
+					rmapEngine->sendPacket(rmapTransaction.replyPacket->getPacketBufferPointer());
+				}
 				rmapTransaction.setState(RMAPTransaction::ReplySent);
 			} catch (...) {
 				rmapTargetAcessAction->transactionReplyCouldNotBeSent(&rmapTransaction);
@@ -210,7 +217,11 @@ private:
 
 private:
 	std::vector<RMAPTarget*> rmapTargets;
+	CxxUtilities::Mutex rmapTargetsMutex;
+	std::shared_ptr<const RMAPAddressMap> addressMap; //compiled from address maps of all RMAPTarget instances
 	std::vector<RMAPTargetProcessThread*> rmapTargetProcessThreads;
+	RMAPPacket inlineReplyPacket; //reused by processCommandInline()
+	std::vector<uint8_t> receiveBuffer;
 
 public:
 	static const size_t MaximumTIDNumber = 65536;
@@ -342,7 +353,19 @@ public:
 private:
 	void rmapCommandPacketReceived(RMAPPacket* commandPacket) throw (RMAPEngineException) {
 		using namespace std;
-		//first cleanup completed threads
+		//find an RMAPTarget instance which can accept the accessed address range
+		RMAPTransaction rmapTransaction;
+		rmapTransaction.commandPacket = commandPacket;
+		rmapTransaction.setState(RMAPTransaction::CommandPacketReceived);
+		RMAPAddressRange addressRange = RMAPTarget::getAccessedAddressRange(commandPacket);
+		RMAPTargetAccessAction* rmapTargetAcessAction = getAddressMap()->find(addressRange.addressFrom,
+				addressRange.addressTo);
+		if (rmapTargetAcessAction != NULL && rmapTargetAcessAction->isInlineProcessingEnabled()) {
+			processCommandInline(rmapTransaction, rmapTargetAcessAction);
+			return;
+		}
+
+		//cleanup completed threads
 		std::vector<RMAPTargetProcessThread*> newRMAPTargetProcessThreads;
 		for (size_t i = 0; i < rmapTargetProcessThreads.size(); i++) {
 			if (rmapTargetProcessThreads[i]->isCompleted()) {
@@ -353,24 +376,55 @@ private:
 		}
 		rmapTargetProcessThreads = newRMAPTargetProcessThreads;
 
-		//find an RMAPTarget instance which can accept the accessed address range
-		RMAPTransaction rmapTransaction;
-		rmapTransaction.commandPacket = commandPacket;
-		rmapTransaction.setState(RMAPTransaction::CommandPacketReceived);
-		for (size_t i = 0; i < rmapTargets.size(); i++) {
-			RMAPTargetAccessAction* rmapTargetAcessAction = rmapTargets[i]->getCorrespondingRMAPTargetAccessAction(
-					&rmapTransaction);
-			if (rmapTargetAcessAction != NULL) {
-				RMAPTargetProcessThread* aThread = new RMAPTargetProcessThread(this, rmapTransaction, rmapTargetAcessAction);
-				aThread->start();
-				rmapTargetProcessThreads.push_back(aThread);
-				return;
-			}
+		if (rmapTargetAcessAction != NULL) {
+			RMAPTargetProcessThread* aThread = new RMAPTargetProcessThread(this, rmapTransaction, rmapTargetAcessAction);
+			aThread->start();
+			rmapTargetProcessThreads.push_back(aThread);
+			return;
 		}
 		delete commandPacket;
 		receivedCommandPacketDiscarded();
 	}
 
+private:
+	/** Processes a command in the receive thread (see RMAPTargetAccessAction::setInlineProcessing()).
+	 */
+	void processCommandInline(RMAPTransaction& rmapTransaction, RMAPTargetAccessAction* rmapTargetAcessAction) {
+		rmapTransaction.replyPacket = &inlineReplyPacket;
+		try {
+			if (rmapTransaction.commandPacket->isReadModifyWrite()) {
+				rmapTargetAcessAction->processReadModifyWriteTransaction(&rmapTransaction);
+			} else {
+				rmapTargetAcessAction->processTransaction(&rmapTransaction);
+			}
+			rmapTransaction.setState(RMAPTransaction::ReplySet);
+		} catch (...) {
+			delete rmapTransaction.commandPacket;
+			receivedCommandPacketDiscarded();
+			return;
+		}
+		bool isReplyPacketOwnedByAction = (rmapTransaction.replyPacket != &inlineReplyPacket);
+		try {
+			if (rmapTransaction.commandPacket->isReplyFlagSet()) {
+				rmapTransaction.replyPacket->constructPacket();
+				sendPacket(rmapTransaction.replyPacket->getPacketBufferPointer());
+			}
+			rmapTransaction.setState(RMAPTransaction::ReplySent);
+		} catch (...) {
+			if (isReplyPacketOwnedByAction) {
+				rmapTargetAcessAction->transactionReplyCouldNotBeSent(&rmapTransaction);
+			}
+			replyToReceivedCommandPacketCouldNotBeSent();
+			delete rmapTransaction.commandPacket;
+			return;
+		}
+		if (isReplyPacketOwnedByAction) {
+			rmapTargetAcessAction->transactionWillComplete(&rmapTransaction);
+		}
+		rmapTransaction.setState(RMAPTransaction::ReplyCompleted);
+		delete rmapTransaction.commandPacket;
+	}
+
 private:
 	std::vector<RMAPPacket*> discardedRMAPReplyPackets;
 
@@ -445,11 +499,12 @@ private:
 private:
 	RMAPPacket* receivePacket() throw (RMAPEngineException) {
 		using namespace std;
-		std::vector<uint8_t>* buffer = new std::vector<uint8_t>;
+		//receiveBuffer is used only by the receive thread, and reused to avoid allocation per packet
+		std::vector<uint8_t>* buffer = &receiveBuffer;
+		buffer->clear();
 		try {
 			spwif->receive(buffer);
 		} catch (SpaceWireIFException& e) {
-			delete buffer;
 			//cout << e.toString() << endl;
 			if (e.status == SpaceWireIFException::Disconnected) {
 				//tell run() that SpaceWireIF is disconnected
@@ -474,11 +529,9 @@ private:
 			packet->interpretAsAnRMAPPacket(buffer);
 		} catch (RMAPPacketException& e) {
 			delete packet;
-			delete buffer;
 			receivedPacketDiscarded();
 			return NULL;
 		}
-		delete buffer;
 		return packet;
 	}
 
@@ -537,8 +590,9 @@ public:
 		commandPacket->setTransactionID(transactionID);
 		commandPacket->constructPacket();
 		if (isStarted()) {
-			sendPacket(commandPacket->getPacketBufferPointer());
+			//set before sending so that the state set by a quick reply is not overwritten
 			transaction->state = RMAPTransaction::Initiated;
+			sendPacket(commandPacket->getPacketBufferPointer());
 		} else {
 			throw RMAPEngineException(RMAPEngineException::RMAPEngineIsNotStarted);
 		}
@@ -630,11 +684,15 @@ public:
 
 public:
 	void addRMAPTarget(RMAPTarget* rmapTarget) {
+		rmapTargetsMutex.lock();
 		rmapTargets.push_back(rmapTarget);
+		rmapTargetsMutex.unlock();
+		RMAPAddressMap::advanceGeneration();
 	}
 
 public:
 	void removeRMAPTarget(RMAPTarget* rmapTarget) {
+		rmapTargetsMutex.lock();
 		std::vector<RMAPTarget*> aVector;
 		for (size_t i = 0; i < rmapTargets.size(); i++) {
 			if (rmapTargets[i] != rmapTarget) {
@@ -642,6 +700,36 @@ public:
 			}
 		}
 		rmapTargets = aVector;
+		rmapTargetsMutex.unlock();
+		RMAPAddressMap::advanceGeneration();
+	}
+
+private:
+	/** Returns the address map of all registered RMAPTarget instances, recompiling it if
+	 * an RMAPTarget was added/removed or an address range was registered since the last compilation.
+	 * When ranges overlap, ranges of an earlier added RMAPTarget take precedence.
+	 */
+	std::shared_ptr<const RMAPAddressMap> getAddressMap() {
+		std::shared_ptr<const RMAPAddressMap> currentAddressMap = std::atomic_load(&addressMap);
+		if (currentAddressMap && currentAddressMap->getGeneration() == RMAPAddressMap::getCurrentGeneration()) {
+			return currentAddressMap;
+		}
+		rmapTargetsMutex.lock();
+		//read the generation before collecting entries; a change during compilation causes another compilation
+		uint64_t generation = RMAPAddressMap::getCurrentGeneration();
+		std::vector<RMAPAddressMap::Entry> entries;
+		for (size_t i = 0; i < rmapTargets.size(); i++) {
+			std::shared_ptr<const RMAPAddressMap> targetAddressMap = rmapTargets[i]->getAddressMap();
+			uint32_t priorityOffset = entries.size();
+			for (auto entry : targetAddressMap->getEntries()) {
+				entry.priority += priorityOffset;
+				entries.push_back(entry);
+			}
+		}
+		currentAddressMap = std::make_shared<const RMAPAddressMap>(entries, generation);
+		std::atomic_store(&addressMap, currentAddressMap);
+		rmapTargetsMutex.unlock();
+		return currentAddressMap;
 	}
 
 public:
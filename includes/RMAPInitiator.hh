@@ -42,6 +42,7 @@
 #include "RMAPReplyException.hh"
 #include "RMAPProtocol.hh"
 #include "RMAPMemoryObject.hh"
+#include "RMAPRegister.hh"
 
 class RMAPInitiatorException: public CxxUtilities::Exception {
 public:
@@ -59,7 +60,8 @@ public:
 		SpecifiedRMAPMemoryObjectIsNotRMWable,
 		RMAPTargetNodeDBIsNotRegistered,
 		NonblockingTransactionHasNotBeenInitiated,
-		NonblockingTransactionHasNotBeenCompleted
+		NonblockingTransactionHasNotBeenCompleted,
+		InvalidReadModifyWriteLength
 	};
 
 public:
@@ -117,6 +119,9 @@ public:
 		case NonblockingTransactionHasNotBeenCompleted:
 			result = "NonblockingTransactionHasNotBeenCompleted";
 			break;
+		case InvalidReadModifyWriteLength:
+			result = "InvalidReadModifyWriteLength";
+			break;
 		default:
 			result = "Undefined status";
 			break;
@@ -131,6 +136,7 @@ public:
 	static const bool DefaultIncrementMode = true;
 	static const bool DefaultVerifyMode = true;
 	static const bool DefaultReplyMode = true;
+	static constexpr double ReplyWaitSliceInMilliSec = 1.0;
 
 private:
 	RMAPEngine* rmapEngine;
@@ -190,6 +196,24 @@ public:
 		}
 	}
 
+private:
+	/** Waits until the reply of the current transaction is received or timeoutDuration elapses.
+	 * The signal from RMAPEngine is lost if the reply arrives before the wait starts (which is
+	 * common with fast targets), so the state is checked before and between short waits.
+	 */
+	void waitForReply(double timeoutDuration) {
+		double waitedDuration = 0;
+		while (transaction.state != RMAPTransaction::ReplyReceived && transaction.state != RMAPTransaction::Timeout
+				&& waitedDuration < timeoutDuration) {
+			double slice = timeoutDuration - waitedDuration;
+			if (slice > ReplyWaitSliceInMilliSec) {
+				slice = ReplyWaitSliceInMilliSec;
+			}
+			transaction.condition.wait(slice);
+			waitedDuration += slice;
+		}
+	}
+
 public:
 	void deleteReplyPacket() {
 		deleteReplyPacketMutex.lock();
@@ -294,6 +318,24 @@ public:
 		read(rmapTargetNode, memoryObject->getAddress(), memoryObject->getLength(), buffer, timeoutDuration);
 	}
 
+	/** Reads a memory object referred to by a handle obtained via RMAPTargetNode::getMemoryObjectHandle()
+	 * (no ID lookup).
+	 */
+	void read(RMAPTargetNode* rmapTargetNode, RMAPMemoryObjectHandle memoryObjectHandle, uint8_t *buffer,
+			double timeoutDuration = DefaultTimeoutDuration) throw (RMAPEngineException, RMAPInitiatorException,
+					RMAPReplyException) {
+		RMAPMemoryObject* memoryObject;
+		try {
+			memoryObject = rmapTargetNode->getMemoryObject(memoryObjectHandle);
+		} catch (RMAPTargetNodeException& e) {
+			throw RMAPInitiatorException(RMAPInitiatorException::NoSuchRMAPMemoryObject);
+		}
+		if (!memoryObject->isReadable()) {
+			throw RMAPInitiatorException(RMAPInitiatorException::SpecifiedRMAPMemoryObjectIsNotReadable);
+		}
+		read(rmapTargetNode, memoryObject->getAddress(), memoryObject->getLength(), buffer, timeoutDuration);
+	}
+
 	/** Reads remote memory. This method blocks the current thread. For non-blocking access, use the nonblockingRead() method.
 	 */
 	void read(RMAPTargetNode* rmapTargetNode, uint32_t memoryAddress, uint32_t length, uint8_t *buffer,
@@ -338,7 +380,7 @@ public:
 			transaction.state = RMAPTransaction::NotInitiated;
 			throw RMAPInitiatorException(RMAPInitiatorException::RMAPTransactionCouldNotBeInitiated);
 		}
-		transaction.condition.wait(timeoutDuration);
+		waitForReply(timeoutDuration);
 		if (transaction.state == RMAPTransaction::ReplyReceived) {
 			replyPacket = transaction.replyPacket;
 			transaction.replyPacket = NULL;
@@ -574,6 +616,24 @@ public:
 		write(rmapTargetNode, memoryObject->getAddress(), data, memoryObject->getLength(), timeoutDuration);
 	}
 
+	/** Writes a memory object referred to by a handle obtained via RMAPTargetNode::getMemoryObjectHandle()
+	 * (no ID lookup).
+	 */
+	void write(RMAPTargetNode *rmapTargetNode, RMAPMemoryObjectHandle memoryObjectHandle, uint8_t* data,
+			double timeoutDuration = DefaultTimeoutDuration) throw (RMAPEngineException, RMAPInitiatorException,
+					RMAPReplyException) {
+		RMAPMemoryObject* memoryObject;
+		try {
+			memoryObject = rmapTargetNode->getMemoryObject(memoryObjectHandle);
+		} catch (RMAPTargetNodeException& e) {
+			throw RMAPInitiatorException(RMAPInitiatorException::NoSuchRMAPMemoryObject);
+		}
+		if (!memoryObject->isWritable()) {
+			throw RMAPInitiatorException(RMAPInitiatorException::SpecifiedRMAPMemoryObjectIsNotWritable);
+		}
+		write(rmapTargetNode, memoryObject->getAddress(), data, memoryObject->getLength(), timeoutDuration);
+	}
+
 	void write(RMAPTargetNode *rmapTargetNode, uint32_t memoryAddress, std::vector<uint8_t>* data,
 			double timeoutDuration = DefaultTimeoutDuration) throw (RMAPEngineException, RMAPInitiatorException,
 					RMAPReplyException) {
@@ -634,11 +694,10 @@ public:
 				throw RMAPInitiatorException(RMAPInitiatorException::RMAPTransactionCouldNotBeInitiated);
 			}
 		}
-		transaction.state = RMAPTransaction::CommandSent;
-
 		//if reply is expected
-		transaction.condition.wait(timeoutDuration);
-		if (transaction.state == RMAPTransaction::CommandSent) {
+		//(the state is not updated here because a quick reply may already have set ReplyReceived)
+		waitForReply(timeoutDuration);
+		if (transaction.state == RMAPTransaction::Initiated) {
 			if (replyMode) {
 				unlock();
 				//cancel transaction (return transaction ID)
@@ -685,6 +744,247 @@ public:
 		}
 	}
 
+public:
+	void readModifyWrite(RMAPTargetNode* rmapTargetNode, std::string memoryObjectID, uint8_t* data, uint8_t* mask,
+			uint8_t* readData, double timeoutDuration = DefaultTimeoutDuration) throw (RMAPEngineException,
+					RMAPInitiatorException, RMAPReplyException) {
+		RMAPMemoryObject* memoryObject;
+		try {
+			memoryObject = rmapTargetNode->getMemoryObject(memoryObjectID);
+		} catch (RMAPTargetNodeException& e) {
+			throw RMAPInitiatorException(RMAPInitiatorException::NoSuchRMAPMemoryObject);
+		}
+		//check if the memory is RMWable.
+		if (!memoryObject->isRMWable()) {
+			throw RMAPInitiatorException(RMAPInitiatorException::SpecifiedRMAPMemoryObjectIsNotRMWable);
+		}
+		readModifyWrite(rmapTargetNode, memoryObject->getAddress(), data, mask, memoryObject->getLength(), readData,
+				timeoutDuration);
+	}
+
+	/** Read-modify-writes remote memory. The target reads the memory, writes
+	 * (data & mask) | (readData & ~mask) as a single operation, and replies the data read
+	 * before the modification. This method blocks the current thread.
+	 * @param[in] data data to be written (length bytes)
+	 * @param[in] mask bits to be modified (length bytes)
+	 * @param[in] length number of bytes to be modified (1 to 4)
+	 * @param[out] readData data before the modification (length bytes)
+	 * @throw RMAPInitiatorException InvalidReadModifyWriteLength if length is 0 or larger than 4
+	 */
+	void readModifyWrite(RMAPTargetNode* rmapTargetNode, uint32_t memoryAddress, uint8_t* data, uint8_t* mask,
+			uint32_t length, uint8_t* readData, double timeoutDuration = DefaultTimeoutDuration)
+					throw (RMAPEngineException, RMAPInitiatorException, RMAPReplyException) {
+		if (length == 0 || length > 4) {
+			throw RMAPInitiatorException(RMAPInitiatorException::InvalidReadModifyWriteLength);
+		}
+		lock();
+		transaction.isNonblockingMode = false;
+		if (replyPacket != NULL) {
+			deleteReplyPacket();
+		}
+		setCRCVersion();
+		commandPacket->setInitiatorLogicalAddress(this->getInitiatorLogicalAddress());
+		commandPacket->setCommand();
+		commandPacket->setReadModifyWrite();
+		if (incrementMode) {
+			commandPacket->setIncrementMode();
+		} else {
+			commandPacket->setNoIncrementMode();
+		}
+		commandPacket->setExtendedAddress(0x00);
+		commandPacket->setAddress(memoryAddress);
+		std::vector<uint8_t> dataAndMask(data, data + length);
+		dataAndMask.insert(dataAndMask.end(), mask, mask + length);
+		commandPacket->setData(dataAndMask);
+		/** InitiatorLogicalAddress might be updated in commandPacket->setRMAPTargetInformation(rmapTargetNode) below */
+		commandPacket->setRMAPTargetInformation(rmapTargetNode);
+		transaction.commandPacket = this->commandPacket;
+		//tid
+		if (isTransactionIDSet_) {
+			transaction.setTransactionID(transactionID);
+		}
+		try {
+			rmapEngine->initiateTransaction(transaction);
+		} catch (...) {
+			unlock();
+			transaction.state = RMAPTransaction::NotInitiated;
+			throw RMAPInitiatorException(RMAPInitiatorException::RMAPTransactionCouldNotBeInitiated);
+		}
+		waitForReply(timeoutDuration);
+		if (transaction.state == RMAPTransaction::ReplyReceived) {
+			replyPacket = transaction.replyPacket;
+			transaction.replyPacket = NULL;
+			if (replyPacket->getStatus() != RMAPReplyStatus::CommandExcecutedSuccessfully) {
+				uint8_t replyStatus = replyPacket->getStatus();
+				unlock();
+				transaction.state = RMAPTransaction::NotInitiated;
+				deleteReplyPacket();
+				throw RMAPReplyException(replyStatus);
+			}
+			if (replyPacket->getDataBuffer()->size() != length) {
+				unlock();
+				transaction.state = RMAPTransaction::NotInitiated;
+				deleteReplyPacket();
+				throw RMAPInitiatorException(RMAPInitiatorException::ReadReplyWithInsufficientData);
+			}
+			replyPacket->getData(readData, length);
+			transaction.state = RMAPTransaction::NotInitiated;
+			unlock();
+			return;
+		} else {
+			//cancel transaction (return transaction ID)
+			rmapEngine->cancelTransaction(&transaction);
+			transaction.state = RMAPTransaction::NotInitiated;
+			unlock();
+			deleteReplyPacket();
+			throw RMAPInitiatorException(RMAPInitiatorException::Timeout);
+		}
+	}
+
+public:
+	/** Reads a register defined with RMAPRegister, and returns the decoded value.
+	 * The address and length are compile-time constants (no memory object lookup).
+	 * @param[in] offset added to the register address (e.g. the base address of a channel)
+	 */
+	template<class Register>
+	typename Register::ValueType readRegister(RMAPTargetNode* rmapTargetNode, uint32_t offset = 0,
+			double timeoutDuration = DefaultTimeoutDuration) throw (RMAPEngineException, RMAPInitiatorException,
+					RMAPReplyException) {
+		static_assert(Register::isReadable(), "the register is not readable");
+		uint8_t buffer[Register::Length];
+		read(rmapTargetNode, Register::Address + offset, Register::Length, buffer, timeoutDuration);
+		return Register::decode(buffer);
+	}
+
+public:
+	/** Writes a value to a register defined with RMAPRegister.
+	 * @param[in] offset added to the register address (e.g. the base address of a channel)
+	 */
+	template<class Register>
+	void writeRegister(RMAPTargetNode* rmapTargetNode, typename Register::ValueType value, uint32_t offset = 0,
+			double timeoutDuration = DefaultTimeoutDuration) throw (RMAPEngineException, RMAPInitiatorException,
+					RMAPReplyException) {
+		static_assert(Register::isWritable(), "the register is not writable");
+		uint8_t buffer[Register::Length];
+		Register::encode(value, buffer);
+		write(rmapTargetNode, Register::Address + offset, buffer, Register::Length, timeoutDuration);
+	}
+
+public:
+	/** Reads a bit field defined with RMAPRegisterField.
+	 */
+	template<class Field>
+	typename Field::ValueType readRegisterField(RMAPTargetNode* rmapTargetNode, uint32_t offset = 0,
+			double timeoutDuration = DefaultTimeoutDuration) throw (RMAPEngineException, RMAPInitiatorException,
+					RMAPReplyException) {
+		return Field::extract(readRegister<typename Field::RegisterType>(rmapTargetNode, offset, timeoutDuration));
+	}
+
+public:
+	/** Writes a bit field defined with RMAPRegisterField keeping the other bits of the register.
+	 * If the register is RMWable (and at most 4 bytes wide), a single RMW command is used;
+	 * otherwise the register is read and then written (not atomic).
+	 */
+	template<class Field>
+	void writeRegisterField(RMAPTargetNode* rmapTargetNode, typename Field::ValueType value, uint32_t offset = 0,
+			double timeoutDuration = DefaultTimeoutDuration) throw (RMAPEngineException, RMAPInitiatorException,
+					RMAPReplyException) {
+		typedef typename Field::RegisterType Register;
+		static_assert(Register::isReadable() && Register::isWritable(), "the register is not readable and writable");
+		if (Register::isRMWable() && Register::Length <= 4) {
+			uint8_t data[Register::Length];
+			uint8_t mask[Register::Length];
+			uint8_t readData[Register::Length];
+			Register::encode(Field::insert(0, value), data);
+			Register::encode(static_cast<typename Register::ValueType>(Field::Mask), mask);
+			readModifyWrite(rmapTargetNode, Register::Address + offset, data, mask, Register::Length, readData,
+					timeoutDuration);
+		} else {
+			typename Register::ValueType registerValue = readRegister<Register>(rmapTargetNode, offset, timeoutDuration);
+			writeRegister<Register>(rmapTargetNode, Field::insert(registerValue, value), offset, timeoutDuration);
+		}
+	}
+
+public:
+	/** Writes remote memory without blocking the current thread (a reply is always requested).
+	 * Completion can be checked via isNonblockingWriteCompleted(), and the reply status via
+	 * checkNonblockingWriteReply(). As with nonblockingRead(), other methods should not be invoked
+	 * until the transaction completes or is canceled via cancelNonblockingWrite().
+	 */
+	void nonblockingWrite(RMAPTargetNode* rmapTargetNode, uint32_t memoryAddress, uint8_t* data, uint32_t length)
+			throw (RMAPEngineException, RMAPInitiatorException) {
+		lock();
+		transaction.isNonblockingMode = true;
+		if (replyPacket != NULL) {
+			deleteReplyPacket();
+		}
+		setCRCVersion();
+		commandPacket->setInitiatorLogicalAddress(this->getInitiatorLogicalAddress());
+		commandPacket->setWrite();
+		commandPacket->setCommand();
+		if (incrementMode) {
+			commandPacket->setIncrementMode();
+		} else {
+			commandPacket->setNoIncrementMode();
+		}
+		if (verifyMode) {
+			commandPacket->setVerifyMode();
+		} else {
+			commandPacket->setNoVerifyMode();
+		}
+		commandPacket->setReplyMode();
+		commandPacket->setExtendedAddress(0x00);
+		commandPacket->setAddress(memoryAddress);
+		commandPacket->setRMAPTargetInformation(rmapTargetNode);
+		commandPacket->setData(data, length);
+		transaction.commandPacket = this->commandPacket;
+		//tid
+		if (isTransactionIDSet_) {
+			transaction.setTransactionID(transactionID);
+		}
+		try {
+			rmapEngine->initiateTransaction(transaction);
+			unlock();
+		} catch (...) {
+			transaction.state = RMAPTransaction::NotInitiated;
+			unlock();
+			throw RMAPInitiatorException(RMAPInitiatorException::RMAPTransactionCouldNotBeInitiated);
+		}
+	}
+
+	bool isNonblockingWriteCompleted() {
+		return transaction.state == RMAPTransaction::ReplyReceived;
+	}
+
+	/** Checks the reply of a completed non-blocking write.
+	 * @throw RMAPReplyException if the target replied an error status
+	 */
+	void checkNonblockingWriteReply() throw (RMAPInitiatorException, RMAPReplyException) {
+		if (transaction.state == RMAPTransaction::NotInitiated) {
+			throw RMAPInitiatorException(RMAPInitiatorException::NonblockingTransactionHasNotBeenInitiated);
+		}
+		if (transaction.state != RMAPTransaction::ReplyReceived) {
+			throw RMAPInitiatorException(RMAPInitiatorException::NonblockingTransactionHasNotBeenCompleted);
+		}
+		replyPacket = transaction.replyPacket;
+		transaction.replyPacket = NULL;
+		transaction.state = RMAPTransaction::NotInitiated;
+		if (replyPacket->getStatus() != RMAPReplyStatus::CommandExcecutedSuccessfully) {
+			uint8_t replyStatus = replyPacket->getStatus();
+			deleteReplyPacket();
+			throw RMAPReplyException(replyStatus);
+		}
+	}
+
+	void cancelNonblockingWrite() {
+		try {
+			//cancel transaction (return transaction ID)
+			rmapEngine->cancelTransaction(&transaction);
+		} catch (...) {
+		}
+		transaction.state = RMAPTransaction::NotInitiated;
+	}
+
 private:
 	void setRMAPTransactionOptions(RMAPTransaction& transaction) {
 		//increment mode
@@ -839,6 +1139,11 @@ public:
 		return targetNodeDB;
 	}
 
+public:
+	RMAPEngine* getRMAPEngine() {
+		return rmapEngine;
+	}
+
 public:
 	bool isUseDraftECRC() const {
 		return useDraftECRC;
@@ -103,6 +103,7 @@ private:
 public:
 	RMAPMemoryObject() {
 		accessMode = Readable | Writable | RMWable;
+		key = 0x00;
 		isAccessModeSet_ = false;
 		isKeySet_ = false;
 		isIncrementModeSet_ = false;
@@ -138,6 +139,7 @@ public:
 	}
 
 	void setKey(uint8_t key) {
+		isKeySet_ = true;
 		this->key = key;
 	}
 
@@ -320,6 +322,14 @@ public:
 		}
 	}
 
+	bool isRMWable() {
+		if ((accessMode & RMWable) == 0) {
+			return false;
+		} else {
+			return true;
+		}
+	}
+
 	bool isAccessModeSet() {
 		return isAccessModeSet_;
 	}
@@ -0,0 +1,417 @@
+/* 
+============================================================================
+SpaceWire/RMAP Library is provided under the MIT License.
+============================================================================
+
+Copyright (c) 2006-2013 Takayuki Yuasa and The Open-source SpaceWire Project
+
+Permission is hereby granted, free of charge, to any person obtaining a 
+copy of this software and associated documentation files (the 
+"Software"), to deal in the Software without restriction, including 
+without limitation the rights to use, copy, modify, merge, publish, 
+distribute, sublicense, and/or sell copies of the Software, and to 
+permit persons to whom the Software is furnished to do so, subject to 
+the following conditions:
+
+The above copyright notice and this permission notice shall be included 
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. 
+*/
+/*
+ * RMAPMemoryTarget.hh
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef RMAPMEMORYTARGET_HH_
+#define RMAPMEMORYTARGET_HH_
+
+#include "RMAPTarget.hh"
+#include <atomic>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+class RMAPMemoryTarget;
+
+class RMAPMemoryTargetException: public CxxUtilities::Exception {
+public:
+	enum {
+		FileCouldNotBeOpened, MemoryCouldNotBeMapped, InvalidSize, InvalidAddress
+	};
+
+public:
+	RMAPMemoryTargetException(int status) :
+			CxxUtilities::Exception(status) {
+	}
+
+public:
+	virtual ~RMAPMemoryTargetException() {
+	}
+
+public:
+	virtual std::string toString() {
+		std::string result;
+		switch (status) {
+		case FileCouldNotBeOpened:
+			result = "FileCouldNotBeOpened";
+			break;
+		case MemoryCouldNotBeMapped:
+			result = "MemoryCouldNotBeMapped";
+			break;
+		case InvalidSize:
+			result = "InvalidSize";
+			break;
+		case InvalidAddress:
+			result = "InvalidAddress";
+			break;
+		default:
+			result = "Undefined status";
+			break;
+		}
+		return result;
+	}
+};
+
+/** Side effects of accesses to pages of an RMAPMemoryTarget (e.g. registers which
+ * start an operation when written, or status registers updated when read).
+ * Each method is called once per hooked page touched by a command, with the part of
+ * the accessed range which lies in the page. Methods can access memory via
+ * RMAPMemoryTarget::getPointer(), and can be called from multiple threads.
+ * Hooks are called while writes are serialized (also hooks of reads), and should not throw.
+ */
+class RMAPMemoryTargetHook {
+public:
+	virtual ~RMAPMemoryTargetHook() {
+	}
+
+public:
+	/** Called before data are read (also for the read part of an RMW).
+	 * @return RMAPReplyStatus::CommandExcecutedSuccessfully to continue, or an error status to reject the command
+	 */
+	virtual uint8_t willRead(RMAPMemoryTarget* target, uint32_t address, uint32_t length) {
+		return RMAPReplyStatus::CommandExcecutedSuccessfully;
+	}
+
+public:
+	/** Called before data are written (also for the write part of an RMW).
+	 * @return RMAPReplyStatus::CommandExcecutedSuccessfully to continue, or an error status to reject the command
+	 */
+	virtual uint8_t willWrite(RMAPMemoryTarget* target, uint32_t address, uint32_t length) {
+		return RMAPReplyStatus::CommandExcecutedSuccessfully;
+	}
+
+public:
+	/** Called after data were written.
+	 */
+	virtual void didWrite(RMAPMemoryTarget* target, uint32_t address, uint32_t length) {
+	}
+};
+
+/** An RMAPTarget backed by a memory region, e.g. to emulate SDRAM or register files of a board.
+ * The region is mmap'd; anonymous memory is allocated lazily by the OS so that large regions
+ * cost nothing until accessed, and a file-backed region persists its content in the file.
+ * Read replies refer to the region (RMAPPacket::setDataReference()), so read data are copied
+ * only once, from the region into the packet buffer, and the data CRC is calculated over that copy. Writes and read-modify-writes are applied
+ * in place. Writes and RMWs are serialized so that an RMW is atomic; reads are not locked
+ * unless they touch hooked pages (as with real memory, a read concurrent with a write can see either data).
+ * Only incrementing accesses are supported; commands without the increment flag are replied
+ * with CommandNotImplementedOrNotAuthorized, because a memory region has no FIFO-like address.
+ *
+ * @code
+ * RMAPMemoryTarget sdram(0x00000000, 64 * 1024 * 1024); //64 MB
+ * rmapEngine->addRMAPTarget(&sdram);
+ * @endcode
+ * The instance should outlive its registration to RMAPEngine.
+ */
+class RMAPMemoryTarget: public RMAPTarget {
+public:
+	static const size_t DefaultPageSize = 4096;
+	static const size_t DefaultVerifyBufferSize = 0xffffff; //maximum RMAP data length (no limit)
+
+private:
+	class MemoryAccessAction: public RMAPTargetAccessAction {
+	private:
+		RMAPMemoryTarget* parent;
+
+	public:
+		MemoryAccessAction(RMAPMemoryTarget* parent) {
+			this->parent = parent;
+		}
+
+	public:
+		void processTransaction(RMAPTransaction* rmapTransaction) throw (RMAPTargetAccessActionException) {
+			parent->processCommand(this, rmapTransaction);
+		}
+
+	public:
+		void processReadModifyWriteTransaction(RMAPTransaction* rmapTransaction)
+				throw (RMAPTargetAccessActionException) {
+			parent->processReadModifyWriteCommand(this, rmapTransaction);
+		}
+	};
+
+private:
+	uint32_t baseAddress;
+	size_t size;
+	uint8_t* memory;
+	int fd;
+	std::string fileName;
+	size_t pageSize;
+	size_t verifyBufferSize;
+	std::vector<RMAPMemoryTargetHook*> pageHooks;
+	std::atomic<size_t> nHookedPages;
+	CxxUtilities::Mutex writeMutex;
+	RMAPAddressRange addressRange;
+	MemoryAccessAction accessAction;
+
+public:
+	/** Constructor. Maps the region and registers it as the address range of this target.
+	 * @param[in] baseAddress RMAP address of the first byte
+	 * @param[in] size size of the region in bytes
+	 * @param[in] fileName if not empty, the region is mapped from this file (created, or extended if
+	 * smaller than size; a larger file is not truncated)
+	 * @param[in] pageSize granularity of hooks
+	 */
+	RMAPMemoryTarget(uint32_t baseAddress, size_t size, std::string fileName = "", size_t pageSize = DefaultPageSize)
+			throw (RMAPMemoryTargetException) :
+			accessAction(this) {
+		using namespace std;
+		if (size == 0 || pageSize == 0 || (uint64_t) baseAddress + size - 1 > 0xffffffffULL) {
+			throw RMAPMemoryTargetException(RMAPMemoryTargetException::InvalidSize);
+		}
+		this->baseAddress = baseAddress;
+		this->size = size;
+		this->fileName = fileName;
+		this->pageSize = pageSize;
+		this->verifyBufferSize = DefaultVerifyBufferSize;
+		this->fd = -1;
+		void* mapped;
+		if (fileName == "") {
+			mapped = ::mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		} else {
+			fd = ::open(fileName.c_str(), O_RDWR | O_CREAT, 0644);
+			struct stat fileStatus;
+			if (fd < 0 || ::fstat(fd, &fileStatus) != 0
+					|| ((size_t) fileStatus.st_size < size && ::ftruncate(fd, size) != 0)) {
+				cerr << "RMAPMemoryTarget::RMAPMemoryTarget(): " << fileName << " could not be opened" << endl;
+				if (fd >= 0) {
+					::close(fd);
+				}
+				throw RMAPMemoryTargetException(RMAPMemoryTargetException::FileCouldNotBeOpened);
+			}
+			mapped = ::mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		}
+		if (mapped == MAP_FAILED) {
+			if (fd >= 0) {
+				::close(fd);
+			}
+			throw RMAPMemoryTargetException(RMAPMemoryTargetException::MemoryCouldNotBeMapped);
+		}
+		memory = (uint8_t*) mapped;
+		pageHooks.resize((size + pageSize - 1) / pageSize, NULL);
+		nHookedPages = 0;
+		addressRange = RMAPAddressRange(baseAddress, baseAddress + size - 1);
+		addAddressRangeAndAssociatedAction(&addressRange, &accessAction);
+	}
+
+public:
+	~RMAPMemoryTarget() {
+		::munmap(memory, size);
+		if (fd >= 0) {
+			::close(fd);
+		}
+	}
+
+public:
+	uint32_t getBaseAddress() const {
+		return baseAddress;
+	}
+
+public:
+	size_t getSize() const {
+		return size;
+	}
+
+public:
+	/** Returns a pointer to the byte at an RMAP address.
+	 */
+	uint8_t* getPointer(uint32_t address = 0) throw (RMAPMemoryTargetException) {
+		if (address < baseAddress || address - baseAddress >= size) {
+			throw RMAPMemoryTargetException(RMAPMemoryTargetException::InvalidAddress);
+		}
+		return memory + (address - baseAddress);
+	}
+
+public:
+	/** Sets a hook for all pages which overlap [address, address+length).
+	 * Hooks can be changed while commands are processed; a command sees either the old or new hooks.
+	 * @param[in] hook hook instance (NULL removes hooks); not deleted by this class
+	 */
+	void setHook(uint32_t address, size_t length, RMAPMemoryTargetHook* hook) throw (RMAPMemoryTargetException) {
+		if (length == 0 || address < baseAddress || address - baseAddress + length > size) {
+			throw RMAPMemoryTargetException(RMAPMemoryTargetException::InvalidAddress);
+		}
+		size_t firstPage = (address - baseAddress) / pageSize;
+		size_t lastPage = (address - baseAddress + length - 1) / pageSize;
+		writeMutex.lock();
+		for (size_t page = firstPage; page <= lastPage; page++) {
+			pageHooks[page] = hook;
+		}
+		size_t nPages = 0;
+		for (size_t page = 0; page < pageHooks.size(); page++) {
+			if (pageHooks[page] != NULL) {
+				nPages++;
+			}
+		}
+		nHookedPages = nPages;
+		writeMutex.unlock();
+	}
+
+public:
+	/** Sets the maximum data length of verified writes.
+	 * A verified write longer than this is replied with VerifyBufferOverrun without writing data.
+	 */
+	void setVerifyBufferSize(size_t verifyBufferSize) {
+		this->verifyBufferSize = verifyBufferSize;
+	}
+
+public:
+	/** Enables/disables processing of commands in the RMAPEngine receive thread
+	 * (see RMAPTargetAccessAction::setInlineProcessing()). This shortens the response time of
+	 * register-sized accesses; a long transfer then delays reception of other packets.
+	 */
+	void setInlineProcessing(bool inlineProcessing) {
+		accessAction.setInlineProcessing(inlineProcessing);
+	}
+
+public:
+	/** Flushes a file-backed region to the file.
+	 */
+	void sync() {
+		if (fd >= 0) {
+			::msync(memory, size, MS_SYNC);
+		}
+	}
+
+private:
+	void processCommand(RMAPTargetAccessAction* action, RMAPTransaction* rmapTransaction) {
+		RMAPPacket* commandPacket = rmapTransaction->commandPacket;
+		uint32_t address = commandPacket->getAddress();
+		uint32_t length = commandPacket->getLength();
+		uint8_t status;
+		if (!commandPacket->isIncrementFlagSet()) {
+			action->setReplyWithStatus(rmapTransaction, RMAPReplyStatus::CommandNotImplementedOrNotAuthorized);
+			return;
+		}
+		if (commandPacket->isRead()) {
+			if (nHookedPages != 0) {
+				//hooks are not changed by setHook() while they are called
+				writeMutex.lock();
+				status = callHooks(&RMAPMemoryTargetHook::willRead, address, length);
+				writeMutex.unlock();
+			} else {
+				status = RMAPReplyStatus::CommandExcecutedSuccessfully;
+			}
+			if (status != RMAPReplyStatus::CommandExcecutedSuccessfully) {
+				action->setReplyWithStatus(rmapTransaction, status);
+				return;
+			}
+			action->setReplyWithStatus(rmapTransaction, RMAPReplyStatus::CommandExcecutedSuccessfully);
+			rmapTransaction->replyPacket->setDataReference(memory + (address - baseAddress), length);
+			return;
+		}
+		//write
+		if (commandPacket->isVerifyFlagSet() && length > verifyBufferSize) {
+			action->setReplyWithStatus(rmapTransaction, RMAPReplyStatus::VerifyBufferOverrun);
+			return;
+		}
+		//the data length and data CRC were checked when the command was interpreted
+		std::vector<uint8_t>* data = commandPacket->getDataBuffer();
+		writeMutex.lock();
+		status = callHooks(&RMAPMemoryTargetHook::willWrite, address, length);
+		if (status == RMAPReplyStatus::CommandExcecutedSuccessfully) {
+			if (length != 0) {
+				std::memcpy(memory + (address - baseAddress), &(*data)[0], length);
+			}
+			callDidWriteHooks(address, length);
+		}
+		writeMutex.unlock();
+		action->setReplyWithStatus(rmapTransaction, status);
+	}
+
+private:
+	void processReadModifyWriteCommand(RMAPTargetAccessAction* action, RMAPTransaction* rmapTransaction) {
+		RMAPPacket* commandPacket = rmapTransaction->commandPacket;
+		uint32_t address = commandPacket->getAddress();
+		uint32_t length = RMAPTarget::getAccessedLength(commandPacket);
+		if (!commandPacket->isIncrementFlagSet()) {
+			action->setReplyWithStatus(rmapTransaction, RMAPReplyStatus::CommandNotImplementedOrNotAuthorized);
+			return;
+		}
+		writeMutex.lock();
+		uint8_t status = callHooks(&RMAPMemoryTargetHook::willRead, address, length);
+		if (status == RMAPReplyStatus::CommandExcecutedSuccessfully) {
+			status = callHooks(&RMAPMemoryTargetHook::willWrite, address, length);
+		}
+		if (status != RMAPReplyStatus::CommandExcecutedSuccessfully) {
+			action->setReplyWithStatus(rmapTransaction, status);
+		} else {
+			action->readModifyWrite(rmapTransaction, memory + (address - baseAddress));
+			if (rmapTransaction->replyPacket->getStatus() == RMAPReplyStatus::CommandExcecutedSuccessfully) {
+				callDidWriteHooks(address, length);
+			}
+		}
+		writeMutex.unlock();
+	}
+
+private:
+	uint8_t callHooks(uint8_t (RMAPMemoryTargetHook::*method)(RMAPMemoryTarget*, uint32_t, uint32_t), uint32_t address,
+			uint32_t length) {
+		if (nHookedPages == 0 || length == 0) {
+			return RMAPReplyStatus::CommandExcecutedSuccessfully;
+		}
+		size_t offset = address - baseAddress;
+		size_t end = offset + length;
+		while (offset < end) {
+			size_t page = offset / pageSize;
+			size_t pageEnd = std::min((page + 1) * pageSize, end);
+			if (pageHooks[page] != NULL) {
+				uint8_t status = (pageHooks[page]->*method)(this, baseAddress + offset, pageEnd - offset);
+				if (status != RMAPReplyStatus::CommandExcecutedSuccessfully) {
+					return status;
+				}
+			}
+			offset = pageEnd;
+		}
+		return RMAPReplyStatus::CommandExcecutedSuccessfully;
+	}
+
+private:
+	void callDidWriteHooks(uint32_t address, uint32_t length) {
+		if (nHookedPages == 0 || length == 0) {
+			return;
+		}
+		size_t offset = address - baseAddress;
+		size_t end = offset + length;
+		while (offset < end) {
+			size_t page = offset / pageSize;
+			size_t pageEnd = std::min((page + 1) * pageSize, end);
+			if (pageHooks[page] != NULL) {
+				pageHooks[page]->didWrite(this, baseAddress + offset, pageEnd - offset);
+			}
+			offset = pageEnd;
+		}
+	}
+};
+
+#endif /* RMAPMEMORYTARGET_HH_ */
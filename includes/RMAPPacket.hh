@@ -35,6 +35,7 @@ SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #define RMAPPACKET_HH_
 
 #include <CxxUtilities/CommonHeader.hh>
+#include <cstring>
 
 #include "SpaceWirePacket.hh"
 #include "SpaceWireUtilities.hh"
@@ -118,9 +119,11 @@ private:
 
 private:
 	std::vector<uint8_t> header;
+	std::shared_ptr<const RMAPCommandHeaderTemplate> commandHeaderTemplate; //see setRMAPTargetInformation()
 
 private:
 	std::vector<uint8_t> data;
+	const uint8_t* dataReference; //see setDataReference()
 	uint8_t dataCRC;
 
 private:
@@ -197,12 +200,19 @@ public:
 		extendedAddress = RMAPProtocol::DefaultExtendedAddress;
 		headerCRC = 0;
 		dataCRC = 0;
+		dataReference = NULL;
 	}
 
 public:
 	void constructHeader() {
 		using namespace std;
 
+		if (commandHeaderTemplate && headerCRCMode == RMAPPacket::AutoCRC
+				&& commandHeaderTemplate->isApplicable(targetLogicalAddress, protocolID, instruction, key)) {
+			constructHeaderFromTemplate();
+			return;
+		}
+
 		header.clear();
 		if (isCommand()) {
 			//if command packet
@@ -253,6 +263,38 @@ public:
 		header.push_back(headerCRC);
 	}
 
+private:
+	/** Constructs a command header by patching the pre-encoded prefix of commandHeaderTemplate.
+	 * The header CRC is continued from the CRC state after the prefix.
+	 */
+	void constructHeaderFromTemplate() {
+		const std::vector<uint8_t>& prefix = commandHeaderTemplate->getHeaderPrefix();
+		size_t prefixLength = prefix.size();
+		header.resize(prefixLength + 12);
+		uint8_t* p = &header[0];
+		std::memcpy(p, &prefix[0], prefixLength);
+		p[2] = instruction;
+		uint8_t* trailer = p + prefixLength;
+		trailer[0] = initiatorLogicalAddress;
+		trailer[1] = (uint8_t) (transactionID >> 8);
+		trailer[2] = (uint8_t) (transactionID);
+		trailer[3] = extendedAddress;
+		trailer[4] = (uint8_t) (address >> 24);
+		trailer[5] = (uint8_t) (address >> 16);
+		trailer[6] = (uint8_t) (address >> 8);
+		trailer[7] = (uint8_t) (address);
+		trailer[8] = (uint8_t) (dataLength >> 16);
+		trailer[9] = (uint8_t) (dataLength >> 8);
+		trailer[10] = (uint8_t) (dataLength);
+		uint8_t crc = commandHeaderTemplate->getCRCAfterPrefix(instruction, useDraftECRC);
+		if (!useDraftECRC) {
+			headerCRC = RMAPUtilities::calculateCRC(trailer, 11, crc);
+		} else {
+			headerCRC = RMAPUtilities::calculateCRCBasedOnDraftESpecification(trailer, 11, crc);
+		}
+		trailer[11] = headerCRC;
+	}
+
 public:
 	inline void calculateHeaderCRC() {
 		if (!useDraftECRC) {
@@ -264,6 +306,10 @@ public:
 
 public:
 	inline void calculateDataCRC() {
+		if (dataReference != NULL) {
+			calculateDataCRC(dataReference, dataLength);
+			return;
+		}
 		if (!useDraftECRC) {
 			dataCRC = RMAPUtilities::calculateCRC(data);
 		} else {
@@ -271,12 +317,21 @@ public:
 		}
 	}
 
+private:
+	inline void calculateDataCRC(const uint8_t* data, size_t length) {
+		if (!useDraftECRC) {
+			dataCRC = RMAPUtilities::calculateCRC(data, length);
+		} else {
+			dataCRC = RMAPUtilities::calculateCRCBasedOnDraftESpecification(data, length);
+		}
+	}
+
 public:
 	void constructPacket() {
 		using namespace std;
 
 		constructHeader();
-		if (dataCRCMode == RMAPPacket::AutoCRC) {
+		if (dataCRCMode == RMAPPacket::AutoCRC && dataReference == NULL) {
 			calculateDataCRC();
 		}
 		wholePacket.clear();
@@ -286,7 +341,17 @@ public:
 			SpaceWireUtilities::concatenateTo(wholePacket, replyAddress);
 		}
 		SpaceWireUtilities::concatenateTo(wholePacket, header);
-		SpaceWireUtilities::concatenateTo(wholePacket, data);
+		if (dataReference != NULL) {
+			//copied directly from the referenced memory; the data CRC is calculated over the copy
+			//so that it matches the sent data even if the memory is modified meanwhile
+			size_t dataOffset = wholePacket.size();
+			wholePacket.insert(wholePacket.end(), dataReference, dataReference + dataLength);
+			if (dataCRCMode == RMAPPacket::AutoCRC) {
+				calculateDataCRC(wholePacket.data() + dataOffset, dataLength);
+			}
+		} else {
+			SpaceWireUtilities::concatenateTo(wholePacket, data);
+		}
 		if (hasData()) {
 			wholePacket.push_back(dataCRC);
 		}
@@ -300,6 +365,7 @@ public:
 			throw(RMAPPacketException(RMAPPacketException::PacketInterpretationFailed));
 		}
 		std::vector<uint8_t> temporaryPathAddress;
+		commandHeaderTemplate.reset();
 		try {
 			size_t i = 0;
 			size_t rmapIndex = 0;
@@ -366,14 +432,13 @@ public:
 				}
 				dataIndex = rmapIndexAfterSourcePathAddress + 12;
 				data.clear();
-				if (isWrite()) {
-					for (uint32_t i = 0; i < lengthSpecifiedInPacket; i++) {
-						if ((dataIndex + i) < (length - 1)) {
-							data.push_back(packet[dataIndex + i]);
-						} else {
-							throw(RMAPPacketException(RMAPPacketException::DataLengthMismatch));
-						}
+				dataReference = NULL;
+				//a read-modify-write command carries data and mask in the data field
+				if (isWrite() || isReadModifyWrite()) {
+					if (dataIndex + lengthSpecifiedInPacket > length - 1) {
+						throw(RMAPPacketException(RMAPPacketException::DataLengthMismatch));
 					}
+					data.assign(packet + dataIndex, packet + dataIndex + lengthSpecifiedInPacket);
 
 					//length check for DataCRC
 					uint8_t temporaryDataCRC = 0x00;
@@ -434,14 +499,12 @@ public:
 					}
 					dataIndex = rmapIndex + 12;
 					data.clear();
-					for (uint32_t i = 0; i < lengthSpecifiedInPacket; i++) {
-						if ((dataIndex + i) < (length - 1)) {
-							data.push_back(packet[dataIndex + i]);
-						} else {
-							dataCRC = 0x00; //initialized
-							throw(RMAPPacketException(RMAPPacketException::DataLengthMismatch));
-						}
+					dataReference = NULL;
+					if (dataIndex + lengthSpecifiedInPacket > length - 1) {
+						dataCRC = 0x00; //initialized
+						throw(RMAPPacketException(RMAPPacketException::DataLengthMismatch));
 					}
+					data.assign(packet + dataIndex, packet + dataIndex + lengthSpecifiedInPacket);
 
 					//length check for DataCRC
 					uint8_t temporaryDataCRC = 0x00;
@@ -491,11 +554,20 @@ public:
 	}
 
 public:
+	/** Sets target information from an RMAPTargetNode.
+	 * Addresses are copied from the node's command header template (see RMAPTargetNode::getCommandHeaderTemplate())
+	 * into the existing buffers of this packet, and the template is kept so that constructHeader()
+	 * does not re-encode them.
+	 */
 	void setRMAPTargetInformation(RMAPTargetNode *rmapTargetNode) {
-		setTargetLogicalAddress(rmapTargetNode->getTargetLogicalAddress());
-		setReplyAddress(rmapTargetNode->getReplyAddress());
-		setTargetSpaceWireAddress(rmapTargetNode->getTargetSpaceWireAddress());
-		setKey(rmapTargetNode->getDefaultKey());
+		std::shared_ptr<const RMAPCommandHeaderTemplate> headerTemplate = rmapTargetNode->getCommandHeaderTemplate();
+		targetLogicalAddress = headerTemplate->getTargetLogicalAddress();
+		targetSpaceWireAddress = headerTemplate->getTargetSpaceWireAddress();
+		replyAddress = headerTemplate->getReplyAddress();
+		instruction = (instruction & (~BitMaskForReplyPathAddressLength))
+				| (headerTemplate->getFixedInstructionBits() & BitMaskForReplyPathAddressLength);
+		key = headerTemplate->getKey();
+		commandHeaderTemplate = headerTemplate;
 		if (rmapTargetNode->isInitiatorLogicalAddressSet()) {
 			setInitiatorLogicalAddress(rmapTargetNode->getInitiatorLogicalAddress());
 		}
@@ -562,6 +634,29 @@ public:
 		instruction = instruction & (~RMAPPacket::BitMaskForWriteRead);
 	}
 
+public:
+	/** Returns true if this is a read-modify-write command or reply
+	 * (Write/Read bit = 0 and Verify bit = 1).
+	 */
+	inline bool isReadModifyWrite() {
+		if ((instruction & (RMAPPacket::BitMaskForWriteRead | RMAPPacket::BitMaskForVerifyFlag))
+				== RMAPPacket::BitMaskForVerifyFlag) {
+			return true;
+		} else {
+			return false;
+		}
+	}
+
+public:
+	/** Sets the instruction field to read-modify-write (a reply is always requested).
+	 * The data field of an RMW command consists of data followed by mask of the same length.
+	 */
+	inline void setReadModifyWrite() {
+		setRead();
+		setVerifyFlag();
+		setReplyFlag();
+	}
+
 public:
 	inline bool isVerifyFlagSet() {
 		if ((instruction & RMAPPacket::BitMaskForVerifyFlag) > 0) {
@@ -670,7 +765,7 @@ public:
 		if (data.size() != 0) {
 			return true;
 		} else {
-			if ((isCommand() && isWrite()) || (isReply() && isRead())) {
+			if ((isCommand() && (isWrite() || isReadModifyWrite())) || (isReply() && isRead())) {
 				return true;
 			} else {
 				return false;
@@ -690,8 +785,8 @@ public:
 		if (maxLength < length) {
 			throw RMAPPacketException(RMAPPacketException::InsufficientBufferSize);
 		}
-		for (uint32_t i = 0; i < length; i++) {
-			buffer[i] = data[i];
+		if (length != 0) {
+			std::memcpy(buffer, &data[0], length);
 		}
 	}
 
@@ -783,15 +878,26 @@ public:
 	void setData(std::vector<uint8_t> & data) {
 		this->data = data;
 		this->dataLength = data.size();
+		this->dataReference = NULL;
 	}
 
 public:
 	void setData(uint8_t *data, size_t length) {
+		this->data.assign(data, data + length);
+		this->dataLength = length;
+		this->dataReference = NULL;
+	}
+
+public:
+	/** Makes the data field of this packet refer to memory owned by the caller, instead of a copy.
+	 * constructPacket() copies the referenced bytes directly into the packet buffer (and calculates
+	 * the data CRC over the copy), so the memory should stay valid until constructPacket() is called.
+	 * getData()/getDataBuffer() do not return referenced data. setData()/clearData() cancel the reference.
+	 */
+	void setDataReference(const uint8_t* data, size_t length) {
 		this->data.clear();
-		for (size_t i = 0; i < length; i++) {
-			this->data.push_back(data[i]);
-		}
 		this->dataLength = length;
+		this->dataReference = data;
 	}
 
 public:
@@ -838,6 +944,7 @@ public:
 	void setReplyAddress(std::vector<uint8_t> replyAddress, //
 			bool automaticallySetPathAddressLengthToInstructionField = true) {
 		this->replyAddress = replyAddress;
+		commandHeaderTemplate.reset();
 		if (automaticallySetPathAddressLengthToInstructionField) {
 			if (replyAddress.size() % 4 == 0) {
 				instruction = (instruction & (~BitMaskForReplyPathAddressLength)) + replyAddress.size() / 4;
@@ -891,6 +998,7 @@ public:
 public:
 	inline void clearData() {
 		data.clear();
+		dataReference = NULL;
 	}
 
 public:
@@ -987,7 +1095,7 @@ private:
 				<< endl;
 		//Data Part
 		ss << "---------  RMAP Data Part  ---------" << endl;
-		if (isWrite()) {
+		if (isWrite() || isReadModifyWrite()) {
 			ss << "[data size = " << dec << dataLength << "bytes]" << endl;
 			SpaceWireUtilities::dumpPacket(&ss, &data, 1, 16);
 			ss << "Data CRC                  : " << right << setw(2) << setfill('0') << hex << (unsigned int) (dataCRC)
@@ -1358,15 +1466,37 @@ public:
 	static RMAPPacket* constructReplyForCommand(RMAPPacket* commandPacket, uint8_t status =
 			RMAPReplyStatus::CommandExcecutedSuccessfully) {
 		RMAPPacket* replyPacket = new RMAPPacket();
+		constructReplyForCommand(commandPacket, status, replyPacket);
+		return replyPacket;
+	}
+
+public:
+	/** Fills an existing packet instance with the reply for a command.
+	 * Buffers already allocated in replyPacket are reused.
+	 */
+	static void constructReplyForCommand(RMAPPacket* commandPacket, uint8_t status, RMAPPacket* replyPacket) {
+		//the command's data and packet buffer (which can be large) are not copied to the reply
+		std::vector<uint8_t> commandData;
+		std::vector<uint8_t> commandWholePacket;
+		commandData.swap(commandPacket->data);
+		commandWholePacket.swap(commandPacket->wholePacket);
 		*replyPacket = *commandPacket;
+		commandPacket->data.swap(commandData);
+		commandPacket->wholePacket.swap(commandWholePacket);
 
 		//remove leading zeros in the Reply Address (Reply SpaceWire Address)
 		replyPacket->setReplyAddress(removeLeadingZerosInReplyAddress(replyPacket->getReplyAddress()));
 
 		replyPacket->clearData();
+		if (commandPacket->isReadModifyWrite()) {
+			//the data length of an RMW reply is that of the returned (old) data, which is set later
+			replyPacket->setDataLength(0);
+		} else if (commandPacket->isRead() && status != RMAPReplyStatus::CommandExcecutedSuccessfully) {
+			//an error reply to a read command carries no data
+			replyPacket->setDataLength(0);
+		}
 		replyPacket->setReply();
 		replyPacket->setStatus(status);
-		return replyPacket;
 	}
 };
 #endif /* RMAPPACKET_HH_ */
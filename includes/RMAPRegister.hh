@@ -0,0 +1,163 @@
+/* 
+============================================================================
+SpaceWire/RMAP Library is provided under the MIT License.
+============================================================================
+
+Copyright (c) 2006-2013 Takayuki Yuasa and The Open-source SpaceWire Project
+
+Permission is hereby granted, free of charge, to any person obtaining a 
+copy of this software and associated documentation files (the 
+"Software"), to deal in the Software without restriction, including 
+without limitation the rights to use, copy, modify, merge, publish, 
+distribute, sublicense, and/or sell copies of the Software, and to 
+permit persons to whom the Software is furnished to do so, subject to 
+the following conditions:
+
+The above copyright notice and this permission notice shall be included 
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. 
+*/
+/*
+ * RMAPRegister.hh
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef RMAPREGISTER_HH_
+#define RMAPREGISTER_HH_
+
+#include <CxxUtilities/CommonHeader.hh>
+#include <type_traits>
+#include "RMAPMemoryObject.hh"
+
+/** Byte order of a register defined with RMAPRegister. */
+class RMAPRegisterEndianness {
+public:
+	enum Type {
+		BigEndian, LittleEndian
+	};
+};
+
+/** A register of an RMAP target defined at compile time.
+ * Unlike RMAPMemoryObject, whose address and length are looked up by string ID at runtime,
+ * a register map is a set of types, e.g.
+ * <pre>
+ * typedef RMAPRegister<0x0002, uint16_t> TriggerModeRegister;
+ * typedef RMAPRegisterField<Status1Register, 4, 1, bool> BufferFull;
+ * </pre>
+ * and RMAPInitiator::readRegister()/writeRegister() access them with the address and length
+ * as constants, converting values in the register's byte order. Access mode is checked at
+ * compile time.
+ * @tparam RegisterAddress address (or the offset from a base address given when accessed)
+ * @tparam RegisterValueType integer or enum type of the register value (the size is the register width: 1, 2, 4, or 8 bytes)
+ * @tparam RegisterAccessMode combination of RMAPMemoryObject::Readable, Writable, and RMWable
+ * @tparam RegisterEndianness byte order of the value in the target memory
+ */
+template<uint32_t RegisterAddress, typename RegisterValueType,
+		uint32_t RegisterAccessMode = RMAPMemoryObject::Readable | RMAPMemoryObject::Writable,
+		RMAPRegisterEndianness::Type RegisterEndianness = RMAPRegisterEndianness::BigEndian>
+class RMAPRegister {
+public:
+	typedef RegisterValueType ValueType;
+	static const uint32_t Address = RegisterAddress;
+	static const uint32_t Length = sizeof(RegisterValueType);
+	static const uint32_t AccessMode = RegisterAccessMode;
+	static const RMAPRegisterEndianness::Type Endianness = RegisterEndianness;
+
+	static_assert(Length == 1 || Length == 2 || Length == 4 || Length == 8, "register width should be 1, 2, 4, or 8 bytes");
+	static_assert(std::is_integral<RegisterValueType>::value || std::is_enum<RegisterValueType>::value,
+			"register value should be an integer or an enum");
+
+public:
+	static constexpr bool isReadable() {
+		return (RegisterAccessMode & RMAPMemoryObject::Readable) != 0;
+	}
+
+public:
+	static constexpr bool isWritable() {
+		return (RegisterAccessMode & RMAPMemoryObject::Writable) != 0;
+	}
+
+public:
+	static constexpr bool isRMWable() {
+		return (RegisterAccessMode & RMAPMemoryObject::RMWable) != 0;
+	}
+
+public:
+	/** Converts a value to Length bytes in the register's byte order. */
+	static inline void encode(ValueType value, uint8_t* buffer) {
+		uint64_t raw = static_cast<uint64_t>(value);
+		for (size_t i = 0; i < Length; i++) {
+			size_t shift = (RegisterEndianness == RMAPRegisterEndianness::BigEndian) ? (Length - 1 - i) * 8 : i * 8;
+			buffer[i] = static_cast<uint8_t>(raw >> shift);
+		}
+	}
+
+public:
+	/** Converts Length bytes in the register's byte order to a value. */
+	static inline ValueType decode(const uint8_t* buffer) {
+		uint64_t raw = 0;
+		for (size_t i = 0; i < Length; i++) {
+			size_t shift = (RegisterEndianness == RMAPRegisterEndianness::BigEndian) ? (Length - 1 - i) * 8 : i * 8;
+			raw |= static_cast<uint64_t>(buffer[i]) << shift;
+		}
+		return static_cast<ValueType>(raw);
+	}
+
+public:
+	/** Creates an equivalent RMAPMemoryObject (e.g. to add it to an RMAPTargetNode used by code
+	 * which accesses memory objects by ID).
+	 */
+	static RMAPMemoryObject* createMemoryObject(std::string id, uint32_t offset = 0) {
+		RMAPMemoryObject* memoryObject = new RMAPMemoryObject();
+		memoryObject->setID(id);
+		memoryObject->setExtendedAddress(0x00);
+		memoryObject->setAddress(RegisterAddress + offset);
+		memoryObject->setLength(Length);
+		memoryObject->setAccessMode(RegisterAccessMode);
+		return memoryObject;
+	}
+};
+
+/** A bit field of a register defined with RMAPRegister.
+ * @tparam Register RMAPRegister type (its value type should be an integer)
+ * @tparam FieldOffset position of the least significant bit of the field
+ * @tparam FieldWidth number of bits
+ * @tparam FieldValueType type of the field value (e.g. bool for 1-bit flags)
+ */
+template<class Register, unsigned FieldOffset, unsigned FieldWidth,
+		typename FieldValueType = typename Register::ValueType>
+class RMAPRegisterField {
+public:
+	typedef Register RegisterType;
+	typedef FieldValueType ValueType;
+	static const unsigned Offset = FieldOffset;
+	static const unsigned Width = FieldWidth;
+	static constexpr uint64_t Mask = ((FieldWidth >= 64) ? ~0ULL : ((1ULL << FieldWidth) - 1)) << FieldOffset;
+
+	static_assert(std::is_integral<typename Register::ValueType>::value, "bit fields need an integer register");
+	static_assert(FieldWidth != 0 && FieldOffset + FieldWidth <= Register::Length * 8, "bit field exceeds the register");
+
+public:
+	/** Returns the field value in a register value. */
+	static inline ValueType extract(typename Register::ValueType registerValue) {
+		return static_cast<ValueType>((static_cast<uint64_t>(registerValue) & Mask) >> FieldOffset);
+	}
+
+public:
+	/** Returns a register value whose field is replaced with a value (other bits are kept). */
+	static inline typename Register::ValueType insert(typename Register::ValueType registerValue, ValueType value) {
+		uint64_t raw = (static_cast<uint64_t>(registerValue) & ~Mask)
+				| ((static_cast<uint64_t>(value) << FieldOffset) & Mask);
+		return static_cast<typename Register::ValueType>(raw);
+	}
+};
+
+#endif /* RMAPREGISTER_HH_ */
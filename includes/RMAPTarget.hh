@@ -35,6 +35,7 @@ SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #define RMAPTARGET_HH_
 
 #include "RMAPTransaction.hh"
+#include "RMAPAddressMap.hh"
 
 class RMAPAddressRange {
 public:
@@ -105,13 +106,46 @@ public:
 };
 
 class RMAPTargetAccessAction {
+private:
+	bool inlineProcessing = false;
+
 public:
 	virtual ~RMAPTargetAccessAction() {
 	}
 
+public:
+	/** Enables/disables inline processing. By default, RMAPEngine processes each command
+	 * in a new thread. With inline processing, RMAPEngine calls processTransaction()
+	 * (or processReadModifyWriteTransaction()) in its receive thread and sends the reply
+	 * immediately, using a reply packet instance owned by RMAPEngine. This removes the thread
+	 * handoff, and suits actions which complete quickly without blocking (e.g. register maps);
+	 * while an inline action runs, no other packet is received.
+	 * For inline actions, transactionWillComplete() and transactionReplyCouldNotBeSent()
+	 * are called only if the action replaced the reply packet with its own instance.
+	 */
+	void setInlineProcessing(bool inlineProcessing) {
+		this->inlineProcessing = inlineProcessing;
+	}
+
+public:
+	bool isInlineProcessingEnabled() const {
+		return inlineProcessing;
+	}
+
 public:
 	virtual void processTransaction(RMAPTransaction* rmapTransaction) throw (RMAPTargetAccessActionException)= 0;
 
+	/** Processes a read-modify-write command.
+	 * The default implementation replies CommandNotImplementedOrNotAuthorized.
+	 * A subclass that supports RMW overrides this method, and typically calls
+	 * readModifyWrite() while holding a lock which also serializes processTransaction(),
+	 * so that the RMW is atomic with respect to other accesses.
+	 */
+	virtual void processReadModifyWriteTransaction(RMAPTransaction* rmapTransaction)
+			throw (RMAPTargetAccessActionException) {
+		setReplyWithStatus(rmapTransaction, RMAPReplyStatus::CommandNotImplementedOrNotAuthorized);
+	}
+
 	virtual void transactionWillComplete(RMAPTransaction* rmapTransaction) throw (RMAPTargetAccessActionException) {
 		delete rmapTransaction->replyPacket;
 	}
@@ -122,16 +156,50 @@ public:
 	}
 
 public:
+	/** Sets a reply. If the transaction already has a reply packet instance
+	 * (e.g. provided by RMAPEngine for inline processing), it is reused.
+	 */
 	void setReplyWithDataWithStatus(RMAPTransaction* rmapTransaction, std::vector<uint8_t>* data, uint8_t status) {
-		rmapTransaction->replyPacket = RMAPPacket::constructReplyForCommand(rmapTransaction->commandPacket, status);
+		setReplyWithStatus(rmapTransaction, status);
 		rmapTransaction->replyPacket->setData(*data);
 	}
 
 	void setReplyWithStatus(RMAPTransaction* rmapTransaction, uint8_t status) {
-		rmapTransaction->replyPacket = RMAPPacket::constructReplyForCommand(rmapTransaction->commandPacket, status);
+		if (rmapTransaction->replyPacket == NULL) {
+			rmapTransaction->replyPacket = RMAPPacket::constructReplyForCommand(rmapTransaction->commandPacket, status);
+		} else {
+			RMAPPacket::constructReplyForCommand(rmapTransaction->commandPacket, status, rmapTransaction->replyPacket);
+		}
 		rmapTransaction->replyPacket->clearData();
 	}
 
+public:
+	static const uint32_t MaximumReadModifyWriteLength = 4;
+
+public:
+	/** Executes a read-modify-write command on memory, and sets a reply which contains the data before modification.
+	 * Each byte becomes (data & mask) | (old & ~mask). A command whose data length is not
+	 * 2n (n = 0 to 4) is replied with RMWDataLengthError without modifying memory.
+	 * @param[in] memory pointer to the accessed bytes (the command's length/2 bytes)
+	 */
+	void readModifyWrite(RMAPTransaction* rmapTransaction, uint8_t* memory) {
+		RMAPPacket* commandPacket = rmapTransaction->commandPacket;
+		uint32_t length = commandPacket->getLength() / 2;
+		std::vector<uint8_t>* dataAndMask = commandPacket->getDataBuffer();
+		if (commandPacket->getLength() % 2 != 0 || length > MaximumReadModifyWriteLength
+				|| dataAndMask->size() != length * 2) {
+			setReplyWithStatus(rmapTransaction, RMAPReplyStatus::RMWDataLengthError);
+			return;
+		}
+		std::vector<uint8_t> previousData(memory, memory + length);
+		for (uint32_t i = 0; i < length; i++) {
+			uint8_t data = (*dataAndMask)[i];
+			uint8_t mask = (*dataAndMask)[length + i];
+			memory[i] = (data & mask) | (memory[i] & ~mask);
+		}
+		setReplyWithDataWithStatus(rmapTransaction, &previousData, RMAPReplyStatus::CommandExcecutedSuccessfully);
+	}
+
 };
 
 class RMAPTargetException: public CxxUtilities::Exception {
@@ -152,12 +220,14 @@ public:
 
 class RMAPTarget {
 private:
-	std::map<RMAPAddressRange*, RMAPTargetAccessAction*> actions;
 	std::vector<RMAPAddressRange*> addressRanges;
+	std::vector<RMAPTargetAccessAction*> actions;
+	CxxUtilities::Mutex addressRangesMutex;
+	std::shared_ptr<const RMAPAddressMap> addressMap;
 
 public:
 	RMAPTarget() {
-
+		compileAddressMap();
 	}
 
 	~RMAPTarget() {
@@ -165,61 +235,125 @@ public:
 	}
 
 public:
+	/** Registers an address range and the action which processes commands accessing it.
+	 * The range is copied into the compiled address map, so an RMAPAddressRange instance
+	 * should not be modified after it is registered.
+	 */
 	void addAddressRangeAndAssociatedAction(RMAPAddressRange* addressRange, RMAPTargetAccessAction* action) {
-		actions[addressRange] = action;
+		addressRangesMutex.lock();
 		addressRanges.push_back(addressRange);
+		actions.push_back(action);
+		compileAddressMap();
+		addressRangesMutex.unlock();
 	}
 
-	bool doesAcceptAddressRange(RMAPAddressRange addressRange) {
-		for (size_t i = 0; i < addressRanges.size(); i++) {
-			if (addressRanges[i]->contains(addressRange) == true) {
-				return true;
-			}
+	/** Registers many address ranges at once. The address map is compiled only once,
+	 * which is much faster than calling addAddressRangeAndAssociatedAction() for each range.
+	 */
+	void addAddressRangesAndAssociatedActions(
+			const std::vector<std::pair<RMAPAddressRange*, RMAPTargetAccessAction*> >& rangesAndActions) {
+		addressRangesMutex.lock();
+		for (size_t i = 0; i < rangesAndActions.size(); i++) {
+			addressRanges.push_back(rangesAndActions[i].first);
+			actions.push_back(rangesAndActions[i].second);
 		}
-		return false;
+		compileAddressMap();
+		addressRangesMutex.unlock();
 	}
 
-	bool doesAcceptTransaction(RMAPTransaction* rmapTransaction) {
-		uint32_t addressFrom = rmapTransaction->commandPacket->getAddress();
-		uint32_t addressTo = addressFrom + rmapTransaction->commandPacket->getLength();
-		RMAPAddressRange addressRange(addressFrom, addressTo);
+	/** Unregisters an address range (and its action).
+	 */
+	void removeAddressRange(RMAPAddressRange* addressRange) {
+		addressRangesMutex.lock();
 		for (size_t i = 0; i < addressRanges.size(); i++) {
-			if (addressRanges[i]->contains(addressRange) == true) {
-				return true;
+			if (addressRanges[i] == addressRange) {
+				addressRanges.erase(addressRanges.begin() + i);
+				actions.erase(actions.begin() + i);
+				break;
 			}
 		}
-		return false;
+		compileAddressMap();
+		addressRangesMutex.unlock();
+	}
+
+	bool doesAcceptAddressRange(RMAPAddressRange addressRange) {
+		return getAddressMap()->find(addressRange.addressFrom, addressRange.addressTo) != NULL;
+	}
+
+public:
+	/** Returns the number of bytes accessed by a command.
+	 * The data field of a read-modify-write command is data followed by mask, and therefore
+	 * only half of its length is accessed.
+	 */
+	static uint32_t getAccessedLength(RMAPPacket* commandPacket) {
+		if (commandPacket->isReadModifyWrite()) {
+			return commandPacket->getLength() / 2;
+		} else {
+			return commandPacket->getLength();
+		}
+	}
+
+public:
+	/** Returns the address range (both ends inclusive) accessed by a command.
+	 */
+	static RMAPAddressRange getAccessedAddressRange(RMAPPacket* commandPacket) {
+		uint32_t addressFrom = commandPacket->getAddress();
+		uint32_t length = getAccessedLength(commandPacket);
+		return RMAPAddressRange(addressFrom, (length == 0) ? addressFrom : addressFrom + length - 1);
+	}
+
+public:
+	bool doesAcceptTransaction(RMAPTransaction* rmapTransaction) {
+		return getCorrespondingRMAPTargetAccessAction(rmapTransaction) != NULL;
 	}
 
 	void processTransaction(RMAPTransaction* rmapTransaction) throw (RMAPTargetException) {
-		uint32_t addressFrom = rmapTransaction->commandPacket->getAddress();
-		uint32_t addressTo = addressFrom + rmapTransaction->commandPacket->getLength();
-		RMAPAddressRange addressRange(addressFrom, addressTo);
-		for (size_t i = 0; i < addressRanges.size(); i++) {
-			if (addressRanges[i]->contains(addressRange) == true) {
-				try {
-					actions[addressRanges[i]]->processTransaction(rmapTransaction);
-					return;
-				} catch (...) {
-					throw RMAPTargetException(RMAPTargetException::AccessToUndefinedAddressRange);
-				}
+		RMAPTargetAccessAction* action = getCorrespondingRMAPTargetAccessAction(rmapTransaction);
+		if (action == NULL) {
+			throw RMAPTargetException(RMAPTargetException::AccessToUndefinedAddressRange);
+		}
+		try {
+			if (rmapTransaction->commandPacket->isReadModifyWrite()) {
+				action->processReadModifyWriteTransaction(rmapTransaction);
+			} else {
+				action->processTransaction(rmapTransaction);
 			}
+		} catch (...) {
+			throw RMAPTargetException(RMAPTargetException::AccessToUndefinedAddressRange);
 		}
-		throw RMAPTargetException(RMAPTargetException::AccessToUndefinedAddressRange);
 	}
 
 	/** Can return NULL. */
 	RMAPTargetAccessAction* getCorrespondingRMAPTargetAccessAction(RMAPTransaction* rmapTransaction) {
-		using namespace std;
-		uint32_t addressFrom = rmapTransaction->commandPacket->getAddress();
-		uint32_t addressTo = addressFrom + rmapTransaction->commandPacket->getLength() - 1;
-		RMAPAddressRange addressRange(addressFrom, addressTo);
+		RMAPAddressRange addressRange = getAccessedAddressRange(rmapTransaction->commandPacket);
+		return getAddressMap()->find(addressRange.addressFrom, addressRange.addressTo);
+	}
+
+public:
+	/** Returns the compiled address map of this target.
+	 * The returned instance stays valid (and unchanged) even if ranges are added/removed later.
+	 */
+	std::shared_ptr<const RMAPAddressMap> getAddressMap() const {
+		return std::atomic_load(&addressMap);
+	}
+
+private:
+	/** Compiles registered ranges into a new RMAPAddressMap, and publishes it.
+	 * Called with addressRangesMutex locked (or from the constructor).
+	 */
+	void compileAddressMap() {
+		std::vector<RMAPAddressMap::Entry> entries(addressRanges.size());
 		for (size_t i = 0; i < addressRanges.size(); i++) {
-			if (addressRanges[i]->contains(addressRange) == true) {
-				return actions[addressRanges[i]];
-			}
+			entries[i].addressFrom = addressRanges[i]->addressFrom;
+			entries[i].addressTo = addressRanges[i]->addressTo;
+			entries[i].priority = i;
+			entries[i].action = actions[i];
 		}
-		return NULL;
+		std::shared_ptr<const RMAPAddressMap> newAddressMap = std::make_shared<const RMAPAddressMap>(entries,
+				RMAPAddressMap::getCurrentGeneration());
+		std::atomic_store(&addressMap, newAddressMap);
+		//advanced after publishing so that RMAPEngine recompiles with this map
+		RMAPAddressMap::advanceGeneration();
 	}
 
 };
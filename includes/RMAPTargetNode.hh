@@ -35,9 +35,12 @@ SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #define RMAPTARGETNODE_HH_
 
 #include <CxxUtilities/CommonHeader.hh>
+#include <memory>
+#include <unordered_map>
 #include "SpaceWireUtilities.hh"
 #include "RMAPMemoryObject.hh"
 #include "RMAPNode.hh"
+#include "RMAPCommandHeaderTemplate.hh"
 #ifndef NO_XMLLODER
 #include "XMLUtilities/XMLUtilities.hh"
 #endif
@@ -86,6 +89,40 @@ public:
 
 };
 
+/** An interned reference to an RMAPMemoryObject of an RMAPTargetNode, obtained once via
+ * RMAPTargetNode::getMemoryObjectHandle(). Resolving a handle is an array access, so accesses
+ * via a handle (e.g. RMAPInitiator::read(RMAPTargetNode*, RMAPMemoryObjectHandle, uint8_t*))
+ * do not hash or compare memory object IDs. A handle remains valid for the node from which it
+ * was obtained (also after the memory object is replaced by addMemoryObject() with the same ID).
+ */
+class RMAPMemoryObjectHandle {
+public:
+	static const uint32_t InvalidIndex = 0xFFFFFFFF;
+
+private:
+	uint32_t index;
+
+public:
+	RMAPMemoryObjectHandle() :
+			index(InvalidIndex) {
+	}
+
+public:
+	explicit RMAPMemoryObjectHandle(uint32_t index) :
+			index(index) {
+	}
+
+public:
+	uint32_t getIndex() const {
+		return index;
+	}
+
+public:
+	bool isValid() const {
+		return index != InvalidIndex;
+	}
+};
+
 class RMAPTargetNode: public RMAPNode {
 private:
 	std::vector<uint8_t> targetSpaceWireAddress;
@@ -96,12 +133,17 @@ private:
 
 	bool isInitiatorLogicalAddressSet_;
 
+private:
+	std::shared_ptr<const RMAPCommandHeaderTemplate> commandHeaderTemplate; //see getCommandHeaderTemplate()
+
 public:
 	static const uint8_t DefaultLogicalAddress = 0xFE;
 	static const uint8_t DefaultKey = 0x20;
 
 private:
 	std::map<std::string, RMAPMemoryObject*> memoryObjects;
+	std::unordered_map<std::string, uint32_t> memoryObjectIndices; //ID - index in memoryObjectTable
+	std::vector<RMAPMemoryObject*> memoryObjectTable; //indexed by RMAPMemoryObjectHandle
 
 public:
 	RMAPTargetNode() {
@@ -264,6 +306,7 @@ public:
 			newList.push_back(targetSpaceWireAddress.at(i));
 		}
 		targetSpaceWireAddress = newList;
+		invalidateCommandHeaderTemplate();
 	}
 
 public:
@@ -274,6 +317,7 @@ public:
 		}
 		newList.push_back(spaceWireAddress);
 		targetSpaceWireAddress = newList;
+		invalidateCommandHeaderTemplate();
 	}
 
 public:
@@ -284,6 +328,7 @@ public:
 			newList.push_back(replyAddress.at(i));
 		}
 		replyAddress = newList;
+		invalidateCommandHeaderTemplate();
 	}
 
 public:
@@ -294,6 +339,7 @@ public:
 		}
 		newList.push_back(spaceWireAddress);
 		replyAddress = newList;
+		invalidateCommandHeaderTemplate();
 	}
 
 public:
@@ -319,21 +365,25 @@ public:
 public:
 	void setDefaultKey(uint8_t defaultKey) {
 		this->defaultKey = defaultKey;
+		invalidateCommandHeaderTemplate();
 	}
 
 public:
 	void setReplyAddress(std::vector<uint8_t> replyAddress) {
 		this->replyAddress = replyAddress;
+		invalidateCommandHeaderTemplate();
 	}
 
 public:
 	void setTargetLogicalAddress(uint8_t targetLogicalAddress) {
 		this->targetLogicalAddress = targetLogicalAddress;
+		invalidateCommandHeaderTemplate();
 	}
 
 public:
 	void setTargetSpaceWireAddress(std::vector<uint8_t> targetSpaceWireAddress) {
 		this->targetSpaceWireAddress = targetSpaceWireAddress;
+		invalidateCommandHeaderTemplate();
 	}
 
 public:
@@ -358,22 +408,55 @@ public:
 		return initiatorLogicalAddress;
 	}
 
+public:
+	/** Returns a pre-encoded command header for this target, which RMAPPacket::setRMAPTargetInformation()
+	 * uses so that a command header is constructed without re-encoding the invariant fields.
+	 * The template is created on first use, and re-created after the target SpaceWire address,
+	 * target logical address, reply address, or default key is changed.
+	 */
+	std::shared_ptr<const RMAPCommandHeaderTemplate> getCommandHeaderTemplate() {
+		std::shared_ptr<const RMAPCommandHeaderTemplate> result = std::atomic_load(&commandHeaderTemplate);
+		if (!result) {
+			result = std::make_shared<const RMAPCommandHeaderTemplate>(targetSpaceWireAddress, targetLogicalAddress,
+					defaultKey, replyAddress);
+			std::atomic_store(&commandHeaderTemplate, result);
+		}
+		return result;
+	}
+
+private:
+	void invalidateCommandHeaderTemplate() {
+		std::atomic_store(&commandHeaderTemplate, std::shared_ptr<const RMAPCommandHeaderTemplate>());
+	}
+
 public:
 	void addMemoryObject(RMAPMemoryObject* memoryObject) {
 		memoryObjects[memoryObject->getID()] = memoryObject;
+		internMemoryObject(memoryObject);
 	}
 
 public:
+	/** Returns the memory objects ordered by ID.
+	 * @attention This method is deprecated; use getMemoryObjectMap() to read memory objects, and
+	 * addMemoryObject() to add them. A memory object inserted into the returned map is found by
+	 * getMemoryObject()/findMemoryObject(), but has no handle (getMemoryObjectHandle() throws).
+	 */
 	std::map<std::string, RMAPMemoryObject*>* getMemoryObjects() {
 		return &memoryObjects;
 	}
 
+public:
+	/** Returns the memory objects ordered by ID. Memory objects are added via addMemoryObject(). */
+	const std::map<std::string, RMAPMemoryObject*>* getMemoryObjectMap() const {
+		return &memoryObjects;
+	}
+
 public:
 	/** This method does not return NULL even when not found, but throws an exception. */
-	RMAPMemoryObject* getMemoryObject(std::string memoryObjectID) throw (RMAPTargetNodeException) {
-		std::map<std::string, RMAPMemoryObject*>::iterator it = memoryObjects.find(memoryObjectID);
-		if (it != memoryObjects.end()) {
-			return it->second;
+	RMAPMemoryObject* getMemoryObject(const std::string& memoryObjectID) throw (RMAPTargetNodeException) {
+		RMAPMemoryObject* memoryObject = findMemoryObject(memoryObjectID);
+		if (memoryObject != NULL) {
+			return memoryObject;
 		} else {
 			throw RMAPTargetNodeException(RMAPTargetNodeException::NoSuchRMAPMemoryObject);
 		}
@@ -381,15 +464,57 @@ public:
 
 public:
 	/** This method can return NULL when not found.*/
-	RMAPMemoryObject* findMemoryObject(std::string memoryObjectID) throw (RMAPTargetNodeException) {
-		std::map<std::string, RMAPMemoryObject*>::iterator it = memoryObjects.find(memoryObjectID);
-		if (it != memoryObjects.end()) {
-			return it->second;
+	RMAPMemoryObject* findMemoryObject(const std::string& memoryObjectID) throw (RMAPTargetNodeException) {
+		std::unordered_map<std::string, uint32_t>::const_iterator it = memoryObjectIndices.find(memoryObjectID);
+		if (it != memoryObjectIndices.end()) {
+			return memoryObjectTable[it->second];
+		}
+		//a memory object inserted directly into getMemoryObjects() (not interned here so that
+		//concurrent lookups do not modify the node)
+		std::map<std::string, RMAPMemoryObject*>::const_iterator it2 = memoryObjects.find(memoryObjectID);
+		if (it2 != memoryObjects.end()) {
+			return it2->second;
 		} else {
 			return NULL;
 		}
 	}
 
+public:
+	/** Returns a handle which refers to a memory object without looking up its ID.
+	 * Memory objects are interned only by addMemoryObject() (not those inserted directly into
+	 * getMemoryObjects()), so this method does not modify the node and can be called concurrently with lookups.
+	 */
+	RMAPMemoryObjectHandle getMemoryObjectHandle(const std::string& memoryObjectID) const
+			throw (RMAPTargetNodeException) {
+		std::unordered_map<std::string, uint32_t>::const_iterator it = memoryObjectIndices.find(memoryObjectID);
+		if (it != memoryObjectIndices.end()) {
+			return RMAPMemoryObjectHandle(it->second);
+		} else {
+			throw RMAPTargetNodeException(RMAPTargetNodeException::NoSuchRMAPMemoryObject);
+		}
+	}
+
+public:
+	/** This method does not return NULL even when not found, but throws an exception. */
+	RMAPMemoryObject* getMemoryObject(RMAPMemoryObjectHandle memoryObjectHandle) throw (RMAPTargetNodeException) {
+		if (memoryObjectHandle.getIndex() < memoryObjectTable.size()) {
+			return memoryObjectTable[memoryObjectHandle.getIndex()];
+		} else {
+			throw RMAPTargetNodeException(RMAPTargetNodeException::NoSuchRMAPMemoryObject);
+		}
+	}
+
+private:
+	void internMemoryObject(RMAPMemoryObject* memoryObject) {
+		std::unordered_map<std::string, uint32_t>::iterator it = memoryObjectIndices.find(memoryObject->getID());
+		if (it != memoryObjectIndices.end()) {
+			memoryObjectTable[it->second] = memoryObject;
+		} else {
+			memoryObjectIndices[memoryObject->getID()] = memoryObjectTable.size();
+			memoryObjectTable.push_back(memoryObject);
+		}
+	}
+
 public:
 	std::map<std::string, RMAPMemoryObject*> getAllMemoryObjects(){
 		return memoryObjects;
@@ -409,7 +534,7 @@ public:
 		ss << "Target SpaceWire Address  : " << SpaceWireUtilities::packetToString(&targetSpaceWireAddress) << endl;
 		ss << "Reply Address             : " << SpaceWireUtilities::packetToString(&replyAddress) << endl;
 		ss << "Default Key               : 0x" << right << hex << setw(2) << setfill('0') << (uint32_t) defaultKey << endl;
-		std::map<std::string, RMAPMemoryObject*>::iterator it = memoryObjects.begin();
+		std::map<std::string, RMAPMemoryObject*>::const_iterator it = memoryObjects.begin();
 		for (; it != memoryObjects.end(); it++) {
 			ss << it->second->toString(nTabs + 1);
 		}
@@ -441,7 +566,7 @@ public:
 		ss << "	<ReplyAddress>" << SpaceWireUtilities::packetToString(&replyAddress) << "</ReplyAddress>" << endl;
 		ss << "	<DefaultKey>" << "0x" << hex << right << setw(2) << setfill('0') << (uint32_t) defaultKey << "</DefaultKey>"
 				<< endl;
-		std::map<std::string, RMAPMemoryObject*>::iterator it = memoryObjects.begin();
+		std::map<std::string, RMAPMemoryObject*>::const_iterator it = memoryObjects.begin();
 		for (; it != memoryObjects.end(); it++) {
 			ss << it->second->toXMLString(nTabs + 1);
 		}
@@ -490,6 +615,7 @@ public:
 class RMAPTargetNodeDB {
 private:
 	std::map<std::string, RMAPTargetNode*> db; //targetNodeID-RMAPTargetNodeInstance
+	std::unordered_map<std::string, RMAPTargetNode*> index; //the same as db, for lookup by ID
 
 public:
 	RMAPTargetNodeDB() {
@@ -518,6 +644,7 @@ public:
 public:
 	void addRMAPTargetNode(RMAPTargetNode* rmapTargetNode) {
 		db[rmapTargetNode->getID()] = rmapTargetNode;
+		index[rmapTargetNode->getID()] = rmapTargetNode;
 	}
 
 public:
@@ -542,9 +669,9 @@ public:
 	/** This method does not return NULL when not found, but throws an exception.
 	 *
 	 */
-	RMAPTargetNode* getRMAPTargetNode(std::string id) throw (RMAPTargetNodeDBException) {
-		std::map<std::string, RMAPTargetNode*>::iterator it = db.find(id);
-		if (it != db.end()) {
+	RMAPTargetNode* getRMAPTargetNode(const std::string& id) throw (RMAPTargetNodeDBException) {
+		std::unordered_map<std::string, RMAPTargetNode*>::iterator it = index.find(id);
+		if (it != index.end()) {
 			return it->second;
 		} else {
 			throw RMAPTargetNodeDBException(RMAPTargetNodeDBException::NoSuchRMAPTargetNode);
@@ -554,9 +681,9 @@ public:
 public:
 	/** This method can return NULL when an RMAPTargetNode with a specified ID is not found.
 	 */
-	RMAPTargetNode* findRMAPTargetNode(std::string id) {
-		std::map<std::string, RMAPTargetNode*>::iterator it = db.find(id);
-		if (it != db.end()) {
+	RMAPTargetNode* findRMAPTargetNode(const std::string& id) {
+		std::unordered_map<std::string, RMAPTargetNode*>::iterator it = index.find(id);
+		if (it != index.end()) {
 			return it->second;
 		} else {
 			return NULL;
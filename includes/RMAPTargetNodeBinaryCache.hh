@@ -0,0 +1,536 @@
+/* 
+============================================================================
+SpaceWire/RMAP Library is provided under the MIT License.
+============================================================================
+
+Copyright (c) 2006-2013 Takayuki Yuasa and The Open-source SpaceWire Project
+
+Permission is hereby granted, free of charge, to any person obtaining a 
+copy of this software and associated documentation files (the 
+"Software"), to deal in the Software without restriction, including 
+without limitation the rights to use, copy, modify, merge, publish, 
+distribute, sublicense, and/or sell copies of the Software, and to 
+permit persons to whom the Software is furnished to do so, subject to 
+the following conditions:
+
+The above copyright notice and this permission notice shall be included 
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. 
+*/
+/*
+ * RMAPTargetNodeBinaryCache.hh
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef RMAPTARGETNODEBINARYCACHE_HH_
+#define RMAPTARGETNODEBINARYCACHE_HH_
+
+#include <CxxUtilities/CommonHeader.hh>
+#include <CxxUtilities/Exception.hh>
+#include <CxxUtilities/Mutex.hh>
+#include "RMAPTargetNode.hh"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+class RMAPTargetNodeBinaryCacheException: public CxxUtilities::Exception {
+public:
+	enum {
+		FileCouldNotBeOpened, FileCouldNotBeWritten, InvalidFormat, UnsupportedFormatVersion
+	};
+
+public:
+	RMAPTargetNodeBinaryCacheException(int status) :
+			CxxUtilities::Exception(status) {
+	}
+
+public:
+	virtual ~RMAPTargetNodeBinaryCacheException() {
+	}
+
+public:
+	virtual std::string toString() {
+		std::string result;
+		switch (status) {
+		case FileCouldNotBeOpened:
+			result = "FileCouldNotBeOpened";
+			break;
+		case FileCouldNotBeWritten:
+			result = "FileCouldNotBeWritten";
+			break;
+		case InvalidFormat:
+			result = "InvalidFormat";
+			break;
+		case UnsupportedFormatVersion:
+			result = "UnsupportedFormatVersion";
+			break;
+		default:
+			result = "Undefined status";
+			break;
+		}
+		return result;
+	}
+};
+
+/** Compact binary form of RMAPTargetNode definitions, and a cache of it keyed by the hash of XML content.
+ *
+ * constructFromXMLString()/constructFromXMLFile() return the same RMAPTargetNode instances as
+ * RMAPTargetNode::constructFromXMLString()/constructFromXMLFile(), but parse XML only when the content
+ * is seen for the first time. The serialized form is kept in memory (so that e.g. router classes
+ * which embed their register maps as XML strings parse them once per process), and, if a cache
+ * directory is set, also written to a file named after the content hash, which is mmap'd and
+ * deserialized by later processes.
+ *
+ * Format (all integers are little endian):
+ * - header: magic "RMAPNDB1", format version (u32), number of nodes (u32), number of memory objects (u32),
+ *   size of the byte table (u32)
+ * - node records (NodeRecordSize bytes each): ID, target SpaceWire address, and reply address as
+ *   (offset, length) pairs in the byte table (u32 each), target logical address, initiator logical address,
+ *   initiator logical address set flag, default key (u8 each), index of the first memory object and
+ *   number of memory objects (u32 each)
+ * - memory object records (MemoryObjectRecordSize bytes each): ID as (offset, length), extended address,
+ *   address, length, access mode (u32 each), key, flags (u8 each; bit 0 = access mode set,
+ *   bit 1 = increment mode set, bit 2 = increment, bit 3 = key set), and 2 padding bytes
+ * - byte table
+ */
+class RMAPTargetNodeBinaryCache {
+public:
+	static const uint32_t FormatVersion = 2;
+	static const size_t HeaderSize = 24;
+	static const size_t NodeRecordSize = 36;
+	static const size_t MemoryObjectRecordSize = 28;
+
+private:
+	enum {
+		AccessModeSetFlag = 0x01, IncrementModeSetFlag = 0x02, IncrementFlag = 0x04, KeySetFlag = 0x08
+	};
+
+private:
+	std::string cacheDirectory;
+	std::map<uint64_t, std::vector<uint8_t> > serializedNodes; //content hash - serialized form
+	CxxUtilities::Mutex mutex;
+
+public:
+	/** Constructor.
+	 * @param[in] cacheDirectory directory where cache files are created (no file is used if empty)
+	 */
+	RMAPTargetNodeBinaryCache(std::string cacheDirectory = "") {
+		this->cacheDirectory = cacheDirectory;
+	}
+
+public:
+	/** Returns an instance shared in the process. Its cache directory is taken from
+	 * the RMAP_TARGET_NODE_CACHE_DIRECTORY environment variable (no file is used if not set).
+	 */
+	static RMAPTargetNodeBinaryCache* getSharedInstance() {
+		static RMAPTargetNodeBinaryCache* instance = NULL;
+		static CxxUtilities::Mutex instanceMutex;
+		instanceMutex.lock();
+		if (instance == NULL) {
+			const char* directory = getenv("RMAP_TARGET_NODE_CACHE_DIRECTORY");
+			instance = new RMAPTargetNodeBinaryCache((directory != NULL) ? directory : "");
+		}
+		instanceMutex.unlock();
+		return instance;
+	}
+
+public:
+	std::string getCacheDirectory() const {
+		return cacheDirectory;
+	}
+
+public:
+	/** Returns the name of the cache file for XML content.
+	 */
+	std::string getCacheFileName(const std::string& xmlContent) {
+		std::stringstream ss;
+		ss << cacheDirectory << "/RMAPTargetNodes_" << std::hex << std::setw(16) << std::setfill('0')
+				<< computeContentHash(xmlContent) << ".bin";
+		return ss.str();
+	}
+
+#ifndef NO_XMLLODER
+public:
+	/** Constructs RMAPTargetNode instances defined in an XML string using the cache.
+	 * Returned instances are owned by the caller.
+	 */
+	std::vector<RMAPTargetNode*> constructFromXMLString(const std::string& str) throw (XMLLoader::XMLLoaderException,
+			RMAPTargetNodeException, RMAPMemoryObjectException) {
+		uint64_t hash = computeContentHash(str);
+		std::vector<RMAPTargetNode*> result;
+		if (findCachedNodes(hash, str, result)) {
+			return result;
+		}
+		result = RMAPTargetNode::constructFromXMLString(str);
+		storeNodes(hash, str, result);
+		return result;
+	}
+
+public:
+	/** Constructs RMAPTargetNode instances defined in an XML file using the cache.
+	 * The file is read to compute its hash, but is parsed only when the cache does not have it.
+	 * Returned instances are owned by the caller.
+	 */
+	std::vector<RMAPTargetNode*> constructFromXMLFile(std::string filename) throw (XMLLoader::XMLLoaderException,
+			RMAPTargetNodeException, RMAPMemoryObjectException) {
+		std::ifstream ifs(filename.c_str(), std::ios::binary);
+		if (!ifs.is_open()) {
+			throw RMAPTargetNodeException(RMAPTargetNodeException::FileNotFound, filename);
+		}
+		std::stringstream ss;
+		ss << ifs.rdbuf();
+		std::string content = ss.str();
+		uint64_t hash = computeContentHash(content);
+		std::vector<RMAPTargetNode*> result;
+		if (findCachedNodes(hash, content, result)) {
+			return result;
+		}
+		result = RMAPTargetNode::constructFromXMLFile(filename);
+		storeNodes(hash, content, result);
+		return result;
+	}
+
+public:
+	/** Adds RMAPTargetNode instances defined in an XML file to an RMAPTargetNodeDB using the cache.
+	 */
+	void loadRMAPTargetNodesFromXMLFile(RMAPTargetNodeDB* db, std::string filename)
+			throw (XMLLoader::XMLLoaderException, RMAPTargetNodeException, RMAPMemoryObjectException) {
+		db->addRMAPTargetNodes(constructFromXMLFile(filename));
+	}
+#endif
+
+public:
+	/** Discards serialized nodes kept in memory (cache files are not deleted).
+	 */
+	void clearMemoryCache() {
+		mutex.lock();
+		serializedNodes.clear();
+		mutex.unlock();
+	}
+
+public:
+	/** 64-bit FNV-1a hash of content (the format version is also hashed so that
+	 * files of an old format are not used).
+	 */
+	static uint64_t computeContentHash(const std::string& content) {
+		uint64_t hash = 0xcbf29ce484222325ULL;
+		const uint64_t prime = 0x100000001b3ULL;
+		for (size_t i = 0; i < 4; i++) {
+			hash = (hash ^ ((FormatVersion >> (i * 8)) & 0xFF)) * prime;
+		}
+		for (size_t i = 0; i < content.size(); i++) {
+			hash = (hash ^ (uint8_t) content[i]) * prime;
+		}
+		return hash;
+	}
+
+public:
+	static std::vector<uint8_t> serialize(std::vector<RMAPTargetNode*> nodes) {
+		std::vector<uint8_t> records;
+		std::vector<uint8_t> memoryObjectRecords;
+		std::vector<uint8_t> byteTable;
+		uint32_t nMemoryObjects = 0;
+		for (size_t i = 0; i < nodes.size(); i++) {
+			RMAPTargetNode* node = nodes[i];
+			std::vector<uint8_t> targetSpaceWireAddress = node->getTargetSpaceWireAddress();
+			std::vector<uint8_t> replyAddress = node->getReplyAddress();
+			const std::map<std::string, RMAPMemoryObject*>* memoryObjects = node->getMemoryObjectMap();
+			appendBytes(records, byteTable, node->getID());
+			appendBytes(records, byteTable, std::string(targetSpaceWireAddress.begin(), targetSpaceWireAddress.end()));
+			appendBytes(records, byteTable, std::string(replyAddress.begin(), replyAddress.end()));
+			records.push_back(node->getTargetLogicalAddress());
+			records.push_back(node->getInitiatorLogicalAddress());
+			records.push_back(node->isInitiatorLogicalAddressSet() ? 1 : 0);
+			records.push_back(node->getDefaultKey());
+			appendUInt32(records, nMemoryObjects);
+			appendUInt32(records, memoryObjects->size());
+			std::map<std::string, RMAPMemoryObject*>::const_iterator it = memoryObjects->begin();
+			for (; it != memoryObjects->end(); it++) {
+				RMAPMemoryObject* memoryObject = it->second;
+				appendBytes(memoryObjectRecords, byteTable, memoryObject->getID());
+				appendUInt32(memoryObjectRecords, memoryObject->getExtendedAddress());
+				appendUInt32(memoryObjectRecords, memoryObject->getAddress());
+				appendUInt32(memoryObjectRecords, memoryObject->getLength());
+				appendUInt32(memoryObjectRecords, memoryObject->getAccessMode());
+				uint8_t flags = 0;
+				if (memoryObject->isKeySet()) {
+					memoryObjectRecords.push_back(memoryObject->getKey());
+					flags |= KeySetFlag;
+				} else {
+					memoryObjectRecords.push_back(0);
+				}
+				if (memoryObject->isAccessModeSet()) {
+					flags |= AccessModeSetFlag;
+				}
+				if (memoryObject->isIncrementModeSet()) {
+					flags |= IncrementModeSetFlag;
+					if (memoryObject->isIncrementMode()) {
+						flags |= IncrementFlag;
+					}
+				}
+				memoryObjectRecords.push_back(flags);
+				memoryObjectRecords.push_back(0);
+				memoryObjectRecords.push_back(0);
+				nMemoryObjects++;
+			}
+		}
+		std::vector<uint8_t> result;
+		const char* magic = "RMAPNDB1";
+		result.insert(result.end(), magic, magic + 8);
+		appendUInt32(result, FormatVersion);
+		appendUInt32(result, nodes.size());
+		appendUInt32(result, nMemoryObjects);
+		appendUInt32(result, byteTable.size());
+		result.insert(result.end(), records.begin(), records.end());
+		result.insert(result.end(), memoryObjectRecords.begin(), memoryObjectRecords.end());
+		result.insert(result.end(), byteTable.begin(), byteTable.end());
+		return result;
+	}
+
+public:
+	/** Constructs RMAPTargetNode instances from the serialized form. All offsets are checked
+	 * against the size, so a truncated or corrupted buffer results in an exception.
+	 * Returned instances are owned by the caller.
+	 */
+	static std::vector<RMAPTargetNode*> deserialize(const uint8_t* data, size_t size)
+			throw (RMAPTargetNodeBinaryCacheException) {
+		if (size < HeaderSize || memcmp(data, "RMAPNDB1", 8) != 0) {
+			throw RMAPTargetNodeBinaryCacheException(RMAPTargetNodeBinaryCacheException::InvalidFormat);
+		}
+		if (readUInt32(data + 8) != FormatVersion) {
+			throw RMAPTargetNodeBinaryCacheException(RMAPTargetNodeBinaryCacheException::UnsupportedFormatVersion);
+		}
+		uint64_t nNodes = readUInt32(data + 12);
+		uint64_t nMemoryObjects = readUInt32(data + 16);
+		uint64_t byteTableSize = readUInt32(data + 20);
+		if (HeaderSize + nNodes * NodeRecordSize + nMemoryObjects * MemoryObjectRecordSize + byteTableSize != size) {
+			throw RMAPTargetNodeBinaryCacheException(RMAPTargetNodeBinaryCacheException::InvalidFormat);
+		}
+		const uint8_t* nodeRecords = data + HeaderSize;
+		const uint8_t* memoryObjectRecords = nodeRecords + nNodes * NodeRecordSize;
+		const uint8_t* byteTable = memoryObjectRecords + nMemoryObjects * MemoryObjectRecordSize;
+
+		std::vector<RMAPTargetNode*> result;
+		try {
+			for (size_t i = 0; i < nNodes; i++) {
+				const uint8_t* record = nodeRecords + i * NodeRecordSize;
+				RMAPTargetNode* node = new RMAPTargetNode();
+				result.push_back(node);
+				node->setID(readString(record, byteTable, byteTableSize));
+				std::string targetSpaceWireAddress = readString(record + 8, byteTable, byteTableSize);
+				std::string replyAddress = readString(record + 16, byteTable, byteTableSize);
+				node->setTargetSpaceWireAddress(std::vector<uint8_t>(targetSpaceWireAddress.begin(), targetSpaceWireAddress.end()));
+				node->setReplyAddress(std::vector<uint8_t>(replyAddress.begin(), replyAddress.end()));
+				node->setTargetLogicalAddress(record[24]);
+				if (record[26] != 0) {
+					node->setInitiatorLogicalAddress(record[25]);
+				}
+				node->setDefaultKey(record[27]);
+				uint64_t firstMemoryObject = readUInt32(record + 28);
+				uint64_t nNodeMemoryObjects = readUInt32(record + 32);
+				if (firstMemoryObject + nNodeMemoryObjects > nMemoryObjects) {
+					throw RMAPTargetNodeBinaryCacheException(RMAPTargetNodeBinaryCacheException::InvalidFormat);
+				}
+				for (size_t o = firstMemoryObject; o < firstMemoryObject + nNodeMemoryObjects; o++) {
+					const uint8_t* memoryObjectRecord = memoryObjectRecords + o * MemoryObjectRecordSize;
+					std::string id = readString(memoryObjectRecord, byteTable, byteTableSize);
+					RMAPMemoryObject* memoryObject = new RMAPMemoryObject();
+					memoryObject->setID(id);
+					memoryObject->setExtendedAddress(readUInt32(memoryObjectRecord + 8));
+					memoryObject->setAddress(readUInt32(memoryObjectRecord + 12));
+					memoryObject->setLength(readUInt32(memoryObjectRecord + 16));
+					uint8_t flags = memoryObjectRecord[25];
+					if (flags & AccessModeSetFlag) {
+						memoryObject->setAccessMode(readUInt32(memoryObjectRecord + 20));
+					}
+					if (flags & KeySetFlag) {
+						memoryObject->setKey(memoryObjectRecord[24]);
+					}
+					if (flags & IncrementModeSetFlag) {
+						memoryObject->setIncrementMode((flags & IncrementFlag) ? "increment" : "nonincrement");
+					}
+					node->addMemoryObject(memoryObject);
+				}
+			}
+		} catch (RMAPTargetNodeBinaryCacheException& e) {
+			deleteNodes(result);
+			throw e;
+		}
+		return result;
+	}
+
+public:
+	/** Writes the serialized form to a file. The file is written under a temporary name and then renamed,
+	 * so that other processes never map a partially written file.
+	 */
+	static void saveToFile(const std::vector<uint8_t>& serialized, std::string filename)
+			throw (RMAPTargetNodeBinaryCacheException) {
+		std::stringstream ss;
+		ss << filename << ".tmp" << getpid();
+		std::string temporaryFilename = ss.str();
+		FILE* file = fopen(temporaryFilename.c_str(), "wb");
+		if (file == NULL) {
+			throw RMAPTargetNodeBinaryCacheException(RMAPTargetNodeBinaryCacheException::FileCouldNotBeOpened);
+		}
+		size_t written = fwrite(&serialized[0], 1, serialized.size(), file);
+		if (fclose(file) != 0 || written != serialized.size()
+				|| rename(temporaryFilename.c_str(), filename.c_str()) != 0) {
+			unlink(temporaryFilename.c_str());
+			throw RMAPTargetNodeBinaryCacheException(RMAPTargetNodeBinaryCacheException::FileCouldNotBeWritten);
+		}
+	}
+
+public:
+	/** Constructs RMAPTargetNode instances from a file written by saveToFile(). The file is mmap'd
+	 * and deserialized in place. Returned instances are owned by the caller.
+	 */
+	static std::vector<RMAPTargetNode*> loadFromFile(std::string filename) throw (RMAPTargetNodeBinaryCacheException) {
+		return loadFromFile(filename, NULL);
+	}
+
+private:
+	/** @param[out] serialized if not NULL, the content of the file is copied to it
+	 */
+	static std::vector<RMAPTargetNode*> loadFromFile(std::string filename, std::vector<uint8_t>* serialized)
+			throw (RMAPTargetNodeBinaryCacheException) {
+		int fd = ::open(filename.c_str(), O_RDONLY);
+		if (fd < 0) {
+			throw RMAPTargetNodeBinaryCacheException(RMAPTargetNodeBinaryCacheException::FileCouldNotBeOpened);
+		}
+		struct stat status;
+		if (::fstat(fd, &status) != 0 || status.st_size < (off_t) HeaderSize) {
+			::close(fd);
+			throw RMAPTargetNodeBinaryCacheException(RMAPTargetNodeBinaryCacheException::InvalidFormat);
+		}
+		size_t size = status.st_size;
+		void* mapped = ::mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+		::close(fd);
+		if (mapped == MAP_FAILED) {
+			throw RMAPTargetNodeBinaryCacheException(RMAPTargetNodeBinaryCacheException::FileCouldNotBeOpened);
+		}
+		std::vector<RMAPTargetNode*> result;
+		try {
+			result = deserialize((const uint8_t*) mapped, size);
+		} catch (RMAPTargetNodeBinaryCacheException& e) {
+			::munmap(mapped, size);
+			throw e;
+		}
+		if (serialized != NULL) {
+			serialized->assign((const uint8_t*) mapped, (const uint8_t*) mapped + size);
+		}
+		::munmap(mapped, size);
+		return result;
+	}
+
+private:
+	/** Looks up the memory cache and then the cache file. The serialized form in the memory cache is
+	 * copied under the mutex and deserialized after unlocking it, so that an exception from deserialize()
+	 * does not leave the mutex locked.
+	 * @return true if nodes were constructed from the cache
+	 */
+	bool findCachedNodes(uint64_t hash, const std::string& content, std::vector<RMAPTargetNode*>& result) {
+		std::vector<uint8_t> serialized;
+		mutex.lock();
+		std::map<uint64_t, std::vector<uint8_t> >::iterator it = serializedNodes.find(hash);
+		bool isInMemory = (it != serializedNodes.end());
+		if (isInMemory) {
+			serialized = it->second;
+		}
+		mutex.unlock();
+		if (isInMemory) {
+			try {
+				result = deserialize(&serialized[0], serialized.size());
+				return true;
+			} catch (RMAPTargetNodeBinaryCacheException& e) {
+				//broken in memory; the XML is parsed again and the entry is replaced
+				return false;
+			}
+		}
+		if (cacheDirectory == "") {
+			return false;
+		}
+		try {
+			result = loadFromFile(getCacheFileName(content), &serialized);
+		} catch (RMAPTargetNodeBinaryCacheException& e) {
+			//not cached yet (a broken or old file is replaced after the XML is parsed)
+			return false;
+		}
+		mutex.lock();
+		serializedNodes[hash].swap(serialized);
+		mutex.unlock();
+		return true;
+	}
+
+private:
+	void storeNodes(uint64_t hash, const std::string& content, std::vector<RMAPTargetNode*>& nodes) {
+		std::vector<uint8_t> serialized = serialize(nodes);
+		if (cacheDirectory != "") {
+			try {
+				saveToFile(serialized, getCacheFileName(content));
+			} catch (RMAPTargetNodeBinaryCacheException& e) {
+				//the cache directory is not writable; nodes are cached only in memory
+			}
+		}
+		mutex.lock();
+		serializedNodes[hash].swap(serialized);
+		mutex.unlock();
+	}
+
+private:
+	static void deleteNodes(std::vector<RMAPTargetNode*>& nodes) {
+		for (size_t i = 0; i < nodes.size(); i++) {
+			const std::map<std::string, RMAPMemoryObject*>* memoryObjects = nodes[i]->getMemoryObjectMap();
+			std::map<std::string, RMAPMemoryObject*>::const_iterator it = memoryObjects->begin();
+			for (; it != memoryObjects->end(); it++) {
+				delete it->second;
+			}
+			delete nodes[i];
+		}
+		nodes.clear();
+	}
+
+private:
+	static void appendUInt32(std::vector<uint8_t>& buffer, uint32_t value) {
+		buffer.push_back(value & 0xFF);
+		buffer.push_back((value >> 8) & 0xFF);
+		buffer.push_back((value >> 16) & 0xFF);
+		buffer.push_back((value >> 24) & 0xFF);
+	}
+
+private:
+	static void appendBytes(std::vector<uint8_t>& buffer, std::vector<uint8_t>& byteTable, const std::string& bytes) {
+		appendUInt32(buffer, byteTable.size());
+		appendUInt32(buffer, bytes.size());
+		byteTable.insert(byteTable.end(), bytes.begin(), bytes.end());
+	}
+
+private:
+	static uint32_t readUInt32(const uint8_t* p) {
+		return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t) p[3] << 24);
+	}
+
+private:
+	static std::string readString(const uint8_t* reference, const uint8_t* byteTable, uint64_t byteTableSize)
+			throw (RMAPTargetNodeBinaryCacheException) {
+		uint64_t offset = readUInt32(reference);
+		uint64_t length = readUInt32(reference + 4);
+		if (offset + length > byteTableSize) {
+			throw RMAPTargetNodeBinaryCacheException(RMAPTargetNodeBinaryCacheException::InvalidFormat);
+		}
+		return std::string((const char*) byteTable + offset, length);
+	}
+};
+
+#endif /* RMAPTARGETNODEBINARYCACHE_HH_ */
@@ -67,8 +67,10 @@ public:
 	}
 
 	/** Calculates a CRC code for an array of bytes.
+	 * @param[in] crc CRC code of preceding bytes; a CRC code can be calculated piece by piece
+	 * by passing the result for the first piece when calculating the next one.
 	 */
-	static uint8_t calculateCRC(uint8_t* data, size_t length) {
+	static uint8_t calculateCRC(const uint8_t* data, size_t length, uint8_t crc = 0x00) {
 		static const uint8_t RMAPCRCTable[] = { 0x00, 0x91, 0xe3, 0x72, 0x07, 0x96, 0xe4, 0x75, 0x0e, 0x9f, 0xed, 0x7c,
 				0x09, 0x98, 0xea, 0x7b, 0x1c, 0x8d, 0xff, 0x6e, 0x1b, 0x8a, 0xf8, 0x69, 0x12, 0x83, 0xf1, 0x60, 0x15,
 				0x84, 0xf6, 0x67, 0x38, 0xa9, 0xdb, 0x4a, 0x3f, 0xae, 0xdc, 0x4d, 0x36, 0xa7, 0xd5, 0x44, 0x31, 0xa0,
@@ -86,7 +88,6 @@ public:
 				0x37, 0x45, 0xd4, 0xa1, 0x30, 0x42, 0xd3, 0xb4, 0x25, 0x57, 0xc6, 0xb3, 0x22, 0x50, 0xc1, 0xba, 0x2b,
 				0x59, 0xc8, 0xbd, 0x2c, 0x5e, 0xcf };
 
-		uint8_t crc = 0x00;
 		for (size_t i = 0; i < length; i++) {
 			crc = RMAPCRCTable[(crc ^ data[i]) & 0xff];
 		}
@@ -129,8 +130,9 @@ public:
 	}
 
 	/** Calculates a CRC code for an array of bytes using an algorithm defined in an old RMAP Standard (Draft E).
+	 * @param[in] crc CRC code of preceding bytes (see calculateCRC(const uint8_t*, size_t, uint8_t))
 	 */
-	static uint8_t calculateCRCBasedOnDraftESpecification(uint8_t* data, size_t length) {
+	static uint8_t calculateCRCBasedOnDraftESpecification(const uint8_t* data, size_t length, uint8_t crc = 0x00) {
 		// CRC Table from RMAP spec draft E
 		static const uint8_t RMAP_CRCTable_DraftE[] = { 0x00, 0x07, 0x0e, 0x09, 0x1c, 0x1b,
 				0x12, 0x15, 0x38, 0x3f, 0x36, 0x31, 0x24, 0x23, 0x2a, 0x2d, 0x70, 0x77,
@@ -155,7 +157,6 @@ public:
 				0x98, 0x9f, 0x8a, 0x8d, 0x84, 0x83, 0xde, 0xd9, 0xd0, 0xd7, 0xc2, 0xc5,
 				0xcc, 0xcb, 0xe6, 0xe1, 0xe8, 0xef, 0xfa, 0xfd, 0xf4, 0xf3 };
 		//^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^
-		unsigned char crc=0x00;
 		for (int i=0;i<length;i++){
 			crc=RMAP_CRCTable_DraftE[(crc^data[i]) & 0xff];
 		}
@@ -67,6 +67,9 @@ public:
 		case RMAPInitiatorIsNotAvailable:
 			str = "RMAPInitiatorIsNotAvailable";
 			break;
+		case InvalidRoutingTable:
+			str = "InvalidRoutingTable";
+			break;
 		}
 		return str;
 	}
@@ -76,17 +79,80 @@ public:
 		OperationFailed, //
 		InvalidPortNumber, //
 		InvalidLinkFrequency, //
-		RMAPInitiatorIsNotAvailable
+		RMAPInitiatorIsNotAvailable, //
+		InvalidRoutingTable
 	};
 };
 
+class RouterConfigurationPort;
+
+/** An action invoked when a link control/status register value of a router port changes
+ * (detected when the register is read, or written via RouterConfigurationPort).
+ * See RouterConfigurationPort::addLinkStatusChangedAction().
+ */
+class RouterConfigurationPortLinkStatusChangedAction {
+public:
+	virtual ~RouterConfigurationPortLinkStatusChangedAction() {
+	}
+
+public:
+	/** @param[in] previousValue register value before the change (4 bytes)
+	 * @param[in] newValue register value after the change (4 bytes)
+	 */
+	virtual void doAction(RouterConfigurationPort* routerConfigurationPort, uint8_t port, const uint8_t* previousValue,
+			const uint8_t* newValue) = 0;
+};
+
 class RouterConfigurationPort {
 
 protected:
 	RMAPInitiator* rmapInitiator;
 
+public:
+	/** Number of register accesses kept in flight when registers are accessed one by one. */
+	static const size_t NumberOfPipelinedRegisterAccesses = 8;
+	static constexpr double PipelinedAccessPollingIntervalInMilliSec = 0.05;
+
+public:
+	/** Number of routing table entries (one per logical address from MinimumLogicalAddress to MaximumLogicalAddress). */
+	static const size_t NumberOfRoutingTableEntries = SpaceWireProtocol::MaximumLogicalAddress
+			- SpaceWireProtocol::MinimumLogicalAddress + 1;
+
+private:
+	//initiators used by routing table and pipelined register accesses (created on demand, and
+	//bound to the RMAPEngine of rmapInitiator at that time; see setRMAPInitiator())
+	std::vector<RMAPInitiator*> registerAccessInitiators;
+
+private:
+	//routing table entries (port bit patterns) last read from or written to the router
+	std::vector<uint32_t> routingTableCache;
+	bool isRoutingTableCached_;
+
+private:
+	bool useRoutingTableBlockAccess;
+	double registerAccessTimeoutDuration;
+
+private:
+	struct LinkControlStatusRegisterCacheEntry {
+		uint8_t value[4];
+		double readTime; //clock value in ms when the value was read from the router
+	};
+	std::map<uint8_t, LinkControlStatusRegisterCacheEntry> linkControlStatusRegisterCache;
+	double linkControlStatusRegisterMaximumAge;
+	std::vector<RouterConfigurationPortLinkStatusChangedAction*> linkStatusChangedActions;
+
+public:
+	RouterConfigurationPort() {
+		rmapInitiator = NULL;
+		isRoutingTableCached_ = false;
+		useRoutingTableBlockAccess = true;
+		registerAccessTimeoutDuration = RMAPInitiator::DefaultTimeoutDuration;
+		linkControlStatusRegisterMaximumAge = 0;
+	}
+
 public:
 	virtual ~RouterConfigurationPort() {
+		deleteRegisterAccessInitiators();
 	}
 
 public:
@@ -110,6 +176,26 @@ public:
 public:
 	virtual uint32_t getLinkFrequencyRegisterAddress(uint8_t port) throw (RouterConfigurationPortException) = 0;
 
+public:
+	/** Returns the address of the link control/status register of a port.
+	 * Used by refreshLinkControlStatusRegisters(). The default implementation throws NotImplemented,
+	 * so that subclasses which do not use the register cache need not implement it.
+	 */
+	virtual uint32_t getLinkControlStatusRegisterAddress(uint8_t port) throw (RouterConfigurationPortException) {
+		throw RouterConfigurationPortException(RouterConfigurationPortException::NotImplemented);
+	}
+
+public:
+	/** Returns port numbers whose link control/status registers are refreshed by refreshLinkControlStatusRegisters().
+	 */
+	virtual std::vector<uint8_t> getConfigurablePorts() {
+		std::vector<uint8_t> result;
+		for (size_t port = 1; port <= getNumberOfExternalPorts(); port++) {
+			result.push_back(port);
+		}
+		return result;
+	}
+
 public:
 	virtual RMAPMemoryObject* getLinkFrequencyRegisterMemoryObject(uint8_t port) throw (RouterConfigurationPortException) = 0;
 
@@ -167,8 +253,478 @@ public:
 	}
 
 public:
+	/** Sets the initiator used to access the router.
+	 * Routing table and pipelined register accesses use additional initiators which share the
+	 * RMAPEngine of rmapInitiator. They are deleted here and in the destructor, but not when the
+	 * RMAPEngine is deleted, so after the RMAPEngine is replaced (e.g. on reconnection) this method
+	 * should be called again with an initiator of the new RMAPEngine (or NULL) before the next access.
+	 */
 	void setRMAPInitiator(RMAPInitiator* rmapInitiator) {
 		this->rmapInitiator = rmapInitiator;
+		deleteRegisterAccessInitiators();
+		invalidateRoutingTableCache();
+		invalidateLinkControlStatusRegisterCache();
+	}
+
+public:
+	/** Reads the link control/status registers of all ports returned by getConfigurablePorts()
+	 * in one pipelined batch, and updates the cached values (change actions are invoked for
+	 * registers whose values changed).
+	 */
+	void refreshLinkControlStatusRegisters() throw (RouterConfigurationPortException) {
+		std::vector<uint8_t> ports = getConfigurablePorts();
+		std::vector<uint32_t> addresses;
+		for (size_t i = 0; i < ports.size(); i++) {
+			addresses.push_back(getLinkControlStatusRegisterAddress(ports[i]));
+		}
+		std::vector<uint8_t> data(ports.size() * 4);
+		double readTime = CxxUtilities::Time::getClockValueInMilliSec();
+		accessRegisters(addresses, data, false);
+		for (size_t i = 0; i < ports.size(); i++) {
+			updateLinkControlStatusRegisterCache(ports[i], &data[i * 4], readTime);
+		}
+	}
+
+public:
+	/** Returns how long (in ms) a cached link control/status register value is used
+	 * instead of reading the register again. 0 (default) means that every query reads the register.
+	 */
+	double getLinkControlStatusRegisterMaximumAge() const {
+		return linkControlStatusRegisterMaximumAge;
+	}
+
+public:
+	/** Sets how long (in ms) a cached link control/status register value is used (see getLinkControlStatusRegisterMaximumAge()).
+	 * With a positive value, status queries such as isLinkEnabled() cost no RMAP transaction while
+	 * the cached value is fresh, and read-modify-write operations such as setLinkEnable() cost only a write.
+	 * Writes via this class are always reflected in the cache.
+	 */
+	void setLinkControlStatusRegisterMaximumAge(double linkControlStatusRegisterMaximumAge) {
+		this->linkControlStatusRegisterMaximumAge = linkControlStatusRegisterMaximumAge;
+	}
+
+public:
+	void invalidateLinkControlStatusRegisterCache() {
+		linkControlStatusRegisterCache.clear();
+	}
+
+public:
+	void addLinkStatusChangedAction(RouterConfigurationPortLinkStatusChangedAction* action) {
+		for (size_t i = 0; i < linkStatusChangedActions.size(); i++) {
+			if (action == linkStatusChangedActions[i]) {
+				return;
+			}
+		}
+		linkStatusChangedActions.push_back(action);
+	}
+
+public:
+	void deleteLinkStatusChangedAction(RouterConfigurationPortLinkStatusChangedAction* action) {
+		std::vector<RouterConfigurationPortLinkStatusChangedAction*> newActions;
+		for (size_t i = 0; i < linkStatusChangedActions.size(); i++) {
+			if (action != linkStatusChangedActions[i]) {
+				newActions.push_back(linkStatusChangedActions[i]);
+			}
+		}
+		linkStatusChangedActions = newActions;
+	}
+
+public:
+	/** Reads the routing table entries of all logical addresses.
+	 * If the routing table occupies a contiguous address range, it is read with one incrementing-address
+	 * read command. If the router rejects the block read (or it fails), entries are read one by one with
+	 * up to NumberOfPipelinedRegisterAccesses reads in flight, so that a lost reply delays only
+	 * its own entry. Entries which failed are retried once.
+	 * The result is cached and used by writeWholeRoutingTable().
+	 * @return port numbers for each logical address (index 0 = MinimumLogicalAddress)
+	 */
+	std::vector<std::vector<uint8_t> > readWholeRoutingTable() throw (RouterConfigurationPortException,
+			RMAPInitiatorException) {
+		prepareRegisterAccessInitiators();
+		std::vector<uint32_t> entries(NumberOfRoutingTableEntries, 0);
+		if (!accessRoutingTableBlock(0, NumberOfRoutingTableEntries, entries, false)) {
+			std::vector<size_t> indices;
+			for (size_t i = 0; i < NumberOfRoutingTableEntries; i++) {
+				indices.push_back(i);
+			}
+			accessRoutingTableEntries(indices, entries, false);
+		}
+		routingTableCache = entries;
+		isRoutingTableCached_ = true;
+		std::vector<std::vector<uint8_t> > result;
+		for (size_t i = 0; i < NumberOfRoutingTableEntries; i++) {
+			result.push_back(convertRoutingTableEntryToPortNumbers(entries[i]));
+		}
+		return result;
+	}
+
+public:
+	/** Writes the routing table entries of all logical addresses.
+	 * Only entries which differ from the cached routing table are written (the table is read first
+	 * if it has not been cached). Changed entries are written with one incrementing-address write command
+	 * covering the first to the last changed entry when possible, otherwise one by one with
+	 * up to NumberOfPipelinedRegisterAccesses writes in flight.
+	 * @param[in] routingTable port numbers for each logical address (index 0 = MinimumLogicalAddress).
+	 * Entries after the end of routingTable are not changed.
+	 * @return the number of entries which were changed
+	 */
+	size_t writeWholeRoutingTable(const std::vector<std::vector<uint8_t> >& routingTable)
+			throw (RouterConfigurationPortException, RMAPInitiatorException) {
+		if (routingTable.size() > NumberOfRoutingTableEntries) {
+			throw RouterConfigurationPortException(RouterConfigurationPortException::InvalidRoutingTable);
+		}
+		prepareRegisterAccessInitiators();
+		if (!isRoutingTableCached_) {
+			readWholeRoutingTable();
+		}
+		std::vector<uint32_t> entries = routingTableCache;
+		std::vector<size_t> changedIndices;
+		for (size_t i = 0; i < routingTable.size(); i++) {
+			entries[i] = convertPortNumbersToRoutingTableEntry(routingTable[i]);
+			if (entries[i] != routingTableCache[i]) {
+				changedIndices.push_back(i);
+			}
+		}
+		if (changedIndices.size() == 0) {
+			return 0;
+		}
+		size_t first = changedIndices.front();
+		size_t last = changedIndices.back();
+		if (changedIndices.size() == 1
+				|| !accessRoutingTableBlock(first, last - first + 1, entries, true)) {
+			accessRoutingTableEntries(changedIndices, entries, true);
+		}
+		routingTableCache = entries;
+		return changedIndices.size();
+	}
+
+public:
+	/** Forgets the cached routing table (e.g. when the router may have been reconfigured by others).
+	 */
+	void invalidateRoutingTableCache() {
+		isRoutingTableCached_ = false;
+	}
+
+public:
+	bool isRoutingTableCached() const {
+		return isRoutingTableCached_;
+	}
+
+public:
+	/** Returns true if the routing table is accessed with block read/write commands.
+	 * This is disabled automatically when the router rejects a block access.
+	 */
+	bool isRoutingTableBlockAccessUsed() const {
+		return useRoutingTableBlockAccess;
+	}
+
+public:
+	void setUseRoutingTableBlockAccess(bool useRoutingTableBlockAccess) {
+		this->useRoutingTableBlockAccess = useRoutingTableBlockAccess;
+	}
+
+public:
+	double getRegisterAccessTimeoutDuration() const {
+		return registerAccessTimeoutDuration;
+	}
+
+public:
+	/** Sets the timeout of each routing table/pipelined register access in ms.
+	 */
+	void setRegisterAccessTimeoutDuration(double registerAccessTimeoutDuration) {
+		this->registerAccessTimeoutDuration = registerAccessTimeoutDuration;
+	}
+
+protected:
+	/** Copies the cached link control/status register value of a port to value if it is fresh
+	 * (see setLinkControlStatusRegisterMaximumAge()).
+	 * @return true if the cached value was copied
+	 */
+	bool readLinkControlStatusRegisterFromCache(uint8_t port, uint8_t* value) {
+		if (linkControlStatusRegisterMaximumAge <= 0) {
+			return false;
+		}
+		std::map<uint8_t, LinkControlStatusRegisterCacheEntry>::iterator it = linkControlStatusRegisterCache.find(port);
+		if (it == linkControlStatusRegisterCache.end()
+				|| CxxUtilities::Time::getClockValueInMilliSec() - it->second.readTime > linkControlStatusRegisterMaximumAge) {
+			return false;
+		}
+		std::memcpy(value, it->second.value, 4);
+		return true;
+	}
+
+protected:
+	/** Caches a link control/status register value read from the router.
+	 * @param[in] readTime clock value in ms when the read was started
+	 */
+	void updateLinkControlStatusRegisterCache(uint8_t port, const uint8_t* value, double readTime) {
+		setLinkControlStatusRegisterCacheValue(port, value, readTime);
+	}
+
+protected:
+	/** Reflects a value written to a link control/status register in the cache.
+	 * The time of the last read is kept, because status bits are updated only by reads.
+	 */
+	void writeThroughLinkControlStatusRegisterCache(uint8_t port, const uint8_t* value) {
+		std::map<uint8_t, LinkControlStatusRegisterCacheEntry>::iterator it = linkControlStatusRegisterCache.find(port);
+		if (it != linkControlStatusRegisterCache.end()) {
+			setLinkControlStatusRegisterCacheValue(port, value, it->second.readTime);
+		}
+	}
+
+private:
+	void setLinkControlStatusRegisterCacheValue(uint8_t port, const uint8_t* value, double readTime) {
+		std::map<uint8_t, LinkControlStatusRegisterCacheEntry>::iterator it = linkControlStatusRegisterCache.find(port);
+		bool changed = (it != linkControlStatusRegisterCache.end()) && std::memcmp(it->second.value, value, 4) != 0;
+		uint8_t previousValue[4];
+		LinkControlStatusRegisterCacheEntry& entry = linkControlStatusRegisterCache[port];
+		std::memcpy(previousValue, entry.value, 4);
+		std::memcpy(entry.value, value, 4);
+		entry.readTime = readTime;
+		if (changed) {
+			for (size_t i = 0; i < linkStatusChangedActions.size(); i++) {
+				linkStatusChangedActions[i]->doAction(this, port, previousValue, value);
+			}
+		}
+	}
+
+protected:
+	/** Updates the cached routing table after a single entry has been read or written.
+	 */
+	void updateRoutingTableCache(uint8_t logicalAddress, const std::vector<uint8_t>& portNumbers) {
+		if (isRoutingTableCached_ && logicalAddress >= SpaceWireProtocol::MinimumLogicalAddress) {
+			routingTableCache[logicalAddress - SpaceWireProtocol::MinimumLogicalAddress] =
+					convertPortNumbersToRoutingTableEntry(portNumbers);
+		}
+	}
+
+protected:
+	/** Converts a routing table entry (bit n = port n) to port numbers.
+	 */
+	static std::vector<uint8_t> convertRoutingTableEntryToPortNumbers(uint32_t entry) {
+		std::vector<uint8_t> result;
+		for (size_t i = 0; i < 32; i++) {
+			if ((entry & (0x01u << i)) != 0) {
+				result.push_back(i);
+			}
+		}
+		return result;
+	}
+
+protected:
+	static uint32_t convertPortNumbersToRoutingTableEntry(const std::vector<uint8_t>& portNumbers) {
+		uint32_t entry = 0;
+		for (size_t i = 0; i < portNumbers.size(); i++) {
+			if (portNumbers[i] < 32) {
+				entry |= 0x01u << portNumbers[i];
+			}
+		}
+		return entry;
+	}
+
+private:
+	/** Creates initiators used for routing table and pipelined register accesses (sharing the RMAPEngine of rmapInitiator).
+	 */
+	void prepareRegisterAccessInitiators() throw (RouterConfigurationPortException) {
+		if (rmapInitiator == NULL) {
+			throw RouterConfigurationPortException(RouterConfigurationPortException::RMAPInitiatorIsNotAvailable);
+		}
+		while (registerAccessInitiators.size() < NumberOfPipelinedRegisterAccesses) {
+			RMAPInitiator* initiator = new RMAPInitiator(rmapInitiator->getRMAPEngine());
+			if (rmapInitiator->isInitiatorLogicalAddressSet()) {
+				initiator->setInitiatorLogicalAddress(rmapInitiator->getInitiatorLogicalAddress());
+			}
+			initiator->setUseDraftECRC(rmapInitiator->isUseDraftECRC());
+			registerAccessInitiators.push_back(initiator);
+		}
+	}
+
+private:
+	void deleteRegisterAccessInitiators() {
+		for (size_t i = 0; i < registerAccessInitiators.size(); i++) {
+			delete registerAccessInitiators[i];
+		}
+		registerAccessInitiators.clear();
+	}
+
+private:
+	/** Returns true if the entries [index, index+nEntries) are mapped to consecutive 4-byte words.
+	 */
+	bool isRoutingTableContiguous(size_t index, size_t nEntries) {
+		uint32_t firstAddress = getRoutingTableAddress(SpaceWireProtocol::MinimumLogicalAddress + index);
+		for (size_t i = 1; i < nEntries; i++) {
+			if (getRoutingTableAddress(SpaceWireProtocol::MinimumLogicalAddress + index + i) != firstAddress + i * 4) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+private:
+	/** Reads/writes entries [index, index+nEntries) with one incrementing-address command.
+	 * @return false if block access is not available or failed (entries should then be accessed one by one)
+	 */
+	bool accessRoutingTableBlock(size_t index, size_t nEntries, std::vector<uint32_t>& entries, bool isWrite) {
+		using namespace std;
+		if (!useRoutingTableBlockAccess || !isRoutingTableContiguous(index, nEntries)) {
+			return false;
+		}
+		RMAPInitiator* initiator = registerAccessInitiators[0];
+		uint32_t address = getRoutingTableAddress(SpaceWireProtocol::MinimumLogicalAddress + index);
+		std::vector<uint8_t> buffer(nEntries * 4);
+		try {
+			if (isWrite) {
+				for (size_t i = 0; i < nEntries; i++) {
+					convertRoutingTableEntryToBytes(entries[index + i], &buffer[i * 4]);
+				}
+				initiator->write(getRMAPTargetNodeInstance(), address, &buffer[0], buffer.size(),
+						registerAccessTimeoutDuration);
+			} else {
+				initiator->read(getRMAPTargetNodeInstance(), address, buffer.size(), &buffer[0],
+						registerAccessTimeoutDuration);
+				for (size_t i = 0; i < nEntries; i++) {
+					entries[index + i] = convertBytesToRoutingTableEntry(&buffer[i * 4]);
+				}
+			}
+			return true;
+		} catch (RMAPReplyException& e) {
+			//the router does not accept block access
+			cerr << "RouterConfigurationPort: block access to the routing table was rejected (" << e.toString()
+					<< "); accessing entries one by one" << endl;
+			useRoutingTableBlockAccess = false;
+			return false;
+		} catch (CxxUtilities::Exception& e) {
+			return false;
+		}
+	}
+
+private:
+	/** Reads/writes the specified routing table entries one by one (see accessRegisters()).
+	 */
+	void accessRoutingTableEntries(const std::vector<size_t>& indices, std::vector<uint32_t>& entries, bool isWrite)
+			throw (RouterConfigurationPortException) {
+		std::vector<uint32_t> addresses(indices.size());
+		std::vector<uint8_t> data(indices.size() * 4);
+		for (size_t i = 0; i < indices.size(); i++) {
+			addresses[i] = getRoutingTableAddress(SpaceWireProtocol::MinimumLogicalAddress + indices[i]);
+			if (isWrite) {
+				convertRoutingTableEntryToBytes(entries[indices[i]], &data[i * 4]);
+			}
+		}
+		try {
+			accessRegisters(addresses, data, isWrite);
+		} catch (RouterConfigurationPortException& e) {
+			invalidateRoutingTableCache();
+			throw e;
+		}
+		if (!isWrite) {
+			for (size_t i = 0; i < indices.size(); i++) {
+				entries[indices[i]] = convertBytesToRoutingTableEntry(&data[i * 4]);
+			}
+		}
+	}
+
+protected:
+	/** Reads/writes 4-byte registers one by one, keeping up to NumberOfPipelinedRegisterAccesses
+	 * accesses in flight so that a lost reply delays only its own register.
+	 * Registers whose access failed (error reply or timeout) are retried once.
+	 * @param[in] addresses register addresses
+	 * @param[in,out] data 4 bytes per register (read data are stored, or write data are taken)
+	 */
+	void accessRegisters(const std::vector<uint32_t>& addresses, std::vector<uint8_t>& data, bool isWrite)
+			throw (RouterConfigurationPortException) {
+		using namespace std;
+		prepareRegisterAccessInitiators();
+		RMAPTargetNode* rmapTargetNode = getRMAPTargetNodeInstance();
+		const size_t nInitiators = registerAccessInitiators.size();
+		std::vector<size_t> failedIndices;
+		size_t nIssued = 0;
+		size_t nCompleted = 0;
+		while (nCompleted < addresses.size()) {
+			while (nIssued < addresses.size() && nIssued - nCompleted < nInitiators) {
+				RMAPInitiator* initiator = registerAccessInitiators[nIssued % nInitiators];
+				try {
+					if (isWrite) {
+						initiator->nonblockingWrite(rmapTargetNode, addresses[nIssued], &data[nIssued * 4], 4);
+					} else {
+						initiator->nonblockingRead(rmapTargetNode, addresses[nIssued], 4);
+					}
+				} catch (CxxUtilities::Exception& e) {
+					//cancel the accesses in flight (and the failed one) so that the initiators can be reused
+					cancelRegisterAccesses(nCompleted, nIssued + 1, isWrite);
+					throw RouterConfigurationPortException(RouterConfigurationPortException::OperationFailed);
+				}
+				nIssued++;
+			}
+			RMAPInitiator* initiator = registerAccessInitiators[nCompleted % nInitiators];
+			CxxUtilities::Condition c;
+			double deadline = CxxUtilities::Time::getClockValueInMilliSec() + registerAccessTimeoutDuration;
+			bool completed;
+			while (!(completed = isWrite ? initiator->isNonblockingWriteCompleted() : initiator->isNonblockingReadCompleted())
+					&& CxxUtilities::Time::getClockValueInMilliSec() < deadline) {
+				c.wait(PipelinedAccessPollingIntervalInMilliSec);
+			}
+			try {
+				if (!completed) {
+					throw RMAPInitiatorException(RMAPInitiatorException::Timeout);
+				}
+				if (isWrite) {
+					initiator->checkNonblockingWriteReply();
+				} else {
+					initiator->getNonblockingReadData(&data[nCompleted * 4], 4);
+				}
+			} catch (CxxUtilities::Exception& e) {
+				cancelRegisterAccesses(nCompleted, nCompleted + 1, isWrite);
+				failedIndices.push_back(nCompleted);
+			}
+			nCompleted++;
+		}
+
+		//retry failed registers
+		for (size_t i = 0; i < failedIndices.size(); i++) {
+			size_t index = failedIndices[i];
+			try {
+				if (isWrite) {
+					registerAccessInitiators[0]->write(rmapTargetNode, addresses[index], &data[index * 4], 4,
+							registerAccessTimeoutDuration);
+				} else {
+					registerAccessInitiators[0]->read(rmapTargetNode, addresses[index], 4, &data[index * 4],
+							registerAccessTimeoutDuration);
+				}
+			} catch (CxxUtilities::Exception& e) {
+				cerr << "RouterConfigurationPort: access to address 0x" << hex << addresses[index] << dec << " failed ("
+						<< e.toString() << ")" << endl;
+				throw RouterConfigurationPortException(RouterConfigurationPortException::OperationFailed);
+			}
+		}
+	}
+
+private:
+	/** Cancels nonblocking accesses [from, to) issued by accessRegisters().
+	 */
+	void cancelRegisterAccesses(size_t from, size_t to, bool isWrite) {
+		const size_t nInitiators = registerAccessInitiators.size();
+		for (size_t i = from; i < to; i++) {
+			if (isWrite) {
+				registerAccessInitiators[i % nInitiators]->cancelNonblockingWrite();
+			} else {
+				registerAccessInitiators[i % nInitiators]->cancelNonblockingRead();
+			}
+		}
+	}
+
+private:
+	//routing table entries are 32-bit little-endian words
+	static uint32_t convertBytesToRoutingTableEntry(const uint8_t* bytes) {
+		return bytes[0] + (bytes[1] << 8) + (bytes[2] << 16) + ((uint32_t) bytes[3] << 24);
+	}
+
+private:
+	static void convertRoutingTableEntryToBytes(uint32_t entry, uint8_t* bytes) {
+		bytes[0] = entry & 0xFF;
+		bytes[1] = (entry >> 8) & 0xFF;
+		bytes[2] = (entry >> 16) & 0xFF;
+		bytes[3] = (entry >> 24) & 0xFF;
 	}
 };
 
@@ -0,0 +1,508 @@
+/* 
+============================================================================
+SpaceWire/RMAP Library is provided under the MIT License.
+============================================================================
+
+Copyright (c) 2006-2013 Takayuki Yuasa and The Open-source SpaceWire Project
+
+Permission is hereby granted, free of charge, to any person obtaining a 
+copy of this software and associated documentation files (the 
+"Software"), to deal in the Software without restriction, including 
+without limitation the rights to use, copy, modify, merge, publish, 
+distribute, sublicense, and/or sell copies of the Software, and to 
+permit persons to whom the Software is furnished to do so, subject to 
+the following conditions:
+
+The above copyright notice and this permission notice shall be included 
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. 
+*/
+/*
+ * RouterNetworkDiscovery.hh
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef ROUTERNETWORKDISCOVERY_HH_
+#define ROUTERNETWORKDISCOVERY_HH_
+
+#include "CxxUtilities/CxxUtilities.hh"
+#include "RMAP.hh"
+#include <limits>
+
+/** A router found by RouterNetworkDiscovery. */
+class DiscoveredRouter {
+public:
+	static const size_t NoParent = (size_t) -1;
+
+public:
+	/** Path address to the router (the configuration port address is added by the router class). */
+	std::vector<uint8_t> targetSpaceWireAddress;
+	/** Reply address from the router back to the initiator. */
+	std::vector<uint8_t> replyAddress;
+	/** Index of the router from which this router was reached (NoParent for the first router). */
+	size_t parentIndex;
+	/** Port of the parent router connected to this router. */
+	uint8_t parentPort;
+	/** Port of this router connected to the parent router (for the first router, the first hop of the reply address, or 0). */
+	uint8_t arrivalPort;
+	/** Distance from the first router. */
+	size_t depth;
+	/** False if the status of this router (link control/status registers or routing table) could not be read.
+	 * Ports of a router whose link control/status registers could not be read are not probed. */
+	bool isHealthy;
+
+public:
+	/** Ports whose links are connected. */
+	std::vector<uint8_t> connectedPorts;
+	/** Link control/status register value (4 bytes) of each port returned by getConfigurablePorts(). */
+	std::map<uint8_t, std::vector<uint8_t> > linkControlStatusRegisters;
+	/** Connected ports which lead to other routers, and the indices of those routers. */
+	std::map<uint8_t, size_t> neighborRouters;
+	/** Connected ports at which no router answered (e.g. nodes other than routers). */
+	std::vector<uint8_t> nonRouterPorts;
+	/** Connected ports whose probes could not be sent (e.g. the SpaceWire interface failed), so it is
+	 * unknown whether they lead to routers. */
+	std::vector<uint8_t> failedProbePorts;
+	/** Routing table (port numbers for each logical address from MinimumLogicalAddress), if read. */
+	std::vector<std::vector<uint8_t> > routingTable;
+
+public:
+	DiscoveredRouter() {
+		parentIndex = NoParent;
+		parentPort = 0;
+		arrivalPort = 0;
+		depth = 0;
+		isHealthy = true;
+	}
+};
+
+/** A snapshot of a router network created by RouterNetworkDiscovery::discover(). */
+class RouterNetworkTopology {
+public:
+	std::vector<DiscoveredRouter> routers;
+	/** Time spent for the discovery in ms. */
+	double discoveryTime;
+	/** Number of RMAP probes sent to find neighbor routers. */
+	size_t nProbes;
+	/** Number of probes which could not be sent. */
+	size_t nFailedProbes;
+
+public:
+	RouterNetworkTopology() {
+		discoveryTime = 0;
+		nProbes = 0;
+		nFailedProbes = 0;
+	}
+
+public:
+	std::string toString() {
+		using namespace std;
+		stringstream ss;
+		ss << routers.size() << " routers (discovered in " << discoveryTime << " ms with " << nProbes << " probes)" << endl;
+		for (size_t i = 0; i < routers.size(); i++) {
+			DiscoveredRouter& router = routers[i];
+			ss << "Router " << i << " depth=" << router.depth << " path=["
+					<< CxxUtilities::Array<uint8_t>::toString(router.targetSpaceWireAddress, "hex", 128) << "] reply=["
+					<< CxxUtilities::Array<uint8_t>::toString(router.replyAddress, "hex", 128) << "]";
+			if (router.parentIndex != DiscoveredRouter::NoParent) {
+				ss << " parent=" << router.parentIndex << " (port " << (uint32_t) router.parentPort << " -> port "
+						<< (uint32_t) router.arrivalPort << ")";
+			}
+			if (!router.isHealthy) {
+				ss << " (status could not be read)";
+			}
+			ss << endl;
+			for (std::map<uint8_t, size_t>::iterator it = router.neighborRouters.begin();
+					it != router.neighborRouters.end(); it++) {
+				ss << "  Port " << (uint32_t) it->first << " -> Router " << it->second << endl;
+			}
+			for (size_t p = 0; p < router.nonRouterPorts.size(); p++) {
+				ss << "  Port " << (uint32_t) router.nonRouterPorts[p] << " -> (non-router node)" << endl;
+			}
+			for (size_t p = 0; p < router.failedProbePorts.size(); p++) {
+				ss << "  Port " << (uint32_t) router.failedProbePorts[p] << " -> (probe failed)" << endl;
+			}
+		}
+		return ss.str();
+	}
+};
+
+/** Discovers a network of routers of the same model breadth-first.
+ * Starting from the router at a given path address, the link control/status registers of all routers
+ * found at one depth are read (one pipelined batch per router), and every connected port which does not lead back
+ * to the parent is probed for a router. As the port of the next router through which a probe arrives
+ * is not known in advance, one probe is sent per candidate arrival port (with the reply address
+ * starting with that port), and only the probe with the right reply address is answered.
+ * Probes of all ports of all routers at the same depth are kept in flight at once (up to
+ * the number of initiators), and remaining probes of a port are canceled as soon as one
+ * of them is answered, so a depth costs about one round trip unless some connected port
+ * leads to a non-router node (then the probe timeout).
+ *
+ * RouterType should be a RouterConfigurationPort subclass which provides
+ * isConnected(port) and readLinkControlStatusRegister(port, value) (e.g. ShimafujiElectricSpaceWire6PortRouter).
+ * Routers are identified by their paths; in a network with loops, a router can be found more than once
+ * (up to the maximum depth).
+ */
+template<class RouterType>
+class RouterNetworkDiscovery {
+public:
+	static const size_t DefaultNumberOfProbesInFlight = 32;
+	static constexpr double DefaultProbeTimeoutDuration = 100.0;
+	static const size_t DefaultMaximumDepth = 16;
+	static const size_t DefaultMaximumNumberOfRouters = 256;
+	static constexpr double ProbePollingIntervalInMilliSec = 0.05;
+
+private:
+	RMAPInitiator* rmapInitiator;
+	std::vector<RMAPInitiator*> probeInitiators;
+	RouterType* prototype;
+	std::vector<RouterType*> routerInstances;
+
+private:
+	size_t nProbesInFlight;
+	double probeTimeoutDuration;
+	size_t maximumDepth;
+	size_t maximumNumberOfRouters;
+	bool readRoutingTables;
+
+private:
+	struct Probe {
+		RMAPTargetNode node;
+		uint32_t address;
+		size_t group;
+		uint8_t arrivalPort;
+		bool succeeded;
+		bool failed; //could not be sent
+	};
+
+public:
+	/** Constructor.
+	 * @param[in] rmapInitiator initiator whose RMAPEngine is used for all accesses
+	 */
+	RouterNetworkDiscovery(RMAPInitiator* rmapInitiator) {
+		this->rmapInitiator = rmapInitiator;
+		prototype = new RouterType();
+		nProbesInFlight = DefaultNumberOfProbesInFlight;
+		probeTimeoutDuration = DefaultProbeTimeoutDuration;
+		maximumDepth = DefaultMaximumDepth;
+		maximumNumberOfRouters = DefaultMaximumNumberOfRouters;
+		readRoutingTables = true;
+	}
+
+public:
+	virtual ~RouterNetworkDiscovery() {
+		deleteRouterInstances();
+		for (size_t i = 0; i < probeInitiators.size(); i++) {
+			delete probeInitiators[i];
+		}
+		delete prototype;
+	}
+
+public:
+	/** Discovers routers.
+	 * @param[in] targetSpaceWireAddress path address to the first router (as passed to applyNewPathAddresses();
+	 * a trailing configuration port address 0x00 is removed)
+	 * @param[in] replyAddress reply address from the first router
+	 */
+	RouterNetworkTopology discover(std::vector<uint8_t> targetSpaceWireAddress, std::vector<uint8_t> replyAddress)
+			throw (RouterConfigurationPortException, RMAPInitiatorException) {
+		RouterNetworkTopology topology;
+		double startTime = CxxUtilities::Time::getClockValueInMilliSec();
+		deleteRouterInstances();
+		prepareProbeInitiators();
+
+		if (targetSpaceWireAddress.size() != 0 && targetSpaceWireAddress.back() == 0x00) {
+			targetSpaceWireAddress.pop_back();
+		}
+		DiscoveredRouter first;
+		first.targetSpaceWireAddress = targetSpaceWireAddress;
+		first.replyAddress = replyAddress;
+		//the first hop of the reply address leads back to the initiator
+		for (size_t i = 0; i < replyAddress.size(); i++) {
+			if (replyAddress[i] != 0x00) {
+				first.arrivalPort = replyAddress[i];
+				break;
+			}
+		}
+		topology.routers.push_back(first);
+		routerInstances.push_back(createRouterInstance(first));
+
+		size_t levelBegin = 0;
+		while (levelBegin < topology.routers.size()) {
+			size_t levelEnd = topology.routers.size();
+			std::vector<Probe> probes;
+			std::vector<std::pair<size_t, uint8_t> > groups; //(router index, port) of each probe group
+			for (size_t i = levelBegin; i < levelEnd; i++) {
+				readRouterStatus(topology.routers[i], routerInstances[i]);
+				if (topology.routers[i].depth >= maximumDepth) {
+					continue;
+				}
+				addProbes(topology.routers[i], i, probes, groups);
+			}
+			runProbes(probes, groups.size());
+			topology.nProbes += probes.size();
+
+			//routers found at the next depth
+			std::vector<bool> answered(groups.size(), false);
+			std::vector<bool> failed(groups.size(), false);
+			for (size_t i = 0; i < probes.size(); i++) {
+				if (probes[i].failed) {
+					failed[probes[i].group] = true;
+					topology.nFailedProbes++;
+				}
+				if (!probes[i].succeeded || topology.routers.size() >= maximumNumberOfRouters) {
+					continue;
+				}
+				answered[probes[i].group] = true;
+				size_t parentIndex = groups[probes[i].group].first;
+				uint8_t parentPort = groups[probes[i].group].second;
+				DiscoveredRouter router;
+				router.targetSpaceWireAddress = topology.routers[parentIndex].targetSpaceWireAddress;
+				router.targetSpaceWireAddress.push_back(parentPort);
+				router.replyAddress.push_back(probes[i].arrivalPort);
+				router.replyAddress.insert(router.replyAddress.end(), topology.routers[parentIndex].replyAddress.begin(),
+						topology.routers[parentIndex].replyAddress.end());
+				router.parentIndex = parentIndex;
+				router.parentPort = parentPort;
+				router.arrivalPort = probes[i].arrivalPort;
+				router.depth = topology.routers[parentIndex].depth + 1;
+				topology.routers[parentIndex].neighborRouters[parentPort] = topology.routers.size();
+				topology.routers.push_back(router);
+				routerInstances.push_back(createRouterInstance(router));
+			}
+			for (size_t g = 0; g < groups.size(); g++) {
+				if (answered[g]) {
+					continue;
+				}
+				//a router may be behind a port whose probe (with the right arrival port) could not be sent
+				if (failed[g]) {
+					topology.routers[groups[g].first].failedProbePorts.push_back(groups[g].second);
+					std::cerr << "RouterNetworkDiscovery: probes of port " << (uint32_t) groups[g].second
+							<< " of the router at path ["
+							<< CxxUtilities::Array<uint8_t>::toString(topology.routers[groups[g].first].targetSpaceWireAddress,
+									"hex", 128) << "] could not be sent" << std::endl;
+				} else {
+					topology.routers[groups[g].first].nonRouterPorts.push_back(groups[g].second);
+				}
+			}
+			levelBegin = levelEnd;
+		}
+		topology.discoveryTime = CxxUtilities::Time::getClockValueInMilliSec() - startTime;
+		return topology;
+	}
+
+public:
+	/** Returns router instances configured with the paths of the routers found by the last discover()
+	 * (the i-th instance corresponds to RouterNetworkTopology::routers[i]). The instances are owned by this object.
+	 */
+	std::vector<RouterType*> getRouterInstances() {
+		return routerInstances;
+	}
+
+public:
+	void setNumberOfProbesInFlight(size_t nProbesInFlight) {
+		this->nProbesInFlight = (nProbesInFlight == 0) ? 1 : nProbesInFlight;
+	}
+
+public:
+	/** Sets the timeout of a probe in ms. A connected port which leads to a non-router node costs this duration
+	 * once per depth (probes of other ports are in flight meanwhile).
+	 */
+	void setProbeTimeoutDuration(double probeTimeoutDuration) {
+		this->probeTimeoutDuration = probeTimeoutDuration;
+	}
+
+public:
+	void setMaximumDepth(size_t maximumDepth) {
+		this->maximumDepth = maximumDepth;
+	}
+
+public:
+	/** Sets the maximum number of routers to be discovered. As routers are identified by their paths,
+	 * this (and the maximum depth) bounds the discovery in a network with loops.
+	 */
+	void setMaximumNumberOfRouters(size_t maximumNumberOfRouters) {
+		this->maximumNumberOfRouters = maximumNumberOfRouters;
+	}
+
+public:
+	/** Sets whether routing tables are read (with RouterConfigurationPort::readWholeRoutingTable()).
+	 */
+	void setReadRoutingTables(bool readRoutingTables) {
+		this->readRoutingTables = readRoutingTables;
+	}
+
+private:
+	void prepareProbeInitiators() {
+		while (probeInitiators.size() < nProbesInFlight) {
+			RMAPInitiator* initiator = new RMAPInitiator(rmapInitiator->getRMAPEngine());
+			if (rmapInitiator->isInitiatorLogicalAddressSet()) {
+				initiator->setInitiatorLogicalAddress(rmapInitiator->getInitiatorLogicalAddress());
+			}
+			initiator->setUseDraftECRC(rmapInitiator->isUseDraftECRC());
+			probeInitiators.push_back(initiator);
+		}
+	}
+
+private:
+	RouterType* createRouterInstance(DiscoveredRouter& router) {
+		RouterType* instance = new RouterType();
+		instance->setRMAPInitiator(rmapInitiator);
+		instance->applyNewPathAddresses(router.targetSpaceWireAddress, router.replyAddress);
+		instance->setRegisterAccessTimeoutDuration(probeTimeoutDuration);
+		return instance;
+	}
+
+private:
+	void deleteRouterInstances() {
+		for (size_t i = 0; i < routerInstances.size(); i++) {
+			delete routerInstances[i];
+		}
+		routerInstances.clear();
+	}
+
+private:
+	/** Reads link control/status registers in one pipelined batch (and the routing table if enabled).
+	 * If reading fails, the router is marked unhealthy (DiscoveredRouter::isHealthy) and the discovery continues.
+	 */
+	void readRouterStatus(DiscoveredRouter& router, RouterType* instance) {
+		using namespace std;
+		double maximumAge = instance->getLinkControlStatusRegisterMaximumAge();
+		try {
+			instance->setLinkControlStatusRegisterMaximumAge(std::numeric_limits<double>::max());
+			instance->refreshLinkControlStatusRegisters();
+			std::vector<uint8_t> ports = instance->getConfigurablePorts();
+			std::map<uint8_t, std::vector<uint8_t> > linkControlStatusRegisters;
+			std::vector<uint8_t> connectedPorts;
+			for (size_t i = 0; i < ports.size(); i++) {
+				std::vector<uint8_t> value(4);
+				instance->readLinkControlStatusRegister(ports[i], &value[0]); //from the cache
+				linkControlStatusRegisters[ports[i]] = value;
+				if (instance->isConnected(ports[i])) {
+					connectedPorts.push_back(ports[i]);
+				}
+			}
+			router.linkControlStatusRegisters.swap(linkControlStatusRegisters);
+			router.connectedPorts.swap(connectedPorts);
+			instance->setLinkControlStatusRegisterMaximumAge(maximumAge);
+			if (readRoutingTables) {
+				router.routingTable = instance->readWholeRoutingTable();
+			}
+		} catch (CxxUtilities::Exception& e) {
+			instance->setLinkControlStatusRegisterMaximumAge(maximumAge);
+			router.isHealthy = false;
+			cerr << "RouterNetworkDiscovery: status of the router at path ["
+					<< CxxUtilities::Array<uint8_t>::toString(router.targetSpaceWireAddress, "hex", 128)
+					<< "] could not be read (" << e.toString() << ")" << endl;
+		}
+	}
+
+private:
+	/** Adds probes for every connected port of a router except the one leading back to its parent.
+	 */
+	void addProbes(DiscoveredRouter& router, size_t routerIndex, std::vector<Probe>& probes,
+			std::vector<std::pair<size_t, uint8_t> >& groups) {
+		std::vector<uint8_t> candidateArrivalPorts = prototype->getConfigurablePorts();
+		for (size_t i = 0; i < router.connectedPorts.size(); i++) {
+			uint8_t port = router.connectedPorts[i];
+			if (port == router.arrivalPort) {
+				continue;
+			}
+			size_t group = groups.size();
+			groups.push_back(std::make_pair(routerIndex, port));
+			std::vector<uint8_t> targetSpaceWireAddress = router.targetSpaceWireAddress;
+			targetSpaceWireAddress.push_back(port);
+			for (size_t c = 0; c < candidateArrivalPorts.size(); c++) {
+				std::vector<uint8_t> replyAddress;
+				replyAddress.push_back(candidateArrivalPorts[c]);
+				replyAddress.insert(replyAddress.end(), router.replyAddress.begin(), router.replyAddress.end());
+				prototype->applyNewPathAddresses(targetSpaceWireAddress, replyAddress);
+				Probe probe;
+				probe.node = *prototype->getRMAPTargetNodeInstance();
+				//the arrival port's link control/status register (the link should be connected)
+				probe.address = prototype->getLinkControlStatusRegisterAddress(candidateArrivalPorts[c]);
+				probe.group = group;
+				probe.arrivalPort = candidateArrivalPorts[c];
+				probe.succeeded = false;
+				probe.failed = false;
+				probes.push_back(probe);
+			}
+		}
+	}
+
+private:
+	/** Sends probes keeping up to nProbesInFlight in flight. When a probe of a group is answered,
+	 * the other probes of the group are canceled or not sent. Probes which could not be sent are marked failed.
+	 */
+	void runProbes(std::vector<Probe>& probes, size_t nGroups) {
+		const size_t nInitiators = probeInitiators.size();
+		std::vector<size_t> slotProbes(nInitiators, probes.size()); //probe index per initiator (probes.size() = free)
+		std::vector<double> slotDeadlines(nInitiators, 0);
+		std::vector<bool> groupAnswered(nGroups, false);
+		size_t next = 0;
+		size_t nBusy = 0;
+		CxxUtilities::Condition c;
+		while (true) {
+			//issue
+			for (size_t s = 0; s < nInitiators && next < probes.size(); s++) {
+				if (slotProbes[s] != probes.size()) {
+					continue;
+				}
+				while (next < probes.size() && groupAnswered[probes[next].group]) {
+					next++;
+				}
+				if (next == probes.size()) {
+					break;
+				}
+				try {
+					probeInitiators[s]->nonblockingRead(&probes[next].node, probes[next].address, 4);
+					slotProbes[s] = next;
+					slotDeadlines[s] = CxxUtilities::Time::getClockValueInMilliSec() + probeTimeoutDuration;
+					nBusy++;
+				} catch (CxxUtilities::Exception& e) {
+					probes[next].failed = true;
+				}
+				next++;
+			}
+			if (nBusy == 0) {
+				break;
+			}
+			c.wait(ProbePollingIntervalInMilliSec);
+			//complete
+			double now = CxxUtilities::Time::getClockValueInMilliSec();
+			for (size_t s = 0; s < nInitiators; s++) {
+				size_t index = slotProbes[s];
+				if (index == probes.size()) {
+					continue;
+				}
+				Probe& probe = probes[index];
+				bool completed = probeInitiators[s]->isNonblockingReadCompleted();
+				if (completed) {
+					uint8_t value[4];
+					try {
+						probeInitiators[s]->getNonblockingReadData(value, 4);
+						probe.succeeded = true;
+						groupAnswered[probe.group] = true;
+					} catch (CxxUtilities::Exception& e) {
+					}
+				} else if (!groupAnswered[probe.group] && now < slotDeadlines[s]) {
+					continue;
+				} else {
+					probeInitiators[s]->cancelNonblockingRead();
+				}
+				slotProbes[s] = probes.size();
+				nBusy--;
+			}
+		}
+	}
+};
+
+#endif /* ROUTERNETWORKDISCOVERY_HH_ */
@@ -37,6 +37,7 @@
 #include <CxxUtilities/CommonHeader.hh>
 #include <CxxUtilities/Exception.hh>
 #include "SpaceWireEOPMarker.hh"
+#include <sys/uio.h>
 
 class SpaceWireIFException: public CxxUtilities::Exception {
 public:
@@ -211,6 +212,33 @@ public:
 		}
 	}
 
+public:
+	/** Sends a SpaceWire packet whose content is scattered over multiple memory regions.
+	 * This default implementation gathers the regions into a temporary buffer and
+	 * calls send(uint8_t*, size_t, EOPType). Subclasses which can transmit directly
+	 * from scattered memory should override this method.
+	 * @param[in] iovecs memory regions which constitute the packet
+	 * @param[in] nIOVecs number of entries in iovecs
+	 * @param[in] eopType End-of-Packet marker
+	 */
+	virtual void sendIOVectors(struct iovec* iovecs, size_t nIOVecs, SpaceWireEOPMarker::EOPType eopType =
+			SpaceWireEOPMarker::EOP) throw (SpaceWireIFException) {
+		size_t length = 0;
+		for (size_t i = 0; i < nIOVecs; i++) {
+			length += iovecs[i].iov_len;
+		}
+		if (length == 0) {
+			return;
+		}
+		std::vector<uint8_t> data(length);
+		size_t index = 0;
+		for (size_t i = 0; i < nIOVecs; i++) {
+			memcpy(&(data[index]), iovecs[i].iov_base, iovecs[i].iov_len);
+			index += iovecs[i].iov_len;
+		}
+		send(&(data[0]), length, eopType);
+	}
+
 	/*
 	 public:
 	 void send(SpaceWirePacket* packet) throw (SpaceWireIFException) {
@@ -186,6 +186,23 @@ public:
 		}
 	}
 
+public:
+	void sendIOVectors(struct iovec* iovecs, size_t nIOVecs, SpaceWireEOPMarker::EOPType eopType =
+			SpaceWireEOPMarker::EOP) throw (SpaceWireIFException) {
+		if (ssdtp == NULL) {
+			throw SpaceWireIFException(SpaceWireIFException::LinkIsNotOpened);
+		}
+		try {
+			ssdtp->send(iovecs, nIOVecs, eopType);
+		} catch (SpaceWireSSDTPException& e) {
+			if (e.getStatus() == SpaceWireSSDTPException::Timeout) {
+				throw SpaceWireIFException(SpaceWireIFException::Timeout);
+			} else {
+				throw SpaceWireIFException(SpaceWireIFException::Disconnected);
+			}
+		}
+	}
+
 public:
 	void receive(std::vector<uint8_t>* buffer) throw (SpaceWireIFException) {
 		if (ssdtp == NULL) {
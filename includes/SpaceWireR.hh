@@ -38,6 +38,9 @@ SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #pragma clang diagnostic ignored "-Wc++11-extensions"
 
 #include "SpaceWire.hh"
+#include "SpaceWireR/SpaceWireRTrace.hh"
+#include "SpaceWireR/SpaceWireRRingBuffer.hh"
+#include "SpaceWireR/SpaceWireRTransmitScheduler.hh"
 #include "SpaceWireR/SpaceWireRClassInterfaces.hh"
 #include "SpaceWireR/SpaceWireRProtocol.hh"
 #include "SpaceWireR/SpaceWireREngine.hh"
@@ -35,38 +35,166 @@ SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #define SPACEWIRERCLASSINTERFACES_HH_
 
 #include "SpaceWireR/SpaceWireRPacket.hh"
+#include "SpaceWireR/SpaceWireRRingBuffer.hh"
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
 
 class SpaceWireRTEPInterface {
+public:
+	/** The number of received packets that can be queued for a TEP.
+	 * This should be larger than the maximum sliding window size so that
+	 * a full window of segments (and their acks) fits without backpressure.
+	 */
+	static const size_t DefaultReceivedPacketQueueCapacity = 1024;
+
+public:
+	SpaceWireRTEPInterface() :
+			receivedPackets(DefaultReceivedPacketQueueCapacity) {
+		isTEPWaitingForPacket = false;
+		isEngineWaitingForQueueSpace = false;
+		nReceivedPacketQueueFull = 0;
+		nDroppedReceivedPackets = 0;
+	}
+
 public:
 	virtual ~SpaceWireRTEPInterface() {
 	}
 
 public:
-	std::list<SpaceWireRPacket*> receivedPackets;
-	CxxUtilities::Condition packetArrivalNotifier; //used to notify arrival of SpaceWire-R packets by SpaceWire-R Engine
+	/** Received packets passed from SpaceWireREngine.
+	 * The engine's receive thread is the only producer, and the TEP's run() thread is the only consumer.
+	 */
+	SpaceWireRRingBuffer<SpaceWireRPacket*> receivedPackets;
 	uint16_t channel;
 
 public:
 	virtual void closeDueToSpaceWireIFFailure() = 0;
 
 private:
-	CxxUtilities::Mutex mutexReceivedPackets;
+	//CxxUtilities::Condition::wait() locks its mutex internally, and therefore cannot check
+	//the queue state under the mutex; std::condition_variable is used to wait without lost wakeups
+	std::mutex receivedPacketsMutex;
+	std::condition_variable packetArrivalNotifier; //notifies arrival of SpaceWire-R packets to the TEP
+	std::condition_variable packetConsumptionNotifier; //wakes up SpaceWireREngine waiting for free space
+	std::atomic<bool> isTEPWaitingForPacket;
+	std::atomic<bool> isEngineWaitingForQueueSpace;
+
+private:
+	//backpressure counters (updated only by SpaceWireREngine)
+	size_t nReceivedPacketQueueFull;
+	size_t nDroppedReceivedPackets;
+
+public:
+	/** Queues a received packet without blocking.
+	 * The TEP is notified only if it is waiting in waitForReceivedPacket();
+	 * while the TEP is draining the queue, pushing does not take any lock.
+	 * @param[in] packet a received packet
+	 * @return false if the queue is full
+	 */
+	bool pushReceivedSpaceWireRPacket(SpaceWireRPacket* packet) {
+		if (!receivedPackets.push(packet)) {
+			return false;
+		}
+		//pairs with the fence in waitForReceivedPacket(): either the TEP sees the packet
+		//before it starts waiting, or this thread sees that the TEP is waiting
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (isTEPWaitingForPacket.load(std::memory_order_relaxed)) {
+			notify(packetArrivalNotifier);
+		}
+		return true;
+	}
+
+public:
+	/** Waits until the TEP consumes a packet from the queue.
+	 * Called by SpaceWireREngine when the queue is full and the engine is configured to block.
+	 * @param[in] timeoutDurationInMilliSec timeout duration
+	 */
+	void waitForReceivedPacketQueueSpace(double timeoutDurationInMilliSec) {
+		isEngineWaitingForQueueSpace.store(true);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		//make sure that the TEP is awake to drain the queue
+		notify(packetArrivalNotifier);
+		{
+			std::unique_lock<std::mutex> lock(receivedPacketsMutex);
+			packetConsumptionNotifier.wait_for(lock,
+					std::chrono::duration<double, std::milli>(timeoutDurationInMilliSec), [this]() {
+						return !receivedPackets.isFull();
+					});
+		}
+		isEngineWaitingForQueueSpace.store(false);
+	}
+
+public:
+	void incrementNReceivedPacketQueueFull() {
+		nReceivedPacketQueueFull++;
+	}
+
+public:
+	void incrementNDroppedReceivedPackets() {
+		nDroppedReceivedPackets++;
+	}
+
+public:
+	/** Returns the number of times SpaceWireREngine found receivedPackets full.
+	 */
+	size_t getNReceivedPacketQueueFull() const {
+		return nReceivedPacketQueueFull;
+	}
 
 public:
-	void pushReceivedSpaceWireRPacket(SpaceWireRPacket* packet) {
-		mutexReceivedPackets.lock();
-		receivedPackets.push_back(packet);
-		mutexReceivedPackets.unlock();
+	/** Returns the number of packets dropped because receivedPackets was full.
+	 */
+	size_t getNDroppedReceivedPackets() const {
+		return nDroppedReceivedPackets;
 	}
 
 protected:
+	/** Removes the oldest received packet.
+	 * @return a received packet, or NULL if no packet is queued
+	 */
 	SpaceWireRPacket* popReceivedSpaceWireRPacket() {
-		mutexReceivedPackets.lock();
-		SpaceWireRPacket* result = *(receivedPackets.begin());
-		receivedPackets.pop_front();
-		mutexReceivedPackets.unlock();
+		SpaceWireRPacket* result;
+		if (!receivedPackets.pop(result)) {
+			return NULL;
+		}
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (isEngineWaitingForQueueSpace.load(std::memory_order_relaxed)) {
+			notify(packetConsumptionNotifier);
+		}
 		return result;
 	}
+
+protected:
+	/** Waits until a packet is queued or the timeout duration elapses.
+	 * Returns immediately if a packet is already queued, and therefore
+	 * a packet pushed just before this method is called is not missed.
+	 * @param[in] timeoutDurationInMilliSec timeout duration
+	 */
+	void waitForReceivedPacket(double timeoutDurationInMilliSec) {
+		isTEPWaitingForPacket.store(true);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		{
+			std::unique_lock<std::mutex> lock(receivedPacketsMutex);
+			packetArrivalNotifier.wait_for(lock, std::chrono::duration<double, std::milli>(timeoutDurationInMilliSec),
+					[this]() {
+						return !receivedPackets.isEmpty();
+					});
+		}
+		isTEPWaitingForPacket.store(false);
+	}
+
+private:
+	/** Wakes up a thread waiting on the condition variable.
+	 * The mutex is taken so that the notification cannot fall between the waiter's
+	 * predicate check and the start of its wait.
+	 */
+	void notify(std::condition_variable& notifier) {
+		{
+			std::lock_guard<std::mutex> lock(receivedPacketsMutex);
+		}
+		notifier.notify_one();
+	}
 };
 
 #endif /* SPACEWIRERCLASSINTERFACES_HH_ */
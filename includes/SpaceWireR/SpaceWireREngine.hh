@@ -37,12 +37,12 @@ SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "CxxUtilities/Thread.hh"
 #include "SpaceWireR/SpaceWireRPacket.hh"
 #include "SpaceWireR/SpaceWireRClassInterfaces.hh"
+#include "SpaceWireR/SpaceWireRTrace.hh"
+#include "SpaceWireR/SpaceWireRTransmitScheduler.hh"
 
 //#define SpaceWireREngineDumpPacket
-#define DebugSpaceWireREngine
 
 #undef SpaceWireREngineDumpPacket
-//#undef DebugSpaceWireREngine
 
 
 /*
@@ -101,16 +101,43 @@ private:
 	SpaceWireIF* spwif;
 	CxxUtilities::Condition stopCondition;
 
+public:
+	/** Number of entries of the channel table (one entry per 16-bit channel number). */
+	static const size_t NumberOfChannels = 0x10000;
+
 private:
-	std::map<uint16_t, SpaceWireRTEPInterface*> receiveTEPs;
-	std::map<uint16_t, SpaceWireRTEPInterface*> transmitTEPs;
-	std::map<uint16_t, SpaceWireRTEPInterface*> allTEPs;
+	/** TEPs registered to a channel.
+	 * anyTEP is the TEP registered last, and receives HeartBeat/FlowControl packets.
+	 */
+	struct ChannelTableEntry {
+		std::atomic<SpaceWireRTEPInterface*> receiveTEP;
+		std::atomic<SpaceWireRTEPInterface*> transmitTEP;
+		std::atomic<SpaceWireRTEPInterface*> anyTEP;
+	};
+
+private:
+	//indexed directly by channel number so that packet dispatch does not need a search
+	ChannelTableEntry* channelTable;
+
+public:
+	/** Behavior when the receive queue of the destination TEP is full. */
+	enum ReceivedPacketQueueFullPolicy {
+		BlockWhenReceivedPacketQueueIsFull, //
+		DropWhenReceivedPacketQueueIsFull
+	};
+
+private:
+	ReceivedPacketQueueFullPolicy receivedPacketQueueFullPolicy;
 
 private:
 	size_t nDiscardedReceivedPackets;
 	size_t nSentPackets;
 	size_t nReceivedPackets;
-	CxxUtilities::Mutex sendMutex;
+	size_t nDroppedReceivedPackets;
+
+private:
+	//serializes packet transmission across channels (priority classes + weighted round robin)
+	SpaceWireRTransmitScheduler transmitScheduler;
 
 private:
 	static constexpr double TimeoutDurationForStopCondition = 1000;
@@ -121,197 +148,234 @@ public:
 		nDiscardedReceivedPackets = 0;
 		nSentPackets = 0;
 		nReceivedPackets = 0;
+		nDroppedReceivedPackets = 0;
+		receivedPacketQueueFullPolicy = BlockWhenReceivedPacketQueueIsFull;
+		channelTable = new ChannelTableEntry[NumberOfChannels];
+		for (size_t i = 0; i < NumberOfChannels; i++) {
+			channelTable[i].receiveTEP = NULL;
+			channelTable[i].transmitTEP = NULL;
+			channelTable[i].anyTEP = NULL;
+		}
+	}
+
+public:
+	virtual ~SpaceWireREngine() {
+		delete[] channelTable;
 	}
 
 public:
 	static constexpr double DefaultReceiveTimeoutDurationInMicroSec = 1000000;
 
+public:
+	/** Time slice of a single wait when the engine blocks on a full receive queue. */
+	static constexpr double WaitDurationInMsForReceivedPacketQueueSpace = 10;
+
+public:
+	/** When blocking on a full receive queue exceeds this duration, the packet is dropped
+	 * so that a stalled TEP does not stop the other channels forever.
+	 */
+	static constexpr double MaximumBlockingDurationInMsForReceivedPacketQueue = 1000;
+
 public:
 	void processReceivedSpaceWireRPacket(SpaceWireRPacket* packet) throw (SpaceWireREngineException) {
 		using namespace std;
-#ifdef DebugSpaceWireREngine
-		cout << "SpaceWireREngine::processReceivedSpaceWireRPacket()" << endl;
-#endif
-		uint16_t channel = packet->getChannelNumber();
-		if(packet->isHeartBeatPacketType() || packet->isHeartBeatAckPacketType()){
-			// for HeartBeat/HeartBeatAck packets, all TEPs can be a potential destiantion TEP,
-			// and therefore, search in the allTEPs map.
-#ifdef DebugSpaceWireREngine
-			cout << "SpaceWireREngine::processReceivedSpaceWireRPacket() is HeartBeat/HeartBeatAck packet." << endl;
-#endif
-			std::map<uint16_t, SpaceWireRTEPInterface*>::iterator it_find = allTEPs.find(channel);
-			if (it_find != allTEPs.end()) {
-				//if there is TransmitTEP/ReceiveTEP corresponding to the channel number in the received packet.
-				it_find->second->pushReceivedSpaceWireRPacket(packet); //pass the received packet to the ReceiveTEP
-				//tell the TEP that a packet has arrived.
-				it_find->second->packetArrivalNotifier.signal();
-#ifdef DebugSpaceWireREngine
-				cout << "SpaceWireREngine::processReceivedSpaceWireRPacket() pushed to " << "0x" << hex << right << setw(8)
-						<< setfill('0') << (uint64_t) it_find->second << " nPackets=" << it_find->second->receivedPackets.size() << endl;
-#endif
-			} else {
-				//if there is no ReceiveTEP to receive the packet.
-				//discard the packet
-#ifdef DebugSpaceWireREngine
-				cout << "SpaceWireREngine::processReceivedSpaceWireRPacket() TEP is not found." << endl;
-#endif
-				nDiscardedReceivedPackets++;
-				delete packet;
-			}
-		}else if(packet->isFlowControlPacket()){
-#ifdef DebugSpaceWireREngine
-			cout << "SpaceWireREngine::processReceivedSpaceWireRPacket() is FlowControl packet (sequence number=" << packet->getSequenceNumberAs32bitInteger() << ")." << endl;
-#endif
-			std::map<uint16_t, SpaceWireRTEPInterface*>::iterator it_find = allTEPs.find(channel);
-			if (it_find != allTEPs.end()) {
-				//if there is TransmitTEP/ReceiveTEP corresponding to the channel number in the received packet.
-				it_find->second->pushReceivedSpaceWireRPacket(packet); //pass the received packet to the ReceiveTEP
-				//tell the TEP that a packet has arrived.
-				it_find->second->packetArrivalNotifier.signal();
-#ifdef DebugSpaceWireREngine
-				cout << "SpaceWireREngine::processReceivedSpaceWireRPacket() pushed to " << "0x" << hex << right << setw(8)
-						<< setfill('0') << (uint64_t) it_find->second << " nPackets=" << it_find->second->receivedPackets.size() << endl;
-#endif
-			} else {
-				//if there is no ReceiveTEP to receive the packet.
-				//discard the packet
-#ifdef DebugSpaceWireREngine
-				cout << "SpaceWireREngine::processReceivedSpaceWireRPacket() TEP is not found." << endl;
-#endif
-				nDiscardedReceivedPackets++;
-				delete packet;
-			}
+		SpaceWireRTraceDebug(SpaceWireRTraceCategory::Engine, "SpaceWireREngine::processReceivedSpaceWireRPacket()");
+		ChannelTableEntry& entry = channelTable[packet->getChannelNumber()];
+		SpaceWireRTEPInterface* tep;
+		if (packet->isHeartBeatPacketType() || packet->isHeartBeatAckPacketType()) {
+			// for HeartBeat/HeartBeatAck packets, all TEPs can be a potential destiantion TEP.
+			SpaceWireRTraceDebug(SpaceWireRTraceCategory::Engine,
+					"SpaceWireREngine::processReceivedSpaceWireRPacket() is HeartBeat/HeartBeatAck packet.");
+			tep = entry.anyTEP.load(std::memory_order_acquire);
+		} else if (packet->isFlowControlPacket()) {
+			SpaceWireRTraceDebug(SpaceWireRTraceCategory::Engine,
+					"SpaceWireREngine::processReceivedSpaceWireRPacket() is FlowControl packet (sequence number={}).",
+					packet->getSequenceNumberAs32bitInteger());
+			tep = entry.anyTEP.load(std::memory_order_acquire);
 		} else if (!packet->isAckPacket()) { //command/data packet
-#ifdef DebugSpaceWireREngine
-			cout << "SpaceWireREngine::processReceivedSpaceWireRPacket() is Command/Data packet." << endl;
-#endif
-			std::map<uint16_t, SpaceWireRTEPInterface*>::iterator it_find = receiveTEPs.find(channel);
-			if (it_find != receiveTEPs.end()) {
-				//if there is ReceiveTEP corresponding to the channel number in the received packet.
-				it_find->second->pushReceivedSpaceWireRPacket(packet); //pass the received packet to the ReceiveTEP
-				//tell the ReceiveTEP that a packet has arrived.
-				it_find->second->packetArrivalNotifier.signal();
-#ifdef DebugSpaceWireREngine
-				cout << "SpaceWireREngine::processReceivedSpaceWireRPacket() pushed to " << "0x" << hex << right << setw(8)
-						<< setfill('0') << (uint64_t) it_find->second << " nPackets=" << it_find->second->receivedPackets.size() << endl;
-#endif
-			} else {
-				//if there is no ReceiveTEP to receive the packet.
-				//discard the packet
-#ifdef DebugSpaceWireREngine
-				cout << "SpaceWireREngine::processReceivedSpaceWireRPacket() TEP is not found." << endl;
-#endif
-				nDiscardedReceivedPackets++;
-				delete packet;
-			}
+			SpaceWireRTraceDebug(SpaceWireRTraceCategory::Engine,
+					"SpaceWireREngine::processReceivedSpaceWireRPacket() is Command/Data packet.");
+			tep = entry.receiveTEP.load(std::memory_order_acquire);
 		} else { //ack packet
-#ifdef DebugSpaceWireREngine
-			cout << "SpaceWireREngine::processReceivedSpaceWireRPacket() is Ack packet." << endl;
-#endif
-			std::map<uint16_t, SpaceWireRTEPInterface*>::iterator it_find = transmitTEPs.find(channel);
-			if (it_find != transmitTEPs.end()) {
-				//if there is TransmitTEP corresponding to the channel number in the received packet.
-				it_find->second->pushReceivedSpaceWireRPacket(packet); //pass the received packet to the ReceiveTEP
-				//tell the ReceiveTEP that a packet has arrived.
-				it_find->second->packetArrivalNotifier.signal();
-#ifdef DebugSpaceWireREngine
-				cout << "SpaceWireREngine::processReceivedSpaceWireRPacket() pushed to " << "0x" << hex << right << setw(8)
-						<< setfill('0') << (uint64_t) it_find->second << " nPackets=" << it_find->second->receivedPackets.size() << endl;
-#endif
-			} else {
-				//if there is no ReceiveTEP to receive the packet.
-				//discard the packet
-#ifdef DebugSpaceWireREngine
-				cout << "SpaceWireREngine::processReceivedSpaceWireRPacket() TEP is not found." << endl;
-#endif
-				nDiscardedReceivedPackets++;
-				delete packet;
+			SpaceWireRTraceDebug(SpaceWireRTraceCategory::Engine,
+					"SpaceWireREngine::processReceivedSpaceWireRPacket() is Ack packet.");
+			tep = entry.transmitTEP.load(std::memory_order_acquire);
+		}
+
+		if (tep == NULL) {
+			//if there is no TEP to receive the packet.
+			//discard the packet
+			SpaceWireRTraceDebug(SpaceWireRTraceCategory::Engine,
+					"SpaceWireREngine::processReceivedSpaceWireRPacket() TEP is not found.");
+			nDiscardedReceivedPackets++;
+			delete packet;
+			return;
+		}
+
+		//pass the received packet to the TEP (the TEP is notified if it is waiting)
+		passReceivedPacketToTEP(tep, packet);
+	}
+
+private:
+	void passReceivedPacketToTEP(SpaceWireRTEPInterface* tep, SpaceWireRPacket* packet) {
+		using namespace std;
+		if (tep->pushReceivedSpaceWireRPacket(packet)) {
+			SpaceWireRTraceDebug(SpaceWireRTraceCategory::Engine,
+					"SpaceWireREngine::passReceivedPacketToTEP() pushed to 0x{x} nPackets={}",
+					(uint64_t) tep, tep->receivedPackets.size());
+			return;
+		}
+
+		//the receive queue is full
+		tep->incrementNReceivedPacketQueueFull();
+		if (receivedPacketQueueFullPolicy == BlockWhenReceivedPacketQueueIsFull) {
+			double waitedDuration = 0;
+			while (!stopped && waitedDuration < MaximumBlockingDurationInMsForReceivedPacketQueue) {
+				tep->waitForReceivedPacketQueueSpace(WaitDurationInMsForReceivedPacketQueueSpace);
+				if (tep->pushReceivedSpaceWireRPacket(packet)) {
+					return;
+				}
+				waitedDuration += WaitDurationInMsForReceivedPacketQueueSpace;
 			}
 		}
+
+		SpaceWireRTraceDebug(SpaceWireRTraceCategory::Engine,
+				"SpaceWireREngine::passReceivedPacketToTEP() receive queue of channel {} is full. The packet is dropped.",
+				tep->channel);
+		tep->incrementNDroppedReceivedPackets();
+		nDroppedReceivedPackets++;
+		delete packet;
 	}
 
+public:
+	/** Header and trailer size used to weigh packets in the transmit scheduler. */
+	static const size_t EstimatedHeaderSizeInBytes = 16;
+
 public:
 	void sendPacket(SpaceWireRPacket* packet) throw (SpaceWireREngineException) {
 		using namespace std;
 		if (this->isStopped()) {
 			throw SpaceWireREngineException(SpaceWireREngineException::SpaceWireREngineIsNotRunning);
 		}
-		sendMutex.lock();
+		//the same packet instance may be sent from more than one thread (e.g. retransmission),
+		//so the packet is encoded only after the link is granted
+		transmitScheduler.acquire(packet->getChannelNumber(), packet->getPayloadSize() + EstimatedHeaderSizeInBytes);
 		try {
-#ifdef DebugSpaceWireREngine
-			cout << "SpaceWireREngine::sendPacket() sending packet." << endl;
-#endif
-			std::vector<uint8_t>* packetBuffer=packet->getPacketBufferPointer();
-			spwif->send(packetBuffer);
-			delete packetBuffer;
+			SpaceWireRTraceDebug(SpaceWireRTraceCategory::Engine, "SpaceWireREngine::sendPacket() sending packet.");
+			//the payload is passed to SpaceWireIF without being copied
+			struct iovec iovecs[SpaceWireRPacket::NumberOfIOVectors];
+			size_t nIOVecs = packet->encodeToIOVectors(iovecs);
+			spwif->sendIOVectors(iovecs, nIOVecs);
 #ifdef SpaceWireREngineDumpPacket
 			SpaceWireUtilities::dumpPacket(packet->getPacketBufferPointer());
 #endif
 			nSentPackets++;
 		} catch (...) {
-			sendMutex.unlock();
+			transmitScheduler.release();
 			using namespace std;
 			cerr << "SpaceWireREngine::sendPacket() fatal error with SpaceWireIF. SpaceWireREngine will stop." << endl;
 			this->stop();
 			throw SpaceWireREngineException(SpaceWireREngineException::SpaceWireIFIsNotWorking);
 		}
-		sendMutex.unlock();
+		transmitScheduler.release();
+	}
+
+public:
+	/** Sets the transmit priority class of a channel (SpaceWireRTransmitPriority::Highest/High/Normal/Low).
+	 * Packets of a higher class are always sent before waiting packets of lower classes.
+	 * All channels are SpaceWireRTransmitPriority::Normal by default.
+	 */
+	void setChannelPriority(uint16_t channel, uint32_t priority) {
+		transmitScheduler.setPriority(channel, priority);
+	}
+
+public:
+	uint32_t getChannelPriority(uint16_t channel) {
+		return transmitScheduler.getPriority(channel);
+	}
+
+public:
+	/** Sets the transmit weight of a channel among channels of the same priority class (default 1).
+	 */
+	void setChannelWeight(uint16_t channel, uint32_t weight) {
+		transmitScheduler.setWeight(channel, weight);
+	}
+
+public:
+	uint32_t getChannelWeight(uint16_t channel) {
+		return transmitScheduler.getWeight(channel);
+	}
+
+public:
+	/** Returns transmit statistics (bytes/sec, queueing delay) of a channel.
+	 */
+	SpaceWireRChannelTransmitStatistics getChannelTransmitStatistics(uint16_t channel) {
+		return transmitScheduler.getStatistics(channel);
+	}
+
+public:
+	void resetChannelTransmitStatistics(uint16_t channel) {
+		transmitScheduler.resetStatistics(channel);
 	}
 
 public:
 	void registerReceiveTEP(SpaceWireRTEPInterface* instance) {
-		receiveTEPs[instance->channel]=instance;
-		allTEPs[instance->channel]=instance;
+		channelTable[instance->channel].receiveTEP.store(instance, std::memory_order_release);
+		channelTable[instance->channel].anyTEP.store(instance, std::memory_order_release);
 		using namespace std;
-#ifdef DebugSpaceWireREngine
-		cout << "SpaceWireREngine::registerReceiveTEP() channel=" << (uint32_t) instance->channel
-				<< " receiveTEPPacketListMap.size()=" << instance->receivedPackets.size() << endl;
-#endif
+		SpaceWireRTraceDebug(SpaceWireRTraceCategory::Engine,
+				"SpaceWireREngine::registerReceiveTEP() channel={} receiveTEPPacketListMap.size()={}",
+				instance->channel, instance->receivedPackets.size());
 	}
 
 public:
 	void unregisterReceiveTEP(uint16_t channel) {
-		if (receiveTEPs.find(channel) != receiveTEPs.end()) {
-			receiveTEPs.erase(receiveTEPs.find(channel));
-		}
-		if (allTEPs.find(channel) != allTEPs.end()) {
-			allTEPs.erase(allTEPs.find(channel));
-		}
+		channelTable[channel].receiveTEP.store(NULL, std::memory_order_release);
+		channelTable[channel].anyTEP.store(NULL, std::memory_order_release);
 	}
 
 public:
 	void registerTransmitTEP(SpaceWireRTEPInterface* instance) {
-		transmitTEPs[instance->channel] = instance;
-		allTEPs[instance->channel]=instance;
-#ifdef DebugSpaceWireREngine
-		using namespace std;
-		cout << "SpaceWireREngine::registerTransmitTEP() channel=" << (uint32_t) instance->channel
-				<< " transmitTEPPacketListMap.size()=" << instance->receivedPackets.size() << endl;
-#endif
+		channelTable[instance->channel].transmitTEP.store(instance, std::memory_order_release);
+		channelTable[instance->channel].anyTEP.store(instance, std::memory_order_release);
+		SpaceWireRTraceDebug(SpaceWireRTraceCategory::Engine,
+				"SpaceWireREngine::registerTransmitTEP() channel={} transmitTEPPacketListMap.size()={}",
+				instance->channel, instance->receivedPackets.size());
 	}
 
 public:
 	void unregisterTransmitTEP(uint16_t channel) {
-		if (transmitTEPs.find(channel) != transmitTEPs.end()) {
-			transmitTEPs.erase(transmitTEPs.find(channel));
-		}
-		if (allTEPs.find(channel) != allTEPs.end()) {
-			allTEPs.erase(allTEPs.find(channel));
-		}
+		channelTable[channel].transmitTEP.store(NULL, std::memory_order_release);
+		channelTable[channel].anyTEP.store(NULL, std::memory_order_release);
 	}
 
 public:
 	void tellDisconnectionToAllTEPs() {
-		std::map<uint16_t, SpaceWireRTEPInterface*>::iterator it1=receiveTEPs.begin();
-		while(it1!=receiveTEPs.end()){
-			it1->second->closeDueToSpaceWireIFFailure();
-		}
-		std::map<uint16_t, SpaceWireRTEPInterface*>::iterator it=transmitTEPs.begin();
-		while(it!=transmitTEPs.end()){
-			it->second->closeDueToSpaceWireIFFailure();
+		for (size_t channel = 0; channel < NumberOfChannels; channel++) {
+			SpaceWireRTEPInterface* receiveTEP = channelTable[channel].receiveTEP.load(std::memory_order_acquire);
+			if (receiveTEP != NULL) {
+				receiveTEP->closeDueToSpaceWireIFFailure();
+			}
+			SpaceWireRTEPInterface* transmitTEP = channelTable[channel].transmitTEP.load(std::memory_order_acquire);
+			if (transmitTEP != NULL) {
+				transmitTEP->closeDueToSpaceWireIFFailure();
+			}
 		}
 	}
 
+public:
+	/** Selects whether the receive thread blocks or drops packets when the receive queue of
+	 * the destination TEP is full. Blocking is the default.
+	 */
+	void setReceivedPacketQueueFullPolicy(ReceivedPacketQueueFullPolicy policy) {
+		this->receivedPacketQueueFullPolicy = policy;
+	}
+
+public:
+	ReceivedPacketQueueFullPolicy getReceivedPacketQueueFullPolicy() const {
+		return receivedPacketQueueFullPolicy;
+	}
+
 public:
 	void run() {
 		using namespace std;
@@ -321,30 +385,26 @@ public:
 		_SpaceWireREngine_run_loop: //
 		while (!stopped) {
 			try {
-#ifdef DebugSpaceWireREngine
-				cout << "SpaceWireREngine::run() Waiting for a packet to be received." << endl;
-#endif
+				SpaceWireRTraceDebug(SpaceWireRTraceCategory::Engine,
+						"SpaceWireREngine::run() Waiting for a packet to be received.");
 				data = spwif->receive();
-#ifdef DebugSpaceWireREngine
-				cout << "SpaceWireREngine::run() A packet was received." << endl;
-#endif
+				SpaceWireRTraceDebug(SpaceWireRTraceCategory::Engine, "SpaceWireREngine::run() A packet was received.");
 #ifdef SpaceWireREngineDumpPacket
 			SpaceWireUtilities::dumpPacket(data);
 #endif
 				nReceivedPackets++;
 				packet = new SpaceWireRPacket;
 				packet->interpretPacket(data);
-#ifdef DebugSpaceWireREngine
-				cout << "SpaceWireREngine::run() Packet was successfully interpreted. ChannelID="
-						<< (uint32_t) packet->getChannelNumber() << endl;
-#endif
+				SpaceWireRTraceDebug(SpaceWireRTraceCategory::Engine,
+						"SpaceWireREngine::run() Packet was successfully interpreted. ChannelID={}",
+						packet->getChannelNumber());
 				processReceivedSpaceWireRPacket(packet);
 				delete data;
 			} catch (SpaceWireIFException& e) {
 				//todo
-#ifdef DebugSpaceWireREngine
-				cerr << "SpaceWireREngine::run() got SpaceWireIF " << e.toString() << endl;
-#endif
+				SpaceWireRTraceInfo(SpaceWireRTraceCategory::Engine,
+						"SpaceWireREngine::run() got SpaceWireIFException status={}",
+						e.getStatus());
 				if(e.getStatus()==SpaceWireIFException::Timeout){
 					goto _SpaceWireREngine_run_loop;
 				}else
@@ -370,9 +430,7 @@ public:
 			}
 
 		}
-#ifdef DebugSpaceWireREngine
-		cerr << "SpaceWireREngine::run() Stops." << endl;
-#endif
+		SpaceWireRTraceDebug(SpaceWireRTraceCategory::Engine, "SpaceWireREngine::run() Stops.");
 		stopped = true;
 		//todo
 		//invokeRegisteredStopActions();
@@ -401,6 +459,13 @@ public:
 		return nDiscardedReceivedPackets;
 	}
 
+public:
+	/** Returns the number of packets dropped because the receive queue of the destination TEP was full.
+	 */
+	size_t getNDroppedReceivedPackets() {
+		return nDroppedReceivedPackets;
+	}
+
 public:
 	size_t getNSentPackets() {
 		return nSentPackets;
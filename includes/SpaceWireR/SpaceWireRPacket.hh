@@ -39,6 +39,7 @@
 #include "SpaceWirePacket.hh"
 #include "SpaceWireUtilities.hh"
 #include "SpaceWireR/SpaceWireRUtilities.hh"
+#include <sys/uio.h>
 
 #undef debugSpaceWireRPacket
 
@@ -216,6 +217,16 @@ private:
 	std::vector<uint8_t> payload;
 	uint16_t crc16;
 
+private:
+	/// payload which is referenced from user memory (see setPayloadReference())
+	uint8_t* payloadReference;
+	size_t payloadReferenceLength;
+
+private:
+	/// buffers used by encodeToIOVectors()
+	std::vector<uint8_t> encodedHeader;
+	uint8_t encodedTrailer[2];
+
 private:
 	double sentoutTimeStamp;
 
@@ -223,6 +234,10 @@ public:
 	const static size_t MaxPayloadLength = 65535;
 	const static size_t MinimumHeaderLength = 10;
 
+public:
+	/// maximum number of iovec entries filled by encodeToIOVectors()
+	const static size_t NumberOfIOVectors = 3;
+
 public:
 	SpaceWireRPacket() :
 			SpaceWirePacket() {
@@ -231,6 +246,8 @@ public:
 		unuseSecondaryHeader();
 		prefixLength = 0;
 		sourceLogicalAddress = SpaceWirePacket::DefaultLogicalAddress;
+		payloadReference = NULL;
+		payloadReferenceLength = 0;
 	}
 
 public:
@@ -329,27 +346,21 @@ public:
 	std::vector<uint8_t>* getPacketBufferPointer() {
 		std::vector<uint8_t>* buffer = new std::vector<uint8_t>();
 		constructHeader();
+		uint8_t* payloadAddress = getPayloadAddress();
+		size_t payloadSize = getPayloadSize();
+		buffer->reserve(destinationSpaceWireAddress.size() + header.size() + payloadSize + 2);
 
 		//Target SpaceWire Address
-		size_t destinationSpaceWireAddressSize = destinationSpaceWireAddress.size();
-		for (size_t i = 0; i < destinationSpaceWireAddressSize; i++) {
-			buffer->push_back(destinationSpaceWireAddress[i]);
-		}
+		buffer->insert(buffer->end(), destinationSpaceWireAddress.begin(), destinationSpaceWireAddress.end());
 
 		//Header
-		size_t headerSize = header.size();
-		for (size_t i = 0; i < headerSize; i++) {
-			buffer->push_back(header[i]);
-		}
+		buffer->insert(buffer->end(), header.begin(), header.end());
 
 		//Payload
-		size_t payloadSize = payload.size();
-		for (size_t i = 0; i < payloadSize; i++) {
-			buffer->push_back(payload[i]);
-		}
+		buffer->insert(buffer->end(), payloadAddress, payloadAddress + payloadSize);
 
 		//Calculate CRC
-		crc16 = SpaceWireRUtilities::calculateCRCForHeaderAndData(header, payload);
+		crc16 = calculateCRCForHeaderAndPayload();
 
 		//Trailer
 		buffer->push_back(crc16 / 0x100);
@@ -365,7 +376,7 @@ public:
 		//Check buffer length
 		size_t destinationSpaceWireAddressSize = destinationSpaceWireAddress.size();
 		size_t headerSize = header.size();
-		size_t payloadSize = payload.size();
+		size_t payloadSize = getPayloadSize();
 		const size_t crcSize = 2;
 		if (destinationSpaceWireAddressSize + headerSize + payloadSize + crcSize > maxLength) {
 			return 0;
@@ -386,9 +397,9 @@ public:
 		}
 
 		//Payload
-		for (size_t i = 0; i < payloadSize; i++) {
-			buffer[index] = payload[i];
-			index++;
+		if (payloadSize != 0) {
+			memcpy(buffer + index, getPayloadAddress(), payloadSize);
+			index += payloadSize;
 		}
 
 		//Calculate CRC
@@ -403,6 +414,58 @@ public:
 		return index;
 	}
 
+public:
+	/** Encodes this packet into a list of memory regions without copying the payload.
+	 * iovecs[0] points to an internal buffer which holds the destination SpaceWire address
+	 * and the header, iovecs[1] points to the payload (the user memory itself when the
+	 * payload was set via setPayloadReference()), and the last entry points to the CRC trailer.
+	 * The payload entry is omitted when the payload is empty.
+	 * The regions remain valid until this instance is modified.
+	 * @param[out] iovecs an array which has at least NumberOfIOVectors entries
+	 * @return number of iovec entries filled
+	 */
+	size_t encodeToIOVectors(struct iovec* iovecs) {
+		constructHeader();
+
+		//Target SpaceWire Address and Header
+		encodedHeader.clear();
+		encodedHeader.insert(encodedHeader.end(), destinationSpaceWireAddress.begin(),
+				destinationSpaceWireAddress.end());
+		encodedHeader.insert(encodedHeader.end(), header.begin(), header.end());
+
+		//Trailer
+		crc16 = calculateCRCForHeaderAndPayload();
+		encodedTrailer[0] = crc16 / 0x100;
+		encodedTrailer[1] = crc16 % 0x100;
+
+		size_t nIOVecs = 0;
+		iovecs[nIOVecs].iov_base = &(encodedHeader[0]);
+		iovecs[nIOVecs].iov_len = encodedHeader.size();
+		nIOVecs++;
+		size_t payloadSize = getPayloadSize();
+		if (payloadSize != 0) {
+			iovecs[nIOVecs].iov_base = getPayloadAddress();
+			iovecs[nIOVecs].iov_len = payloadSize;
+			nIOVecs++;
+		}
+		iovecs[nIOVecs].iov_base = encodedTrailer;
+		iovecs[nIOVecs].iov_len = 2;
+		nIOVecs++;
+		return nIOVecs;
+	}
+
+private:
+	/** Calculates CRC over the header (constructed by constructHeader()) and the payload.
+	 */
+	uint16_t calculateCRCForHeaderAndPayload() {
+		uint16_t crc = SpaceWireRUtilities::CRC_INIT_VAL;
+		if (header.size() != 0) {
+			crc = SpaceWireRUtilities::updateCRCForArray(crc, &(header[0]), header.size());
+		}
+		crc = SpaceWireRUtilities::updateCRCForArray(crc, getPayloadAddress(), getPayloadSize());
+		return crc;
+	}
+
 public:
 	bool isAckPacket() {
 		if (this->packetType == SpaceWireRPacketType::DataAckPacket
@@ -485,6 +548,8 @@ public:
 public:
 	inline void clearPayload() {
 		payload.clear();
+		payloadReference = NULL;
+		payloadReferenceLength = 0;
 		this->setPayloadLength(0);
 	}
 
@@ -648,13 +713,15 @@ public:
 			//Payload
 			try {
 				size_t payloadLengthValue = payloadLength[0] * 0x100 + payloadLength[1];
-				payload.clear();
+				payloadReference = NULL;
+				payloadReferenceLength = 0;
 #ifdef debugSpaceWireRPacket
 				cout << "SpaceWireRPacket::interpretPacket() #9 payloadLength=" << dec << payloadLengthValue << endl;
 #endif
-				for (size_t i = 0; i < payloadLengthValue; i++) {
-					payload.push_back(buffer->at(index));
+				if (buffer->size() < index + payloadLengthValue) {
+					throw SpaceWireRPacketException(SpaceWireRPacketException::InvalidPayloadLength);
 				}
+				payload.assign(buffer->begin() + index, buffer->begin() + index + payloadLengthValue);
 				index += payloadLengthValue;
 			} catch (...) {
 				throw SpaceWireRPacketException(SpaceWireRPacketException::InvalidPayloadLength);
@@ -722,10 +789,40 @@ public:
 		return this->packetType;
 	}
 
+	/** Returns the payload as a vector.
+	 * If the payload is referenced from user memory (see setPayloadReference()),
+	 * it is copied to the internal buffer first.
+	 */
 	inline std::vector<uint8_t>* getPayload() {
+		if (payloadReference != NULL) {
+			payload.assign(payloadReference, payloadReference + payloadReferenceLength);
+			payloadReference = NULL;
+			payloadReferenceLength = 0;
+		}
 		return &payload;
 	}
 
+	/** Returns a pointer to the payload without copying it.
+	 * NULL is returned if the payload is empty.
+	 */
+	inline uint8_t* getPayloadAddress() {
+		if (payloadReference != NULL) {
+			return payloadReference;
+		} else if (payload.size() != 0) {
+			return &(payload[0]);
+		} else {
+			return NULL;
+		}
+	}
+
+	inline size_t getPayloadSize() const {
+		return (payloadReference != NULL) ? payloadReferenceLength : payload.size();
+	}
+
+	inline bool isPayloadReferenced() const {
+		return (payloadReference != NULL) ? true : false;
+	}
+
 	inline uint16_t getPayloadLength() const {
 		return payloadLength[0] * 0x100 + payloadLength[1];
 	}
@@ -772,6 +869,8 @@ public:
 			throw SpaceWireRPacketException::InvalidPayloadLength;
 		}
 		this->payload = payload;
+		payloadReference = NULL;
+		payloadReferenceLength = 0;
 		setPayloadLength(payload.size());
 	}
 
@@ -779,10 +878,9 @@ public:
 		if (length > SpaceWireRPacket::MaxPayloadLength) {
 			throw SpaceWireRPacketException::InvalidPayloadLength;
 		}
-		this->payload.clear();
-		for (size_t i = 0; i < length; i++) {
-			this->payload.push_back(payload[i]);
-		}
+		this->payload.assign(payload, payload + length);
+		payloadReference = NULL;
+		payloadReferenceLength = 0;
 		setPayloadLength(length);
 	}
 
@@ -790,10 +888,32 @@ public:
 		if (length > SpaceWireRPacket::MaxPayloadLength) {
 			throw SpaceWireRPacketException::InvalidPayloadLength;
 		}
+		if (payload->size() < index + length) {
+			throw SpaceWireRPacketException(SpaceWireRPacketException::InvalidPayloadLength);
+		}
+		this->payload.assign(payload->begin() + index, payload->begin() + index + length);
+		payloadReference = NULL;
+		payloadReferenceLength = 0;
+		setPayloadLength(length);
+	}
+
+	/** Sets payload by referencing user memory instead of copying it.
+	 * The referenced memory is transmitted directly by encodeToIOVectors(), and therefore
+	 * it should be kept valid (and unmodified) until this packet is acknowledged.
+	 * @param[in] payload pointer to the first byte of the payload
+	 * @param[in] length length of the payload
+	 */
+	inline void setPayloadReference(uint8_t* payload, size_t length) throw (SpaceWireRPacketException) {
+		if (length > SpaceWireRPacket::MaxPayloadLength) {
+			throw SpaceWireRPacketException(SpaceWireRPacketException::InvalidPayloadLength);
+		}
 		this->payload.clear();
-		size_t loopEnd = length + index;
-		for (size_t i = index; i < loopEnd; i++) {
-			this->payload.push_back(payload->at(i));
+		if (length == 0) {
+			payloadReference = NULL;
+			payloadReferenceLength = 0;
+		} else {
+			payloadReference = payload;
+			payloadReferenceLength = length;
 		}
 		setPayloadLength(length);
 	}
@@ -38,6 +38,24 @@ class SpaceWireRProtocol {
 public:
 	static uint8_t ProtocolID;
 	static const size_t SizeOfSlidingWindow = 256;
+
+public:
+	/** The largest sliding window size which can be negotiated.
+	 * Sequence numbers are 8 bit, and a ReceiveTEP distinguishes retransmitted segments
+	 * (backward window) from new segments (forward window), so the window must not exceed
+	 * half of the sequence number space.
+	 */
+	static const size_t MaximumSlidingWindowSize = SizeOfSlidingWindow / 2;
+
+public:
+	/** The largest segment size (limited by the 16-bit Payload Length field). */
+	static const size_t MaximumSegmentSize = 65535;
+
+public:
+	/** Open command/Open Ack parameters: sliding window size (1 octet) followed by
+	 * maximum segment size (2 octets, big endian).
+	 */
+	static const size_t SizeOfOpenParameters = 3;
 };
 
 uint8_t SpaceWireRProtocol::ProtocolID=0x52;
@@ -42,12 +42,6 @@
 
 #include "SpaceWireR/SpaceWireRTEP.hh"
 
-//#define DebugSpaceWireRReceiveTEP
-//#define DebugSpaceWireRReceiveTEPDumpCriticalIncidents
-
-#undef DebugSpaceWireRReceiveTEP
-#undef DebugSpaceWireRReceiveTEPDumpCriticalIncidents
-
 class SpaceWireRReceiveTEP: public SpaceWireRTEP, public CxxUtilities::StoppableThread {
 
 private:
@@ -59,9 +53,14 @@ public:
 		registerMeToSpaceWireREngine();
 		initializeCounters();
 		isReceivingSegmentedApplicationData = false;
+		isConsumingReceivedPacketes = false;
 		ackPacket = new SpaceWireRPacket();
 		hasReceivedDataPacket = false;
 		randomMT = new CxxUtilities::RandomMT();
+		maximumReceiveSlidingWindowSize = SpaceWireRProtocol::MaximumSlidingWindowSize;
+		maximumSegmentSize = SpaceWireRProtocol::MaximumSegmentSize;
+		negotiatedSegmentSize = DefaultMaximumSegmentSize;
+		hasReceivedOpenParameters = false;
 		this->start();
 		initializeReceiveSlidingWindow();
 	}
@@ -91,6 +90,7 @@ private:
 	std::vector<uint8_t>* currentApplicationData;
 	bool isReceivingSegmentedApplicationData;
 	std::list<std::vector<uint8_t>*> receivedApplicationData;
+	CxxUtilities::Mutex mutexForReceivedApplicationData;
 	CxxUtilities::Condition receiveWaitCondition; //used for receive of application data
 
 public:
@@ -131,6 +131,48 @@ private:
 	uint8_t receiveSlidingWindowFrom;
 	uint8_t receiveSlidingWindowSize;
 
+private:
+	//upper limit of the receive sliding window size accepted in the Open command
+	size_t maximumReceiveSlidingWindowSize;
+	//segment size accepted in the Open command (maximumSegmentSize is the upper limit)
+	size_t negotiatedSegmentSize;
+	bool hasReceivedOpenParameters;
+
+public:
+	/** Sets the largest sliding window size which this ReceiveTEP accepts in the Open command.
+	 * A TransmitTEP which proposes a larger window uses this size instead.
+	 * @param[in] size 1 to SpaceWireRProtocol::MaximumSlidingWindowSize
+	 */
+	void setMaximumReceiveSlidingWindowSize(size_t size) throw (SpaceWireRTEPException) {
+		if (size == 0 || SpaceWireRProtocol::MaximumSlidingWindowSize < size) {
+			throw SpaceWireRTEPException(SpaceWireRTEPException::InvalidParameter);
+		}
+		this->maximumReceiveSlidingWindowSize = size;
+	}
+
+public:
+	/** Sets the largest segment size which this ReceiveTEP accepts in the Open command.
+	 * @param[in] size 1 to SpaceWireRProtocol::MaximumSegmentSize
+	 */
+	void setMaximumSegmentSize(size_t size) throw (SpaceWireRTEPException) {
+		if (size == 0 || SpaceWireRProtocol::MaximumSegmentSize < size) {
+			throw SpaceWireRTEPException(SpaceWireRTEPException::InvalidParameter);
+		}
+		this->maximumSegmentSize = size;
+	}
+
+public:
+	/** Returns the receive sliding window size (negotiated in the Open command). */
+	size_t getReceiveSlidingWindowSize() const {
+		return receiveSlidingWindowSize;
+	}
+
+public:
+	/** Returns the segment size negotiated in the Open command. */
+	size_t getNegotiatedSegmentSize() const {
+		return negotiatedSegmentSize;
+	}
+
 private:
 	void initializeReceiveSlidingWindow() {
 		receiveSlidingWindowBuffer.clear();
@@ -151,22 +193,37 @@ private:
 
 private:
 	std::vector<uint8_t>* popApplicationData() {
-		std::vector<uint8_t>* result = *(receivedApplicationData.begin());
-		receivedApplicationData.pop_front();
+		std::vector<uint8_t>* result = NULL;
+		mutexForReceivedApplicationData.lock();
+		if (receivedApplicationData.size() != 0) {
+			result = receivedApplicationData.front();
+			receivedApplicationData.pop_front();
+		}
+		mutexForReceivedApplicationData.unlock();
 		return result;
 	}
 
+private:
+	void pushApplicationData(std::vector<uint8_t>* applicationData) {
+		mutexForReceivedApplicationData.lock();
+		receivedApplicationData.push_back(applicationData);
+		mutexForReceivedApplicationData.unlock();
+		receiveWaitCondition.signal();
+	}
+
 public:
 	std::vector<uint8_t>* receive(double timeoutDuration = WaitDurationInMsForReceive) throw (SpaceWireRTEPException) {
 		if (state != SpaceWireRTEPState::Open) {
 			throw SpaceWireRTEPException(SpaceWireRTEPException::NotInTheOpenState);
 		}
-		if (receivedApplicationData.size() != 0) {
-			return popApplicationData();
+		std::vector<uint8_t>* result = popApplicationData();
+		if (result != NULL) {
+			return result;
 		}
 		receiveWaitCondition.wait(timeoutDuration);
-		if (receivedApplicationData.size() != 0) {
-			return popApplicationData();
+		result = popApplicationData();
+		if (result != NULL) {
+			return result;
 		} else {
 			throw SpaceWireRTEPException(SpaceWireRTEPException::Timeout);
 		}
@@ -255,13 +312,10 @@ private:
 		}
 
 		if (randomMT->generateRandomDoubleFrom0To1() < ProbabilityOfErrorInjectionNoReply) {
-#ifdef DebugSpaceWireRReceiveTEPDumpCriticalIncidents
-			std::stringstream ss;
-			ss << "SpaceWireRReceiveTEP::errorInjectionNoReply() for sequence number = " << dec << right
-					<< (uint32_t) sequenceNumber << " !!!" << endl;
-			CxxUtilities::TerminalControl::displayInRed(ss.str());
+			SpaceWireRTraceWarning(SpaceWireRTraceCategory::ReceiveTEP,
+					"SpaceWireRReceiveTEP::errorInjectionNoReply() for sequence number = {} !!!",
+					sequenceNumber);
 			nErrorInjectionNoReply++;
-#endif
 			//inject error
 			return true;
 		} else {
@@ -286,11 +340,13 @@ private:
 			}else{
 				ackPacket->constructAckForPacketWithFlowControl(packet, this->getMaximumAcceptableSequenceNumber());
 			}
+			if (packet->isControlPacketOpenCommand() && hasReceivedOpenParameters) {
+				appendOpenParametersToAckPacket();
+			}
 			try {
-#ifdef DebugSpaceWireRReceiveTEP
-				cout << "SpaceWireRReceiveTEP::replyAckForPacket() replying ack for sequence number = "
-						<< (uint32_t) ackPacket->getSequenceNumber() << endl;
-#endif
+				SpaceWireRTraceDebug(SpaceWireRTraceCategory::ReceiveTEP,
+						"SpaceWireRReceiveTEP::replyAckForPacket() replying ack for sequence number = {}",
+						ackPacket->getSequenceNumber());
 
 				//todo: inject CRC error
 
@@ -299,16 +355,26 @@ private:
 				//store sequence number of the latest Ack
 				setSequenceNumberOfLastAck(ackPacket->getSequenceNumber());
 
-#ifdef DebugSpaceWireRReceiveTEP
-				cout << "SpaceWireRReceiveTEP::replyAckForPacket() ack for sequence number = "
-						<< (uint32_t) ackPacket->getSequenceNumber() << " has been sent." << endl;
-#endif
+				SpaceWireRTraceDebug(SpaceWireRTraceCategory::ReceiveTEP,
+						"SpaceWireRReceiveTEP::replyAckForPacket() ack for sequence number = {} has been sent.",
+						ackPacket->getSequenceNumber());
 			} catch (...) {
 				malfunctioningSpaceWireIF();
 			}
 		}
 	}
 
+private:
+	/** Appends accepted Open parameters to the Open Ack packet (after MASN if flow control is enabled).
+	 */
+	void appendOpenParametersToAckPacket() {
+		uint8_t parameters[SpaceWireRProtocol::SizeOfOpenParameters];
+		encodeOpenParameters(receiveSlidingWindowSize, negotiatedSegmentSize, parameters);
+		std::vector<uint8_t> payload(*ackPacket->getPayload());
+		payload.insert(payload.end(), parameters, parameters + SpaceWireRProtocol::SizeOfOpenParameters);
+		ackPacket->setPayload(payload);
+	}
+
 private:
 	bool insideForwardReceiveSlidingWindow(uint8_t sequenceNumber) {
 		uint8_t n = this->receiveSlidingWindowFrom;
@@ -379,48 +445,41 @@ private:
 		mutexForConsumeReceivedPacketes.unlock();
 
 		using namespace std;
-#ifdef DebugSpaceWireRReceiveTEP
-		cout << "SpaceWireRReceiveTEP::consumeReceivedPackets()" << endl;
-#endif
+		SpaceWireRTraceDebug(SpaceWireRTraceCategory::ReceiveTEP, "SpaceWireRReceiveTEP::consumeReceivedPackets()");
 
 		size_t loopSize = receivedPackets.size();
 
 		for (size_t i = 0; i < loopSize; i++) {
-#ifdef DebugSpaceWireRReceiveTEP
-			cout << "SpaceWireRReceiveTEP::consumeReceivedPackets() consuming one packet." << endl;
-#endif
+			SpaceWireRTraceDebug(SpaceWireRTraceCategory::ReceiveTEP,
+					"SpaceWireRReceiveTEP::consumeReceivedPackets() consuming one packet.");
 			SpaceWireRPacket* packet = this->popReceivedSpaceWireRPacket();
 
 			if (packet->isDataPacket()) {
-#ifdef DebugSpaceWireRReceiveTEP
-				cout << "SpaceWireRReceiveTEP::consumeReceivedPackets() processing Data Packet." << endl;
-#endif
+				SpaceWireRTraceDebug(SpaceWireRTraceCategory::ReceiveTEP,
+						"SpaceWireRReceiveTEP::consumeReceivedPackets() processing Data Packet.");
 				processDataPacket(packet);
 				continue;
 			}
 
 			if (packet->isControlPacketOpenCommand()) {
-#ifdef DebugSpaceWireRReceiveTEP
-				cout << "SpaceWireRReceiveTEP::consumeReceivedPackets() processing Open command." << endl;
-#endif
+				SpaceWireRTraceDebug(SpaceWireRTraceCategory::ReceiveTEP,
+						"SpaceWireRReceiveTEP::consumeReceivedPackets() processing Open command.");
 				if (this->hasReceivedDataPacket == false && this->state == SpaceWireRTEPState::Enabled) {
 					processOpenComand(packet);
 				} else {
 					//Open packet was already received, and one or more Data packet have been received.
 					//Therefore this Open packet is invalid.
 					//Moves to the Closing state.
-#ifdef DebugSpaceWireRReceiveTEP
-					cout << "SpaceWireRReceiveTEP::consumeReceivedPackets() invalid Open command." << endl;
-#endif
+					SpaceWireRTraceDebug(SpaceWireRTraceCategory::ReceiveTEP,
+							"SpaceWireRReceiveTEP::consumeReceivedPackets() invalid Open command.");
 					malfunctioningTransportChannel();
 				}
 				continue;
 			}
 
 			if (packet->isControlPacketCloseCommand()) {
-#ifdef DebugSpaceWireRReceiveTEP
-				cout << "SpaceWireRReceiveTEP::consumeReceivedPackets() processing Close command." << endl;
-#endif
+				SpaceWireRTraceDebug(SpaceWireRTraceCategory::ReceiveTEP,
+						"SpaceWireRReceiveTEP::consumeReceivedPackets() processing Close command.");
 				this->state = SpaceWireRTEPState::Closing;
 				replyAckForPacket(packet);
 				delete packet;
@@ -428,32 +487,26 @@ private:
 			}
 
 			if (packet->isHeartBeatPacketType()) {
-#ifdef DebugSpaceWireRReceiveTEP
-				cout << "SpaceWireRReceiveTEP::consumeReceivedPackets() processing HeartBeat packet." << endl;
-#endif
+				SpaceWireRTraceDebug(SpaceWireRTraceCategory::ReceiveTEP,
+						"SpaceWireRReceiveTEP::consumeReceivedPackets() processing HeartBeat packet.");
 				processHeartBeatPacket(packet);
 				continue;
 			}
 
 			if (packet->isAckPacket()) {
-#ifdef DebugSpaceWireRReceiveTEP
-				cout << "SpaceWireRReceiveTEP::consumeReceivedPackets() processing Ack packet." << endl;
-#endif
+				SpaceWireRTraceDebug(SpaceWireRTraceCategory::ReceiveTEP,
+						"SpaceWireRReceiveTEP::consumeReceivedPackets() processing Ack packet.");
 				processAckPacket(packet);
 				delete packet;
 				continue;
 			}
 
 			//should not reach here
-#ifdef DebugSpaceWireRReceiveTEP
-			cout
-					<< "SpaceWireRReceiveTEP::consumeReceivedPackets() Received packet cannot be handled by the SpaceWireRReceiveTEP."
-					<< endl;
-#endif
+			SpaceWireRTraceDebug(SpaceWireRTraceCategory::ReceiveTEP,
+					"SpaceWireRReceiveTEP::consumeReceivedPackets() Received packet cannot be handled by the SpaceWireRReceiveTEP.");
 		}
-#ifdef DebugSpaceWireRReceiveTEP
-		cout << "SpaceWireRReceiveTEP::consumeReceivedPackets() completed." << endl;
-#endif
+		SpaceWireRTraceDebug(SpaceWireRTraceCategory::ReceiveTEP,
+				"SpaceWireRReceiveTEP::consumeReceivedPackets() completed.");
 
 		mutexForConsumeReceivedPacketes.lock();
 		isConsumingReceivedPacketes = false;
@@ -466,10 +519,9 @@ private:
 	 */
 	void processAckPacket(SpaceWireRPacket* packet) {
 		using namespace std;
-#ifdef DebugSpaceWireRTransmitTEP
-		cout << "SpaceWireRReceiveTEP::processAckPacket() sequence number = " << (uint32_t) packet->getSequenceNumber()
-		<< endl;
-#endif
+		SpaceWireRTraceDebug(SpaceWireRTraceCategory::ReceiveTEP,
+				"SpaceWireRReceiveTEP::processAckPacket() sequence number = {}",
+				packet->getSequenceNumber());
 		uint8_t sequenceNumberOfThisPacket = packet->getSequenceNumber();
 		if (packetHasBeenSent[sequenceNumberOfThisPacket] == true) {
 			packetWasAcknowledged[sequenceNumberOfThisPacket] = true;
@@ -484,33 +536,41 @@ private:
 private:
 	void processOpenComand(SpaceWireRPacket* packet) {
 		using namespace std;
-#ifdef DebugSpaceWireRReceiveTEP
-		cout << "SpaceWireRReceiveTEP::processOpenCommand() sequenceNumber=" << packet->getSequenceNumberAs32bitInteger()
-				<< endl;
-#endif
+		SpaceWireRTraceDebug(SpaceWireRTraceCategory::ReceiveTEP,
+				"SpaceWireRReceiveTEP::processOpenCommand() sequenceNumber={}",
+				packet->getSequenceNumberAs32bitInteger());
+		//negotiate sliding window size and segment size
+		//(a TransmitTEP without Open parameters uses the default sizes)
+		size_t windowSize = DefaultSlidingWindowSize;
+		size_t segmentSize = DefaultMaximumSegmentSize;
+		hasReceivedOpenParameters = decodeOpenParameters(packet->getPayloadAddress(), packet->getPayloadSize(),
+				windowSize, segmentSize);
+		this->receiveSlidingWindowSize = std::min(windowSize, maximumReceiveSlidingWindowSize);
+		this->negotiatedSegmentSize = std::min(segmentSize, maximumSegmentSize);
+		SpaceWireRTraceInfo(SpaceWireRTraceCategory::ReceiveTEP,
+				"SpaceWireRReceiveTEP::processOpenCommand() receiveSlidingWindowSize={} segmentSize={}",
+				this->receiveSlidingWindowSize, this->negotiatedSegmentSize);
 		this->state = SpaceWireRTEPState::Open;
 		replyAckForPacket(packet);
 		this->receiveSlidingWindowBuffer[packet->getSequenceNumber()] = packet;
 		slideReceiveSlidingWindow();
-#ifdef DebugSpaceWireRReceiveTEP
-		cout << "SpaceWireRReceiveTEP::processOpenCommand() completed sequenceNumber="
-				<< packet->getSequenceNumberAs32bitInteger() << endl;
-#endif
+		SpaceWireRTraceDebug(SpaceWireRTraceCategory::ReceiveTEP,
+				"SpaceWireRReceiveTEP::processOpenCommand() completed sequenceNumber={}",
+				packet->getSequenceNumberAs32bitInteger());
 	}
 
 private:
 	void processDataPacket(SpaceWireRPacket* packet) {
 		using namespace std;
 		uint8_t sequenceNumber = packet->getSequenceNumber();
-#ifdef DebugSpaceWireRReceiveTEP
-		cout << "SpaceWireRReceiveTEP::processDataPacket() sequenceNumber=" << (uint32_t) sequenceNumber << endl;
-#endif
+		SpaceWireRTraceDebug(SpaceWireRTraceCategory::ReceiveTEP,
+				"SpaceWireRReceiveTEP::processDataPacket() sequenceNumber={}",
+				sequenceNumber);
 		nReceivedDataBytes += packet->getPayloadLength();
 		nReceivedSegments++;
 		if (insideForwardReceiveSlidingWindow(sequenceNumber)) {
-#ifdef DebugSpaceWireRReceiveTEP
-			cout << "SpaceWireRReceiveTEP::processDataPacket() insideForwardReceiveSlidingWindow" << endl;
-#endif
+			SpaceWireRTraceDebug(SpaceWireRTraceCategory::ReceiveTEP,
+					"SpaceWireRReceiveTEP::processDataPacket() insideForwardReceiveSlidingWindow");
 			if (this->receiveSlidingWindowBuffer[sequenceNumber] == NULL) {
 				replyAckForPacket(packet);
 				this->receiveSlidingWindowBuffer[sequenceNumber] = packet;
@@ -520,9 +580,8 @@ private:
 				delete packet;
 			}
 		} else if (insideBackwardReceiveSlidingWindow(sequenceNumber)) {
-#ifdef DebugSpaceWireRReceiveTEP
-			cout << "SpaceWireRReceiveTEP::processDataPacket() insideBackwardReceiveSlidingWindow" << endl;
-#endif
+			SpaceWireRTraceDebug(SpaceWireRTraceCategory::ReceiveTEP,
+					"SpaceWireRReceiveTEP::processDataPacket() insideBackwardReceiveSlidingWindow");
 			//debug
 			CxxUtilities::TerminalControl::displayInCyan(
 					"SpaceWireRReceiveTEP::processDataPacket() insideBackwardReceiveSlidingWindow");
@@ -557,24 +616,21 @@ private:
 private:
 	void slideReceiveSlidingWindow() {
 		using namespace std;
-#ifdef DebugSpaceWireRReceiveTEP
-		cout << "SpaceWireRReceiveTEP::slideReceiveSlidingWindow()" << endl;
-#endif
+		SpaceWireRTraceDebug(SpaceWireRTraceCategory::ReceiveTEP, "SpaceWireRReceiveTEP::slideReceiveSlidingWindow()");
 		uint8_t n = this->receiveSlidingWindowFrom;
 		while (this->receiveSlidingWindowBuffer[n] != NULL) {
-#ifdef DebugSpaceWireRReceiveTEP
-			cout << "SpaceWireRReceiveTEP::slideReceiveSlidingWindow() n=" << (uint32_t) n << endl;
-#endif
+			SpaceWireRTraceDebug(SpaceWireRTraceCategory::ReceiveTEP,
+					"SpaceWireRReceiveTEP::slideReceiveSlidingWindow() n={}",
+					n);
 			reconstructApplicationData(this->receiveSlidingWindowBuffer[n]);
 			delete this->receiveSlidingWindowBuffer[n];
 			this->receiveSlidingWindowBuffer[n] = NULL;
 			n = (uint8_t) (n + 1);
 		}
 		this->receiveSlidingWindowFrom = n;
-#ifdef DebugSpaceWireRReceiveTEP
-		cout << "SpaceWireRReceiveTEP::slideReceiveSlidingWindow() From=" << (uint32_t) this->receiveSlidingWindowFrom
-				<< endl;
-#endif
+		SpaceWireRTraceDebug(SpaceWireRTraceCategory::ReceiveTEP,
+				"SpaceWireRReceiveTEP::slideReceiveSlidingWindow() From={}",
+				this->receiveSlidingWindowFrom);
 	}
 
 private:
@@ -582,38 +638,28 @@ private:
 		using namespace std;
 
 		if (!packet->isDataPacket()) {
-#ifdef DebugSpaceWireRReceiveTEP
-			cout
-					<< "SpaceWireRReceiveTEP::reconstructApplicationData() received packet is not Data packet. Reconstruction is skipped."
-					<< endl;
-#endif
+			SpaceWireRTraceDebug(SpaceWireRTraceCategory::ReceiveTEP,
+					"SpaceWireRReceiveTEP::reconstructApplicationData() received packet is not Data packet. Reconstruction is skipped.");
 			return;
 		}
 
 		this->hasReceivedDataPacket = true;
-#ifdef DebugSpaceWireRReceiveTEP
-		cout << "SpaceWireRReceiveTEP::reconstructApplicationData() isReceivingSegmentedApplicationData=";
-		if (isReceivingSegmentedApplicationData) {
-			cout << "true" << endl;
-		} else {
-			cout << "false" << endl;
-		}
-#endif
+		SpaceWireRTraceDebug(SpaceWireRTraceCategory::ReceiveTEP,
+				"SpaceWireRReceiveTEP::reconstructApplicationData() isReceivingSegmentedApplicationData={}",
+				isReceivingSegmentedApplicationData);
 
 		if (isReceivingSegmentedApplicationData) {
 			//normal cases
 			if (packet->isContinuedSegment()) {
-#ifdef DebugSpaceWireRReceiveTEP
-				cout << "SpaceWireRReceiveTEP::reconstructApplicationData() received continuous segment. " << endl;
-#endif
+				SpaceWireRTraceDebug(SpaceWireRTraceCategory::ReceiveTEP,
+						"SpaceWireRReceiveTEP::reconstructApplicationData() received continuous segment.");
 				appendDataToCurrentApplicationDataInstance(packet);
 				nReceivedApplicationData++;
 				isReceivingSegmentedApplicationData = true;
 				return;
 			} else if (packet->isLastSegment()) {
-#ifdef DebugSpaceWireRReceiveTEP
-				cout << "SpaceWireRReceiveTEP::reconstructApplicationData() received the last segment. " << endl;
-#endif
+				SpaceWireRTraceDebug(SpaceWireRTraceCategory::ReceiveTEP,
+						"SpaceWireRReceiveTEP::reconstructApplicationData() received the last segment.");
 				appendDataToCurrentApplicationDataInstance(packet);
 				completeServiceDataUnitHasBeenReceived();
 				isReceivingSegmentedApplicationData = false;
@@ -621,35 +667,32 @@ private:
 			}
 			//error cases
 			if (packet->isCompleteSegment() || packet->isFirstSegment()) {
-#ifdef DebugSpaceWireRReceiveTEP
-				cout << "SpaceWireRReceiveTEP::reconstructApplicationData() received invalid segment: "
-						<< packet->getSequenceFlagsAsString() << endl;
-#endif
+				SpaceWireRTraceDebug(SpaceWireRTraceCategory::ReceiveTEP,
+						"SpaceWireRReceiveTEP::reconstructApplicationData() received invalid segment: {}",
+						packet->getSequenceFlags());
 				//something is wrong with segmented data
-#ifdef DebugSpaceWireRReceiveTEP
-				cout << "SpaceWireRReceiveTEP::reconstructApplicationData() something is wrong with segmented data: "
-						<< packet->toString() << endl;
-#endif
+				SpaceWireRTraceWarning(SpaceWireRTraceCategory::ReceiveTEP,
+						"SpaceWireRReceiveTEP::reconstructApplicationData() something is wrong with segmented data: sequence number={} flags={}",
+						packet->getSequenceNumber(), packet->getSequenceFlags());
 				malfunctioningTransportChannel();
 				return;
 			}
 		} else {
 			//normal case
 			if (packet->isCompleteSegment()) {
-#ifdef DebugSpaceWireRReceiveTEP
-				cout << "SpaceWireRReceiveTEP::reconstructApplicationData() received complete segment. " << endl;
-				cout << packet->toString() << endl;
-#endif
+				SpaceWireRTraceDebug(SpaceWireRTraceCategory::ReceiveTEP,
+						"SpaceWireRReceiveTEP::reconstructApplicationData() received complete segment. sequence number={}",
+						packet->getSequenceNumber());
 				completeServiceDataUnitHasBeenReceived(packet);
 				isReceivingSegmentedApplicationData = false;
 				return;
 			}
 			if (packet->isFirstSegment()) {
-#ifdef DebugSpaceWireRReceiveTEP
-				cout << "SpaceWireRReceiveTEP::reconstructApplicationData() received the first segment. " << endl;
-#endif
+				SpaceWireRTraceDebug(SpaceWireRTraceCategory::ReceiveTEP,
+						"SpaceWireRReceiveTEP::reconstructApplicationData() received the first segment.");
 				//start new segmented application data
 				currentApplicationData = new std::vector<uint8_t>;
+				currentApplicationData->reserve(estimateSizeOfSegmentedApplicationData(packet));
 				appendDataToCurrentApplicationDataInstance(packet);
 				isReceivingSegmentedApplicationData = true;
 				return;
@@ -657,37 +700,65 @@ private:
 			//error cases
 			if (packet->isContinuedSegment() || packet->isLastSegment()) {
 				//something is wrong with segmented data
-#ifdef DebugSpaceWireRReceiveTEP
-				cout << "SpaceWireRReceiveTEP::reconstructApplicationData() : " << packet->getSequenceFlagsAsString() << endl;
-				cout << "SpaceWireRReceiveTEP::reconstructApplicationData() something is wrong with segmented data: " << endl;
-				cout << packet->toString() << endl;
-#endif
+				SpaceWireRTraceWarning(SpaceWireRTraceCategory::ReceiveTEP,
+						"SpaceWireRReceiveTEP::reconstructApplicationData() something is wrong with segmented data: sequence number={} flags={}",
+						packet->getSequenceNumber(), packet->getSequenceFlags());
 				malfunctioningTransportChannel();
 				return;
 			}
 		}
 	}
 
+private:
+	/** Estimates the size of segmented application data which starts from the specified
+	 * First segment so that the reassembly buffer can be allocated at once.
+	 * Only segments which have already been received (the First segment and consecutive
+	 * segments stored in the receive sliding window) are counted, and therefore the exact
+	 * size is returned if the Last segment is among them. Segments received later are
+	 * appended with the usual geometric growth of std::vector.
+	 * @param[in] firstSegment the First segment of the application data
+	 * @return the total payload size of the received segments in bytes
+	 */
+	size_t estimateSizeOfSegmentedApplicationData(SpaceWireRPacket* firstSegment) {
+		size_t size = firstSegment->getPayloadSize();
+		uint8_t n = (uint8_t) (firstSegment->getSequenceNumber() + 1);
+		for (size_t i = 1; i < receiveSlidingWindowSize; i++) {
+			SpaceWireRPacket* segment = this->receiveSlidingWindowBuffer[n];
+			if (segment == NULL) {
+				break;
+			}
+			if (segment->isDataPacket()) {
+				size += segment->getPayloadSize();
+				if (segment->isLastSegment()) {
+					break;
+				}
+			}
+			n = (uint8_t) (n + 1);
+		}
+		return size;
+	}
+
 private:
 	void appendDataToCurrentApplicationDataInstance(SpaceWireRPacket* packet) {
-		std::vector<uint8_t>* payload = packet->getPayload();
-		size_t size = packet->getPayloadLength();
-		for (size_t i = 0; i < size; i++) {
-			currentApplicationData->push_back(payload->at(i));
+		uint8_t* payload = packet->getPayloadAddress();
+		size_t size = packet->getPayloadSize();
+		if (size != 0) {
+			currentApplicationData->insert(currentApplicationData->end(), payload, payload + size);
 		}
 	}
 
 private:
 	void completeServiceDataUnitHasBeenReceived() {
-		receivedApplicationData.push_back(currentApplicationData);
+		pushApplicationData(currentApplicationData);
 		currentApplicationData = NULL;
 	}
 
 private:
 	void completeServiceDataUnitHasBeenReceived(SpaceWireRPacket* packet) {
-		std::vector<uint8_t>* applicationData = new std::vector<uint8_t>(packet->getPayloadLength());
-		*(applicationData) = *(packet->getPayload());
-		receivedApplicationData.push_back(applicationData);
+		//the payload buffer of the packet is handed over without copying
+		std::vector<uint8_t>* applicationData = new std::vector<uint8_t>();
+		applicationData->swap(*(packet->getPayload()));
+		pushApplicationData(applicationData);
 		currentApplicationData = NULL;
 	}
 
@@ -702,10 +773,9 @@ private:
 			return;
 		}
 
-#ifdef DebugSpaceWireRReceiveTEP
-		cout << "SpaceWireRReceiveTEP::processHeartBeatPacket() nHeartBeat = " << nReceivedHeartBeatPackets
-				<< " sequence number = " << (uint32_t) packet->getSequenceNumber() << endl;
-#endif
+		SpaceWireRTraceDebug(SpaceWireRTraceCategory::ReceiveTEP,
+				"SpaceWireRReceiveTEP::processHeartBeatPacket() nHeartBeat = {} sequence number = {}",
+				nReceivedHeartBeatPackets, packet->getSequenceNumber());
 
 		if (insideForwardReceiveSlidingWindow(sequenceNumber)) {
 			if (this->receiveSlidingWindowBuffer[sequenceNumber] == NULL) {
@@ -763,7 +833,7 @@ public:
 
 			case SpaceWireRTEPState::Enabled:
 				while (this->state == SpaceWireRTEPState::Enabled && !stopped) {
-					packetArrivalNotifier.wait(WaitDurationForPacketReceiveLoop);
+					waitForReceivedPacket(WaitDurationForPacketReceiveLoop);
 					consumeReceivedPackets();
 					/*
 					 cout << "SpaceWireRReceiveTEP::run() Enabled state. receivedPackets.size()=" << receivedPackets.size()
@@ -787,17 +857,16 @@ public:
 
 			case SpaceWireRTEPState::Open:
 				while (this->state == SpaceWireRTEPState::Open && !stopped) {
-					if (receivedPackets.size() != 0) {
+					if (!receivedPackets.isEmpty()) {
 						consumeReceivedPackets();
 					}
-					if (SpaceWireRTEPState::Open) {
-						packetArrivalNotifier.wait(WaitDurationForPacketReceiveLoop);
-					}
+					//returns immediately if packets have arrived during consumeReceivedPackets()
+					waitForReceivedPacket(WaitDurationForPacketReceiveLoop);
 				}
 				break;
 
 			case SpaceWireRTEPState::Closing:
-				while (receivedPackets.size() != 0) {
+				while (!receivedPackets.isEmpty()) {
 					SpaceWireRPacket* packet = this->popReceivedSpaceWireRPacket();
 					if (packet->isControlPacketCloseCommand()) {
 						replyAckForPacket(packet);
@@ -848,7 +917,10 @@ public:
 		ss << "State                      : " << SpaceWireRTEPState::toString(this->state) << endl;
 		ss << "receiveSlidingWindowFrom   : (dec)" << dec << (uint32_t) this->receiveSlidingWindowFrom << endl;
 		ss << "receiveSlidingWindowSize   : (dec)" << dec << (uint32_t) this->receiveSlidingWindowSize << endl;
+		ss << "negotiatedSegmentSize      : (dec)" << dec << this->negotiatedSegmentSize << endl;
 		ss << "receivedPackets.size()     : (dec)" << dec << receivedPackets.size() << endl;
+		ss << "nRcvdPacketQueueFull       : (dec)" << dec << getNReceivedPacketQueueFull() << endl;
+		ss << "nDroppedReceivedPackets    : (dec)" << dec << getNDroppedReceivedPackets() << endl;
 		ss << "Maximum Acceptable Seq Num : " << dec << (uint32_t) this->getMaximumAcceptableSequenceNumber() << endl;
 		ss << "ProbOfErrInjectionNoReply  : " << ProbabilityOfErrorInjectionNoReply << endl;
 		ss << "nErrorInjectionNoReply     : (dec)" << dec << nErrorInjectionNoReply << endl;
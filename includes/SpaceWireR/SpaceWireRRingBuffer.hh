@@ -0,0 +1,122 @@
+/*
+============================================================================
+SpaceWire/RMAP Library is provided under the MIT License.
+============================================================================
+
+Copyright (c) 2006-2013 Takayuki Yuasa and The Open-source SpaceWire Project
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+/*
+ * SpaceWireRRingBuffer.hh
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef SPACEWIRERRINGBUFFER_HH_
+#define SPACEWIRERRINGBUFFER_HH_
+
+#include <atomic>
+#include <vector>
+#include <stddef.h>
+
+/** A bounded lock-free ring buffer for one producer thread and one consumer thread.
+ * push() may only be called from the producer thread, and pop() only from the
+ * consumer thread. size() and isEmpty() can be called from either thread, but
+ * the returned value is a snapshot which may already be stale.
+ * The capacity is rounded up to a power of two.
+ */
+template<typename T>
+class SpaceWireRRingBuffer {
+private:
+	std::vector<T> slots;
+	size_t mask;
+
+private:
+	//head and tail are placed in separate cache lines so that the producer and
+	//the consumer do not invalidate each other's cache line on every operation
+	alignas(64) std::atomic<size_t> head; //written only by the consumer
+	alignas(64) std::atomic<size_t> tail; //written only by the producer
+
+public:
+	SpaceWireRRingBuffer(size_t capacity) :
+			head(0), tail(0) {
+		size_t roundedCapacity = 1;
+		while (roundedCapacity < capacity) {
+			roundedCapacity <<= 1;
+		}
+		slots.resize(roundedCapacity);
+		mask = roundedCapacity - 1;
+	}
+
+public:
+	/** Appends an element.
+	 * @param[in] element an element to be appended
+	 * @return false if the buffer is full (the element is not appended)
+	 */
+	inline bool push(const T& element) {
+		size_t currentTail = tail.load(std::memory_order_relaxed);
+		if (currentTail - head.load(std::memory_order_acquire) == slots.size()) {
+			return false;
+		}
+		slots[currentTail & mask] = element;
+		tail.store(currentTail + 1, std::memory_order_release);
+		return true;
+	}
+
+public:
+	/** Removes the oldest element.
+	 * @param[out] element the removed element
+	 * @return false if the buffer is empty
+	 */
+	inline bool pop(T& element) {
+		size_t currentHead = head.load(std::memory_order_relaxed);
+		if (currentHead == tail.load(std::memory_order_acquire)) {
+			return false;
+		}
+		element = slots[currentHead & mask];
+		head.store(currentHead + 1, std::memory_order_release);
+		return true;
+	}
+
+public:
+	inline size_t size() const {
+		//head is loaded first so that the difference never underflows
+		size_t currentHead = head.load(std::memory_order_acquire);
+		return tail.load(std::memory_order_acquire) - currentHead;
+	}
+
+public:
+	inline bool isEmpty() const {
+		return size() == 0;
+	}
+
+public:
+	inline bool isFull() const {
+		return size() == slots.size();
+	}
+
+public:
+	inline size_t getCapacity() const {
+		return slots.size();
+	}
+};
+
+#endif /* SPACEWIRERRINGBUFFER_HH_ */
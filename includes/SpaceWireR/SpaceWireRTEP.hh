@@ -38,10 +38,7 @@
 #include "SpaceWireR/SpaceWireREngine.hh"
 #include "SpaceWireR/SpaceWireRPacket.hh"
 #include "SpaceWireR/SpaceWireRTEPExceptions.hh"
-
-//#define DebugSpaceWireRTEP
-
-#undef DebugSpaceWireRTEP
+#include "SpaceWireR/SpaceWireRTrace.hh"
 
 class SpaceWireRTEPType {
 public:
@@ -105,6 +102,10 @@ protected:
 	std::vector<SpaceWireRPacket*> slidingWindowBuffer;
 	uint8_t slidingWindowFrom;
 	uint8_t slidingWindowSize;
+	/** Sliding window size set by user. TransmitTEP proposes this value in the Open command,
+	 * and slidingWindowSize is set to the value accepted by ReceiveTEP.
+	 */
+	size_t requestedSlidingWindowSize;
 
 protected:
 	CxxUtilities::Condition stateTransitionNotifier;
@@ -136,6 +137,7 @@ public:
 		flowControlPacket = new SpaceWireRPacket();
 		retryTimerUpdater->start();
 		this->nOfOutstandingPackets = 0;
+		this->requestedSlidingWindowSize = DefaultSlidingWindowSize;
 		this->initializeSlidingWindow();
 		this->initializeSlidingWindowRelatedBuffers();
 		this->initializeHeartBeatCounters();
@@ -156,7 +158,7 @@ protected:
 	void initializeSlidingWindow() {
 		slidingWindowBuffer.clear();
 		slidingWindowBuffer.resize(MaxOfSlidingWindow, NULL);
-		slidingWindowSize = DefaultSlidingWindowSize;
+		slidingWindowSize = requestedSlidingWindowSize;
 		slidingWindowFrom = 0;
 	}
 
@@ -269,15 +271,53 @@ public:
 	}
 
 public:
-	inline void setSlidingWindowSize(uint8_t slidingWindowSize) {
+	/** Sets sliding window size.
+	 * TransmitTEP proposes this size in the Open command, and uses the size
+	 * accepted by ReceiveTEP (which may be smaller) while the TEP is open.
+	 * @param[in] slidingWindowSize 1 to SpaceWireRProtocol::MaximumSlidingWindowSize
+	 */
+	inline void setSlidingWindowSize(size_t slidingWindowSize) throw (SpaceWireRTEPException) {
+		if (slidingWindowSize == 0 || SpaceWireRProtocol::MaximumSlidingWindowSize < slidingWindowSize) {
+			throw SpaceWireRTEPException(SpaceWireRTEPException::InvalidParameter);
+		}
+		this->requestedSlidingWindowSize = slidingWindowSize;
 		this->slidingWindowSize = slidingWindowSize;
 	}
 
+protected:
+	/** Encodes sliding window size and maximum segment size as Open command/Open Ack parameters.
+	 */
+	static void encodeOpenParameters(size_t windowSize, size_t segmentSize,
+			uint8_t (&parameters)[SpaceWireRProtocol::SizeOfOpenParameters]) {
+		parameters[0] = (uint8_t) windowSize;
+		parameters[1] = (uint8_t) (segmentSize / 0x100);
+		parameters[2] = (uint8_t) (segmentSize % 0x100);
+	}
+
+protected:
+	/** Decodes Open command/Open Ack parameters.
+	 * @return false if the parameters are absent or invalid (the output arguments are not modified)
+	 */
+	static bool decodeOpenParameters(uint8_t* parameters, size_t length, size_t& windowSize, size_t& segmentSize) {
+		if (parameters == NULL || length < SpaceWireRProtocol::SizeOfOpenParameters) {
+			return false;
+		}
+		size_t decodedWindowSize = parameters[0];
+		size_t decodedSegmentSize = parameters[1] * 0x100 + parameters[2];
+		if (decodedWindowSize == 0 || SpaceWireRProtocol::MaximumSlidingWindowSize < decodedWindowSize
+				|| decodedSegmentSize == 0) {
+			return false;
+		}
+		windowSize = decodedWindowSize;
+		segmentSize = decodedSegmentSize;
+		return true;
+	}
+
 protected:
 	inline void discardReceivedPackets() {
-		while (receivedPackets.size() != 0) {
-			delete receivedPackets.front();
-			receivedPackets.pop_front();
+		SpaceWireRPacket* packet;
+		while ((packet = this->popReceivedSpaceWireRPacket()) != NULL) {
+			delete packet;
 		}
 	}
 
@@ -408,10 +448,10 @@ private:
 	/** Initializes the memory buffers used in sliding window control.
 	 */
 	void initializeSlidingWindowRelatedBuffers() {
-		retryTimeoutCounters = new double[SpaceWireRProtocol::SizeOfSlidingWindow];
-		packetHasBeenSent = new bool[SpaceWireRProtocol::SizeOfSlidingWindow];
-		packetWasAcknowledged = new bool[SpaceWireRProtocol::SizeOfSlidingWindow];
-		retryCountsForSequenceNumber = new size_t[SpaceWireRProtocol::SizeOfSlidingWindow];
+		retryTimeoutCounters = new double[SpaceWireRProtocol::SizeOfSlidingWindow]();
+		packetHasBeenSent = new bool[SpaceWireRProtocol::SizeOfSlidingWindow]();
+		packetWasAcknowledged = new bool[SpaceWireRProtocol::SizeOfSlidingWindow]();
+		retryCountsForSequenceNumber = new size_t[SpaceWireRProtocol::SizeOfSlidingWindow]();
 	}
 
 private:
@@ -509,11 +549,10 @@ protected:
 		packet->setSequenceNumber(sequenceNumber);
 
 		using namespace std;
-#ifdef DebugSpaceWireRTEP
-		cout << "SpaceWireRTEP::sendPacket() enetered." << endl;
-		cout << "SpaceWireRTEP::sendPacket() PacketType=" << packet->getPacketTypeAsString() << " SequenceNumber="
-		<< packet->getSequenceNumberAs32bitInteger() << endl;
-#endif
+		SpaceWireRTraceDebug(SpaceWireRTraceCategory::TEP, "SpaceWireRTEP::sendPacket() enetered.");
+		SpaceWireRTraceDebug(SpaceWireRTraceCategory::TEP,
+				"SpaceWireRTEP::sendPacket() PacketType={} SequenceNumber={}",
+				packet->getPacketType(), packet->getSequenceNumberAs32bitInteger());
 
 		sendTimeoutCounter = 0;
 		nOfOutstandingPackets = 0;
@@ -538,11 +577,9 @@ protected:
 
 		//send segment
 		try {
-#ifdef DebugSpaceWireRTEP
-			cout << "SpaceWireRTEP::sendPacket() sending a segment sequence number=" << (uint32_t) packet->getSequenceNumber()
-			<< " " << endl;
-			cout << packet->toString() << endl;
-#endif
+			SpaceWireRTraceDebug(SpaceWireRTraceCategory::TEP,
+					"SpaceWireRTEP::sendPacket() sending a segment sequence number={} flags={}",
+					packet->getSequenceNumber(), packet->getSequenceFlags());
 			spwREngine->sendPacket(packet);
 			nSentSegments++;
 			packetHasBeenSent[packet->getSequenceNumber()] = true;
@@ -553,16 +590,13 @@ protected:
 		}
 
 		//check all sent packets were acknowledged
-#ifdef DebugSpaceWireRTEP
-		cout << "SpaceWireRTEP::sendPacket() all segments were sent. Wait until acknowledged." << endl;
-#endif
+		SpaceWireRTraceDebug(SpaceWireRTraceCategory::TEP,
+				"SpaceWireRTEP::sendPacket() all segments were sent. Wait until acknowledged.");
 		while (!allOngoingPacketesWereAcknowledged()) {
 			checkRetryTimerThenRetry();
 			conditionForSendWait.wait(DefaultWaitDurationInMsForCompletionCheck);
 		}
-#ifdef DebugSpaceWireRTEP
-		cout << "SpaceWireRTEP::sendPacket() Completed." << endl;
-#endif
+		SpaceWireRTraceDebug(SpaceWireRTraceCategory::TEP, "SpaceWireRTEP::sendPacket() Completed.");
 		sendMutex.unlock();
 	}
 
@@ -572,18 +606,14 @@ protected:
 		mutexForRetryTimeoutCounters.lock();
 		for (size_t i = 0; i < this->slidingWindowSize; i++) {
 			uint8_t index = (uint8_t) (this->slidingWindowFrom + i);
-#ifdef DebugSpaceWireRTEP
-			cout << "SpaceWireRTEP::checkRetryTimerThenRetry() Window=" << (size_t) index << " TimeoutCounter="
-			<< retryTimeoutCounters[index] << endl;
-#endif
+			SpaceWireRTraceDebug(SpaceWireRTraceCategory::TEP,
+					"SpaceWireRTEP::checkRetryTimerThenRetry() Window={} TimeoutCounter={}",
+					index, retryTimeoutCounters[index]);
 			if (packetHasBeenSent[index] == true && packetWasAcknowledged[index] == false
 					&& retryTimeoutCounters[index] > WaitDurationInMsForPacketRetransmission) {
-#ifdef DebugSpaceWireRTEPDumpCriticalIncidents
-				std::stringstream ss;
-				ss << "SpaceWireRTEP::checkRetryTimerThenRetry() Timer expired for sequence number = " << dec << right
-				<< (uint32_t) index << " !!!" << endl;
-				CxxUtilities::TerminalControl::displayInRed(ss.str());
-#endif
+				SpaceWireRTraceWarning(SpaceWireRTraceCategory::TEP,
+						"SpaceWireRTEP::checkRetryTimerThenRetry() Timer expired for sequence number = {} !!!",
+						index);
 				nLostAckPackets++;
 				retryTimeoutCounters[index] = 0;
 				retryCountsForSequenceNumber[index]++;
@@ -595,12 +625,9 @@ protected:
 				}
 
 				slidingWindowBuffer[index]->setSequenceNumber(index);
-#ifdef DebugSpaceWireRTEP
-				cout << "SpaceWireRTEP::checkRetryTimerThenRetry() Retry for sequence number=" << (uint32_t) index << " "
-				<< slidingWindowBuffer[index]->getPacketTypeAsString() << " "
-				<< (uint32_t) slidingWindowBuffer[index]->getSequenceNumber() << " "
-				<< slidingWindowBuffer[index]->getSequenceFlagsAsString() << endl;
-#endif
+				SpaceWireRTraceDebug(SpaceWireRTraceCategory::TEP,
+						"SpaceWireRTEP::checkRetryTimerThenRetry() Retry for sequence number={} type={} flags={}",
+						index, slidingWindowBuffer[index]->getPacketType(), slidingWindowBuffer[index]->getSequenceFlags());
 				//do retry
 				spwREngine->sendPacket(slidingWindowBuffer[index]);
 				nRetriedSegments++;
@@ -613,16 +640,13 @@ private:
 	void updateRetryTimers() {
 		using namespace std;
 		mutexForRetryTimeoutCounters.lock();
-#ifdef DebugSpaceWireRTEP
-		cout << "SpaceWireRTEP::updateRetryTimers()" << endl;
-#endif
+		SpaceWireRTraceDebug(SpaceWireRTraceCategory::TEP, "SpaceWireRTEP::updateRetryTimers()");
 		for (size_t i = 0; i < this->slidingWindowSize; i++) {
 			uint8_t index = (uint8_t) (this->slidingWindowFrom + i);
 			if (packetHasBeenSent[index] == true && packetWasAcknowledged[index] == false) {
-#ifdef DebugSpaceWireRTEP
-				cout << "SpaceWireRTEP::updateRetryTimers() TimeoutCounter[" << dec << (uint32_t) index << "]="
-				<< retryTimeoutCounters[index] << endl;
-#endif
+				SpaceWireRTraceDebug(SpaceWireRTraceCategory::TEP,
+						"SpaceWireRTEP::updateRetryTimers() TimeoutCounter[{}]={}",
+						index, retryTimeoutCounters[index]);
 				retryTimeoutCounters[index] += timeoutDurationForRetryTimers;
 			}
 		}
@@ -664,17 +688,15 @@ protected:
 protected:
 	inline SpaceWireRPacket* getAvailablePacketInstance() {
 		using namespace std;
-#ifdef DebugSpaceWireRTEP
-		cout << "SpaceWireRTEP::getAvailablePacketInstance() nOfOutstandingPackets=" << dec << nOfOutstandingPackets
-		<< endl;
-#endif
+		SpaceWireRTraceDebug(SpaceWireRTraceCategory::TEP,
+				"SpaceWireRTEP::getAvailablePacketInstance() nOfOutstandingPackets={}",
+				nOfOutstandingPackets);
 		if (nOfOutstandingPackets < this->slidingWindowSize) {
 			SpaceWireRPacket* packet = slidingWindowBuffer[this->sequenceNumber];
 			return packet;
 		} else {
-#ifdef DebugSpaceWireRTEP
-			cout << "SpaceWireRTEP::getAvailablePacketInstance() Returns NULL!!!" << endl;
-#endif
+			SpaceWireRTraceDebug(SpaceWireRTraceCategory::TEP,
+					"SpaceWireRTEP::getAvailablePacketInstance() Returns NULL!!!");
 			return NULL;
 		}
 	}
@@ -684,9 +706,7 @@ protected:
 	 */
 	void slideSlidingWindow() {
 		using namespace std;
-#ifdef DebugSpaceWireRTEP
-		cout << "SpaceWireRTEP::slideSlidingWindow()" << endl;
-#endif
+		SpaceWireRTraceDebug(SpaceWireRTraceCategory::TEP, "SpaceWireRTEP::slideSlidingWindow()");
 		uint8_t n = this->slidingWindowFrom;
 		while (packetHasBeenSent[n] == true && packetWasAcknowledged[n] == true) {
 			packetHasBeenSent[n] = false;
@@ -696,9 +716,8 @@ protected:
 			n = (uint8_t) (n + 1);
 		}
 		this->slidingWindowFrom = n;
-#ifdef DebugSpaceWireRTEP
-		cout << "SpaceWireRTEP::slideSlidingWindow() slidingWindowFrom=" << (uint32_t) this->slidingWindowFrom << endl;
-#endif
+		SpaceWireRTraceDebug(SpaceWireRTraceCategory::TEP, "SpaceWireRTEP::slideSlidingWindow() slidingWindowFrom={}",
+				this->slidingWindowFrom);
 	}
 
 	/* ^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^
@@ -786,14 +805,11 @@ protected:
 public:
 	void enableHeartBeat() {
 		using namespace std;
-#ifdef DebugSpaceWireRTEP
-		cout << "SpaceWireRTEP::enableHeartBeat()" << endl;
-#endif
+		SpaceWireRTraceDebug(SpaceWireRTraceCategory::TEP, "SpaceWireRTEP::enableHeartBeat()");
 		isHeartBeatEmissionEnabled = true;
 		if (heartBeatTimer->isStopped()) {
-#ifdef DebugSpaceWireRTEP
-			cout << "SpaceWireRTEP::enableHeartBeat() starting child thread" << endl;
-#endif
+			SpaceWireRTraceDebug(SpaceWireRTraceCategory::TEP,
+					"SpaceWireRTEP::enableHeartBeat() starting child thread");
 			heartBeatTimer->start();
 		}
 	}
@@ -810,9 +826,7 @@ private:
 	void emitHeartBeatPacket() throw (SpaceWireRTEPException) {
 		sendMutex.lock();
 		using namespace std;
-#ifdef DebugSpaceWireRTEP
-		cout << "SpaceWireRTEP::emitHeartBeatPacket() entered." << endl;
-#endif
+		SpaceWireRTraceDebug(SpaceWireRTraceCategory::TEP, "SpaceWireRTEP::emitHeartBeatPacket() entered.");
 		SpaceWireRPacket* heartBeatPacket;
 		size_t nTrials = 0;
 		heartBeatPacket = this->getAvailablePacketInstance();
@@ -825,9 +839,8 @@ private:
 		heartBeatPacket->setCompleteSegmentFlag();
 		sendPacket(heartBeatPacket);
 		nTransmittedHeartBeatPackets++;
-#ifdef DebugSpaceWireRTEP
-		cout << "SpaceWireRTEP::emitHeartBeatPacket() HeartBeat packet has been transmitted and acknowledged." << endl;
-#endif
+		SpaceWireRTraceDebug(SpaceWireRTraceCategory::TEP,
+				"SpaceWireRTEP::emitHeartBeatPacket() HeartBeat packet has been transmitted and acknowledged.");
 		sendMutex.unlock();
 	}
 
@@ -54,7 +54,8 @@ public:
 		SpaceWireIFIsNotWorking, //
 		Timeout, //
 		TooManyRetryFailures, //
-		NoRoomInSlidingWindow
+		NoRoomInSlidingWindow, //
+		InvalidParameter
 	};
 
 public:
@@ -83,6 +84,9 @@ public:
 		case NoRoomInSlidingWindow:
 			result = "NoRoomInSlidingWindow";
 			break;
+		case InvalidParameter:
+			result = "InvalidParameter";
+			break;
 		default:
 			result = "Undefined status";
 			break;
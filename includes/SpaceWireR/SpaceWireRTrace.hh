@@ -0,0 +1,288 @@
+/*
+============================================================================
+SpaceWire/RMAP Library is provided under the MIT License.
+============================================================================
+
+Copyright (c) 2006-2013 Takayuki Yuasa and The Open-source SpaceWire Project
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+/*
+ * SpaceWireRTrace.hh
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef SPACEWIRERTRACE_HH_
+#define SPACEWIRERTRACE_HH_
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+/** Trace levels of SpaceWire-R classes.
+ * Trace points whose level is larger than SpaceWireRTraceCompiledLevel
+ * are removed at compile time.
+ */
+class SpaceWireRTraceLevel {
+public:
+	enum {
+		Off = 0, Warning = 1, Info = 2, Debug = 3
+	};
+
+public:
+	static std::string toString(uint32_t level) {
+		switch (level) {
+		case Warning:
+			return "Warning";
+		case Info:
+			return "Info";
+		case Debug:
+			return "Debug";
+		default:
+			return "Off";
+		}
+	}
+};
+
+/** Maximum trace level compiled in. Define as 0 (e.g. -DSpaceWireRTraceCompiledLevel=0)
+ * to remove all trace points.
+ */
+#ifndef SpaceWireRTraceCompiledLevel
+#define SpaceWireRTraceCompiledLevel 3
+#endif
+
+/** Trace categories. Each category can be enabled/disabled at runtime
+ * via SpaceWireRTrace::setCategoryMask().
+ */
+class SpaceWireRTraceCategory {
+public:
+	enum {
+		Engine = 0x01, //
+		TEP = 0x02, //
+		ReceiveTEP = 0x04, //
+		TransmitTEP = 0x08, //
+		All = 0x0F
+	};
+
+public:
+	static std::string toString(uint32_t category) {
+		switch (category) {
+		case Engine:
+			return "Engine";
+		case TEP:
+			return "TEP";
+		case ReceiveTEP:
+			return "ReceiveTEP";
+		case TransmitTEP:
+			return "TransmitTEP";
+		default:
+			return "Unknown";
+		}
+	}
+};
+
+/** Trace sink of SpaceWire-R classes.
+ * A trace point stores a pointer to a string literal and up to three integer arguments
+ * into a fixed-size lock-free ring buffer; formatting is deferred until dump().
+ * Writers never block. When the ring buffer wraps around before being dumped,
+ * the oldest records are overwritten and counted as lost.
+ * "{}" in a message is replaced by the next argument in decimal, and "{x}" in hexadecimal.
+ */
+class SpaceWireRTrace {
+public:
+	static const size_t MaximumNumberOfArguments = 3;
+	static const size_t NumberOfRecords = 8192; //must be a power of two
+
+private:
+	/** One trace record. Fields are guarded by a sequence number (seqlock);
+	 * an odd value means that the record is being written.
+	 */
+	struct Record {
+		std::atomic<uint64_t> sequence;
+		std::atomic<uint64_t> timeInNanoSec;
+		std::atomic<uint32_t> level;
+		std::atomic<uint32_t> category;
+		std::atomic<const char*> message;
+		std::atomic<uint32_t> nArguments;
+		std::atomic<uint64_t> arguments[MaximumNumberOfArguments];
+	};
+
+private:
+	std::vector<Record> records;
+	std::atomic<uint64_t> writeIndex;
+	uint64_t readIndex;
+	size_t nLostRecords;
+
+private:
+	SpaceWireRTrace() :
+			records(NumberOfRecords) {
+		for (size_t i = 0; i < records.size(); i++) {
+			records[i].sequence = 0;
+		}
+		writeIndex = 0;
+		readIndex = 0;
+		nLostRecords = 0;
+	}
+
+public:
+	static SpaceWireRTrace& getInstance() {
+		static SpaceWireRTrace instance;
+		return instance;
+	}
+
+private:
+	static std::atomic<uint32_t>& categoryMask() {
+		//constant-initialized, so no initialization guard is involved on the hot path
+		static std::atomic<uint32_t> mask(0);
+		return mask;
+	}
+
+public:
+	/** Sets enabled categories (OR of SpaceWireRTraceCategory values). All categories are disabled by default.
+	 */
+	static void setCategoryMask(uint32_t mask) {
+		categoryMask().store(mask, std::memory_order_relaxed);
+	}
+
+public:
+	static uint32_t getCategoryMask() {
+		return categoryMask().load(std::memory_order_relaxed);
+	}
+
+public:
+	static inline bool isEnabled(uint32_t category) {
+		return (categoryMask().load(std::memory_order_relaxed) & category) != 0;
+	}
+
+public:
+	template<typename ... Arguments>
+	static void record(uint32_t level, uint32_t category, const char* message, Arguments ... arguments) {
+		static_assert(sizeof...(Arguments) <= MaximumNumberOfArguments, "too many trace arguments");
+		uint64_t values[] = { 0, (uint64_t) arguments... };
+		getInstance().write(level, category, message, values + 1, sizeof...(Arguments));
+	}
+
+private:
+	void write(uint32_t level, uint32_t category, const char* message, const uint64_t* values, size_t nValues) {
+		uint64_t index = writeIndex.fetch_add(1, std::memory_order_relaxed);
+		Record& r = records[index & (NumberOfRecords - 1)];
+		r.sequence.store(2 * index + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		r.timeInNanoSec.store(
+				std::chrono::duration_cast<std::chrono::nanoseconds>(
+						std::chrono::steady_clock::now().time_since_epoch()).count(), std::memory_order_relaxed);
+		r.level.store(level, std::memory_order_relaxed);
+		r.category.store(category, std::memory_order_relaxed);
+		r.message.store(message, std::memory_order_relaxed);
+		r.nArguments.store(nValues, std::memory_order_relaxed);
+		for (size_t i = 0; i < nValues; i++) {
+			r.arguments[i].store(values[i], std::memory_order_relaxed);
+		}
+		r.sequence.store(2 * index + 2, std::memory_order_release);
+	}
+
+public:
+	/** Formats records written since the last dump, and outputs them to a stream.
+	 * Only one thread should call this method at a time.
+	 * @return the number of output records
+	 */
+	size_t dump(std::ostream& os = std::cout) {
+		uint64_t end = writeIndex.load(std::memory_order_acquire);
+		if (end - readIndex > NumberOfRecords) {
+			nLostRecords += end - readIndex - NumberOfRecords;
+			readIndex = end - NumberOfRecords;
+		}
+		size_t nOutput = 0;
+		for (; readIndex < end; readIndex++) {
+			Record& r = records[readIndex & (NumberOfRecords - 1)];
+			uint64_t sequence = r.sequence.load(std::memory_order_acquire);
+			if (sequence != 2 * readIndex + 2) {
+				//still being written, or already overwritten
+				nLostRecords++;
+				continue;
+			}
+			uint64_t timeInNanoSec = r.timeInNanoSec.load(std::memory_order_relaxed);
+			uint32_t level = r.level.load(std::memory_order_relaxed);
+			uint32_t category = r.category.load(std::memory_order_relaxed);
+			const char* message = r.message.load(std::memory_order_relaxed);
+			size_t nArguments = r.nArguments.load(std::memory_order_relaxed);
+			uint64_t arguments[MaximumNumberOfArguments];
+			for (size_t i = 0; i < nArguments && i < MaximumNumberOfArguments; i++) {
+				arguments[i] = r.arguments[i].load(std::memory_order_relaxed);
+			}
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (r.sequence.load(std::memory_order_relaxed) != sequence) {
+				nLostRecords++;
+				continue;
+			}
+			os << "[" << std::dec << timeInNanoSec / 1000 << "us " << SpaceWireRTraceLevel::toString(level) << " "
+					<< SpaceWireRTraceCategory::toString(category) << "] " << format(message, arguments, nArguments)
+					<< std::endl;
+			nOutput++;
+		}
+		return nOutput;
+	}
+
+public:
+	/** Returns the number of records which were overwritten before being dumped.
+	 */
+	size_t getNLostRecords() const {
+		return nLostRecords;
+	}
+
+private:
+	static std::string format(const char* message, const uint64_t* arguments, size_t nArguments) {
+		std::stringstream ss;
+		size_t argumentIndex = 0;
+		for (const char* p = message; *p != 0; p++) {
+			if (p[0] == '{' && p[1] == '}' && argumentIndex < nArguments) {
+				ss << std::dec << arguments[argumentIndex++];
+				p++;
+			} else if (p[0] == '{' && p[1] == 'x' && p[2] == '}' && argumentIndex < nArguments) {
+				ss << "0x" << std::hex << arguments[argumentIndex++] << std::dec;
+				p += 2;
+			} else {
+				ss << *p;
+			}
+		}
+		return ss.str();
+	}
+};
+
+/** Trace points. Arguments are evaluated only when the category is enabled,
+ * and the whole statement is removed when the level is not compiled in.
+ */
+#define SpaceWireRTraceAtLevel(level, category, ...) \
+	do { \
+		if ((level) <= SpaceWireRTraceCompiledLevel && SpaceWireRTrace::isEnabled(category)) { \
+			SpaceWireRTrace::record((level), (category), __VA_ARGS__); \
+		} \
+	} while (0)
+
+#define SpaceWireRTraceWarning(category, ...) SpaceWireRTraceAtLevel(SpaceWireRTraceLevel::Warning, category, __VA_ARGS__)
+#define SpaceWireRTraceInfo(category, ...) SpaceWireRTraceAtLevel(SpaceWireRTraceLevel::Info, category, __VA_ARGS__)
+#define SpaceWireRTraceDebug(category, ...) SpaceWireRTraceAtLevel(SpaceWireRTraceLevel::Debug, category, __VA_ARGS__)
+
+#endif /* SPACEWIRERTRACE_HH_ */
@@ -0,0 +1,354 @@
+/*
+============================================================================
+SpaceWire/RMAP Library is provided under the MIT License.
+============================================================================
+
+Copyright (c) 2006-2013 Takayuki Yuasa and The Open-source SpaceWire Project
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+/*
+ * SpaceWireRTransmitScheduler.hh
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef SPACEWIRERTRANSMITSCHEDULER_HH_
+#define SPACEWIRERTRANSMITSCHEDULER_HH_
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <stddef.h>
+#include <stdint.h>
+
+/** Priority classes of SpaceWire-R channels.
+ * A packet of a higher class (smaller value) is always transmitted before
+ * packets of lower classes which are waiting at the same time.
+ */
+class SpaceWireRTransmitPriority {
+public:
+	enum {
+		Highest = 0, High = 1, Normal = 2, Low = 3
+	};
+
+public:
+	static const size_t NumberOfPriorityClasses = 4;
+
+public:
+	static std::string toString(uint32_t priority) {
+		switch (priority) {
+		case Highest:
+			return "Highest";
+		case High:
+			return "High";
+		case Normal:
+			return "Normal";
+		case Low:
+			return "Low";
+		default:
+			return "Unknown";
+		}
+	}
+};
+
+/** Transmit statistics of a SpaceWire-R channel.
+ */
+class SpaceWireRChannelTransmitStatistics {
+public:
+	size_t nSentPackets;
+	size_t nSentBytes;
+	size_t nQueuedPackets; //packets which had to wait for the link
+	double bytesPerSec; //measured over the last completed interval
+	double totalQueueingDelayInMs;
+	double maximumQueueingDelayInMs;
+
+public:
+	SpaceWireRChannelTransmitStatistics() {
+		nSentPackets = 0;
+		nSentBytes = 0;
+		nQueuedPackets = 0;
+		bytesPerSec = 0;
+		totalQueueingDelayInMs = 0;
+		maximumQueueingDelayInMs = 0;
+	}
+
+public:
+	double getAverageQueueingDelayInMs() const {
+		if (nSentPackets == 0) {
+			return 0;
+		}
+		return totalQueueingDelayInMs / nSentPackets;
+	}
+
+public:
+	std::string toString() const {
+		std::stringstream ss;
+		ss << "nSentPackets=" << nSentPackets << " nSentBytes=" << nSentBytes << " nQueuedPackets=" << nQueuedPackets
+				<< " bytesPerSec=" << bytesPerSec << " averageQueueingDelay=" << getAverageQueueingDelayInMs() << "ms"
+				<< " maximumQueueingDelay=" << maximumQueueingDelayInMs << "ms";
+		return ss.str();
+	}
+};
+
+/** Arbitrates the outgoing SpaceWire link among SpaceWire-R channels.
+ * A thread which sends a packet calls acquire() before writing the packet to SpaceWireIF
+ * and release() after that. When the link is busy, the packet waits in the queue of its channel.
+ * On release(), the next packet is selected from the highest priority class which has waiting packets,
+ * and among channels of the same class by deficit round robin weighted by the channel weight
+ * (each channel can send weight x QuantumInBytes bytes per round).
+ * Packets are not copied; the sending thread itself writes its packet when it is granted the link.
+ */
+class SpaceWireRTransmitScheduler {
+public:
+	static const size_t NumberOfChannels = 0x10000;
+	static const size_t QuantumInBytes = 4096;
+	static const uint32_t DefaultWeight = 1;
+	static const uint32_t DefaultPriority = SpaceWireRTransmitPriority::Normal;
+	static constexpr double IntervalInMsForThroughputMeasurement = 1000;
+
+private:
+	typedef std::chrono::steady_clock Clock;
+
+private:
+	struct Request {
+		size_t size;
+		bool granted;
+	};
+
+private:
+	struct ChannelState {
+		uint32_t priority;
+		uint32_t weight;
+		size_t deficit;
+		bool hasReceivedQuantumInThisRound;
+		std::deque<Request*> requests;
+		std::condition_variable grantCondition;
+		SpaceWireRChannelTransmitStatistics statistics;
+		Clock::time_point intervalStartTime;
+		size_t nSentBytesInInterval;
+	};
+
+private:
+	std::mutex mutex;
+	bool isLinkBusy;
+	size_t nWaitingRequests;
+	//indexed by channel number; created when a channel is used or configured for the first time
+	std::vector<ChannelState*> channelStates;
+	//channels which have waiting requests, per priority class, in round-robin order
+	std::list<ChannelState*> activeChannels[SpaceWireRTransmitPriority::NumberOfPriorityClasses];
+
+public:
+	SpaceWireRTransmitScheduler() :
+			channelStates(NumberOfChannels, (ChannelState*) NULL) {
+		isLinkBusy = false;
+		nWaitingRequests = 0;
+	}
+
+public:
+	~SpaceWireRTransmitScheduler() {
+		for (size_t i = 0; i < channelStates.size(); i++) {
+			delete channelStates[i];
+		}
+	}
+
+public:
+	/** Waits until the link is granted to the calling thread.
+	 * @param[in] channel channel number of the packet
+	 * @param[in] size packet size in bytes
+	 */
+	void acquire(uint16_t channel, size_t size) {
+		std::unique_lock<std::mutex> lock(mutex);
+		ChannelState* state = getChannelState(channel);
+		Clock::time_point enqueuedTime = Clock::now();
+		if (!isLinkBusy && nWaitingRequests == 0) {
+			//fast path: the link is idle
+			isLinkBusy = true;
+			updateStatistics(state, size, 0, enqueuedTime);
+			return;
+		}
+
+		Request request;
+		request.size = size;
+		request.granted = false;
+		if (state->requests.empty()) {
+			activeChannels[state->priority].push_back(state);
+		}
+		state->requests.push_back(&request);
+		nWaitingRequests++;
+		state->statistics.nQueuedPackets++;
+		state->grantCondition.wait(lock, [&request] {return request.granted;});
+
+		Clock::time_point grantedTime = Clock::now();
+		double queueingDelayInMs = std::chrono::duration<double, std::milli>(grantedTime - enqueuedTime).count();
+		updateStatistics(state, size, queueingDelayInMs, grantedTime);
+	}
+
+public:
+	/** Releases the link, and grants it to the next packet if any.
+	 */
+	void release() {
+		std::lock_guard<std::mutex> lock(mutex);
+		if (nWaitingRequests == 0) {
+			isLinkBusy = false;
+			return;
+		}
+		for (size_t priority = 0; priority < SpaceWireRTransmitPriority::NumberOfPriorityClasses; priority++) {
+			if (!activeChannels[priority].empty()) {
+				grantNextRequest(activeChannels[priority]);
+				nWaitingRequests--;
+				//isLinkBusy stays true; the link is handed over to the granted thread
+				return;
+			}
+		}
+	}
+
+public:
+	/** Sets the priority class of a channel (see SpaceWireRTransmitPriority).
+	 */
+	void setPriority(uint16_t channel, uint32_t priority) {
+		if (priority >= SpaceWireRTransmitPriority::NumberOfPriorityClasses) {
+			priority = SpaceWireRTransmitPriority::NumberOfPriorityClasses - 1;
+		}
+		std::lock_guard<std::mutex> lock(mutex);
+		ChannelState* state = getChannelState(channel);
+		if (state->priority == priority) {
+			return;
+		}
+		if (!state->requests.empty()) {
+			activeChannels[state->priority].remove(state);
+			activeChannels[priority].push_back(state);
+		}
+		state->priority = priority;
+	}
+
+public:
+	uint32_t getPriority(uint16_t channel) {
+		std::lock_guard<std::mutex> lock(mutex);
+		return getChannelState(channel)->priority;
+	}
+
+public:
+	/** Sets the weight of a channel within its priority class.
+	 * A channel with weight n gets n times as much bandwidth as a channel with weight 1
+	 * when both have packets waiting.
+	 */
+	void setWeight(uint16_t channel, uint32_t weight) {
+		if (weight == 0) {
+			weight = 1;
+		}
+		std::lock_guard<std::mutex> lock(mutex);
+		getChannelState(channel)->weight = weight;
+	}
+
+public:
+	uint32_t getWeight(uint16_t channel) {
+		std::lock_guard<std::mutex> lock(mutex);
+		return getChannelState(channel)->weight;
+	}
+
+public:
+	SpaceWireRChannelTransmitStatistics getStatistics(uint16_t channel) {
+		std::lock_guard<std::mutex> lock(mutex);
+		return getChannelState(channel)->statistics;
+	}
+
+public:
+	void resetStatistics(uint16_t channel) {
+		std::lock_guard<std::mutex> lock(mutex);
+		ChannelState* state = getChannelState(channel);
+		state->statistics = SpaceWireRChannelTransmitStatistics();
+		state->intervalStartTime = Clock::now();
+		state->nSentBytesInInterval = 0;
+	}
+
+private:
+	//called with mutex locked
+	ChannelState* getChannelState(uint16_t channel) {
+		ChannelState* state = channelStates[channel];
+		if (state == NULL) {
+			state = new ChannelState;
+			state->priority = DefaultPriority;
+			state->weight = DefaultWeight;
+			state->deficit = 0;
+			state->hasReceivedQuantumInThisRound = false;
+			state->intervalStartTime = Clock::now();
+			state->nSentBytesInInterval = 0;
+			channelStates[channel] = state;
+		}
+		return state;
+	}
+
+private:
+	//called with mutex locked; activeChannels should not be empty
+	void grantNextRequest(std::list<ChannelState*>& channels) {
+		while (true) {
+			ChannelState* state = channels.front();
+			if (!state->hasReceivedQuantumInThisRound) {
+				state->deficit += state->weight * QuantumInBytes;
+				state->hasReceivedQuantumInThisRound = true;
+			}
+			Request* request = state->requests.front();
+			if (request->size <= state->deficit) {
+				state->deficit -= request->size;
+				state->requests.pop_front();
+				if (state->requests.empty()) {
+					//an idle channel does not accumulate deficit
+					state->deficit = 0;
+					state->hasReceivedQuantumInThisRound = false;
+					channels.pop_front();
+				}
+				request->granted = true;
+				state->grantCondition.notify_all();
+				return;
+			}
+			//the deficit is used up in this round; move to the next channel
+			state->hasReceivedQuantumInThisRound = false;
+			channels.pop_front();
+			channels.push_back(state);
+		}
+	}
+
+private:
+	//called with mutex locked
+	void updateStatistics(ChannelState* state, size_t size, double queueingDelayInMs, Clock::time_point now) {
+		SpaceWireRChannelTransmitStatistics& statistics = state->statistics;
+		statistics.nSentPackets++;
+		statistics.nSentBytes += size;
+		statistics.totalQueueingDelayInMs += queueingDelayInMs;
+		if (statistics.maximumQueueingDelayInMs < queueingDelayInMs) {
+			statistics.maximumQueueingDelayInMs = queueingDelayInMs;
+		}
+		state->nSentBytesInInterval += size;
+		double elapsedTimeInMs = std::chrono::duration<double, std::milli>(now - state->intervalStartTime).count();
+		if (elapsedTimeInMs >= IntervalInMsForThroughputMeasurement) {
+			statistics.bytesPerSec = state->nSentBytesInInterval / (elapsedTimeInMs / 1000.0);
+			state->nSentBytesInInterval = 0;
+			state->intervalStartTime = now;
+		}
+	}
+};
+
+#endif /* SPACEWIRERTRANSMITSCHEDULER_HH_ */
@@ -36,11 +36,6 @@
 
 #include "SpaceWireR/SpaceWireRTEP.hh"
 
-#define DebugSpaceWireRTransmitTEP
-#define DebugSpaceWireRTransmitTEPDumpCriticalIncidents
-//#undef DebugSpaceWireRTransmitTEP
-//#undef DebugSpaceWireRTransmitTEPDumpCriticalIncidents
-
 class SpaceWireRTransmitTEP: public SpaceWireRTEP, public CxxUtilities::StoppableThread {
 
 public:
@@ -53,6 +48,7 @@ public:
 		this->sourceLogicalAddress = sourceLogicalAddress;
 		this->sourceSpaceWireAddress = sourceSpaceWireAddress;
 		this->maximumSegmentSize = DefaultMaximumSegmentSize;
+		this->requestedSegmentSize = DefaultMaximumSegmentSize;
 		this->initializeCounters();
 		this->prepareSpaceWireRPacketInstances();
 		this->start();
@@ -79,6 +75,12 @@ private:
 
 private:
 	uint8_t maximumAcceptableSequenceNumber;
+
+private:
+	/** Segment size set by user. This is proposed in the Open command, and
+	 * maximumSegmentSize is set to the value accepted by ReceiveTEP.
+	 */
+	size_t requestedSegmentSize;
 	/* --------------------------------------------- */
 
 private:
@@ -93,9 +95,7 @@ private:
 public:
 	void open(double timeoutDrationInMilliSec = DefaultTimeoutDurationInMilliSec) throw (SpaceWireRTEPException) {
 		using namespace std;
-#ifdef DebugSpaceWireRTransmitTEP
-		cout << "SpaceWireRTransmitTEP::open()" << endl;
-#endif
+		SpaceWireRTraceDebug(SpaceWireRTraceCategory::TransmitTEP, "SpaceWireRTransmitTEP::open()");
 		openCommandAcknowledged = false;
 		closeCommandAcknowledged = false;
 		if (this->state == SpaceWireRTEPState::Closed) {
@@ -105,6 +105,8 @@ public:
 		}
 		this->sequenceNumber = 0;
 		this->nOfOutstandingPackets = 0;
+		this->slidingWindowSize = requestedSlidingWindowSize;
+		this->maximumSegmentSize = requestedSegmentSize;
 		this->state = SpaceWireRTEPState::Enabled;
 		initializeRetryCounts();
 		registerMeToSpaceWireREngine();
@@ -172,36 +174,31 @@ private:
 private:
 	void consumeReceivedPackets() {
 		using namespace std;
-		while (receivedPackets.size() != 0) {
-#ifdef DebugSpaceWireRTransmitTEP
-			cout << "SpaceWireRTransmitTEP::consumeReceivedPackets() process one packet." << endl;
-#endif
+		while (!receivedPackets.isEmpty()) {
+			SpaceWireRTraceDebug(SpaceWireRTraceCategory::TransmitTEP,
+					"SpaceWireRTransmitTEP::consumeReceivedPackets() process one packet.");
 			SpaceWireRPacket* packet = this->popReceivedSpaceWireRPacket();
 			if (packet->isHeartBeatPacketType()) {
-#ifdef DebugSpaceWireRTransmitTEP
-				cout << "SpaceWireRTransmitTEP::consumeReceivedPackets() HeartBeat packet received." << endl;
-#endif
+				SpaceWireRTraceDebug(SpaceWireRTraceCategory::TransmitTEP,
+						"SpaceWireRTransmitTEP::consumeReceivedPackets() HeartBeat packet received.");
 				processHeartBeatPacket(packet);
 				delete packet;
 				continue;
 			} else if (packet->isFlowControlPacket()) {
-#ifdef DebugSpaceWireRTransmitTEP
-				cout << "SpaceWireRTransmitTEP::consumeReceivedPackets() FlowControl packet received." << endl;
-#endif
+				SpaceWireRTraceDebug(SpaceWireRTraceCategory::TransmitTEP,
+						"SpaceWireRTransmitTEP::consumeReceivedPackets() FlowControl packet received.");
 				processFlowControlPacket(packet);
 				delete packet;
 				continue;
 			} else if (packet->isAckPacket()) {
-#ifdef DebugSpaceWireRTransmitTEP
-				cout << "SpaceWireRTransmitTEP::consumeReceivedPackets() Ack packet received." << endl;
-#endif
+				SpaceWireRTraceDebug(SpaceWireRTraceCategory::TransmitTEP,
+						"SpaceWireRTransmitTEP::consumeReceivedPackets() Ack packet received.");
 				processAckPacket(packet);
 				delete packet;
 				continue;
 			} else {
-#ifdef DebugSpaceWireRTransmitTEP
-				cout << "SpaceWireRTransmitTEP::consumeReceivedPackets() invalid packet. Stops this TEP." << endl;
-#endif
+				SpaceWireRTraceDebug(SpaceWireRTraceCategory::TransmitTEP,
+						"SpaceWireRTransmitTEP::consumeReceivedPackets() invalid packet. Stops this TEP.");
 				malfunctioningTransportChannel();
 				delete packet;
 				return;
@@ -230,17 +227,18 @@ public:
 
 			case SpaceWireRTEPState::Open:
 				while (this->state == SpaceWireRTEPState::Open && !stopped) {
-					if (receivedPackets.size() != 0) {
+					if (!receivedPackets.isEmpty()) {
 						consumeReceivedPackets();
 					}
-					if (SpaceWireRTEPState::Open) {
-						packetArrivalNotifier.wait(WaitDurationForPacketReceiveLoop);
-						if (receivedPackets.size() == 0) {
+					//returns immediately if packets have arrived during consumeReceivedPackets()
+					if (receivedPackets.isEmpty()) {
+						waitForReceivedPacket(WaitDurationForPacketReceiveLoop);
+						if (receivedPackets.isEmpty()) {
 							//increment sendTimeoutCounter
 							sendTimeoutCounter += WaitDurationForPacketReceiveLoop;
 						}
-						conditionForSendWait.signal();
 					}
+					conditionForSendWait.signal();
 				}
 				break;
 
@@ -258,10 +256,22 @@ public:
 	/** Sets segment size.
 	 * @param[in] size segment size
 	 */
-	inline void setSegmentSize(size_t size) {
+	inline void setSegmentSize(size_t size) throw (SpaceWireRTEPException) {
+		if (size == 0 || SpaceWireRProtocol::MaximumSegmentSize < size) {
+			throw SpaceWireRTEPException(SpaceWireRTEPException::InvalidParameter);
+		}
+		this->requestedSegmentSize = size;
 		this->maximumSegmentSize = size;
 	}
 
+public:
+	/** Returns the segment size currently used.
+	 * After open(), this is the size accepted by ReceiveTEP.
+	 */
+	inline size_t getSegmentSize() const {
+		return maximumSegmentSize;
+	}
+
 private:
 	/** Processes a received FlowControl packet.
 	 * MASN will be updated by retrieving the value contained in the
@@ -269,9 +279,8 @@ private:
 	 */
 	void processFlowControlPacket(SpaceWireRPacket* packet){
 		using namespace std;
-#ifdef DebugSpaceWireRTransmitTEP
-		cout << "SpaceWireRTransmitTEP::processFlowControlPacket() entered." << endl;
-#endif
+		SpaceWireRTraceDebug(SpaceWireRTraceCategory::TransmitTEP,
+				"SpaceWireRTransmitTEP::processFlowControlPacket() entered.");
 		nReceivedFlowControlPackets++;
 
 		updateMaximumAcceptableSequenceNumber(packet);
@@ -286,20 +295,18 @@ private:
 		flowControlPacket->constructAckForPacket(packet);
 
 		try {
-#ifdef DebugSpaceWireRTransmitTEP
-			cout << "SpaceWireRTransmitTEP::processFlowControlPacket() replying FlowControlAck for sequence number = "
-					<< (uint32_t) flowControlPacket->getSequenceNumber() << endl;
-#endif
+			SpaceWireRTraceDebug(SpaceWireRTraceCategory::TransmitTEP,
+					"SpaceWireRTransmitTEP::processFlowControlPacket() replying FlowControlAck for sequence number = {}",
+					flowControlPacket->getSequenceNumber());
 
 			//todo: inject CRC error
 
 			spwREngine->sendPacket(flowControlPacket);
 			nTransmittedFlowControlPackets++;
 
-#ifdef DebugSpaceWireRTransmitTEP
-			cout << "SpaceWireRTransmitTEP::processFlowControlPacket() FlowControlAck packet for sequence number = "
-					<< (uint32_t) flowControlPacket->getSequenceNumber() << " has been sent." << endl;
-#endif
+			SpaceWireRTraceDebug(SpaceWireRTraceCategory::TransmitTEP,
+					"SpaceWireRTransmitTEP::processFlowControlPacket() FlowControlAck packet for sequence number = {} has been sent.",
+					flowControlPacket->getSequenceNumber());
 		} catch (...) {
 			malfunctioningSpaceWireIF();
 		}
@@ -314,36 +321,32 @@ private:
 	void processHeartBeatPacket(SpaceWireRPacket* packet) {
 		using namespace std;
 		nReceivedHeartBeatPackets++;
-#ifdef DebugSpaceWireRTransmitTEP
-		cout << "SpaceWireRTransmitTEP::processHeartBeatPacket() nHeartBeat = " << nReceivedHeartBeatPackets
-				<< " sequence number = " << (uint32_t) packet->getSequenceNumber() << endl;
-#endif
+		SpaceWireRTraceDebug(SpaceWireRTraceCategory::TransmitTEP,
+				"SpaceWireRTransmitTEP::processHeartBeatPacket() nHeartBeat = {} sequence number = {}",
+				nReceivedHeartBeatPackets, packet->getSequenceNumber());
 
 		//return if response to received HeartBeat packets are disabled
 		if (!shouldRespondToReceivedHeartBeatPacket()) {
-#ifdef DebugSpaceWireRTransmitTEP
-			cout << "SpaceWireRTransmitTEP::processHeartBeatPacket() nHeartBeat = " << nReceivedHeartBeatPackets
-					<< " does not reply HeartBeatAck." << endl;
-#endif
+			SpaceWireRTraceDebug(SpaceWireRTraceCategory::TransmitTEP,
+					"SpaceWireRTransmitTEP::processHeartBeatPacket() nHeartBeat = {} does not reply HeartBeatAck.",
+					nReceivedHeartBeatPackets);
 			return;
 		}
 
 		heartBeatAckPacket->constructAckForPacket(packet);
 		try {
-#ifdef DebugSpaceWireRTransmitTEP
-			cout << "SpaceWireRTransmitTEP::processHeartBeatPacket() replying HeartBeatAck for sequence number = "
-					<< (uint32_t) heartBeatAckPacket->getSequenceNumber() << endl;
-#endif
+			SpaceWireRTraceDebug(SpaceWireRTraceCategory::TransmitTEP,
+					"SpaceWireRTransmitTEP::processHeartBeatPacket() replying HeartBeatAck for sequence number = {}",
+					heartBeatAckPacket->getSequenceNumber());
 
 			//todo: inject CRC error
 
 			spwREngine->sendPacket(heartBeatAckPacket);
 			nTransmittedHeartBeatAckPackets++;
 
-#ifdef DebugSpaceWireRTransmitTEP
-			cout << "SpaceWireRTransmitTEP::processHeartBeatPacket() HeartBeatAck for sequence number = "
-					<< (uint32_t) heartBeatAckPacket->getSequenceNumber() << " has been sent." << endl;
-#endif
+			SpaceWireRTraceDebug(SpaceWireRTraceCategory::TransmitTEP,
+					"SpaceWireRTransmitTEP::processHeartBeatPacket() HeartBeatAck for sequence number = {} has been sent.",
+					heartBeatAckPacket->getSequenceNumber());
 		} catch (...) {
 			malfunctioningSpaceWireIF();
 		}
@@ -355,16 +358,16 @@ private:
 	 */
 	void processAckPacket(SpaceWireRPacket* packet) {
 		using namespace std;
-#ifdef DebugSpaceWireRTransmitTEP
-		cout << "SpaceWireRTransmitTEP::processAckPacket() sequence number = " << (uint32_t) packet->getSequenceNumber()
-				<< endl;
-#endif
+		SpaceWireRTraceDebug(SpaceWireRTraceCategory::TransmitTEP,
+				"SpaceWireRTransmitTEP::processAckPacket() sequence number = {}",
+				packet->getSequenceNumber());
 		uint8_t sequenceNumberOfThisPacket = packet->getSequenceNumber();
 		if (packetHasBeenSent[sequenceNumberOfThisPacket] == true) {
 			packetWasAcknowledged[sequenceNumberOfThisPacket] = true;
 			decrementNOfOutstandingPackets();
 		}
 		if (packet->isControlAckPacket() && slidingWindowBuffer[sequenceNumberOfThisPacket]->isControlPacketOpenCommand()) {
+			adoptOpenParameters(packet);
 			openCommandAcknowledged = true;
 		}
 		if (packet->isControlAckPacket()
@@ -380,6 +383,27 @@ private:
 		slideSlidingWindow();
 	}
 
+private:
+	/** Sets sliding window size and segment size to the values accepted by ReceiveTEP.
+	 * The parameters follow MASN in the Open Ack payload when flow control is enabled.
+	 * A ReceiveTEP which does not support the negotiation replies without parameters, and
+	 * then the default window size (which such a ReceiveTEP uses) is used.
+	 */
+	void adoptOpenParameters(SpaceWireRPacket* ackPacket) {
+		size_t offset = (this->isFlowControlEnabled()) ? 1 : 0;
+		size_t windowSize = std::min(requestedSlidingWindowSize, (size_t) DefaultSlidingWindowSize);
+		size_t segmentSize = requestedSegmentSize;
+		if (offset < ackPacket->getPayloadSize()) {
+			decodeOpenParameters(ackPacket->getPayloadAddress() + offset, ackPacket->getPayloadSize() - offset,
+					windowSize, segmentSize);
+		}
+		this->slidingWindowSize = std::min(windowSize, requestedSlidingWindowSize);
+		this->maximumSegmentSize = std::min(segmentSize, requestedSegmentSize);
+		SpaceWireRTraceInfo(SpaceWireRTraceCategory::TransmitTEP,
+				"SpaceWireRTransmitTEP::adoptOpenParameters() slidingWindowSize={} segmentSize={}",
+				this->slidingWindowSize, this->maximumSegmentSize);
+	}
+
 private:
 	void sendPacket(SpaceWireRPacket* packet, double timeoutDuration = DefaultTimeoutDurationInMs/*ms*/)
 			throw (SpaceWireRTEPException) {
@@ -389,17 +413,32 @@ private:
 public:
 	void send(std::vector<uint8_t>* data, double timeoutDuration = DefaultTimeoutDurationInMs)
 			throw (SpaceWireRTEPException) {
+		if (data->size() == 0) {
+			send((uint8_t*) NULL, 0, timeoutDuration);
+		} else {
+			send(&(data->at(0)), data->size(), timeoutDuration);
+		}
+	}
+
+public:
+	/** Sends application data (SDU).
+	 * Segments reference the memory region specified by the arguments instead of
+	 * copying it, and therefore the data should not be modified until this method returns.
+	 * The references are released before this method returns or throws an exception.
+	 * @param[in] data pointer to the application data
+	 * @param[in] dataSize size of the application data in bytes
+	 * @param[in] timeoutDuration timeout duration in millisecond
+	 */
+	void send(uint8_t* data, size_t dataSize, double timeoutDuration = DefaultTimeoutDurationInMs)
+			throw (SpaceWireRTEPException) {
 		using namespace std;
-#ifdef DebugSpaceWireRTransmitTEP
-		cout << "SpaceWireRTransmitTEP::send() entered." << endl;
-#endif
+		SpaceWireRTraceDebug(SpaceWireRTraceCategory::TransmitTEP, "SpaceWireRTransmitTEP::send() entered.");
 		sendMutex.lock();
 		this->heartBeatTimer->resetHeartBeatTimer();
 		sendTimeoutCounter = 0;
 		nOfOutstandingPackets = 0;
 		//slideSlidingWindow();
 		//sequenceNumber = this->getSlidingWindowFrom();
-		size_t dataSize = data->size();
 		size_t remainingSize = dataSize;
 		size_t payloadSize;
 		size_t index = 0;
@@ -410,6 +449,7 @@ public:
 			if (sendTimeoutCounter > timeoutDuration) {
 				cout << "sendTimeoutCounter = " << dec << sendTimeoutCounter << "  timeoutDuration=" << timeoutDuration << endl;
 				//timeout occurs
+				releasePayloadReferences();
 				malfunctioningTransportChannel();
 				sendMutex.unlock();
 				throw SpaceWireRTEPException(SpaceWireRTEPException::Timeout);
@@ -440,20 +480,18 @@ public:
 
 			//configure SpaceWireRPacket instance
 			if (isFirst) {
-#ifdef DebugSpaceWireRTransmitTEP
-				cout << "SpaceWireRTransmitTEP::send() setting the FirstSegment flag." << endl;
-#endif
+				SpaceWireRTraceDebug(SpaceWireRTraceCategory::TransmitTEP,
+						"SpaceWireRTransmitTEP::send() setting the FirstSegment flag.");
 				packet->setFirstSegmentFlag();
 				isFirst = false;
 			} else {
-#ifdef DebugSpaceWireRTransmitTEP
-				cout << "SpaceWireRTransmitTEP::send() setting the ContinuedSegment flag." << endl;
-#endif
+				SpaceWireRTraceDebug(SpaceWireRTraceCategory::TransmitTEP,
+						"SpaceWireRTransmitTEP::send() setting the ContinuedSegment flag.");
 				packet->setContinuedSegmentFlag();
 			}
 			packet->setSequenceNumber(sequenceNumber);
 			packet->setDataPacketFlag();
-			packet->setPayload(data, index, payloadSize);
+			packet->setPayloadReference(data + index, payloadSize);
 
 			//update counters
 			remainingSize -= payloadSize;
@@ -470,30 +508,27 @@ public:
 			//set LastFlag/CompleteSegment if necessary
 			if (remainingSize == 0) {
 				if (nSegmentation == 1) {
-#ifdef DebugSpaceWireRTransmitTEP
-					cout << "SpaceWireRTransmitTEP::send() setting the CompleteSement flag." << endl;
-#endif
+					SpaceWireRTraceDebug(SpaceWireRTraceCategory::TransmitTEP,
+							"SpaceWireRTransmitTEP::send() setting the CompleteSement flag.");
 					packet->setCompleteSegmentFlag();
 				} else {
-#ifdef DebugSpaceWireRTransmitTEP
-					cout << "SpaceWireRTransmitTEP::send() setting the LastSegment flag. " << endl;
-#endif
+					SpaceWireRTraceDebug(SpaceWireRTraceCategory::TransmitTEP,
+							"SpaceWireRTransmitTEP::send() setting the LastSegment flag.");
 					packet->setLastSegmentFlag();
 				}
 			}
 
 			//send segment
 			try {
-#ifdef DebugSpaceWireRTransmitTEP
-				cout << "SpaceWireRTransmitTEP::send() sending a segment sequence number="
-						<< packet->getSequenceNumberAs32bitInteger() << " " << packet->getSequenceFlagsAsString() << endl;
-				cout << packet->toString() << endl;
-#endif
+				SpaceWireRTraceDebug(SpaceWireRTraceCategory::TransmitTEP,
+						"SpaceWireRTransmitTEP::send() sending a segment sequence number={} flags={}",
+						packet->getSequenceNumberAs32bitInteger(), packet->getSequenceFlags());
 				spwREngine->sendPacket(packet);
 				nSentSegments++;
 				packetHasBeenSent[packet->getSequenceNumber()] = true;
 				//slidingWindowBuffer[packet->getSequenceNumber()] = packet;
 			} catch (...) {
+				releasePayloadReferences();
 				sendMutex.unlock();
 				this->malfunctioningSpaceWireIF();
 				throw SpaceWireRTEPException(SpaceWireRTEPException::SpaceWireIFIsNotWorking);
@@ -501,20 +536,31 @@ public:
 		}
 
 		//check all sent packets were acknowledged
-#ifdef DebugSpaceWireRTransmitTEP
-		cout << "SpaceWireRTransmitTEP::send() all segments were sent. Wait until acknowledged." << endl;
-#endif
+		SpaceWireRTraceDebug(SpaceWireRTraceCategory::TransmitTEP,
+				"SpaceWireRTransmitTEP::send() all segments were sent. Wait until acknowledged.");
 
 		while (!allOngoingPacketesWereAcknowledged()) {
 			checkRetryTimerThenRetry();
 			conditionForSendWait.wait(DefaultWaitDurationInMsForCompletionCheck);
 		}
+		releasePayloadReferences();
 		nSentUserData++;
-		nSentUserDataInBytes += data->size();
+		nSentUserDataInBytes += dataSize;
 		sendMutex.unlock();
-#ifdef DebugSpaceWireRTransmitTEP
-		cout << "SpaceWireRTransmitTEP::send() Completed." << endl;
-#endif
+		SpaceWireRTraceDebug(SpaceWireRTraceCategory::TransmitTEP, "SpaceWireRTransmitTEP::send() Completed.");
+	}
+
+private:
+	/** Detaches segments in the sliding window from the application data passed to send().
+	 * This is called on every exit from send() so that no segment keeps referring to
+	 * memory which the caller may release after send() returned or threw.
+	 */
+	void releasePayloadReferences() {
+		for (size_t i = 0; i < slidingWindowBuffer.size(); i++) {
+			if (slidingWindowBuffer[i] != NULL && slidingWindowBuffer[i]->isPayloadReferenced()) {
+				slidingWindowBuffer[i]->clearPayload();
+			}
+		}
 	}
 
 private:
@@ -524,9 +570,8 @@ private:
 private:
 	void sequenceNumberLaps() {
 		using namespace std;
-#ifdef DebugSpaceWireRTransmitTEP
-		cout << "SpaceWireRTransmitTEP::sequenceNumberLaps() entered." << endl;
-#endif
+		SpaceWireRTraceDebug(SpaceWireRTraceCategory::TransmitTEP,
+				"SpaceWireRTransmitTEP::sequenceNumberLaps() entered.");
 		masnGuardBit_mutex.lock();
 		masnGuardBit_true_if_MASNLapped_SNNotLappedYet = !masnGuardBit_true_if_MASNLapped_SNNotLappedYet;
 		masnGuardBit_mutex.unlock();
@@ -535,9 +580,7 @@ private:
 private:
 	void masnLaps() {
 		using namespace std;
-#ifdef DebugSpaceWireRTransmitTEP
-		cout << "SpaceWireRTransmitTEP::masnLaps() entered." << endl;
-#endif
+		SpaceWireRTraceDebug(SpaceWireRTraceCategory::TransmitTEP, "SpaceWireRTransmitTEP::masnLaps() entered.");
 		masnGuardBit_mutex.lock();
 		masnGuardBit_true_if_MASNLapped_SNNotLappedYet = !masnGuardBit_true_if_MASNLapped_SNNotLappedYet;
 		masnGuardBit_mutex.unlock();
@@ -548,26 +591,21 @@ private:
 		uint8_t n = sequenceNumber;
 		uint8_t masn = maximumAcceptableSequenceNumber;
 		using namespace std;
-#ifdef DebugSpaceWireRTransmitTEP
-		cout << "SpaceWireRTransmitTEP::masnAllowsToSend() sequenceNumber=" << dec << (uint32_t) n << " MASN="
-				<< (uint32_t) masn << " Lap=" << ((masnGuardBit_true_if_MASNLapped_SNNotLappedYet) ? "true" : "false") << " ."
-				<< endl;
-#endif
+		SpaceWireRTraceDebug(SpaceWireRTraceCategory::TransmitTEP,
+				"SpaceWireRTransmitTEP::masnAllowsToSend() sequenceNumber={} MASN={} Lap={} .",
+				n, masn, masnGuardBit_true_if_MASNLapped_SNNotLappedYet);
 		if (masnGuardBit_true_if_MASNLapped_SNNotLappedYet) {
-#ifdef DebugSpaceWireRTransmitTEP
-			cout << "SpaceWireRTransmitTEP::masnAllowsToSend() true." << endl;
-#endif
+			SpaceWireRTraceDebug(SpaceWireRTraceCategory::TransmitTEP,
+					"SpaceWireRTransmitTEP::masnAllowsToSend() true.");
 			return true; //can send packet since masn is larger than n.
 		} else {
 			if (n <= masn) {
-#ifdef DebugSpaceWireRTransmitTEP
-				cout << "SpaceWireRTransmitTEP::masnAllowsToSend() true." << endl;
-#endif
+				SpaceWireRTraceDebug(SpaceWireRTraceCategory::TransmitTEP,
+						"SpaceWireRTransmitTEP::masnAllowsToSend() true.");
 				return true; //can send packet since masn is larger than n.
 			} else {
-#ifdef DebugSpaceWireRTransmitTEP
-				cout << "SpaceWireRTransmitTEP::masnAllowsToSend() false." << endl;
-#endif
+				SpaceWireRTraceDebug(SpaceWireRTraceCategory::TransmitTEP,
+						"SpaceWireRTransmitTEP::masnAllowsToSend() false.");
 				return false; //should wait until masn becomes larger than n
 			}
 		}
@@ -581,9 +619,7 @@ private:
 private:
 	void sendOpenCommand() throw (SpaceWireRTEPException) {
 		using namespace std;
-#ifdef DebugSpaceWireRTransmitTEP
-		cout << "SpaceWireRTransmitTEP::sendOpenCommand()" << endl;
-#endif
+		SpaceWireRTraceDebug(SpaceWireRTraceCategory::TransmitTEP, "SpaceWireRTransmitTEP::sendOpenCommand()");
 
 		//initialize
 		initializeRetryCounts();
@@ -592,9 +628,8 @@ private:
 		SpaceWireRPacket* packet = slidingWindowBuffer[0];
 		nOfOutstandingPackets++;
 		if (packet == NULL) {
-#ifdef DebugSpaceWireRTransmitTEP
-			cout << "SpaceWireRTransmitTEP::sendOpenCommand() no packet instance available." << endl;
-#endif
+			SpaceWireRTraceDebug(SpaceWireRTraceCategory::TransmitTEP,
+					"SpaceWireRTransmitTEP::sendOpenCommand() no packet instance available.");
 			malfunctioningTransportChannel();
 		}
 
@@ -604,18 +639,19 @@ private:
 		//set packet type
 		packet->setPacketType(SpaceWireRPacketType::ControlPacketOpenCommand);
 
-		//set payload length
-		packet->setPayloadLength(0x00);
+		//set payload (proposed sliding window size and segment size)
+		uint8_t parameters[SpaceWireRProtocol::SizeOfOpenParameters];
+		encodeOpenParameters(requestedSlidingWindowSize, requestedSegmentSize, parameters);
+		packet->setPayload(parameters, SpaceWireRProtocol::SizeOfOpenParameters);
 
 		//set sequence number
 		packet->setSequenceNumber(0x00);
 		this->sequenceNumber = 0;
 		openCommandAcknowledged = false;
 		while (!openCommandAcknowledged) {
-#ifdef DebugSpaceWireRTransmitTEP
-			cout << "SpaceWireRTransmitTEP::sendOpenCommand() Sending open command." << endl;
-			cout << packet->toString() << endl;
-#endif
+			SpaceWireRTraceDebug(SpaceWireRTraceCategory::TransmitTEP,
+					"SpaceWireRTransmitTEP::sendOpenCommand() Sending open command. sequence number={}",
+					packet->getSequenceNumber());
 			//send
 			spwREngine->sendPacket(packet);
 			packetHasBeenSent[sequenceNumber] = true;
@@ -643,8 +679,8 @@ private:
 		//set packet type
 		packet->setPacketType(SpaceWireRPacketType::ControlPacketCloseCommand);
 
-		//set payload length
-		packet->setPayloadLength(0x00);
+		//clear payload (the packet instance may still hold a data segment)
+		packet->clearPayload();
 
 		//set sequence number
 		packet->setSequenceNumber(0x00);
@@ -667,11 +703,10 @@ private:
 public:
 	void updateMaximumAcceptableSequenceNumber(SpaceWireRPacket* packet) {
 		using namespace std;
-#ifdef DebugSpaceWireRTransmitTEP
-		cout << "SpaceWireRTransmitTEP::updateMaximumAcceptableSequenceNumber() entered." << endl;
-#endif
-		if (packet->getPayloadLength() != 1 && packet->getPayload()->size() != 1) {
-			//MASM should be one octet.
+		SpaceWireRTraceDebug(SpaceWireRTraceCategory::TransmitTEP,
+				"SpaceWireRTransmitTEP::updateMaximumAcceptableSequenceNumber() entered.");
+		if (packet->getPayloadLength() < 1 || packet->getPayloadSize() < 1) {
+			//MASN should be one octet (Open Ack may carry Open parameters after MASN).
 			malfunctioningTransportChannel();
 		}
 
@@ -679,10 +714,9 @@ public:
 		if (newMASN < maximumAcceptableSequenceNumber) {
 			masnLaps();
 		}
-#ifdef DebugSpaceWireRTransmitTEP
-		cout << "SpaceWireRTransmitTEP::updateMaximumAcceptableSequenceNumber() currentMASN="
-				<< (uint32_t) maximumAcceptableSequenceNumber << " newMASN=" << (uint32_t) newMASN << endl;
-#endif
+		SpaceWireRTraceDebug(SpaceWireRTraceCategory::TransmitTEP,
+				"SpaceWireRTransmitTEP::updateMaximumAcceptableSequenceNumber() currentMASN={} newMASN={}",
+				maximumAcceptableSequenceNumber, newMASN);
 		maximumAcceptableSequenceNumber = newMASN;
 	}
 
@@ -695,9 +729,12 @@ public:
 		ss << "State                : " << SpaceWireRTEPState::toString(this->state) << endl;
 		ss << "slidingWindowFrom    : " << dec << (uint32_t) this->slidingWindowFrom << endl;
 		ss << "slidingWindowSize    : " << dec << (uint32_t) this->slidingWindowSize << endl;
+		ss << "segmentSize          : " << dec << this->maximumSegmentSize << endl;
 		ss << "nOfOutstandingPckts  : " << dec << (uint32_t) this->nOfOutstandingPackets << endl;
 		ss << "MASN                 : " << dec << (uint32_t) this->maximumAcceptableSequenceNumber << endl;
 		ss << "receivedPackets.size : " << dec << receivedPackets.size() << endl;
+		ss << "nRcvdPcktQueueFull   : " << dec << getNReceivedPacketQueueFull() << endl;
+		ss << "nDroppedRcvdPackets  : " << dec << getNDroppedReceivedPackets() << endl;
 		ss << "Counters:" << endl;
 		ss << "nSentUserData        : " << dec << nSentUserData << endl;
 		ss << "nSentUserDataInBytes : " << dec << nSentUserDataInBytes / 1024 << "kB" << endl;
@@ -36,11 +36,24 @@
 #include <vector>
 
 class SpaceWireRUtilities {
-private:
+public:
 	static const uint16_t CRC_INIT_VAL = 0xFFFFU;
 
 public:
 	static uint16_t calculateCRCForArray(uint8_t* data, size_t length) {
+		return updateCRCForArray(CRC_INIT_VAL, data, length);
+	}
+
+public:
+	/** Continues CRC calculation from the specified intermediate value.
+	 * This is used to calculate a CRC over data scattered in multiple
+	 * memory regions (e.g. header and payload) without concatenating them.
+	 * @param[in] crc intermediate CRC value (CRC_INIT_VAL for the first region)
+	 * @param[in] data pointer to the data
+	 * @param[in] length length of the data
+	 * @return updated CRC value
+	 */
+	static uint16_t updateCRCForArray(uint16_t crc, uint8_t* data, size_t length) {
 		static const uint16_t CRC16Table[] = { 0x00, 0x1021, 0x2042, 0x3063, 0x4084, 0x50a5, 0x60c6, 0x70e7, 0x8108, 0x9129,
 				0xa14a, 0xb16b, 0xc18c, 0xd1ad, 0xe1ce, 0xf1ef, 0x1231, 0x210, 0x3273, 0x2252, 0x52b5, 0x4294, 0x72f7, 0x62d6,
 				0x9339, 0x8318, 0xb37b, 0xa35a, 0xd3bd, 0xc39c, 0xf3ff, 0xe3de, 0x2462, 0x3443, 0x420, 0x1401, 0x64e6, 0x74c7,
@@ -61,7 +74,7 @@ public:
 				0x5c64, 0x4c45, 0x3ca2, 0x2c83, 0x1ce0, 0xcc1, 0xef1f, 0xff3e, 0xcf5d, 0xdf7c, 0xaf9b, 0xbfba, 0x8fd9, 0x9ff8,
 				0x6e17, 0x7e36, 0x4e55, 0x5e74, 0x2e93, 0x3eb2, 0xed1, 0x1ef0 };
 
-		uint16_t result = CRC_INIT_VAL;
+		uint16_t result = crc;
 		for (size_t i = 0; i < length; i++) {
 			result = (result << 8) ^ CRC16Table[(uint8_t) (result >> 8) ^ *data++];
 		}
@@ -246,6 +246,57 @@ public:
 		sendmutex.unlock();
 	}
 
+public:
+	/** Sends a SpaceWire packet which is scattered over multiple memory regions.
+	 * The SSDTP header and the regions are assembled in the send buffer so that
+	 * the packet is written to the TCP socket with a single send call.
+	 * This is a blocking method.
+	 * @param[in] iovecs memory regions which constitute the packet.
+	 * @param[in] nIOVecs number of entries in iovecs.
+	 * @param[in] eopType End-of-Packet marker. SpaceWireEOPMarker::EOP or SpaceWireEOPMarker::EEP.
+	 */
+	void send(struct iovec* iovecs, size_t nIOVecs, uint32_t eopType = SpaceWireEOPMarker::EOP)
+			throw (SpaceWireSSDTPException) {
+		sendmutex.lock();
+		if (this->closed) {
+			sendmutex.unlock();
+			return;
+		}
+		size_t length = 0;
+		for (size_t i = 0; i < nIOVecs; i++) {
+			length += iovecs[i].iov_len;
+		}
+		if (length + 12 > BufferSize) {
+			sendmutex.unlock();
+			throw SpaceWireSSDTPException(SpaceWireSSDTPException::DataSizeTooLarge);
+		}
+		if (eopType == SpaceWireEOPMarker::EOP) {
+			sendbuffer[0] = DataFlag_Complete_EOP;
+		} else if (eopType == SpaceWireEOPMarker::EEP) {
+			sendbuffer[0] = DataFlag_Complete_EEP;
+		} else if (eopType == SpaceWireEOPMarker::Continued) {
+			sendbuffer[0] = DataFlag_Flagmented;
+		}
+		sendbuffer[1] = 0x00;
+		size_t asize = length;
+		for (size_t i = 11; i > 1; i--) {
+			sendbuffer[i] = asize % 0x100;
+			asize = asize / 0x100;
+		}
+		size_t index = 12;
+		for (size_t i = 0; i < nIOVecs; i++) {
+			memcpy(sendbuffer + index, iovecs[i].iov_base, iovecs[i].iov_len);
+			index += iovecs[i].iov_len;
+		}
+		try {
+			datasocket->send(sendbuffer, index);
+		} catch (...) {
+			sendmutex.unlock();
+			throw SpaceWireSSDTPException(SpaceWireSSDTPException::Disconnected);
+		}
+		sendmutex.unlock();
+	}
+
 public:
 	/** Tries to receive a pcket from the SpaceWire interface.
 	 * This method will block the thread for a certain length of time.
@@ -73,10 +73,7 @@ public:
 	/** Concatenates two std::vector<uint8_t> instances creating new instance.
 	 */
 	static void concatenateTo(std::vector<uint8_t>& array1, std::vector<uint8_t>& array2) {
-		using namespace std;
-		for (size_t i = 0; i < array2.size(); i++) {
-			array1.push_back(array2[i]);
-		}
+		array1.insert(array1.end(), array2.begin(), array2.end());
 	}
 
 public:
@@ -0,0 +1,158 @@
+/*
+ * test_RMAPAddressMap.cc
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+/* Tests RMAPAddressMap via RMAPTarget.
+ * - overlapping ranges: lookups agree with the linear search over registered ranges
+ *   (the first registered range which contains the accessed range wins)
+ * - priority order: nested and partially overlapping ranges, and accesses crossing segment boundaries
+ * - add/remove: a new map is published, and a map obtained earlier stays unchanged
+ * - lookup time when a wide range at the start of the address space overlaps many small ranges
+ *
+ * Usage: test_RMAPAddressMap [nRanges]
+ */
+
+#include "SpaceWireRMAPLibrary/SpaceWire.hh"
+#include "SpaceWireRMAPLibrary/RMAP.hh"
+
+#include <chrono>
+#include <random>
+
+class NumberedAction: public RMAPTargetAccessAction {
+public:
+	size_t number;
+
+public:
+	NumberedAction(size_t number) :
+			number(number) {
+	}
+
+public:
+	void processTransaction(RMAPTransaction* rmapTransaction) throw (RMAPTargetAccessActionException) {
+	}
+};
+
+/** Registers ranges to an RMAPTarget and keeps them for the linear search. */
+class RegisteredRanges {
+public:
+	RMAPTarget target;
+	std::vector<std::pair<RMAPAddressRange*, NumberedAction*> > rangesAndActions;
+
+public:
+	NumberedAction* add(uint32_t addressFrom, uint32_t addressTo) {
+		RMAPAddressRange* addressRange = new RMAPAddressRange(addressFrom, addressTo);
+		NumberedAction* action = new NumberedAction(rangesAndActions.size());
+		target.addAddressRangeAndAssociatedAction(addressRange, action);
+		rangesAndActions.push_back(std::make_pair(addressRange, action));
+		return action;
+	}
+
+public:
+	RMAPTargetAccessAction* findLinearly(uint32_t addressFrom, uint32_t addressTo) {
+		RMAPAddressRange accessedRange(addressFrom, addressTo);
+		for (auto& rangeAndAction : rangesAndActions) {
+			if (rangeAndAction.first->contains(accessedRange)) {
+				return rangeAndAction.second;
+			}
+		}
+		return NULL;
+	}
+};
+
+int main(int argc, char* argv[]) {
+	using namespace std;
+	size_t nRanges = 10000;
+	if (argc > 1) {
+		nRanges = atoi(argv[1]);
+	}
+	size_t nErrors = 0;
+
+	//overlapping ranges compared with the linear search
+	std::mt19937 random(1);
+	size_t nMismatches = 0;
+	for (size_t trial = 0; trial < 200; trial++) {
+		RegisteredRanges ranges;
+		size_t n = 1 + random() % 30;
+		for (size_t i = 0; i < n; i++) {
+			uint32_t addressFrom = random() % 1000;
+			ranges.add(addressFrom, addressFrom + random() % 200);
+		}
+		std::shared_ptr<const RMAPAddressMap> addressMap = ranges.target.getAddressMap();
+		for (size_t i = 0; i < 2000; i++) {
+			uint32_t addressFrom = random() % 1300;
+			uint32_t addressTo = addressFrom + random() % 50;
+			if (addressMap->find(addressFrom, addressTo) != ranges.findLinearly(addressFrom, addressTo)) {
+				nMismatches++;
+			}
+		}
+	}
+	cout << "Overlapping ranges: " << nMismatches << " mismatches with the linear search" << endl;
+	if (nMismatches != 0) {
+		nErrors++;
+	}
+
+	//priority order
+	RegisteredRanges ranges;
+	NumberedAction* inner = ranges.add(0x100, 0x1ff);
+	NumberedAction* outer = ranges.add(0x000, 0xfff);
+	NumberedAction* partial = ranges.add(0xf80, 0x10ff);
+	NumberedAction* top = ranges.add(0xfffffff0, 0xffffffff);
+	std::shared_ptr<const RMAPAddressMap> addressMap = ranges.target.getAddressMap();
+	//inner is registered before outer; accesses crossing the end of inner or outer fall to the next range
+	if (addressMap->find(0x100, 0x1ff) != inner || addressMap->find(0x1f0, 0x20f) != outer
+			|| addressMap->find(0xf80, 0xfff) != outer || addressMap->find(0xff0, 0x100f) != partial
+			|| addressMap->find(0x1000, 0x1003) != partial || addressMap->find(0x10f0, 0x1100) != NULL
+			|| addressMap->find(0xfffffff0, 0xffffffff) != top || addressMap->find(0xffffffe0, 0xffffffff) != NULL) {
+		cout << "Priority order: wrong action" << endl;
+		nErrors++;
+	}
+
+	//add/remove: new maps are published, and earlier maps are unchanged
+	RMAPAddressRange* addedRange = new RMAPAddressRange(0x2000, 0x20ff);
+	NumberedAction addedAction(100);
+	uint64_t generation = RMAPAddressMap::getCurrentGeneration();
+	ranges.target.addAddressRangeAndAssociatedAction(addedRange, &addedAction);
+	std::shared_ptr<const RMAPAddressMap> addedAddressMap = ranges.target.getAddressMap();
+	ranges.target.removeAddressRange(addedRange);
+	ranges.target.removeAddressRange(ranges.rangesAndActions[0].first);
+	std::shared_ptr<const RMAPAddressMap> removedAddressMap = ranges.target.getAddressMap();
+	if (addedAddressMap->find(0x2000, 0x2003) != &addedAction || addressMap->find(0x2000, 0x2003) != NULL
+			|| removedAddressMap->find(0x2000, 0x2003) != NULL || removedAddressMap->find(0x100, 0x1ff) != outer
+			|| addedAddressMap->find(0x100, 0x1ff) != inner || RMAPAddressMap::getCurrentGeneration() < generation + 3
+			|| removedAddressMap->size() != 3) {
+		cout << "Add/remove: wrong map" << endl;
+		nErrors++;
+	}
+
+	//a wide range at the start of the address space and many small ranges after it
+	std::vector<std::pair<RMAPAddressRange*, RMAPTargetAccessAction*> > rangesAndActions;
+	rangesAndActions.push_back(std::make_pair(new RMAPAddressRange(0, 0xffffffff), new NumberedAction(0)));
+	for (size_t i = 0; i < nRanges; i++) {
+		rangesAndActions.push_back(std::make_pair(new RMAPAddressRange(i * 0x100, i * 0x100 + 0xff), new NumberedAction(i)));
+	}
+	RMAPTarget wideTarget;
+	auto startTime = std::chrono::steady_clock::now();
+	wideTarget.addAddressRangesAndAssociatedActions(rangesAndActions);
+	double compilationInSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+	std::shared_ptr<const RMAPAddressMap> wideAddressMap = wideTarget.getAddressMap();
+	const size_t nLookups = 1000000;
+	size_t nWrongActions = 0;
+	startTime = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < nLookups; i++) {
+		uint32_t addressFrom = (random() % nRanges) * 0x100 + 4;
+		if (wideAddressMap->find(addressFrom, addressFrom + 3) != rangesAndActions[0].second) {
+			nWrongActions++;
+		}
+	}
+	double lookupInSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+	cout << "Wide range and " << nRanges << " small ranges: compilation " << compilationInSec * 1e3 << " ms, lookup "
+			<< lookupInSec * 1e9 / nLookups << " ns" << endl;
+	if (nWrongActions != 0) {
+		nErrors++;
+	}
+
+	cout << nErrors << " errors" << endl;
+	return (nErrors == 0) ? 0 : 1;
+}
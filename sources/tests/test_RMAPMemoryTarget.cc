@@ -0,0 +1,260 @@
+/*
+ * test_RMAPMemoryTarget.cc
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+/* Tests RMAPMemoryTarget served over SpaceWireIFOverTCP on localhost.
+ * - read and write of an anonymous region, and RMW
+ * - hooks: willRead/willWrite/didWrite, rejection by willWrite, removal, and setHook() while
+ *   commands are processed
+ * - commands without the increment flag are rejected
+ * - file-backed region: a smaller file is extended (keeping its content), a larger file is not
+ *   truncated, and written data are in the file after sync()
+ *
+ * Usage: test_RMAPMemoryTarget [TCP port number] [backing file name]
+ */
+
+#include "SpaceWireRMAPLibrary/SpaceWire.hh"
+#include "SpaceWireRMAPLibrary/RMAP.hh"
+
+#include <atomic>
+#include <fstream>
+#include <thread>
+
+/** Counts hook calls, modifies memory before a read, and optionally rejects writes. */
+class CountingHook: public RMAPMemoryTargetHook {
+public:
+	std::atomic<size_t> nWillReads;
+	std::atomic<size_t> nDidWrites;
+	bool rejectWrites = false;
+
+public:
+	CountingHook() :
+			nWillReads(0), nDidWrites(0) {
+	}
+
+public:
+	uint8_t willRead(RMAPMemoryTarget* target, uint32_t address, uint32_t length) {
+		nWillReads++;
+		*target->getPointer(address) = 0x5a;
+		return RMAPReplyStatus::CommandExcecutedSuccessfully;
+	}
+
+public:
+	uint8_t willWrite(RMAPMemoryTarget* target, uint32_t address, uint32_t length) {
+		return rejectWrites ?
+				RMAPReplyStatus::CommandNotImplementedOrNotAuthorized : RMAPReplyStatus::CommandExcecutedSuccessfully;
+	}
+
+public:
+	void didWrite(RMAPMemoryTarget* target, uint32_t address, uint32_t length) {
+		nDidWrites++;
+	}
+};
+
+/** Serves targets over SpaceWireIFOverTCP (server mode). */
+class TargetServer {
+public:
+	SpaceWireIFOverTCP* spwif;
+	RMAPEngine* rmapEngine;
+	std::thread thread;
+
+public:
+	TargetServer(uint32_t portNumber, std::vector<RMAPTarget*> targets) {
+		spwif = new SpaceWireIFOverTCP(portNumber);
+		rmapEngine = NULL;
+		thread = std::thread([this, targets]() {
+			spwif->open();
+			rmapEngine = new RMAPEngine(spwif);
+			for (auto target : targets) {
+				rmapEngine->addRMAPTarget(target);
+			}
+			rmapEngine->start();
+		});
+	}
+
+public:
+	void waitForStart() {
+		thread.join();
+		while (!rmapEngine->isStarted()) {
+			CxxUtilities::Condition c;
+			c.wait(10);
+		}
+	}
+};
+
+/** Returns the reply status of an access, or CommandExcecutedSuccessfully. */
+template<typename Access>
+uint8_t getReplyStatus(Access access) {
+	try {
+		access();
+	} catch (RMAPReplyException& e) {
+		return e.getStatus();
+	}
+	return RMAPReplyStatus::CommandExcecutedSuccessfully;
+}
+
+size_t getFileSize(std::string fileName) {
+	std::ifstream file(fileName.c_str(), std::ios::binary | std::ios::ate);
+	return file.tellg();
+}
+
+int main(int argc, char* argv[]) {
+	using namespace std;
+	uint32_t portNumber = 10160;
+	std::string fileName = "test_RMAPMemoryTarget.bin";
+	if (argc > 1) {
+		portNumber = atoi(argv[1]);
+	}
+	if (argc > 2) {
+		fileName = argv[2];
+	}
+	size_t nErrors = 0;
+
+	//a backing file smaller than the region, with content at its start
+	const size_t fileRegionSize = 1024 * 1024;
+	const std::string fileContent = "RMAPMemoryTarget";
+	::unlink(fileName.c_str());
+	{
+		std::ofstream file(fileName.c_str(), std::ios::binary);
+		file << fileContent;
+	}
+
+	RMAPMemoryTarget sdram(0x00000000, 16 * 1024 * 1024);
+	RMAPMemoryTarget* fileTarget = new RMAPMemoryTarget(0x10000000, fileRegionSize, fileName);
+	if (getFileSize(fileName) != fileRegionSize
+			|| std::memcmp(fileTarget->getPointer(0x10000000), fileContent.c_str(), fileContent.size()) != 0) {
+		cout << "Backing file was not extended keeping its content" << endl;
+		nErrors++;
+	}
+	TargetServer server(portNumber, { &sdram, fileTarget });
+	CxxUtilities::Condition c;
+	c.wait(100);
+	SpaceWireIFOverTCP* spwif = new SpaceWireIFOverTCP("127.0.0.1", portNumber);
+	try {
+		spwif->open();
+	} catch (...) {
+		cerr << "Could not connect to the target" << endl;
+		exit(1);
+	}
+	server.waitForStart();
+	RMAPEngine* rmapEngine = new RMAPEngine(spwif);
+	rmapEngine->start();
+	while (!rmapEngine->isStarted()) {
+		c.wait(10);
+	}
+	RMAPInitiator* rmapInitiator = new RMAPInitiator(rmapEngine);
+	RMAPTargetNode* rmapTargetNode = new RMAPTargetNode();
+	rmapTargetNode->setTargetLogicalAddress(0xFE);
+	rmapTargetNode->setDefaultKey(0x00);
+	rmapTargetNode->setInitiatorLogicalAddress(0xFE);
+
+	//read and write
+	std::vector<uint8_t> writeData(64 * 1024), readData(64 * 1024);
+	for (size_t i = 0; i < writeData.size(); i++) {
+		writeData[i] = i * 7 + 3;
+	}
+	rmapInitiator->write(rmapTargetNode, 0x123400, &writeData[0], writeData.size());
+	rmapInitiator->read(rmapTargetNode, 0x123400, readData.size(), &readData[0]);
+	if (readData != writeData || std::memcmp(sdram.getPointer(0x123400), &writeData[0], writeData.size()) != 0) {
+		cout << "Read/write: data mismatch" << endl;
+		nErrors++;
+	}
+
+	//RMW
+	uint8_t data[2] = { 0xab, 0xcd }, mask[2] = { 0xf0, 0x0f }, previousData[2];
+	rmapInitiator->readModifyWrite(rmapTargetNode, 0x123400, data, mask, 2, previousData);
+	uint8_t* p = sdram.getPointer(0x123400);
+	if (previousData[0] != writeData[0] || previousData[1] != writeData[1]
+			|| p[0] != ((data[0] & mask[0]) | (writeData[0] & ~mask[0]))
+			|| p[1] != ((data[1] & mask[1]) | (writeData[1] & ~mask[1]))) {
+		cout << "RMW: wrong data" << endl;
+		nErrors++;
+	}
+
+	//hooks
+	CountingHook hook;
+	sdram.setHook(0x200000, 16, &hook);
+	uint8_t registerData[4] = { 1, 2, 3, 4 }, readRegisterData[4];
+	rmapInitiator->write(rmapTargetNode, 0x200000, registerData, 4);
+	rmapInitiator->read(rmapTargetNode, 0x200000, 4, readRegisterData);
+	if (hook.nDidWrites != 1 || hook.nWillReads != 1 || readRegisterData[0] != 0x5a || readRegisterData[1] != 2) {
+		cout << "Hooks: didWrite " << hook.nDidWrites << ", willRead " << hook.nWillReads << endl;
+		nErrors++;
+	}
+	hook.rejectWrites = true;
+	uint8_t status = getReplyStatus([&]() {
+		rmapInitiator->write(rmapTargetNode, 0x200000, data, 2);
+	});
+	if (status != RMAPReplyStatus::CommandNotImplementedOrNotAuthorized || sdram.getPointer(0x200000)[1] != 2) {
+		cout << "Hooks: write was not rejected" << endl;
+		nErrors++;
+	}
+	sdram.setHook(0x200000, 16, NULL);
+	rmapInitiator->write(rmapTargetNode, 0x200000, data, 2);
+	if (sdram.getPointer(0x200000)[0] != data[0] || hook.nDidWrites != 1) {
+		cout << "Hooks: hook was not removed" << endl;
+		nErrors++;
+	}
+
+	//setHook() while reads and writes are processed
+	hook.rejectWrites = false;
+	std::atomic<bool> stopped(false);
+	std::thread hookSetter([&]() {
+		while (!stopped) {
+			sdram.setHook(0x300000, 0x2000, &hook);
+			sdram.setHook(0x300000, 0x2000, NULL);
+		}
+	});
+	for (size_t i = 0; i < 500; i++) {
+		rmapInitiator->write(rmapTargetNode, 0x300ffe, registerData, 4);
+		rmapInitiator->read(rmapTargetNode, 0x300ffe, 4, readRegisterData);
+	}
+	stopped = true;
+	hookSetter.join();
+
+	//commands without the increment flag
+	rmapInitiator->setIncrementMode(false);
+	uint8_t readStatus = getReplyStatus([&]() {
+		rmapInitiator->read(rmapTargetNode, 0x123400, 4, readRegisterData);
+	});
+	uint8_t writeStatus = getReplyStatus([&]() {
+		rmapInitiator->write(rmapTargetNode, 0x123400, registerData, 4);
+	});
+	uint8_t rmwStatus = getReplyStatus([&]() {
+		rmapInitiator->readModifyWrite(rmapTargetNode, 0x123400, data, mask, 2, previousData);
+	});
+	rmapInitiator->setIncrementMode(true);
+	if (readStatus != RMAPReplyStatus::CommandNotImplementedOrNotAuthorized
+			|| writeStatus != RMAPReplyStatus::CommandNotImplementedOrNotAuthorized
+			|| rmwStatus != RMAPReplyStatus::CommandNotImplementedOrNotAuthorized || p[2] != writeData[2]) {
+		cout << "Non-incrementing commands were not rejected" << endl;
+		nErrors++;
+	}
+
+	//file-backed region
+	rmapInitiator->write(rmapTargetNode, 0x10000100, &writeData[0], 4096);
+	fileTarget->sync();
+	std::vector<uint8_t> fileData(4096);
+	{
+		std::ifstream file(fileName.c_str(), std::ios::binary);
+		file.seekg(0x100);
+		file.read((char*) &fileData[0], fileData.size());
+	}
+	if (std::memcmp(&fileData[0], &writeData[0], fileData.size()) != 0) {
+		cout << "File-backed region: written data are not in the file" << endl;
+		nErrors++;
+	}
+	RMAPMemoryTarget smallerTarget(0x20000000, 4096, fileName);
+	if (getFileSize(fileName) != fileRegionSize || smallerTarget.getPointer(0x20000100)[0] != writeData[0]) {
+		cout << "File-backed region: larger file was truncated" << endl;
+		nErrors++;
+	}
+	rmapEngine->stop();
+	spwif->close();
+	::unlink(fileName.c_str());
+
+	cout << nErrors << " errors" << endl;
+	return (nErrors == 0) ? 0 : 1;
+}
@@ -0,0 +1,121 @@
+/*
+ * test_RMAPPacket_commandConstruction_benchmark.cc
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+/* Constructs RMAP read/write command packets as RMAPInitiator does, and reports
+ * construction speed in packets/sec for two ways of setting target information:
+ *  - fields: target information is copied field by field from RMAPTargetNode getters,
+ *            and constructHeader() encodes the whole header (the previous behavior).
+ *  - template: RMAPPacket::setRMAPTargetInformation() uses the node's pre-encoded
+ *            command header template, and constructHeader() only patches it.
+ * Packets constructed in both ways are compared byte by byte before benchmarking.
+ *
+ * Usage: test_RMAPPacket_commandConstruction_benchmark [number of packets] [reply address length]
+ */
+
+#include "SpaceWireRMAPLibrary/SpaceWire.hh"
+#include "SpaceWireRMAPLibrary/RMAP.hh"
+
+#include <chrono>
+
+void setTargetInformationFieldByField(RMAPPacket* packet, RMAPTargetNode* rmapTargetNode) {
+	packet->setTargetLogicalAddress(rmapTargetNode->getTargetLogicalAddress());
+	packet->setReplyAddress(rmapTargetNode->getReplyAddress());
+	packet->setTargetSpaceWireAddress(rmapTargetNode->getTargetSpaceWireAddress());
+	packet->setKey(rmapTargetNode->getDefaultKey());
+	if (rmapTargetNode->isInitiatorLogicalAddressSet()) {
+		packet->setInitiatorLogicalAddress(rmapTargetNode->getInitiatorLogicalAddress());
+	}
+}
+
+void constructCommand(RMAPPacket* packet, RMAPTargetNode* rmapTargetNode, size_t i, bool useTemplate) {
+	if (i % 2 == 0) {
+		packet->setRead();
+	} else {
+		packet->setWrite();
+	}
+	packet->setCommand();
+	if (i % 3 == 0) {
+		packet->setIncrementMode();
+	} else {
+		packet->setNoIncrementMode();
+	}
+	if (i % 5 == 0) {
+		packet->setVerifyMode();
+	} else {
+		packet->setNoVerifyMode();
+	}
+	packet->setReplyMode();
+	packet->setExtendedAddress(0x00);
+	packet->setAddress(0x01010000 + i * 4);
+	packet->setDataLength(2);
+	packet->clearData();
+	if (useTemplate) {
+		packet->setRMAPTargetInformation(rmapTargetNode);
+	} else {
+		setTargetInformationFieldByField(packet, rmapTargetNode);
+	}
+	packet->setTransactionID(i & 0xFFFF);
+	if (packet->isWrite()) {
+		uint8_t data[] = { (uint8_t) i, (uint8_t) (i >> 8) };
+		packet->setData(data, 2);
+	}
+	packet->constructPacket();
+}
+
+int main(int argc, char* argv[]) {
+	using namespace std;
+	size_t nPackets = 1000000;
+	size_t replyAddressLength = 3;
+	if (argc > 1) {
+		nPackets = atoi(argv[1]);
+	}
+	if (argc > 2) {
+		replyAddressLength = atoi(argv[2]);
+	}
+
+	RMAPTargetNode rmapTargetNode;
+	rmapTargetNode.setID("Target");
+	rmapTargetNode.setTargetLogicalAddress(0x30);
+	rmapTargetNode.setDefaultKey(0x02);
+	rmapTargetNode.setInitiatorLogicalAddress(0xFE);
+	for (size_t i = 0; i < 3; i++) {
+		rmapTargetNode.pushTrailingTargetSpaceWireAddress(i + 1);
+	}
+	for (size_t i = 0; i < replyAddressLength; i++) {
+		rmapTargetNode.pushTrailingReplyAddress(i + 5);
+	}
+
+	//check
+	RMAPPacket packetFromFields, packetFromTemplate;
+	for (size_t draftE = 0; draftE < 2; draftE++) {
+		packetFromFields.setUseDraftECRC(draftE == 1);
+		packetFromTemplate.setUseDraftECRC(draftE == 1);
+		for (size_t i = 0; i < 1000; i++) {
+			constructCommand(&packetFromFields, &rmapTargetNode, i, false);
+			constructCommand(&packetFromTemplate, &rmapTargetNode, i, true);
+			if (*packetFromFields.getPacketBufferPointer() != *packetFromTemplate.getPacketBufferPointer()) {
+				cerr << "Constructed packets differ (i=" << i << ", draftE=" << draftE << ")" << endl;
+				cerr << packetFromFields.toString() << endl << packetFromTemplate.toString() << endl;
+				return -1;
+			}
+		}
+	}
+	cout << "Constructed packets are identical." << endl;
+
+	//benchmark
+	for (size_t useTemplate = 0; useTemplate < 2; useTemplate++) {
+		RMAPPacket packet;
+		size_t totalSize = 0;
+		auto start = chrono::high_resolution_clock::now();
+		for (size_t i = 0; i < nPackets; i++) {
+			constructCommand(&packet, &rmapTargetNode, i, useTemplate == 1);
+			totalSize += packet.getPacketBufferPointer()->size();
+		}
+		double elapsed = chrono::duration<double>(chrono::high_resolution_clock::now() - start).count();
+		cout << (useTemplate ? "template" : "fields  ") << " : " << nPackets / elapsed << " packets/sec (" << totalSize
+				<< " bytes)" << endl;
+	}
+}
@@ -0,0 +1,277 @@
+/*
+ * test_RMAPRegister.cc
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+/* Tests compile-time register maps (RMAPRegister/RMAPRegisterField) and the typed accessors
+ * of RMAPInitiator against emulated registers served over SpaceWireIFOverTCP on localhost.
+ * - encode()/decode() in big and little endian, and RMAPRegisterField::extract()/insert()/Mask
+ * - readRegister()/writeRegister(), and writeRegisterField() which uses a single RMW for an
+ *   RMWable register and a read followed by a write otherwise
+ * Then compares address resolution by memory object ID (string formatting and lookup) with
+ * compile-time addresses, and reports the time per resolution.
+ *
+ * Usage: test_RMAPRegister [TCP port number] [number of address resolutions]
+ */
+
+#include "SpaceWireRMAPLibrary/SpaceWire.hh"
+#include "SpaceWireRMAPLibrary/RMAP.hh"
+
+#include <chrono>
+#include <thread>
+
+enum class Mode : uint16_t {
+	Idle = 0x0001, Running = 0x1234
+};
+
+typedef RMAPRegister<0x10, uint16_t> StatusRegister;
+typedef RMAPRegister<0x20, uint32_t,
+		RMAPMemoryObject::Readable | RMAPMemoryObject::Writable | RMAPMemoryObject::RMWable,
+		RMAPRegisterEndianness::LittleEndian> ControlRegister;
+typedef RMAPRegister<0x30, Mode> ModeRegister;
+typedef RMAPRegister<0x40, uint32_t, RMAPMemoryObject::Readable | RMAPMemoryObject::Writable> ThresholdRegister;
+typedef RMAPRegister<0x50, uint64_t> CounterRegister;
+typedef RMAPRegisterField<ControlRegister, 8, 4> GainField;
+typedef RMAPRegisterField<ThresholdRegister, 28, 4> ThresholdModeField;
+typedef RMAPRegisterField<CounterRegister, 32, 32> CounterUpperField;
+
+/** Emulates registers which support RMW, and counts each kind of access. */
+class Registers: public RMAPTargetAccessAction {
+public:
+	static const uint32_t Size = 0x100;
+
+public:
+	std::vector<uint8_t> memory;
+	size_t nReads = 0;
+	size_t nWrites = 0;
+	size_t nRMWs = 0;
+
+public:
+	Registers() :
+			memory(Size, 0) {
+	}
+
+public:
+	void processTransaction(RMAPTransaction* rmapTransaction) throw (RMAPTargetAccessActionException) {
+		RMAPPacket* commandPacket = rmapTransaction->commandPacket;
+		uint8_t* p = &memory[commandPacket->getAddress()];
+		if (commandPacket->isRead()) {
+			nReads++;
+			std::vector<uint8_t> data(p, p + commandPacket->getLength());
+			setReplyWithDataWithStatus(rmapTransaction, &data, RMAPReplyStatus::CommandExcecutedSuccessfully);
+			return;
+		}
+		nWrites++;
+		std::vector<uint8_t>* data = commandPacket->getDataBuffer();
+		std::copy(data->begin(), data->end(), p);
+		setReplyWithStatus(rmapTransaction, RMAPReplyStatus::CommandExcecutedSuccessfully);
+	}
+
+public:
+	void processReadModifyWriteTransaction(RMAPTransaction* rmapTransaction) throw (RMAPTargetAccessActionException) {
+		nRMWs++;
+		readModifyWrite(rmapTransaction, &memory[rmapTransaction->commandPacket->getAddress()]);
+	}
+};
+
+/** Serves a target over SpaceWireIFOverTCP (server mode). */
+class TargetServer {
+public:
+	SpaceWireIFOverTCP* spwif;
+	RMAPEngine* rmapEngine;
+	std::thread thread;
+
+public:
+	TargetServer(uint32_t portNumber, RMAPTarget* target) {
+		spwif = new SpaceWireIFOverTCP(portNumber);
+		rmapEngine = NULL;
+		thread = std::thread([this, target]() {
+			spwif->open();
+			rmapEngine = new RMAPEngine(spwif);
+			rmapEngine->addRMAPTarget(target);
+			rmapEngine->start();
+		});
+	}
+
+public:
+	void waitForStart() {
+		thread.join();
+		while (!rmapEngine->isStarted()) {
+			CxxUtilities::Condition c;
+			c.wait(10);
+		}
+	}
+};
+
+size_t testEncodeDecode() {
+	using namespace std;
+	size_t nErrors = 0;
+	uint8_t buffer[8];
+	StatusRegister::encode(0xABCD, buffer);
+	if (buffer[0] != 0xAB || buffer[1] != 0xCD || StatusRegister::decode(buffer) != 0xABCD) {
+		cerr << "Big endian uint16_t register is wrongly encoded/decoded" << endl;
+		nErrors++;
+	}
+	ControlRegister::encode(0x11223344, buffer);
+	if (buffer[0] != 0x44 || buffer[3] != 0x11 || ControlRegister::decode(buffer) != 0x11223344) {
+		cerr << "Little endian uint32_t register is wrongly encoded/decoded" << endl;
+		nErrors++;
+	}
+	CounterRegister::encode(0x0102030405060708ULL, buffer);
+	if (buffer[0] != 0x01 || buffer[7] != 0x08 || CounterRegister::decode(buffer) != 0x0102030405060708ULL) {
+		cerr << "Big endian uint64_t register is wrongly encoded/decoded" << endl;
+		nErrors++;
+	}
+	ModeRegister::encode(Mode::Running, buffer);
+	if (buffer[0] != 0x12 || buffer[1] != 0x34 || ModeRegister::decode(buffer) != Mode::Running) {
+		cerr << "Enum register is wrongly encoded/decoded" << endl;
+		nErrors++;
+	}
+	return nErrors;
+}
+
+size_t testFields() {
+	using namespace std;
+	size_t nErrors = 0;
+	if (GainField::Mask != 0x00000F00 || ThresholdModeField::Mask != 0xF0000000
+			|| CounterUpperField::Mask != 0xFFFFFFFF00000000ULL) {
+		cerr << "Field masks are wrong" << endl;
+		nErrors++;
+	}
+	if (GainField::extract(0x11223A44) != 0xA || ThresholdModeField::extract(0xF2345678) != 0xF
+			|| CounterUpperField::extract(0x0102030405060708ULL) != 0x01020304) {
+		cerr << "Fields are wrongly extracted" << endl;
+		nErrors++;
+	}
+	//values wider than a field are truncated to the field
+	if (GainField::insert(0x11223344, 0xA) != 0x11223A44 || GainField::insert(0x11223344, 0x1A) != 0x11223A44
+			|| ThresholdModeField::insert(0x12345678, 0xF) != 0xF2345678
+			|| CounterUpperField::insert(0x0102030405060708ULL, 0xAABBCCDD) != 0xAABBCCDD05060708ULL) {
+		cerr << "Fields are wrongly inserted" << endl;
+		nErrors++;
+	}
+	return nErrors;
+}
+
+size_t testAccessors(RMAPInitiator* rmapInitiator, RMAPTargetNode* rmapTargetNode, Registers& registers) {
+	using namespace std;
+	size_t nErrors = 0;
+	rmapInitiator->writeRegister<StatusRegister>(rmapTargetNode, 0xABCD);
+	if (registers.memory[0x10] != 0xAB || registers.memory[0x11] != 0xCD
+			|| rmapInitiator->readRegister<StatusRegister>(rmapTargetNode) != 0xABCD) {
+		cerr << "readRegister()/writeRegister() of a big endian register failed" << endl;
+		nErrors++;
+	}
+	rmapInitiator->writeRegister<ControlRegister>(rmapTargetNode, 0x11223344);
+	if (registers.memory[0x20] != 0x44 || registers.memory[0x23] != 0x11
+			|| rmapInitiator->readRegister<ControlRegister>(rmapTargetNode) != 0x11223344) {
+		cerr << "readRegister()/writeRegister() of a little endian register failed" << endl;
+		nErrors++;
+	}
+	rmapInitiator->writeRegister<ModeRegister>(rmapTargetNode, Mode::Running);
+	if (rmapInitiator->readRegister<ModeRegister>(rmapTargetNode) != Mode::Running) {
+		cerr << "readRegister()/writeRegister() of an enum register failed" << endl;
+		nErrors++;
+	}
+
+	//RMWable register: a single RMW
+	size_t nReads = registers.nReads, nWrites = registers.nWrites, nRMWs = registers.nRMWs;
+	rmapInitiator->writeRegisterField<GainField>(rmapTargetNode, 0xA);
+	if (registers.nRMWs != nRMWs + 1 || registers.nReads != nReads || registers.nWrites != nWrites) {
+		cerr << "writeRegisterField() of an RMWable register did not use a single RMW" << endl;
+		nErrors++;
+	}
+	if (rmapInitiator->readRegister<ControlRegister>(rmapTargetNode) != 0x11223A44
+			|| rmapInitiator->readRegisterField<GainField>(rmapTargetNode) != 0xA) {
+		cerr << "writeRegisterField() of an RMWable register failed" << endl;
+		nErrors++;
+	}
+
+	//register which is not RMWable (with an offset): a read followed by a write
+	const uint32_t offset = 0x80;
+	rmapInitiator->writeRegister<ThresholdRegister>(rmapTargetNode, 0x12345678, offset);
+	nReads = registers.nReads, nWrites = registers.nWrites, nRMWs = registers.nRMWs;
+	rmapInitiator->writeRegisterField<ThresholdModeField>(rmapTargetNode, 0xF, offset);
+	if (registers.nRMWs != nRMWs || registers.nReads != nReads + 1 || registers.nWrites != nWrites + 1) {
+		cerr << "writeRegisterField() of a non-RMWable register did not read and write" << endl;
+		nErrors++;
+	}
+	if (rmapInitiator->readRegister<ThresholdRegister>(rmapTargetNode, offset) != 0xF2345678
+			|| ThresholdRegister::decode(&registers.memory[ThresholdRegister::Address]) != 0) {
+		cerr << "writeRegisterField() of a non-RMWable register failed" << endl;
+		nErrors++;
+	}
+	return nErrors;
+}
+
+void benchmarkAddressResolution(size_t nResolutions) {
+	using namespace std;
+	typedef RMAPRegister<0x0000, uint32_t, RMAPMemoryObject::Readable | RMAPMemoryObject::Writable,
+			RMAPRegisterEndianness::LittleEndian> LinkControlStatusRegister;
+	const size_t nPorts = 7;
+	RMAPTargetNode rmapTargetNode;
+	for (size_t port = 0; port < nPorts; port++) {
+		stringstream ss;
+		ss << "Port" << port << "ControlStatusRegister";
+		rmapTargetNode.addMemoryObject(LinkControlStatusRegister::createMemoryObject(ss.str(), port * 4));
+	}
+	volatile uint32_t sink = 0;
+	auto startTime = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < nResolutions; i++) {
+		stringstream ss;
+		ss << "Port" << i % nPorts << "ControlStatusRegister";
+		sink += rmapTargetNode.getMemoryObject(ss.str())->getAddress();
+	}
+	double byIDInSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+	startTime = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < nResolutions; i++) {
+		sink += LinkControlStatusRegister::Address + (i % nPorts) * 4;
+	}
+	double compileTimeInSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+	cout << "Address resolution: by ID " << byIDInSec * 1e9 / nResolutions << " ns, compile-time "
+			<< compileTimeInSec * 1e9 / nResolutions << " ns" << endl;
+}
+
+int main(int argc, char* argv[]) {
+	using namespace std;
+	uint32_t portNumber = 10140;
+	size_t nResolutions = 1000000;
+	if (argc > 1) {
+		portNumber = atoi(argv[1]);
+	}
+	if (argc > 2) {
+		nResolutions = atoi(argv[2]);
+	}
+	size_t nErrors = testEncodeDecode() + testFields();
+
+	Registers registers;
+	RMAPTarget rmapTarget;
+	rmapTarget.addAddressRangeAndAssociatedAction(new RMAPAddressRange(0, Registers::Size - 1), &registers);
+	TargetServer server(portNumber, &rmapTarget);
+	CxxUtilities::Condition c;
+	c.wait(100);
+	SpaceWireIFOverTCP* spwif = new SpaceWireIFOverTCP("127.0.0.1", portNumber);
+	try {
+		spwif->open();
+	} catch (...) {
+		cerr << "Could not connect to the target" << endl;
+		exit(1);
+	}
+	server.waitForStart();
+	RMAPEngine* rmapEngine = new RMAPEngine(spwif);
+	rmapEngine->start();
+	while (!rmapEngine->isStarted()) {
+		c.wait(10);
+	}
+	RMAPInitiator* rmapInitiator = new RMAPInitiator(rmapEngine);
+	RMAPTargetNode* rmapTargetNode = new RMAPTargetNode();
+	rmapTargetNode->setTargetLogicalAddress(0xFE);
+	rmapTargetNode->setDefaultKey(0x00);
+	rmapTargetNode->setInitiatorLogicalAddress(0xFE);
+	nErrors += testAccessors(rmapInitiator, rmapTargetNode, registers);
+
+	benchmarkAddressResolution(nResolutions);
+	cout << nErrors << " errors" << endl;
+	return (nErrors == 0) ? 0 : 1;
+}
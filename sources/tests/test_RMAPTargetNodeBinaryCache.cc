@@ -0,0 +1,257 @@
+/*
+ * test_RMAPTargetNodeBinaryCache.cc
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+/* Tests RMAPTargetNodeBinaryCache.
+ * - round trip: deserialized nodes and memory objects equal the serialized ones, including
+ *   whether optional fields (initiator logical address, key, access mode, increment mode) are set
+ * - corruption: truncated buffers, wrong magic/version, and out-of-range offsets and indices result in
+ *   exceptions; random byte flips never crash
+ * - cache files: saveToFile()/loadFromFile(), a cache file planted for XML content is used instead of
+ *   parsing, the memory cache serves later lookups, and a broken cache file is replaced after parsing;
+ *   concurrent lookups do not deadlock
+ *
+ * Usage: test_RMAPTargetNodeBinaryCache [cache directory]
+ */
+
+#include "SpaceWireRMAPLibrary/SpaceWire.hh"
+#include "SpaceWireRMAPLibrary/RMAP.hh"
+
+#include <random>
+#include <thread>
+
+std::vector<RMAPTargetNode*> createNodes(size_t nNodes, size_t nMemoryObjects) {
+	std::vector<RMAPTargetNode*> nodes;
+	for (size_t n = 0; n < nNodes; n++) {
+		RMAPTargetNode* node = new RMAPTargetNode();
+		std::stringstream ss;
+		ss << "Node" << n;
+		node->setID(ss.str());
+		node->setTargetLogicalAddress(0x20 + n);
+		node->setTargetSpaceWireAddress( { 1, (uint8_t) n, 3 });
+		node->setReplyAddress( { (uint8_t) (n % 7) });
+		node->setDefaultKey(0x20 + n % 3);
+		if (n % 2 == 1) {
+			node->setInitiatorLogicalAddress(0x30);
+		}
+		for (size_t o = 0; o < nMemoryObjects; o++) {
+			RMAPMemoryObject* memoryObject = new RMAPMemoryObject();
+			std::stringstream ss;
+			ss << "Register" << o;
+			memoryObject->setID(ss.str());
+			memoryObject->setExtendedAddress(o % 2);
+			memoryObject->setAddress(0x1000 * o + n);
+			memoryObject->setLength(4 + o);
+			if (o % 2 == 1) {
+				memoryObject->setKey(0x02);
+			}
+			if (o % 3 == 0) {
+				memoryObject->setAccessMode("ro");
+			}
+			if (o % 4 == 0) {
+				memoryObject->setIncrementMode((o % 8 == 0) ? "increment" : "nonincrement");
+			}
+			node->addMemoryObject(memoryObject);
+		}
+		nodes.push_back(node);
+	}
+	return nodes;
+}
+
+bool isSameMemoryObject(RMAPMemoryObject* a, RMAPMemoryObject* b) {
+	return a->getID() == b->getID() && a->getExtendedAddress() == b->getExtendedAddress()
+			&& a->getAddress() == b->getAddress() && a->getLength() == b->getLength()
+			&& a->isKeySet() == b->isKeySet() && (!a->isKeySet() || a->getKey() == b->getKey())
+			&& a->isAccessModeSet() == b->isAccessModeSet() && a->getAccessMode() == b->getAccessMode()
+			&& a->isIncrementModeSet() == b->isIncrementModeSet()
+			&& (!a->isIncrementModeSet() || a->isIncrementMode() == b->isIncrementMode());
+}
+
+bool isSameNodes(std::vector<RMAPTargetNode*> a, std::vector<RMAPTargetNode*> b) {
+	if (a.size() != b.size()) {
+		return false;
+	}
+	for (size_t i = 0; i < a.size(); i++) {
+		if (a[i]->getID() != b[i]->getID() || a[i]->getTargetLogicalAddress() != b[i]->getTargetLogicalAddress()
+				|| a[i]->getTargetSpaceWireAddress() != b[i]->getTargetSpaceWireAddress()
+				|| a[i]->getReplyAddress() != b[i]->getReplyAddress() || a[i]->getDefaultKey() != b[i]->getDefaultKey()
+				|| a[i]->isInitiatorLogicalAddressSet() != b[i]->isInitiatorLogicalAddressSet()
+				|| a[i]->getInitiatorLogicalAddress() != b[i]->getInitiatorLogicalAddress()
+				|| a[i]->getMemoryObjectMap()->size() != b[i]->getMemoryObjectMap()->size()) {
+			return false;
+		}
+		std::map<std::string, RMAPMemoryObject*>::const_iterator it = a[i]->getMemoryObjectMap()->begin();
+		for (; it != a[i]->getMemoryObjectMap()->end(); it++) {
+			RMAPMemoryObject* memoryObject = b[i]->getMemoryObject(it->first);
+			if (memoryObject == NULL || !isSameMemoryObject(it->second, memoryObject)) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+/** Returns the status of the exception thrown by deserialize(), or -1 if nothing was thrown. */
+int getDeserializationStatus(const std::vector<uint8_t>& serialized) {
+	try {
+		RMAPTargetNodeBinaryCache::deserialize(serialized.data(), serialized.size());
+	} catch (RMAPTargetNodeBinaryCacheException& e) {
+		return e.getStatus();
+	}
+	return -1;
+}
+
+void setUInt32(std::vector<uint8_t>& buffer, size_t offset, uint32_t value) {
+	for (size_t i = 0; i < 4; i++) {
+		buffer[offset + i] = (value >> (i * 8)) & 0xFF;
+	}
+}
+
+int main(int argc, char* argv[]) {
+	using namespace std;
+	std::string cacheDirectory = "/tmp";
+	if (argc > 1) {
+		cacheDirectory = argv[1];
+	}
+	size_t nErrors = 0;
+
+	//round trip
+	std::vector<RMAPTargetNode*> nodes = createNodes(100, 20);
+	std::vector<uint8_t> serialized = RMAPTargetNodeBinaryCache::serialize(nodes);
+	std::vector<RMAPTargetNode*> deserialized = RMAPTargetNodeBinaryCache::deserialize(&serialized[0],
+			serialized.size());
+	if (!isSameNodes(nodes, deserialized) || RMAPTargetNodeBinaryCache::serialize(deserialized) != serialized) {
+		cout << "Round trip: nodes differ" << endl;
+		nErrors++;
+	}
+	std::vector<uint8_t> empty = RMAPTargetNodeBinaryCache::serialize(std::vector<RMAPTargetNode*>());
+	if (empty.size() != RMAPTargetNodeBinaryCache::HeaderSize
+			|| RMAPTargetNodeBinaryCache::deserialize(&empty[0], empty.size()).size() != 0) {
+		cout << "Round trip: empty node list" << endl;
+		nErrors++;
+	}
+
+	//corruption
+	const size_t nodeRecords = RMAPTargetNodeBinaryCache::HeaderSize;
+	std::vector<std::vector<uint8_t> > corrupted;
+	for (size_t size : { (size_t) 0, (size_t) 10, nodeRecords, serialized.size() / 2, serialized.size() - 1 }) {
+		corrupted.push_back(std::vector<uint8_t>(serialized.begin(), serialized.begin() + size));
+	}
+	std::vector<uint8_t> extended = serialized;
+	extended.push_back(0);
+	corrupted.push_back(extended);
+	std::vector<uint8_t> badMagic = serialized;
+	badMagic[0] = 'X';
+	corrupted.push_back(badMagic);
+	std::vector<uint8_t> badStringOffset = serialized;
+	setUInt32(badStringOffset, nodeRecords + RMAPTargetNodeBinaryCache::NodeRecordSize * 10, 0xfffffff0);
+	corrupted.push_back(badStringOffset);
+	std::vector<uint8_t> badStringLength = serialized;
+	setUInt32(badStringLength, nodeRecords + RMAPTargetNodeBinaryCache::NodeRecordSize * 99 + 4, 0xffffffff);
+	corrupted.push_back(badStringLength);
+	std::vector<uint8_t> badMemoryObjectIndex = serialized;
+	setUInt32(badMemoryObjectIndex, nodeRecords + RMAPTargetNodeBinaryCache::NodeRecordSize * 50 + 28, 100 * 20 - 5);
+	corrupted.push_back(badMemoryObjectIndex);
+	std::vector<uint8_t> badNodeCount = serialized;
+	setUInt32(badNodeCount, 12, 0xffffffff);
+	corrupted.push_back(badNodeCount);
+	size_t nUndetected = 0;
+	for (auto& buffer : corrupted) {
+		if (getDeserializationStatus(buffer) != RMAPTargetNodeBinaryCacheException::InvalidFormat) {
+			nUndetected++;
+		}
+	}
+	std::vector<uint8_t> badVersion = serialized;
+	setUInt32(badVersion, 8, RMAPTargetNodeBinaryCache::FormatVersion + 1);
+	if (getDeserializationStatus(badVersion) != RMAPTargetNodeBinaryCacheException::UnsupportedFormatVersion) {
+		nUndetected++;
+	}
+	std::mt19937 random(1);
+	size_t nDetectedFlips = 0;
+	for (size_t i = 0; i < 1000; i++) {
+		std::vector<uint8_t> flipped = serialized;
+		flipped[random() % flipped.size()] ^= 1 << (random() % 8);
+		try {
+			std::vector<RMAPTargetNode*> result = RMAPTargetNodeBinaryCache::deserialize(&flipped[0], flipped.size());
+			for (auto node : result) {
+				delete node;
+			}
+		} catch (RMAPTargetNodeBinaryCacheException& e) {
+			nDetectedFlips++;
+		}
+	}
+	cout << "Corruption: " << nUndetected << " undetected, " << nDetectedFlips << " of 1000 byte flips detected" << endl;
+	if (nUndetected != 0) {
+		nErrors++;
+	}
+
+	//cache files
+	std::string fileName = cacheDirectory + "/test_RMAPTargetNodeBinaryCache.bin";
+	RMAPTargetNodeBinaryCache::saveToFile(serialized, fileName);
+	if (!isSameNodes(nodes, RMAPTargetNodeBinaryCache::loadFromFile(fileName))) {
+		cout << "Cache files: loaded nodes differ" << endl;
+		nErrors++;
+	}
+	::unlink(fileName.c_str());
+	int missingFileStatus = -1;
+	try {
+		RMAPTargetNodeBinaryCache::loadFromFile(fileName);
+	} catch (RMAPTargetNodeBinaryCacheException& e) {
+		missingFileStatus = e.getStatus();
+	}
+	if (missingFileStatus != RMAPTargetNodeBinaryCacheException::FileCouldNotBeOpened) {
+		cout << "Cache files: missing file was not reported" << endl;
+		nErrors++;
+	}
+
+	//XML content which defines no node; nodes are obtained only from the planted cache file
+	std::stringstream ss;
+	ss << "<RMAPTargetNodes><!-- test_RMAPTargetNodeBinaryCache " << getpid() << " --></RMAPTargetNodes>";
+	std::string xml = ss.str();
+	RMAPTargetNodeBinaryCache cache(cacheDirectory);
+	std::string cacheFileName = cache.getCacheFileName(xml);
+	RMAPTargetNodeBinaryCache::saveToFile(serialized, cacheFileName);
+	bool isFileUsed = isSameNodes(nodes, cache.constructFromXMLString(xml));
+	::unlink(cacheFileName.c_str());
+	bool isMemoryCacheUsed = isSameNodes(nodes, cache.constructFromXMLString(xml));
+	std::vector<std::thread> threads;
+	std::vector<size_t> nMismatches(4, 0);
+	for (size_t t = 0; t < nMismatches.size(); t++) {
+		threads.push_back(std::thread([&, t]() {
+			for (size_t i = 0; i < 20; i++) {
+				if (!isSameNodes(nodes, cache.constructFromXMLString(xml))) {
+					nMismatches[t]++;
+				}
+			}
+		}));
+	}
+	for (auto& thread : threads) {
+		thread.join();
+	}
+	cout << "Cache files: planted file " << (isFileUsed ? "used" : "not used") << ", memory cache "
+			<< (isMemoryCacheUsed ? "used" : "not used") << endl;
+	if (!isFileUsed || !isMemoryCacheUsed || nMismatches != std::vector<size_t>(4, 0)) {
+		nErrors++;
+	}
+
+	//a broken cache file is not used, and is replaced with the parsed (empty) node list
+	cache.clearMemoryCache();
+	RMAPTargetNodeBinaryCache::saveToFile(std::vector<uint8_t>(serialized.begin(), serialized.end() - 1),
+			cacheFileName);
+	bool isBrokenFileIgnored = (cache.constructFromXMLString(xml).size() == 0);
+	bool isBrokenFileReplaced = false;
+	try {
+		isBrokenFileReplaced = (RMAPTargetNodeBinaryCache::loadFromFile(cacheFileName).size() == 0);
+	} catch (RMAPTargetNodeBinaryCacheException& e) {
+	}
+	::unlink(cacheFileName.c_str());
+	if (!isBrokenFileIgnored || !isBrokenFileReplaced) {
+		cout << "Cache files: broken file was not replaced" << endl;
+		nErrors++;
+	}
+
+	cout << nErrors << " errors" << endl;
+	return (nErrors == 0) ? 0 : 1;
+}
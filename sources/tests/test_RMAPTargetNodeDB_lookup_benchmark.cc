@@ -0,0 +1,138 @@
+/*
+ * test_RMAPTargetNodeDB_lookup_benchmark.cc
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+/* Tests named lookups of RMAPTargetNodeDB/RMAPTargetNode and memory object handles
+ * (RMAPTargetNode::getMemoryObjectHandle()), and compares the time per lookup of
+ * - node and memory object IDs in ordered maps (std::map, as getMemoryObjectMap() is ordered)
+ * - node and memory object IDs via getRMAPTargetNode() and getMemoryObject() (hash tables)
+ * - a memory object handle resolved once
+ *
+ * Usage: test_RMAPTargetNodeDB_lookup_benchmark [nNodes] [nMemoryObjects per node] [nLookups]
+ */
+
+#include "SpaceWireRMAPLibrary/SpaceWire.hh"
+#include "SpaceWireRMAPLibrary/RMAP.hh"
+
+#include <chrono>
+
+RMAPMemoryObject* createMemoryObject(std::string id, uint32_t address) {
+	RMAPMemoryObject* memoryObject = new RMAPMemoryObject();
+	memoryObject->setID(id);
+	memoryObject->setExtendedAddress(0);
+	memoryObject->setAddress(address);
+	memoryObject->setLength(4);
+	return memoryObject;
+}
+
+std::string toID(std::string prefix, size_t index) {
+	std::stringstream ss;
+	ss << prefix << index;
+	return ss.str();
+}
+
+int main(int argc, char* argv[]) {
+	using namespace std;
+	size_t nNodes = 300;
+	size_t nMemoryObjects = 250;
+	size_t nLookups = 2000000;
+	if (argc > 1) {
+		nNodes = atoi(argv[1]);
+	}
+	if (argc > 2) {
+		nMemoryObjects = atoi(argv[2]);
+	}
+	if (argc > 3) {
+		nLookups = atoi(argv[3]);
+	}
+	RMAPTargetNodeDB db;
+	std::map<std::string, RMAPTargetNode*> orderedNodes;
+	for (size_t n = 0; n < nNodes; n++) {
+		RMAPTargetNode* rmapTargetNode = new RMAPTargetNode();
+		rmapTargetNode->setID(toID("Node", n));
+		for (size_t i = 0; i < nMemoryObjects; i++) {
+			rmapTargetNode->addMemoryObject(createMemoryObject(toID("Register", i), i * 4));
+		}
+		db.addRMAPTargetNode(rmapTargetNode);
+		orderedNodes[rmapTargetNode->getID()] = rmapTargetNode;
+	}
+	size_t nErrors = 0;
+
+	//named lookups
+	std::string nodeID = toID("Node", nNodes / 2);
+	std::string memoryObjectID = toID("Register", nMemoryObjects - 1);
+	RMAPTargetNode* rmapTargetNode = db.getRMAPTargetNode(nodeID);
+	if (rmapTargetNode != orderedNodes[nodeID] || db.findRMAPTargetNode("NoSuchNode") != NULL
+			|| rmapTargetNode->findMemoryObject("NoSuchRegister") != NULL
+			|| rmapTargetNode->getMemoryObjectMap()->size() != nMemoryObjects) {
+		cerr << "Named lookup failed" << endl;
+		nErrors++;
+	}
+
+	//handles
+	RMAPMemoryObjectHandle handle = rmapTargetNode->getMemoryObjectHandle(memoryObjectID);
+	if (!handle.isValid() || rmapTargetNode->getMemoryObject(handle)->getAddress() != (nMemoryObjects - 1) * 4) {
+		cerr << "Handle does not refer to the memory object" << endl;
+		nErrors++;
+	}
+	RMAPMemoryObject* replacement = createMemoryObject(memoryObjectID, 0x999);
+	rmapTargetNode->addMemoryObject(replacement);
+	if (rmapTargetNode->getMemoryObject(handle) != replacement
+			|| rmapTargetNode->getMemoryObject(memoryObjectID) != replacement
+			|| rmapTargetNode->getMemoryObjectMap()->size() != nMemoryObjects) {
+		cerr << "Handle does not refer to the replaced memory object" << endl;
+		nErrors++;
+	}
+	try {
+		rmapTargetNode->getMemoryObjectHandle("NoSuchRegister");
+		cerr << "Handle of a memory object which was not added was returned" << endl;
+		nErrors++;
+	} catch (RMAPTargetNodeException& e) {
+	}
+	try {
+		rmapTargetNode->getMemoryObject(RMAPMemoryObjectHandle());
+		cerr << "Invalid handle was resolved" << endl;
+		nErrors++;
+	} catch (RMAPTargetNodeException& e) {
+	}
+
+	//a memory object inserted directly into the deprecated getMemoryObjects() map is found, but has no handle
+	RMAPMemoryObject* inserted = createMemoryObject("InsertedRegister", 0x888);
+	(*rmapTargetNode->getMemoryObjects())["InsertedRegister"] = inserted;
+	if (rmapTargetNode->findMemoryObject("InsertedRegister") != inserted
+			|| rmapTargetNode->getMemoryObjectMap()->size() != nMemoryObjects + 1) {
+		cerr << "Directly inserted memory object was not found" << endl;
+		nErrors++;
+	}
+	try {
+		rmapTargetNode->getMemoryObjectHandle("InsertedRegister");
+		cerr << "Handle of a directly inserted memory object was returned" << endl;
+		nErrors++;
+	} catch (RMAPTargetNodeException& e) {
+	}
+
+	//lookup cost
+	volatile uint32_t sink = 0;
+	auto startTime = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < nLookups; i++) {
+		sink += orderedNodes.find(nodeID)->second->getMemoryObjectMap()->find(memoryObjectID)->second->getAddress();
+	}
+	double orderedInSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+	startTime = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < nLookups; i++) {
+		sink += db.getRMAPTargetNode(nodeID)->getMemoryObject(memoryObjectID)->getAddress();
+	}
+	double hashedInSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+	startTime = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < nLookups; i++) {
+		sink += rmapTargetNode->getMemoryObject(handle)->getAddress();
+	}
+	double handleInSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+	cout << nNodes << " nodes, " << nMemoryObjects << " memory objects per node (" << nErrors << " errors)" << endl;
+	cout << "Lookup of a node and a memory object: ordered maps " << orderedInSec * 1e9 / nLookups << " ns, hash tables "
+			<< hashedInSec * 1e9 / nLookups << " ns, handle " << handleInSec * 1e9 / nLookups << " ns" << endl;
+	return (nErrors == 0) ? 0 : 1;
+}
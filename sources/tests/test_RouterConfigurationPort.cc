@@ -0,0 +1,485 @@
+/*
+ * test_RouterConfigurationPort.cc
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+/* Tests routing table accesses and the link control/status register cache of RouterConfigurationPort
+ * against emulated router registers served over SpaceWireIFOverTCP on localhost.
+ * - block read: the whole routing table is read with one command
+ * - pipelined read: a router which rejects block access is read entry by entry
+ * - lost reply: an entry whose reply is lost is retried, without delaying the others
+ * - diffed write: only changed entries are written (with one block write, or one by one)
+ * - reconnection: accesses work after setRMAPInitiator() with an initiator of a new RMAPEngine
+ * - link control/status registers: without the cache every query reads the register; after a batch
+ *   refresh, queries cost no read until the cached values become stale; writes are reflected in the
+ *   cache; change actions are invoked for changed values. A subclass which does not implement
+ *   getLinkControlStatusRegisterAddress() gets NotImplemented from refreshLinkControlStatusRegisters().
+ *
+ * Usage: test_RouterConfigurationPort [TCP port number]
+ */
+
+#include "SpaceWireRMAPLibrary/SpaceWire.hh"
+#include "SpaceWireRMAPLibrary/RMAP.hh"
+
+#include <mutex>
+#include <thread>
+
+/** Emulates router registers (32-bit little-endian words), and counts accesses. */
+class RouterRegisters: public RMAPTargetAccessAction {
+public:
+	static const uint32_t Size = 0x1000;
+	static const uint32_t NoAddress = 0xffffffff;
+
+public:
+	std::mutex mutex;
+	std::vector<uint8_t> memory;
+	size_t nBlockReads = 0;
+	size_t nSingleReads = 0;
+	size_t nBlockWrites = 0;
+	size_t nSingleWrites = 0;
+	bool rejectBlockAccess = false;
+	uint32_t addressOfLostReply = NoAddress; //the reply of the next read of this address is lost
+
+public:
+	RouterRegisters() :
+			memory(Size, 0) {
+	}
+
+public:
+	void processTransaction(RMAPTransaction* rmapTransaction) throw (RMAPTargetAccessActionException) {
+		std::lock_guard<std::mutex> lock(mutex);
+		RMAPPacket* commandPacket = rmapTransaction->commandPacket;
+		uint32_t address = commandPacket->getAddress();
+		uint32_t length = commandPacket->getLength();
+		if (length > 4 && rejectBlockAccess) {
+			setReplyWithStatus(rmapTransaction, RMAPReplyStatus::CommandNotImplementedOrNotAuthorized);
+			return;
+		}
+		if (commandPacket->isRead()) {
+			(length > 4) ? nBlockReads++ : nSingleReads++;
+			if (address == addressOfLostReply) {
+				addressOfLostReply = NoAddress;
+				//the command is discarded without a reply
+				throw RMAPTargetAccessActionException(RMAPTargetAccessActionException::AccessToUndefinedAddressRange);
+			}
+			std::vector<uint8_t> data(&memory[address], &memory[address] + length);
+			setReplyWithDataWithStatus(rmapTransaction, &data, RMAPReplyStatus::CommandExcecutedSuccessfully);
+			return;
+		}
+		(length > 4) ? nBlockWrites++ : nSingleWrites++;
+		std::vector<uint8_t>* data = commandPacket->getDataBuffer();
+		std::copy(data->begin(), data->end(), &memory[address]);
+		setReplyWithStatus(rmapTransaction, RMAPReplyStatus::CommandExcecutedSuccessfully);
+	}
+
+public:
+	void resetCounters() {
+		nBlockReads = nSingleReads = nBlockWrites = nSingleWrites = 0;
+	}
+
+public:
+	uint32_t getEntry(uint8_t logicalAddress) {
+		uint8_t* p = &memory[getRoutingTableAddress(logicalAddress)];
+		return p[0] + (p[1] << 8) + (p[2] << 16) + ((uint32_t) p[3] << 24);
+	}
+
+public:
+	void setEntry(uint8_t logicalAddress, uint32_t entry) {
+		uint8_t* p = &memory[getRoutingTableAddress(logicalAddress)];
+		for (size_t i = 0; i < 4; i++) {
+			p[i] = (entry >> (i * 8)) & 0xff;
+		}
+	}
+
+public:
+	static uint32_t getRoutingTableAddress(uint8_t logicalAddress) {
+		return 0x80 + (logicalAddress - SpaceWireProtocol::MinimumLogicalAddress) * 4;
+	}
+};
+
+/** A router whose routing table is at RouterRegisters::getRoutingTableAddress(). */
+class TestRouter: public RouterConfigurationPort {
+public:
+	RMAPTargetNode* rmapTargetNode;
+
+public:
+	TestRouter(RMAPTargetNode* rmapTargetNode) :
+			rmapTargetNode(rmapTargetNode) {
+	}
+
+public:
+	RMAPTargetNode* getRMAPTargetNodeInstance() {
+		return rmapTargetNode;
+	}
+
+public:
+	size_t getTotalNumberOfPorts() {
+		return 6;
+	}
+
+public:
+	size_t getNumberOfExternalPorts() {
+		return 6;
+	}
+
+public:
+	size_t getNumberOfInternalPorts() {
+		return 0;
+	}
+
+public:
+	uint32_t getRoutingTableAddress(uint8_t logicalAddress) throw (RouterConfigurationPortException) {
+		return RouterRegisters::getRoutingTableAddress(logicalAddress);
+	}
+
+public:
+	RMAPMemoryObject* getRoutingTableMemoryObject(uint8_t logicalAddress) throw (RouterConfigurationPortException) {
+		throw RouterConfigurationPortException(RouterConfigurationPortException::NotImplemented);
+	}
+
+public:
+	uint32_t getLinkFrequencyRegisterAddress(uint8_t port) throw (RouterConfigurationPortException) {
+		throw RouterConfigurationPortException(RouterConfigurationPortException::NotImplemented);
+	}
+
+public:
+	RMAPMemoryObject* getLinkFrequencyRegisterMemoryObject(uint8_t port) throw (RouterConfigurationPortException) {
+		throw RouterConfigurationPortException(RouterConfigurationPortException::NotImplemented);
+	}
+
+public:
+	std::vector<double> getAvailableLinkFrequencies(uint8_t port) {
+		return std::vector<double>();
+	}
+
+public:
+	void setLinkFrequency(uint8_t port, double linkFrequency) throw (RouterConfigurationPortException,
+			RMAPInitiatorException) {
+	}
+
+public:
+	void setLinkEnable(uint8_t port) throw (RouterConfigurationPortException, RMAPInitiatorException) {
+	}
+
+public:
+	void unsetLinkEnable(uint8_t port) throw (RouterConfigurationPortException, RMAPInitiatorException) {
+	}
+
+public:
+	bool isLinkEnabled(uint8_t port) throw (RouterConfigurationPortException, RMAPInitiatorException) {
+		return true;
+	}
+
+public:
+	void setLinkStart(uint8_t port) throw (RouterConfigurationPortException, RMAPInitiatorException) {
+	}
+
+public:
+	void unsetLinkStart(uint8_t port) throw (RouterConfigurationPortException, RMAPInitiatorException) {
+	}
+
+public:
+	bool isLinkStarted(uint8_t port) throw (RouterConfigurationPortException, RMAPInitiatorException) {
+		return true;
+	}
+
+public:
+	void setAutoStart(uint8_t port) throw (RouterConfigurationPortException, RMAPInitiatorException) {
+	}
+
+public:
+	void unsetAutoStart(uint8_t port) throw (RouterConfigurationPortException, RMAPInitiatorException) {
+	}
+
+public:
+	bool isAutoStarted(uint8_t port) throw (RouterConfigurationPortException, RMAPInitiatorException) {
+		return true;
+	}
+
+public:
+	void applyNewPathAddresses(std::vector<uint8_t> targetSpaceWireAddress, std::vector<uint8_t> replyAddress) {
+	}
+};
+
+/** A router whose link control/status register of port n is at n * 4 (bit 1 of byte 2 = link disable),
+ * accessed via the register cache of RouterConfigurationPort.
+ */
+class CachingTestRouter: public TestRouter {
+public:
+	CachingTestRouter(RMAPTargetNode* rmapTargetNode) :
+			TestRouter(rmapTargetNode) {
+	}
+
+public:
+	uint32_t getLinkControlStatusRegisterAddress(uint8_t port) throw (RouterConfigurationPortException) {
+		return port * 4;
+	}
+
+public:
+	bool isLinkEnabled(uint8_t port) throw (RouterConfigurationPortException, RMAPInitiatorException) {
+		uint8_t value[4];
+		readLinkControlStatusRegister(port, value);
+		return (value[2] & 0x02) == 0;
+	}
+
+public:
+	void unsetLinkEnable(uint8_t port) throw (RouterConfigurationPortException, RMAPInitiatorException) {
+		uint8_t value[4];
+		readLinkControlStatusRegister(port, value);
+		value[2] |= 0x02;
+		rmapInitiator->write(rmapTargetNode, getLinkControlStatusRegisterAddress(port), value, 4);
+		writeThroughLinkControlStatusRegisterCache(port, value);
+	}
+
+private:
+	void readLinkControlStatusRegister(uint8_t port, uint8_t* value) {
+		if (readLinkControlStatusRegisterFromCache(port, value)) {
+			return;
+		}
+		double readTime = CxxUtilities::Time::getClockValueInMilliSec();
+		rmapInitiator->read(rmapTargetNode, getLinkControlStatusRegisterAddress(port), 4, value);
+		updateLinkControlStatusRegisterCache(port, value, readTime);
+	}
+};
+
+/** Records link status changes. */
+class LinkStatusChangeRecorder: public RouterConfigurationPortLinkStatusChangedAction {
+public:
+	std::vector<uint8_t> ports;
+	std::vector<uint32_t> previousValues;
+	std::vector<uint32_t> newValues;
+
+public:
+	void doAction(RouterConfigurationPort* routerConfigurationPort, uint8_t port, const uint8_t* previousValue,
+			const uint8_t* newValue) {
+		ports.push_back(port);
+		previousValues.push_back(previousValue[0] + (previousValue[1] << 8) + (previousValue[2] << 16));
+		newValues.push_back(newValue[0] + (newValue[1] << 8) + (newValue[2] << 16));
+	}
+};
+
+/** Serves a target over SpaceWireIFOverTCP (server mode). */
+class TargetServer {
+public:
+	SpaceWireIFOverTCP* spwif;
+	RMAPEngine* rmapEngine;
+	std::thread thread;
+
+public:
+	TargetServer(uint32_t portNumber, RMAPTarget* target) {
+		spwif = new SpaceWireIFOverTCP(portNumber);
+		rmapEngine = NULL;
+		thread = std::thread([this, target]() {
+			spwif->open();
+			rmapEngine = new RMAPEngine(spwif);
+			rmapEngine->addRMAPTarget(target);
+			rmapEngine->start();
+		});
+	}
+
+public:
+	void waitForStart() {
+		thread.join();
+		while (!rmapEngine->isStarted()) {
+			CxxUtilities::Condition c;
+			c.wait(10);
+		}
+	}
+};
+
+/** Connects to a TargetServer, and returns an initiator of a new RMAPEngine. */
+RMAPInitiator* connect(uint32_t portNumber, TargetServer& server) {
+	CxxUtilities::Condition c;
+	c.wait(100);
+	SpaceWireIFOverTCP* spwif = new SpaceWireIFOverTCP("127.0.0.1", portNumber);
+	try {
+		spwif->open();
+	} catch (...) {
+		std::cerr << "Could not connect to the target" << std::endl;
+		exit(1);
+	}
+	server.waitForStart();
+	RMAPEngine* rmapEngine = new RMAPEngine(spwif);
+	rmapEngine->start();
+	while (!rmapEngine->isStarted()) {
+		c.wait(10);
+	}
+	return new RMAPInitiator(rmapEngine);
+}
+
+/** Returns the number of entries which differ from the registers. */
+size_t countMismatchedEntries(const std::vector<std::vector<uint8_t> >& routingTable, RouterRegisters& registers) {
+	size_t nMismatches = 0;
+	for (size_t i = 0; i < routingTable.size(); i++) {
+		uint32_t entry = 0;
+		for (auto port : routingTable[i]) {
+			entry |= 0x01u << port;
+		}
+		if (entry != registers.getEntry(SpaceWireProtocol::MinimumLogicalAddress + i)) {
+			nMismatches++;
+		}
+	}
+	return nMismatches + (RouterConfigurationPort::NumberOfRoutingTableEntries - routingTable.size());
+}
+
+int main(int argc, char* argv[]) {
+	using namespace std;
+	uint32_t portNumber = 10170;
+	if (argc > 1) {
+		portNumber = atoi(argv[1]);
+	}
+	RMAPTargetNode* rmapTargetNode = new RMAPTargetNode();
+	rmapTargetNode->setTargetLogicalAddress(0xFE);
+	rmapTargetNode->setDefaultKey(0x00);
+	rmapTargetNode->setInitiatorLogicalAddress(0xFE);
+	RouterRegisters registers;
+	for (size_t logicalAddress = SpaceWireProtocol::MinimumLogicalAddress;
+			logicalAddress <= SpaceWireProtocol::MaximumLogicalAddress; logicalAddress++) {
+		registers.setEntry(logicalAddress, 0x01u << (logicalAddress % 7));
+	}
+	RMAPTarget rmapTarget;
+	rmapTarget.addAddressRangeAndAssociatedAction(new RMAPAddressRange(0, RouterRegisters::Size - 1), &registers);
+	TargetServer server(portNumber, &rmapTarget);
+	RMAPInitiator* rmapInitiator = connect(portNumber, server);
+	TestRouter router(rmapTargetNode);
+	router.setRMAPInitiator(rmapInitiator);
+	router.setRegisterAccessTimeoutDuration(200);
+	const size_t nEntries = RouterConfigurationPort::NumberOfRoutingTableEntries;
+	size_t nErrors = 0;
+
+	//block read
+	std::vector<std::vector<uint8_t> > routingTable = router.readWholeRoutingTable();
+	cout << "Block read: " << registers.nBlockReads << " block reads, " << registers.nSingleReads << " single reads"
+			<< endl;
+	if (countMismatchedEntries(routingTable, registers) != 0 || registers.nBlockReads != 1
+			|| registers.nSingleReads != 0) {
+		nErrors++;
+	}
+
+	//diffed write with one block write covering the changed entries
+	registers.resetCounters();
+	routingTable[5] = {1, 2};
+	routingTable[100] = {3};
+	size_t nChangedEntries = router.writeWholeRoutingTable(routingTable);
+	size_t nUnchangedEntries = router.writeWholeRoutingTable(routingTable);
+	cout << "Diffed block write: " << nChangedEntries << " changed entries, " << registers.nBlockWrites
+			<< " block writes, " << registers.nSingleWrites << " single writes" << endl;
+	if (nChangedEntries != 2 || nUnchangedEntries != 0 || countMismatchedEntries(routingTable, registers) != 0
+			|| registers.nBlockWrites != 1 || registers.nSingleWrites != 0 || registers.nBlockReads != 0) {
+		nErrors++;
+	}
+
+	//pipelined read from a router which rejects block access, with a lost reply
+	registers.rejectBlockAccess = true;
+	registers.addressOfLostReply = RouterRegisters::getRoutingTableAddress(0x40);
+	registers.resetCounters();
+	router.invalidateRoutingTableCache();
+	double startTime = CxxUtilities::Time::getClockValueInMilliSec();
+	routingTable = router.readWholeRoutingTable();
+	double elapsedTime = CxxUtilities::Time::getClockValueInMilliSec() - startTime;
+	cout << "Pipelined read with a lost reply: " << registers.nSingleReads << " single reads in " << elapsedTime
+			<< " ms, block access used = " << router.isRoutingTableBlockAccessUsed() << endl;
+	//all entries and the retry of the lost one; the lost reply costs one timeout, not one per entry
+	if (countMismatchedEntries(routingTable, registers) != 0 || registers.nSingleReads != nEntries + 1
+			|| router.isRoutingTableBlockAccessUsed() || elapsedTime > 5 * router.getRegisterAccessTimeoutDuration()) {
+		nErrors++;
+	}
+
+	//diffed write one by one
+	registers.resetCounters();
+	routingTable[5] = {4};
+	routingTable[200] = {0, 5};
+	nChangedEntries = router.writeWholeRoutingTable(routingTable);
+	cout << "Diffed pipelined write: " << nChangedEntries << " changed entries, " << registers.nSingleWrites
+			<< " single writes" << endl;
+	if (nChangedEntries != 2 || countMismatchedEntries(routingTable, registers) != 0 || registers.nSingleWrites != 2
+			|| registers.nBlockWrites != 0) {
+		nErrors++;
+	}
+
+	//reconnection with a new RMAPEngine
+	rmapInitiator->getRMAPEngine()->stop();
+	TargetServer secondServer(portNumber + 1, &rmapTarget);
+	router.setRMAPInitiator(connect(portNumber + 1, secondServer));
+	registers.resetCounters();
+	routingTable = router.readWholeRoutingTable();
+	if (countMismatchedEntries(routingTable, registers) != 0 || registers.nSingleReads != nEntries) {
+		cout << "Reconnection: routing table could not be read" << endl;
+		nErrors++;
+	}
+
+	//getLinkControlStatusRegisterAddress() is not implemented by TestRouter
+	try {
+		router.refreshLinkControlStatusRegisters();
+		cout << "Refresh without register addresses did not throw" << endl;
+		nErrors++;
+	} catch (RouterConfigurationPortException& e) {
+		if (e.getStatus() != RouterConfigurationPortException::NotImplemented) {
+			nErrors++;
+		}
+	}
+
+	//link control/status registers: 60 queries over 6 ports, without and with the cache
+	CachingTestRouter cachingRouter(rmapTargetNode);
+	cachingRouter.setRMAPInitiator(router.getRMAPInitiator());
+	LinkStatusChangeRecorder recorder;
+	cachingRouter.addLinkStatusChangedAction(&recorder);
+	const size_t nQueries = 60;
+	std::vector<uint8_t> ports = cachingRouter.getConfigurablePorts();
+	registers.resetCounters();
+	for (size_t i = 0; i < nQueries; i++) {
+		cachingRouter.isLinkEnabled(ports[i % ports.size()]);
+	}
+	size_t nUncachedReads = registers.nSingleReads;
+	cachingRouter.setLinkControlStatusRegisterMaximumAge(1000);
+	registers.resetCounters();
+	cachingRouter.refreshLinkControlStatusRegisters();
+	size_t nRefreshReads = registers.nSingleReads;
+	registers.resetCounters();
+	for (size_t i = 0; i < nQueries; i++) {
+		cachingRouter.isLinkEnabled(ports[i % ports.size()]);
+	}
+	cout << "Link status: " << nQueries << " queries cost " << nUncachedReads << " reads without the cache, "
+			<< registers.nSingleReads << " reads after a refresh of " << nRefreshReads << " reads" << endl;
+	if (nUncachedReads != nQueries || nRefreshReads != ports.size() || registers.nSingleReads != 0) {
+		nErrors++;
+	}
+
+	//write-through: a disable costs one write, and the cached value reflects it
+	registers.resetCounters();
+	cachingRouter.unsetLinkEnable(3);
+	bool isEnabled = cachingRouter.isLinkEnabled(3);
+	if (isEnabled || registers.nSingleReads != 0 || registers.nSingleWrites != 1 || (registers.memory[3 * 4 + 2] & 0x02) == 0
+			|| recorder.ports.size() != 1 || recorder.ports[0] != 3 || recorder.newValues[0] != 0x020000) {
+		cout << "Link status: write was not reflected in the cache" << endl;
+		nErrors++;
+	}
+
+	//change actions on refresh: only for registers which changed
+	registers.memory[2 * 4] = 0x10;
+	cachingRouter.refreshLinkControlStatusRegisters();
+	cachingRouter.refreshLinkControlStatusRegisters();
+	if (recorder.ports.size() != 2 || recorder.ports[1] != 2 || recorder.previousValues[1] != 0
+			|| recorder.newValues[1] != 0x10) {
+		cout << "Link status: " << recorder.ports.size() << " change actions" << endl;
+		nErrors++;
+	}
+
+	//staleness: a cached value older than the maximum age is read again
+	cachingRouter.setLinkControlStatusRegisterMaximumAge(50);
+	cachingRouter.refreshLinkControlStatusRegisters();
+	registers.resetCounters();
+	cachingRouter.isLinkEnabled(1);
+	size_t nFreshReads = registers.nSingleReads;
+	CxxUtilities::Condition c;
+	c.wait(100);
+	cachingRouter.isLinkEnabled(1);
+	if (nFreshReads != 0 || registers.nSingleReads != 1) {
+		cout << "Link status: stale value was used" << endl;
+		nErrors++;
+	}
+
+	cout << nErrors << " errors" << endl;
+	return (nErrors == 0) ? 0 : 1;
+}
@@ -0,0 +1,430 @@
+/*
+ * test_RouterNetworkDiscovery.cc
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+/* Tests RouterNetworkDiscovery on a simulated network of 10 routers connected as a tree
+ * (with arbitrary arrival ports), with nodes other than routers at two ports.
+ * The simulated network is a SpaceWireIF which routes packets by path address, and executes
+ * RMAP commands addressed to the configuration port (0x00) of a router.
+ * - all routers are found with the right parents, ports and routing tables, and ports leading to
+ *   other nodes are reported as non-router ports; the discovery takes much less than a second
+ * - probes which could not be sent (the link to one router fails when sending) are reported
+ *   as failed probes, not as non-router ports
+ *
+ * Usage: test_RouterNetworkDiscovery [probe timeout in ms]
+ */
+
+#include "SpaceWireRMAPLibrary/SpaceWire.hh"
+#include "SpaceWireRMAPLibrary/RMAP.hh"
+#include "SpaceWireRMAPLibrary/RouterNetworkDiscovery.hh"
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <set>
+
+/** A network of routers with 6 ports. Router 0 port 1 is connected to this interface.
+ * The link control/status register of port n of a router is at n * 4 (0x10 = connected),
+ * and the routing table entry of logical address n is at 0x80 + (n - 0x20) * 4.
+ */
+class SimulatedNetwork: public SpaceWireIF {
+public:
+	enum {
+		Host = -1, NonRouter = -2
+	};
+	static const uint32_t RegisterSize = 0x1000;
+
+public:
+	std::vector<std::vector<uint8_t> > registers;
+	std::map<std::pair<int, uint8_t>, std::pair<int, uint8_t> > links; //(router, port) -> (router or Host/NonRouter, port)
+	std::set<std::pair<int, uint8_t> > failingLinks; //sending a command through these links fails
+	size_t nCommands = 0;
+
+private:
+	std::mutex mutex;
+	std::condition_variable condition;
+	std::deque<std::vector<uint8_t> > receivedPackets;
+
+public:
+	SimulatedNetwork(size_t nRouters) :
+			SpaceWireIF(), registers(nRouters, std::vector<uint8_t>(RegisterSize, 0)) {
+		links[std::make_pair(0, 1)] = std::make_pair((int) Host, 0);
+	}
+
+public:
+	void connect(int router1, uint8_t port1, int router2, uint8_t port2) {
+		links[std::make_pair(router1, port1)] = std::make_pair(router2, port2);
+		if (router2 >= 0) {
+			links[std::make_pair(router2, port2)] = std::make_pair(router1, port1);
+		}
+	}
+
+public:
+	/** Sets the connected bits of link control/status registers of linked ports. */
+	void updateLinkStatus() {
+		for (auto& link : links) {
+			registers[link.first.first][link.first.second * 4] = 0x10;
+		}
+	}
+
+public:
+	void open() throw (SpaceWireIFException) {
+		state = Opened;
+	}
+
+public:
+	void send(uint8_t* data, size_t length, SpaceWireEOPMarker::EOPType eopType = SpaceWireEOPMarker::EOP)
+			throw (SpaceWireIFException) {
+		std::vector<uint8_t> packet(data, data + length);
+		std::lock_guard<std::mutex> lock(mutex);
+		deliver(0, packet, true);
+	}
+
+public:
+	void receive(std::vector<uint8_t>* buffer) throw (SpaceWireIFException) {
+		std::unique_lock<std::mutex> lock(mutex);
+		if (!condition.wait_for(lock, std::chrono::milliseconds(100), [this]() {return !receivedPackets.empty();})) {
+			throw SpaceWireIFException(SpaceWireIFException::Timeout);
+		}
+		*buffer = receivedPackets.front();
+		receivedPackets.pop_front();
+	}
+
+public:
+	void emitTimecode(uint8_t timeIn, uint8_t controlFlagIn = 0x00) throw (SpaceWireIFException) {
+	}
+
+public:
+	void setTxLinkRate(uint32_t linkRateType) throw (SpaceWireIFException) {
+	}
+
+public:
+	uint32_t getTxLinkRateType() throw (SpaceWireIFException) {
+		return 0;
+	}
+
+public:
+	void setTimeoutDuration(double microsecond) throw (SpaceWireIFException) {
+	}
+
+public:
+	void cancelReceive() {
+	}
+
+public:
+	/** Returns the router reached by a path address from router 0 (Host/NonRouter if none). */
+	int getRouterAt(const std::vector<uint8_t>& path) {
+		int router = 0;
+		for (auto port : path) {
+			auto it = links.find(std::make_pair(router, port));
+			if (it == links.end() || it->second.first < 0) {
+				return NonRouter;
+			}
+			router = it->second.first;
+		}
+		return router;
+	}
+
+public:
+	/** Returns the port set to a routing table entry of a router (one port per logical address). */
+	static uint8_t getRoutingTablePort(size_t router, size_t index) {
+		return (index + router) % 6 + 1;
+	}
+
+private:
+	/** Routes a packet arriving at a router (called with mutex locked). */
+	void deliver(int router, std::vector<uint8_t>& packet, bool isCommand) throw (SpaceWireIFException) {
+		size_t index = 0;
+		while (index < packet.size()) {
+			uint8_t port = packet[index++];
+			if (port == 0x00) {
+				std::vector<uint8_t> rest(packet.begin() + index, packet.end());
+				execute(router, rest);
+				return;
+			}
+			if (isCommand && failingLinks.count(std::make_pair(router, port)) != 0) {
+				throw SpaceWireIFException(SpaceWireIFException::Disconnected);
+			}
+			auto it = links.find(std::make_pair(router, port));
+			if (it == links.end() || it->second.first == NonRouter) {
+				return;
+			}
+			if (it->second.first == Host) {
+				receivedPackets.push_back(std::vector<uint8_t>(packet.begin() + index, packet.end()));
+				condition.notify_one();
+				return;
+			}
+			router = it->second.first;
+		}
+	}
+
+private:
+	void execute(int router, std::vector<uint8_t>& packet) {
+		nCommands++;
+		RMAPPacket command;
+		command.interpretAsAnRMAPPacket(packet);
+		RMAPPacket* reply = RMAPPacket::constructReplyForCommand(&command);
+		uint8_t* memory = &registers[router][command.getAddress()];
+		if (command.isRead()) {
+			std::vector<uint8_t> data(memory, memory + command.getLength());
+			reply->setData(data);
+		} else {
+			std::vector<uint8_t>* data = command.getDataBuffer();
+			std::copy(data->begin(), data->end(), memory);
+		}
+		reply->constructPacket();
+		std::vector<uint8_t> replyPacket = *reply->getPacketBufferPointer();
+		delete reply;
+		deliver(router, replyPacket, false);
+	}
+};
+
+/** A router of SimulatedNetwork. */
+class SimulatedRouter: public RouterConfigurationPort {
+private:
+	RMAPTargetNode rmapTargetNode;
+
+public:
+	SimulatedRouter() {
+		rmapTargetNode.setTargetLogicalAddress(0xFE);
+		rmapTargetNode.setDefaultKey(0x02);
+		rmapTargetNode.setInitiatorLogicalAddress(0xFE);
+	}
+
+public:
+	RMAPTargetNode* getRMAPTargetNodeInstance() {
+		return &rmapTargetNode;
+	}
+
+public:
+	size_t getTotalNumberOfPorts() {
+		return 7;
+	}
+
+public:
+	size_t getNumberOfExternalPorts() {
+		return 6;
+	}
+
+public:
+	size_t getNumberOfInternalPorts() {
+		return 0;
+	}
+
+public:
+	uint32_t getRoutingTableAddress(uint8_t logicalAddress) throw (RouterConfigurationPortException) {
+		return 0x80 + (logicalAddress - SpaceWireProtocol::MinimumLogicalAddress) * 4;
+	}
+
+public:
+	RMAPMemoryObject* getRoutingTableMemoryObject(uint8_t logicalAddress) throw (RouterConfigurationPortException) {
+		throw RouterConfigurationPortException(RouterConfigurationPortException::NotImplemented);
+	}
+
+public:
+	uint32_t getLinkFrequencyRegisterAddress(uint8_t port) throw (RouterConfigurationPortException) {
+		throw RouterConfigurationPortException(RouterConfigurationPortException::NotImplemented);
+	}
+
+public:
+	uint32_t getLinkControlStatusRegisterAddress(uint8_t port) throw (RouterConfigurationPortException) {
+		return port * 4;
+	}
+
+public:
+	RMAPMemoryObject* getLinkFrequencyRegisterMemoryObject(uint8_t port) throw (RouterConfigurationPortException) {
+		throw RouterConfigurationPortException(RouterConfigurationPortException::NotImplemented);
+	}
+
+public:
+	std::vector<double> getAvailableLinkFrequencies(uint8_t port) {
+		return std::vector<double>();
+	}
+
+public:
+	void setLinkFrequency(uint8_t port, double linkFrequency) throw (RouterConfigurationPortException,
+			RMAPInitiatorException) {
+	}
+
+public:
+	void setLinkEnable(uint8_t port) throw (RouterConfigurationPortException, RMAPInitiatorException) {
+	}
+
+public:
+	void unsetLinkEnable(uint8_t port) throw (RouterConfigurationPortException, RMAPInitiatorException) {
+	}
+
+public:
+	bool isLinkEnabled(uint8_t port) throw (RouterConfigurationPortException, RMAPInitiatorException) {
+		return true;
+	}
+
+public:
+	void setLinkStart(uint8_t port) throw (RouterConfigurationPortException, RMAPInitiatorException) {
+	}
+
+public:
+	void unsetLinkStart(uint8_t port) throw (RouterConfigurationPortException, RMAPInitiatorException) {
+	}
+
+public:
+	bool isLinkStarted(uint8_t port) throw (RouterConfigurationPortException, RMAPInitiatorException) {
+		return true;
+	}
+
+public:
+	void setAutoStart(uint8_t port) throw (RouterConfigurationPortException, RMAPInitiatorException) {
+	}
+
+public:
+	void unsetAutoStart(uint8_t port) throw (RouterConfigurationPortException, RMAPInitiatorException) {
+	}
+
+public:
+	bool isAutoStarted(uint8_t port) throw (RouterConfigurationPortException, RMAPInitiatorException) {
+		return true;
+	}
+
+public:
+	void applyNewPathAddresses(std::vector<uint8_t> targetSpaceWireAddress, std::vector<uint8_t> replyAddress) {
+		targetSpaceWireAddress.push_back(0x00);
+		rmapTargetNode.setTargetSpaceWireAddress(targetSpaceWireAddress);
+		rmapTargetNode.setReplyAddress(replyAddress);
+		invalidateRoutingTableCache();
+		invalidateLinkControlStatusRegisterCache();
+	}
+
+public:
+	void readLinkControlStatusRegister(uint8_t port, uint8_t* value) {
+		if (readLinkControlStatusRegisterFromCache(port, value)) {
+			return;
+		}
+		double readTime = CxxUtilities::Time::getClockValueInMilliSec();
+		rmapInitiator->read(&rmapTargetNode, getLinkControlStatusRegisterAddress(port), 4, value);
+		updateLinkControlStatusRegisterCache(port, value, readTime);
+	}
+
+public:
+	bool isConnected(uint8_t port) {
+		uint8_t value[4];
+		readLinkControlStatusRegister(port, value);
+		return (value[0] & 0x10) != 0;
+	}
+};
+
+/** Checks a discovered topology against the network.
+ * @return number of errors
+ */
+size_t checkTopology(RouterNetworkTopology& topology, SimulatedNetwork& network, size_t nExpectedRouters,
+		size_t nExpectedNonRouterPorts) {
+	using namespace std;
+	size_t nErrors = 0;
+	std::set<int> foundRouters;
+	size_t nNonRouterPorts = 0;
+	for (auto& router : topology.routers) {
+		int id = network.getRouterAt(router.targetSpaceWireAddress);
+		if (id < 0 || foundRouters.count(id) != 0 || !router.isHealthy) {
+			cout << "Router at path [" << CxxUtilities::Array<uint8_t>::toString(router.targetSpaceWireAddress, "hex", 128)
+					<< "] is wrong" << endl;
+			nErrors++;
+			continue;
+		}
+		foundRouters.insert(id);
+		if (router.parentIndex != DiscoveredRouter::NoParent) {
+			int parent = network.getRouterAt(topology.routers[router.parentIndex].targetSpaceWireAddress);
+			auto link = network.links[std::make_pair(parent, router.parentPort)];
+			if (link.first != id || link.second != router.arrivalPort) {
+				cout << "Router " << id << ": wrong parent port or arrival port" << endl;
+				nErrors++;
+			}
+		}
+		if (router.routingTable.size() != RouterConfigurationPort::NumberOfRoutingTableEntries) {
+			cout << "Router " << id << ": routing table was not read" << endl;
+			nErrors++;
+		}
+		for (size_t i = 0; i < router.routingTable.size(); i++) {
+			if (router.routingTable[i] != std::vector<uint8_t> { SimulatedNetwork::getRoutingTablePort(id, i) }) {
+				cout << "Router " << id << ": wrong routing table" << endl;
+				nErrors++;
+				break;
+			}
+		}
+		nNonRouterPorts += router.nonRouterPorts.size();
+	}
+	if (foundRouters.size() != nExpectedRouters || nNonRouterPorts != nExpectedNonRouterPorts) {
+		cout << foundRouters.size() << " routers and " << nNonRouterPorts << " non-router ports were found" << endl;
+		nErrors++;
+	}
+	return nErrors;
+}
+
+int main(int argc, char* argv[]) {
+	using namespace std;
+	double probeTimeoutDuration = 50;
+	if (argc > 1) {
+		probeTimeoutDuration = atof(argv[1]);
+	}
+	const size_t nRouters = 10;
+	SimulatedNetwork network(nRouters);
+	network.connect(0, 2, 1, 5);
+	network.connect(0, 3, 2, 1);
+	network.connect(1, 1, 3, 6);
+	network.connect(1, 2, 4, 3);
+	network.connect(2, 4, 5, 2);
+	network.connect(2, 6, 6, 1);
+	network.connect(3, 2, 7, 4);
+	network.connect(5, 3, 8, 6);
+	network.connect(8, 1, 9, 2);
+	network.connect(4, 4, (int) SimulatedNetwork::NonRouter, 0);
+	network.connect(9, 5, (int) SimulatedNetwork::NonRouter, 0);
+	network.updateLinkStatus();
+	for (size_t router = 0; router < nRouters; router++) {
+		for (size_t i = 0; i < RouterConfigurationPort::NumberOfRoutingTableEntries; i++) {
+			network.registers[router][0x80 + i * 4] = 1 << SimulatedNetwork::getRoutingTablePort(router, i);
+		}
+	}
+	network.open();
+	RMAPEngine* rmapEngine = new RMAPEngine(&network);
+	rmapEngine->start();
+	while (!rmapEngine->isStarted()) {
+		CxxUtilities::Condition c;
+		c.wait(10);
+	}
+	RMAPInitiator* rmapInitiator = new RMAPInitiator(rmapEngine);
+	RouterNetworkDiscovery<SimulatedRouter> discovery(rmapInitiator);
+	discovery.setProbeTimeoutDuration(probeTimeoutDuration);
+	size_t nErrors = 0;
+
+	//all routers
+	RouterNetworkTopology topology = discovery.discover( { }, { 1 });
+	cout << topology.toString();
+	nErrors += checkTopology(topology, network, nRouters, 2);
+	if (topology.discoveryTime > 1000 || topology.nFailedProbes != 0) {
+		nErrors++;
+	}
+
+	//the link from router 2 port 6 to router 6 fails when sending
+	network.failingLinks.insert(std::make_pair(2, 6));
+	topology = discovery.discover( { }, { 1 });
+	size_t nFailedProbePorts = 0;
+	bool isFailedPortReported = false;
+	for (auto& router : topology.routers) {
+		nFailedProbePorts += router.failedProbePorts.size();
+		if (network.getRouterAt(router.targetSpaceWireAddress) == 2 && router.failedProbePorts.size() == 1
+				&& router.failedProbePorts[0] == 6) {
+			isFailedPortReported = true;
+		}
+	}
+	cout << "Failing link: " << topology.routers.size() << " routers, " << topology.nFailedProbes
+			<< " failed probes" << endl;
+	nErrors += checkTopology(topology, network, nRouters - 1, 2);
+	if (!isFailedPortReported || nFailedProbePorts != 1 || topology.nFailedProbes == 0) {
+		nErrors++;
+	}
+
+	rmapEngine->stop();
+	cout << nErrors << " errors" << endl;
+	return (nErrors == 0) ? 0 : 1;
+}
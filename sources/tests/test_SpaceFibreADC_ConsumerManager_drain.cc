@@ -0,0 +1,284 @@
+/*
+ * test_SpaceFibreADC_ConsumerManager_drain.cc
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+/* Tests ConsumerManager::drain() against an emulated SDRAM ring buffer served over
+ * SpaceWire-to-GigabitEther on localhost.
+ * - chunking: the readable region is read in chunks of the configured size
+ * - lazy ReadPointer update: ReadPointer on FPGA is updated only every readPointerUpdateInterval
+ *   bytes or when caught up, and WritePointer is fetched only when all known data have been read
+ * - wrap-around: one drain() call reads both sides of the end of the ring buffer
+ * - reconnection: drain() keeps working after RMAPHandler is disconnected and connected again
+ * Drained data are 16-bit counter values, so that lost or duplicated data are detected.
+ *
+ * Usage: test_SpaceFibreADC_ConsumerManager_drain [TCP port number]
+ */
+
+#include "SpaceWireRMAPLibrary/SpaceWire.hh"
+#include "SpaceWireRMAPLibrary/RMAP.hh"
+#include "SpaceWireRMAPLibrary/Boards/SpaceFibreADC.hh"
+#include "SpaceWireRMAPLibrary/Boards/SpaceFibreADCBoardModules/ConsumerManager.hh"
+
+#include <mutex>
+#include <thread>
+
+/** Emulates the SDRAM ring buffer and the pointer registers of the ConsumerManager module.
+ * Written data are 16-bit counter values (the word at linear byte position p is p/2).
+ */
+class SDRAMRingBuffer: public RMAPTargetAccessAction {
+public:
+	static const uint32_t Size = ConsumerManager::FinalAddressOf_Sdram_EventList + 2;
+
+public:
+	std::mutex mutex;
+	std::vector<uint8_t> sdram;
+	std::map<uint32_t, uint8_t> registers;
+	uint64_t writerPosition = 2; //linear byte position of the next word to be written
+	uint64_t readerPosition = 0; //linear byte position following ReadPointer
+	uint32_t latchedReadPointer = 0;
+	uint64_t nReaderLaps = 0;
+	size_t nSDRAMReads = 0;
+	size_t maximumSDRAMReadLength = 0;
+	size_t nWritePointerReads = 0;
+	size_t nReadPointerUpdates = 0;
+
+public:
+	SDRAMRingBuffer() :
+			sdram(Size, 0) {
+	}
+
+public:
+	/** Writes nBytes of data (less if the ring buffer is full).
+	 * @return written size in bytes
+	 */
+	size_t produce(size_t nBytes) {
+		std::lock_guard<std::mutex> lock(mutex);
+		size_t nWrittenBytes = 0;
+		while (nWrittenBytes < nBytes && writerPosition - readerPosition < Size - 4096) {
+			uint16_t value = (uint16_t) (writerPosition / 2);
+			uint32_t address = writerPosition % Size;
+			sdram[address] = value & 0xff;
+			sdram[address + 1] = value >> 8;
+			writerPosition += 2;
+			nWrittenBytes += 2;
+		}
+		return nWrittenBytes;
+	}
+
+public:
+	void processTransaction(RMAPTransaction* rmapTransaction) throw (RMAPTargetAccessActionException) {
+		std::lock_guard<std::mutex> lock(mutex);
+		RMAPPacket* commandPacket = rmapTransaction->commandPacket;
+		uint32_t address = commandPacket->getAddress();
+		uint32_t length = commandPacket->getLength();
+		if (commandPacket->isRead()) {
+			std::vector<uint8_t> data(length);
+			if (address < Size) {
+				nSDRAMReads++;
+				maximumSDRAMReadLength = std::max<size_t>(maximumSDRAMReadLength, length);
+				std::copy(&sdram[address], &sdram[address] + length, data.begin());
+			} else {
+				if (address == ConsumerManager::AddressOf_WritePointerRegister_High) {
+					nWritePointerReads++;
+				}
+				uint32_t writePointer = (writerPosition - 2) % Size;
+				bool guardBit = (writerPosition - 2) / Size > nReaderLaps;
+				setRegister(ConsumerManager::AddressOf_WritePointerRegister_High, writePointer >> 16);
+				setRegister(ConsumerManager::AddressOf_WritePointerRegister_Low, writePointer & 0xffff);
+				setRegister(ConsumerManager::AddressOf_GuardBitRegister, guardBit ? 1 : 0);
+				for (uint32_t i = 0; i < length; i++) {
+					data[i] = registers[address + i];
+				}
+			}
+			setReplyWithDataWithStatus(rmapTransaction, &data, RMAPReplyStatus::CommandExcecutedSuccessfully);
+			return;
+		}
+		std::vector<uint8_t>* data = commandPacket->getDataBuffer();
+		for (uint32_t i = 0; i < data->size(); i++) {
+			registers[address + i] = (*data)[i];
+		}
+		if (address == ConsumerManager::AddressOf_AddressUpdateGoRegister) {
+			uint32_t readPointer = getRegister(ConsumerManager::AddressOf_ReadPointerRegister_High) << 16
+					| getRegister(ConsumerManager::AddressOf_ReadPointerRegister_Low);
+			if (readPointer < latchedReadPointer) {
+				nReaderLaps++;
+			}
+			latchedReadPointer = readPointer;
+			readerPosition = nReaderLaps * Size + readPointer + 2;
+			nReadPointerUpdates++;
+		}
+		setReplyWithStatus(rmapTransaction, RMAPReplyStatus::CommandExcecutedSuccessfully);
+	}
+
+private:
+	//16-bit registers are little endian (see ConsumerManager::getWritePointer())
+	void setRegister(uint32_t address, uint16_t value) {
+		registers[address] = value & 0xff;
+		registers[address + 1] = value >> 8;
+	}
+
+private:
+	uint16_t getRegister(uint32_t address) {
+		return registers[address] + registers[address + 1] * 0x100;
+	}
+};
+
+/** Serves a target over SpaceWireIFOverTCP (server mode). */
+class TargetServer {
+public:
+	SpaceWireIFOverTCP* spwif;
+	RMAPEngine* rmapEngine;
+	std::thread thread;
+
+public:
+	TargetServer(uint32_t portNumber, RMAPTarget* target) {
+		spwif = new SpaceWireIFOverTCP(portNumber);
+		rmapEngine = NULL;
+		thread = std::thread([this, target]() {
+			spwif->open();
+			rmapEngine = new RMAPEngine(spwif);
+			rmapEngine->addRMAPTarget(target);
+			rmapEngine->start();
+		});
+	}
+
+public:
+	void waitForStart() {
+		thread.join();
+		while (!rmapEngine->isStarted()) {
+			CxxUtilities::Condition c;
+			c.wait(10);
+		}
+	}
+};
+
+/** RMAPHandler which can be connected to another port. */
+class TestRMAPHandler: public RMAPHandler {
+public:
+	TestRMAPHandler(uint32_t portNumber, RMAPTargetNode* adcRMAPTargetNode) :
+			RMAPHandler("127.0.0.1", portNumber, { adcRMAPTargetNode }) {
+	}
+
+public:
+	void connect(uint32_t portNumber, TargetServer& server) {
+		this->tcpPortNumber = portNumber;
+		CxxUtilities::Condition c;
+		c.wait(100);
+		if (!connectoToSpaceWireToGigabitEther()) {
+			std::cerr << "Could not connect to the target" << std::endl;
+			exit(1);
+		}
+		server.waitForStart();
+	}
+};
+
+/** Checks that drained data continue the 16-bit counter. */
+class DataChecker {
+public:
+	uint16_t expectedValue = 0;
+	size_t nBytes = 0;
+	size_t nMismatches = 0;
+
+public:
+	void check(const std::vector<uint8_t>& data) {
+		for (size_t i = 0; i + 1 < data.size(); i += 2) {
+			uint16_t value = data[i] + data[i + 1] * 0x100;
+			if (value != expectedValue) {
+				if (nMismatches == 0) {
+					std::cerr << "Data mismatch at byte " << nBytes + i << std::endl;
+				}
+				nMismatches++;
+				expectedValue = value;
+			}
+			expectedValue++;
+		}
+		nBytes += data.size();
+	}
+};
+
+int main(int argc, char* argv[]) {
+	using namespace std;
+	uint32_t portNumber = 10150;
+	if (argc > 1) {
+		portNumber = atoi(argv[1]);
+	}
+	RMAPTargetNode* adcRMAPTargetNode = new RMAPTargetNode();
+	adcRMAPTargetNode->setID("ADCBox");
+	adcRMAPTargetNode->setTargetLogicalAddress(0xFE);
+	adcRMAPTargetNode->setDefaultKey(0x00);
+	adcRMAPTargetNode->setInitiatorLogicalAddress(0xFE);
+	SDRAMRingBuffer ringBuffer;
+	RMAPTarget rmapTarget;
+	rmapTarget.addAddressRangeAndAssociatedAction(new RMAPAddressRange(0, 0x01ffffff), &ringBuffer);
+	TargetServer server(portNumber, &rmapTarget);
+	TestRMAPHandler rmapHandler(portNumber, adcRMAPTargetNode);
+	rmapHandler.connect(portNumber, server);
+	ConsumerManager consumerManager(&rmapHandler);
+	const size_t chunkSize = 4096;
+	const size_t readPointerUpdateInterval = 1024 * 1024;
+	consumerManager.setDrainParameters(chunkSize, 3, readPointerUpdateInterval);
+	DataChecker checker;
+	std::vector<uint8_t> data;
+	size_t nErrors = 0;
+
+	//chunking and lazy ReadPointer update: 1 MB + 4 kB drained with 256 kB per call
+	size_t nProducedBytes = ringBuffer.produce(1024 * 1024 + 4096);
+	for (size_t i = 0; i < 5; i++) {
+		consumerManager.drain(data, 256 * 1024);
+		checker.check(data);
+	}
+	//the word at SDRAM address 0 is also read (ReadPointer starts at 0)
+	cout << "Chunking: " << checker.nBytes << " bytes in " << ringBuffer.nSDRAMReads << " reads (at most "
+			<< ringBuffer.maximumSDRAMReadLength << " bytes), " << ringBuffer.nWritePointerReads << " WritePointer reads, "
+			<< ringBuffer.nReadPointerUpdates << " ReadPointer updates" << endl;
+	if (checker.nBytes != nProducedBytes + 2 || ringBuffer.maximumSDRAMReadLength != chunkSize
+			|| ringBuffer.nSDRAMReads != (nProducedBytes + 2 + chunkSize - 1) / chunkSize) {
+		nErrors++;
+	}
+	//one WritePointer read in the first call (nothing known yet), and two ReadPointer updates
+	//(after 1 MB, and when caught up with WritePointer)
+	if (ringBuffer.nWritePointerReads != 1 || ringBuffer.nReadPointerUpdates != 2) {
+		nErrors++;
+	}
+
+	//wrap-around: 3 MB per step, so that one step crosses the end of SDRAM
+	size_t nWrappingCalls = 0;
+	while (ringBuffer.writerPosition < SDRAMRingBuffer::Size + 4 * 1024 * 1024) {
+		ringBuffer.produce(3 * 1024 * 1024);
+		uint64_t nLaps = ringBuffer.nReaderLaps;
+		do {
+			consumerManager.drain(data, 4 * 1024 * 1024);
+			checker.check(data);
+		} while (data.size() != 0);
+		if (ringBuffer.nReaderLaps != nLaps) {
+			nWrappingCalls++;
+		}
+	}
+	cout << "Wrap-around: " << checker.nBytes << " bytes drained, " << ringBuffer.nReaderLaps << " laps" << endl;
+	if (checker.nBytes != ringBuffer.writerPosition || ringBuffer.nReaderLaps != 1 || nWrappingCalls != 1) {
+		nErrors++;
+	}
+
+	//reconnection: initiators of the deleted RMAPEngine are not used
+	rmapHandler.disconnectSpWGbE();
+	TargetServer secondServer(portNumber + 1, &rmapTarget);
+	rmapHandler.connect(portNumber + 1, secondServer);
+	ringBuffer.produce(1024 * 1024);
+	do {
+		consumerManager.drain(data);
+		checker.check(data);
+	} while (data.size() != 0);
+	cout << "Reconnection: " << checker.nBytes << " bytes drained" << endl;
+	if (checker.nBytes != ringBuffer.writerPosition) {
+		nErrors++;
+	}
+	if (checker.nMismatches != 0) {
+		nErrors++;
+	}
+	rmapHandler.disconnectSpWGbE();
+
+	cout << nErrors << " errors" << endl;
+	return (nErrors == 0) ? 0 : 1;
+}
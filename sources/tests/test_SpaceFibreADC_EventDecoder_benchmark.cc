@@ -0,0 +1,145 @@
+/*
+ * test_SpaceFibreADC_EventDecoder_benchmark.cc
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+/* Decodes synthetic SpaceFibre ADC event data, checks the decoded events,
+ * and reports decoding speed in events/sec.
+ * Event data are passed to EventDecoder in chunks (as received from the board)
+ * so that events (and 16-bit words) spanning chunk boundaries are also tested.
+ * In batch mode, events are decoded into columnar EventBatch instances.
+ * In both modes, a phaMax spectrum is filled as an example of per-event analysis.
+ *
+ * Usage: test_SpaceFibreADC_EventDecoder_benchmark [nSamples] [chunk size in bytes] [repeat] [event|batch]
+ */
+
+#include "SpaceWireRMAPLibrary/SpaceWire.hh"
+#include "SpaceWireRMAPLibrary/RMAP.hh"
+#include "SpaceWireRMAPLibrary/Boards/SpaceFibreADC.hh"
+
+#include <chrono>
+
+void appendWord(std::vector<uint8_t>& data, uint16_t word) {
+	data.push_back(word & 0xFF);
+	data.push_back(word >> 8);
+}
+
+uint16_t sampleValue(size_t eventIndex, size_t sampleIndex) {
+	return (eventIndex * 7 + sampleIndex * 13) % 0x4000; //14-bit ADC values
+}
+
+std::vector<uint8_t> createEventData(size_t nEvents, size_t nSamples) {
+	std::vector<uint8_t> data;
+	for (size_t e = 0; e < nEvents; e++) {
+		uint64_t timeTag = 0x123456789ULL + e * 1000;
+		uint32_t triggerCount = e;
+		appendWord(data, 0xfff0);
+		appendWord(data, e % SpaceFibreADC::NumberOfChannels);
+		appendWord(data, 0); //consumerID
+		appendWord(data, sampleValue(e, 0)); //phaMax
+		appendWord(data, (timeTag >> 32) & 0xFFFF);
+		appendWord(data, (timeTag >> 16) & 0xFFFF);
+		appendWord(data, timeTag & 0xFFFF);
+		appendWord(data, triggerCount >> 16);
+		appendWord(data, triggerCount & 0xFFFF);
+		appendWord(data, 100); //baseline
+		appendWord(data, 0xfff1);
+		for (size_t i = 0; i < nSamples; i++) {
+			appendWord(data, sampleValue(e, i));
+		}
+		appendWord(data, 0xfff2);
+		appendWord(data, 0xffff);
+	}
+	return data;
+}
+
+bool checkEvent(SpaceFibreADC::Event* event, size_t eventIndex, size_t nSamples) {
+	if (event->ch != eventIndex % SpaceFibreADC::NumberOfChannels || event->nSamples != nSamples
+			|| event->triggerCount != eventIndex || event->timeTag != 0x123456789ULL + eventIndex * 1000) {
+		return false;
+	}
+	for (size_t i = 0; i < nSamples; i++) {
+		if (event->waveform[i] != sampleValue(eventIndex, i)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool checkEvent(const EventBatch& batch, size_t i, size_t eventIndex, size_t nSamples) {
+	SpaceFibreADC::Event event;
+	batch.getEvent(i, event);
+	return checkEvent(&event, eventIndex, nSamples) && batch.baseline[i] == 100
+			&& batch.waveformOffset[i + 1] - batch.waveformOffset[i] == nSamples;
+}
+
+int main(int argc, char* argv[]) {
+	using namespace std;
+	size_t nSamples = SpaceFibreADC::MaxWaveformLength;
+	size_t chunkSize = 64 * 1024 + 6; //not a multiple of the event size
+	size_t nRepeats = 20;
+	if (argc > 1) {
+		nSamples = atoi(argv[1]);
+	}
+	if (argc > 2) {
+		chunkSize = atoi(argv[2]); //an odd size splits 16-bit words between chunks
+	}
+	if (argc > 3) {
+		nRepeats = atoi(argv[3]);
+	}
+	bool batchMode = (argc > 4 && std::string(argv[4]) == "batch");
+	const size_t nEvents = 4000;
+
+	std::vector<uint8_t> data = createEventData(nEvents, nSamples);
+	EventDecoder decoder;
+	decoder.setBatchMode(batchMode);
+	std::vector<size_t> spectrum(0x10000);
+	size_t nDecodedEvents = 0;
+	size_t nErrors = 0;
+	double elapsedTimeInSec = 0;
+
+	std::vector<SpaceFibreADC::Event*> events;
+	EventBatch batch;
+	for (size_t r = 0; r < nRepeats; r++) {
+		size_t eventIndex = 0;
+		auto startTime = std::chrono::steady_clock::now();
+		for (size_t offset = 0; offset < data.size(); offset += chunkSize) {
+			size_t size = std::min(chunkSize, data.size() - offset);
+			decoder.decodeEvent(&data[offset], size);
+			if (batchMode) {
+				decoder.getDecodedEventBatch(batch);
+				const uint16_t* phaMax = batch.phaMax.data();
+				for (size_t i = 0; i < batch.size(); i++) {
+					spectrum[phaMax[i]]++;
+				}
+				for (size_t i = 0; r == 0 && i < batch.size(); i++) {
+					if (!checkEvent(batch, i, eventIndex + i, nSamples)) {
+						nErrors++;
+					}
+				}
+				eventIndex += batch.size();
+				continue;
+			}
+			decoder.getDecodedEvents(events);
+			for (size_t i = 0; i < events.size(); i++) {
+				//check only in the first round so that the check does not affect the measurement
+				if (r == 0 && !checkEvent(events[i], eventIndex, nSamples)) {
+					nErrors++;
+				}
+				spectrum[events[i]->phaMax]++;
+				eventIndex++;
+				decoder.freeEvent(events[i]);
+			}
+		}
+		elapsedTimeInSec += std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+		nDecodedEvents += eventIndex;
+	}
+
+	cout << "nSamples = " << nSamples << ", chunk size = " << chunkSize << " bytes, " << (batchMode ? "batch" : "event")
+			<< " mode" << endl;
+	cout << "Decoded " << nDecodedEvents << " events (" << nErrors << " errors)" << endl;
+	cout << "Decoding speed: " << nDecodedEvents / elapsedTimeInSec << " events/sec, "
+			<< data.size() * nRepeats / elapsedTimeInSec / 1024 / 1024 << " MB/s" << endl;
+	return (nErrors == 0 && nDecodedEvents == nEvents * nRepeats) ? 0 : 1;
+}
@@ -0,0 +1,129 @@
+/*
+ * test_SpaceFibreADC_EventRecorder_benchmark.cc
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+/* Records synthetic SpaceFibre ADC events with EventRecorder, and reports
+ * sustained recording speed in MB/s (including the time to close the file).
+ * The file is then replayed with EventFileReader, and replayed events are checked.
+ *
+ * Usage: test_SpaceFibreADC_EventRecorder_benchmark [output file] [nEvents] [nSamples] [compression (0: none, 1: delta)]
+ */
+
+#include "SpaceWireRMAPLibrary/SpaceWire.hh"
+#include "SpaceWireRMAPLibrary/RMAP.hh"
+#include "SpaceWireRMAPLibrary/Boards/SpaceFibreADC.hh"
+
+#include <chrono>
+
+uint16_t sampleValue(size_t eventIndex, size_t sampleIndex) {
+	//a pulse-like waveform with noise (14-bit ADC values)
+	size_t t = sampleIndex % 256;
+	uint16_t pulse = (t < 16) ? 0 : (uint16_t) (3000.0 * (t - 16) / (t + 40) * 64.0 / (t + 48));
+	return (uint16_t) ((100 + pulse + (eventIndex * 7 + sampleIndex * 13) % 8) & 0x3FFF);
+}
+
+void fillEvent(SpaceFibreADC::Event& event, size_t eventIndex, size_t nSamples) {
+	event.ch = eventIndex % SpaceFibreADC::NumberOfChannels;
+	event.timeTag = 0x123456789ULL + eventIndex * 1000;
+	event.triggerCount = eventIndex;
+	event.livetime = eventIndex * 3;
+	event.phaMax = sampleValue(eventIndex, 40);
+	event.nSamples = nSamples;
+	for (size_t i = 0; i < nSamples; i++) {
+		event.waveform[i] = sampleValue(eventIndex, i);
+	}
+}
+
+/** Checks a replayed event. Waveforms repeat every nPreparedEvents events,
+ * while trigger count, time tag, and livetime are unique.
+ */
+bool checkEvent(const ReplayedEvent& event, size_t eventIndex, const SpaceFibreADC::Event& preparedEvent) {
+	if (event.ch != preparedEvent.ch || event.nSamples != preparedEvent.nSamples || event.triggerCount != eventIndex
+			|| event.livetime != eventIndex * 3 || event.timeTag != 0x123456789ULL + eventIndex * 1000) {
+		return false;
+	}
+	return memcmp(event.waveform, preparedEvent.waveform, event.nSamples * sizeof(uint16_t)) == 0;
+}
+
+int main(int argc, char* argv[]) {
+	using namespace std;
+	std::string fileName = "test_SpaceFibreADC_EventRecorder_benchmark.sfadc";
+	size_t nEvents = 200000;
+	size_t nSamples = 1024;
+	uint32_t compression = EventFileFormat::Uncompressed;
+	if (argc > 1) {
+		fileName = argv[1];
+	}
+	if (argc > 2) {
+		nEvents = atoi(argv[2]);
+	}
+	if (argc > 3) {
+		nSamples = atoi(argv[3]);
+	}
+	if (argc > 4) {
+		compression = atoi(argv[4]);
+	}
+
+	//prepare events in advance so that event generation does not affect the measurement
+	const size_t nPreparedEvents = 1024;
+	std::vector<uint16_t> waveforms(nPreparedEvents * nSamples);
+	std::vector<SpaceFibreADC::Event> events(nPreparedEvents);
+	for (size_t i = 0; i < nPreparedEvents; i++) {
+		events[i].waveform = &waveforms[i * nSamples];
+		fillEvent(events[i], i, nSamples);
+	}
+
+	//record
+	EventRecorder* recorder;
+	try {
+		recorder = new EventRecorder(fileName, compression);
+	} catch (EventFileException& e) {
+		cerr << "Could not create " << fileName << " (" << e.toString() << ")" << endl;
+		return 1;
+	}
+	auto startTime = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < nEvents; i++) {
+		SpaceFibreADC::Event& event = events[i % nPreparedEvents];
+		event.triggerCount = i;
+		event.timeTag = 0x123456789ULL + i * 1000;
+		event.livetime = i * 3;
+		recorder->write(&event);
+	}
+	recorder->close();
+	double recordingTimeInSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+	size_t rawSize = nEvents * (sizeof(EventFileRecordHeader) + nSamples * sizeof(uint16_t));
+
+	cout << "Recorded " << nEvents << " events (" << nSamples << " samples, "
+			<< EventFileFormat::compressionToString(compression) << ", " << (recorder->isDirectIO() ? "O_DIRECT" : "buffered")
+			<< ") to " << fileName << endl;
+	cout << "File size: " << recorder->getNWrittenBytes() / 1024.0 / 1024.0 << " MB (event data "
+			<< rawSize / 1024.0 / 1024.0 << " MB), " << recorder->getNStalls() << " stalls" << endl;
+	cout << "Recording speed: " << nEvents / recordingTimeInSec << " events/sec, " << rawSize / recordingTimeInSec / 1024 / 1024
+			<< " MB/s of event data, " << recorder->getNWrittenBytes() / recordingTimeInSec / 1024 / 1024 << " MB/s to disk"
+			<< endl;
+	delete recorder;
+
+	//replay
+	size_t nReadEvents = 0;
+	size_t nErrors = 0;
+	startTime = std::chrono::steady_clock::now();
+	try {
+		EventFileReader reader(fileName);
+		ReplayedEvent event;
+		while (reader.next(event)) {
+			if (!checkEvent(event, nReadEvents, events[nReadEvents % nPreparedEvents])) {
+				nErrors++;
+			}
+			nReadEvents++;
+		}
+	} catch (EventFileException& e) {
+		cerr << "Could not replay " << fileName << " (" << e.toString() << ")" << endl;
+		return 1;
+	}
+	double replayTimeInSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+	cout << "Replayed " << nReadEvents << " events (" << nErrors << " errors): " << nReadEvents / replayTimeInSec
+			<< " events/sec, " << rawSize / replayTimeInSec / 1024 / 1024 << " MB/s of event data" << endl;
+	return (nErrors == 0 && nReadEvents == nEvents) ? 0 : 1;
+}
@@ -0,0 +1,131 @@
+/*
+ * test_SpaceFibreADC_OnlineHistogram_benchmark.cc
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+/* Fills synthetic events to an OnlineHistogram from several threads while another thread
+ * keeps taking snapshots, and reports filling speed in events/sec per thread.
+ * The merged snapshot is checked against the number of filled events, saved to a file
+ * and loaded again. Filler reuse by EventDecoder::setOnlineHistogram() is also checked.
+ *
+ * Usage: test_SpaceFibreADC_OnlineHistogram_benchmark [nThreads] [nEvents per thread]
+ */
+
+#include "SpaceWireRMAPLibrary/SpaceWire.hh"
+#include "SpaceWireRMAPLibrary/RMAP.hh"
+#include "SpaceWireRMAPLibrary/Boards/SpaceFibreADC.hh"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+int main(int argc, char* argv[]) {
+	using namespace std;
+	size_t nThreads = 1;
+	size_t nEvents = 20000000;
+	if (argc > 1) {
+		nThreads = atoi(argv[1]);
+	}
+	if (argc > 2) {
+		nEvents = atoi(argv[2]);
+	}
+	const size_t nPHABins = 4096;
+	const size_t nTimeBins = 100;
+	const double timeBinWidthInSec = 0.001;
+	const double timeTagClockFrequency = 50e6;
+	const uint64_t timeTagsPerTimeBin = 50000;
+	const uint64_t firstTimeTag = 1000;
+	OnlineHistogram histogram(nPHABins, nTimeBins, timeBinWidthInSec, timeTagClockFrequency);
+	size_t nErrors = 0;
+
+	//fill from nThreads threads while taking snapshots
+	std::atomic<bool> isFilling(true);
+	size_t nSnapshots = 0;
+	std::thread snapshotThread([&]() {
+		while (isFilling) {
+			histogram.getSnapshot();
+			nSnapshots++;
+		}
+	});
+	std::vector<double> elapsedTimeInSec(nThreads);
+	std::vector<std::thread> fillerThreads;
+	for (size_t t = 0; t < nThreads; t++) {
+		fillerThreads.push_back(std::thread([&, t]() {
+			OnlineHistogram::Filler* filler = histogram.createFiller();
+			auto startTime = std::chrono::steady_clock::now();
+			for (size_t i = 0; i < nEvents; i++) {
+				//events span all time bins; some of them overflow the phaMax range
+				uint64_t timeTag = firstTimeTag + i * timeTagsPerTimeBin * nTimeBins / nEvents;
+				filler->fill(i % SpaceFibreADC::NumberOfChannels, timeTag, (i * 7) % 5000);
+			}
+			elapsedTimeInSec[t] = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+			histogram.releaseFiller(filler);
+		}));
+	}
+	for (size_t t = 0; t < nThreads; t++) {
+		fillerThreads[t].join();
+	}
+	isFilling = false;
+	snapshotThread.join();
+
+	//check the merged snapshot
+	OnlineHistogramSnapshot snapshot = histogram.getSnapshot();
+	uint64_t nFilledEvents = 0, nSpectrumEvents = 0, nTimeSeriesEvents = 0;
+	for (size_t ch = 0; ch < SpaceFibreADC::NumberOfChannels; ch++) {
+		nFilledEvents += snapshot.nEvents[ch];
+		nSpectrumEvents += snapshot.nOverflowEvents[ch];
+		nTimeSeriesEvents += snapshot.nOutOfTimeRangeEvents[ch];
+		for (size_t i = 0; i < nPHABins; i++) {
+			nSpectrumEvents += snapshot.getSpectrum(ch)[i];
+		}
+		for (size_t i = 0; i < nTimeBins; i++) {
+			nTimeSeriesEvents += snapshot.eventCounts[ch * nTimeBins + i];
+		}
+	}
+	if (nFilledEvents != nThreads * nEvents || nSpectrumEvents != nFilledEvents || nTimeSeriesEvents != nFilledEvents
+			|| snapshot.firstTimeTag != firstTimeTag || snapshot.getNFilledTimeBins() != nTimeBins) {
+		cerr << "Snapshot does not match filled events" << endl;
+		nErrors++;
+	}
+
+	//save and load
+	std::string fileName = "test_SpaceFibreADC_OnlineHistogram_benchmark.hist";
+	snapshot.save(fileName);
+	OnlineHistogramSnapshot loadedSnapshot;
+	loadedSnapshot.load(fileName);
+	if (loadedSnapshot.nEvents != snapshot.nEvents || loadedSnapshot.spectra != snapshot.spectra
+			|| loadedSnapshot.eventCounts != snapshot.eventCounts || loadedSnapshot.firstTimeTag != snapshot.firstTimeTag) {
+		cerr << "Loaded snapshot does not match the saved one" << endl;
+		nErrors++;
+	}
+	remove(fileName.c_str());
+
+	//a decoder reuses its filler, and a released filler is reused by the next decoder
+	histogram.reset();
+	OnlineHistogram::Filler* releasedFiller = histogram.createFiller();
+	histogram.releaseFiller(releasedFiller);
+	EventDecoder decoder;
+	for (size_t i = 0; i < 1000; i++) {
+		decoder.setOnlineHistogram(&histogram);
+	}
+	decoder.setOnlineHistogram(NULL);
+	OnlineHistogram::Filler* filler = histogram.createFiller();
+	if (filler != releasedFiller) {
+		cerr << "Released filler was not reused" << endl;
+		nErrors++;
+	}
+	filler->fill(1, 5, 10);
+	snapshot = histogram.getSnapshot();
+	if (snapshot.nEvents[1] != 1 || snapshot.nEvents[0] != 0 || snapshot.firstTimeTag != 5) {
+		cerr << "Snapshot after reset() is wrong" << endl;
+		nErrors++;
+	}
+
+	double maxElapsedTimeInSec = *std::max_element(elapsedTimeInSec.begin(), elapsedTimeInSec.end());
+	cout << nThreads << " threads, " << nEvents << " events per thread, " << nSnapshots << " concurrent snapshots"
+			<< endl;
+	cout << "Filled " << nFilledEvents << " events (" << nErrors << " errors)" << endl;
+	cout << "Filling speed: " << nEvents / maxElapsedTimeInSec << " events/sec per thread" << endl;
+	return (nErrors == 0) ? 0 : 1;
+}
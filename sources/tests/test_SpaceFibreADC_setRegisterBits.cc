@@ -0,0 +1,208 @@
+/*
+ * test_SpaceFibreADC_setRegisterBits.cc
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+/* Tests the RMAP read-modify-write path of RMAPHandler/ChannelManager/SemaphoreRegister
+ * against emulated SpaceFibre ADC registers served over SpaceWire-to-GigabitEther on localhost.
+ * - RMW is not used unless enabled with RMAPHandler::setUseReadModifyWrite().
+ * - A target which supports RMW: StartStopRegister bits are modified with RMW, without the semaphore.
+ *   Semaphore test-and-set (SemaphoreRegister::setUseTestAndSet()) is also tested.
+ * - A target which rejects RMW: RMW is disabled after the first attempt, and the register is
+ *   read and written while holding the semaphore.
+ *
+ * Usage: test_SpaceFibreADC_setRegisterBits [TCP port number]
+ */
+
+#include "SpaceWireRMAPLibrary/SpaceWire.hh"
+#include "SpaceWireRMAPLibrary/RMAP.hh"
+#include "SpaceWireRMAPLibrary/Boards/SpaceFibreADC.hh"
+
+#include <thread>
+
+/** Counts writes (including RMWs) to the semaphore register. */
+class SemaphoreAccessCounter: public RMAPMemoryTargetHook {
+public:
+	size_t nWrites = 0;
+
+public:
+	uint8_t willWrite(RMAPMemoryTarget* target, uint32_t address, uint32_t length) {
+		if (address == ChannelManager::AddressOf_StartStopSemaphoreRegister) {
+			nWrites++;
+		}
+		return RMAPReplyStatus::CommandExcecutedSuccessfully;
+	}
+};
+
+/** Emulates registers of a target which does not support RMW. */
+class RegistersWithoutRMW: public RMAPTargetAccessAction {
+public:
+	std::vector<uint8_t> memory;
+	size_t nSemaphoreWrites = 0;
+
+public:
+	RegistersWithoutRMW() :
+			memory(0x100, 0) {
+	}
+
+public:
+	void processTransaction(RMAPTransaction* rmapTransaction) throw (RMAPTargetAccessActionException) {
+		RMAPPacket* commandPacket = rmapTransaction->commandPacket;
+		uint8_t* p = &memory[commandPacket->getAddress() - ChannelManager::ChMgrBA];
+		if (commandPacket->isRead()) {
+			std::vector<uint8_t> data(p, p + commandPacket->getLength());
+			setReplyWithDataWithStatus(rmapTransaction, &data, RMAPReplyStatus::CommandExcecutedSuccessfully);
+			return;
+		}
+		if (commandPacket->getAddress() == ChannelManager::AddressOf_StartStopSemaphoreRegister) {
+			nSemaphoreWrites++;
+		}
+		std::vector<uint8_t>* data = commandPacket->getDataBuffer();
+		std::copy(data->begin(), data->end(), p);
+		setReplyWithStatus(rmapTransaction, RMAPReplyStatus::CommandExcecutedSuccessfully);
+	}
+};
+
+/** Serves a target over SpaceWireIFOverTCP (server mode). */
+class TargetServer {
+public:
+	SpaceWireIFOverTCP* spwif;
+	RMAPEngine* rmapEngine;
+	std::thread thread;
+
+public:
+	TargetServer(uint32_t portNumber, RMAPTarget* target) {
+		spwif = new SpaceWireIFOverTCP(portNumber);
+		rmapEngine = NULL;
+		thread = std::thread([this, target]() {
+			spwif->open();
+			rmapEngine = new RMAPEngine(spwif);
+			rmapEngine->addRMAPTarget(target);
+			rmapEngine->start();
+		});
+	}
+
+public:
+	void waitForStart() {
+		thread.join();
+		while (!rmapEngine->isStarted()) {
+			CxxUtilities::Condition c;
+			c.wait(10);
+		}
+	}
+};
+
+uint16_t getValue(const uint8_t* p) {
+	return p[0] * 0x100 + p[1];
+}
+
+RMAPHandler* connect(uint32_t portNumber, RMAPTargetNode* adcRMAPTargetNode, TargetServer& server) {
+	CxxUtilities::Condition c;
+	c.wait(100);
+	RMAPHandler* rmapHandler = new RMAPHandler("127.0.0.1", portNumber, { adcRMAPTargetNode });
+	if (!rmapHandler->connectoToSpaceWireToGigabitEther()) {
+		std::cerr << "Could not connect to the target" << std::endl;
+		exit(1);
+	}
+	server.waitForStart();
+	if (rmapHandler->isReadModifyWriteUsed()) {
+		std::cerr << "RMW is used by default" << std::endl;
+		exit(1);
+	}
+	rmapHandler->setUseReadModifyWrite(true);
+	return rmapHandler;
+}
+
+int main(int argc, char* argv[]) {
+	using namespace std;
+	uint32_t portNumber = 10130;
+	if (argc > 1) {
+		portNumber = atoi(argv[1]);
+	}
+	RMAPTargetNode* adcRMAPTargetNode = new RMAPTargetNode();
+	adcRMAPTargetNode->setID("ADCBox");
+	adcRMAPTargetNode->setTargetLogicalAddress(0xFE);
+	adcRMAPTargetNode->setDefaultKey(0x00);
+	adcRMAPTargetNode->setInitiatorLogicalAddress(0xFE);
+	size_t nErrors = 0;
+
+	//target which supports RMW
+	RMAPMemoryTarget memoryTarget(ChannelManager::ChMgrBA, 0x100);
+	SemaphoreAccessCounter semaphoreAccessCounter;
+	memoryTarget.setHook(ChannelManager::AddressOf_StartStopSemaphoreRegister, 2, &semaphoreAccessCounter);
+	TargetServer server(portNumber, &memoryTarget);
+	RMAPHandler* rmapHandler = connect(portNumber, adcRMAPTargetNode, server);
+	ChannelManager channelManager(rmapHandler, adcRMAPTargetNode);
+	channelManager.startAcquisitionOfChannel(0);
+	channelManager.startAcquisitionOfChannel(2);
+	channelManager.stopAcquisitionOfChannel(0);
+	uint16_t value = getValue(memoryTarget.getPointer(ChannelManager::AddressOf_StartStopRegister));
+	cout << "RMW target: StartStopRegister = 0x" << hex << value << dec << ", semaphore writes = "
+			<< semaphoreAccessCounter.nWrites << ", RMW used = " << rmapHandler->isReadModifyWriteUsed() << endl;
+	if (value != 0x0004 || semaphoreAccessCounter.nWrites != 0 || !rmapHandler->isReadModifyWriteUsed()) {
+		nErrors++;
+	}
+	uint16_t previousValue = rmapHandler->setRegisterBits(ChannelManager::AddressOf_StartStopRegister, 0xFF00, 0x0F0F);
+	value = getValue(memoryTarget.getPointer(ChannelManager::AddressOf_StartStopRegister));
+	if (previousValue != 0x0004 || value != 0x0F00) {
+		cout << "setRegisterBits(): previous value = 0x" << hex << previousValue << ", value = 0x" << value << dec
+				<< endl;
+		nErrors++;
+	}
+
+	//invalid RMW length is rejected before a command is sent
+	uint8_t data[5] = { 0 }, mask[5] = { 0 }, readData[5];
+	for (uint32_t length : { 0, 5 }) {
+		try {
+			rmapHandler->getRMAPInitiator()->readModifyWrite(adcRMAPTargetNode, ChannelManager::AddressOf_StartStopRegister,
+					data, mask, length, readData);
+			cout << "RMW of " << length << " bytes was not rejected" << endl;
+			nErrors++;
+		} catch (RMAPInitiatorException& e) {
+			if (e.getStatus() != RMAPInitiatorException::InvalidReadModifyWriteLength) {
+				nErrors++;
+			}
+		}
+	}
+
+	//semaphore test-and-set
+	SemaphoreRegister semaphore(rmapHandler, adcRMAPTargetNode, ChannelManager::AddressOf_StartStopSemaphoreRegister);
+	semaphore.setUseTestAndSet(true);
+	bool obtained = semaphore.tryRequest();
+	bool obtainedTwice = semaphore.tryRequest();
+	semaphore.release();
+	value = getValue(memoryTarget.getPointer(ChannelManager::AddressOf_StartStopSemaphoreRegister));
+	cout << "RMW target: test-and-set obtained = " << obtained << ", obtained while held = " << obtainedTwice
+			<< ", semaphore writes = " << semaphoreAccessCounter.nWrites << endl;
+	if (!obtained || obtainedTwice || value != 0x0000 || semaphoreAccessCounter.nWrites != 3
+			|| !semaphore.isTestAndSetUsed()) {
+		nErrors++;
+	}
+	rmapHandler->disconnectSpWGbE();
+
+	//target which rejects RMW
+	RegistersWithoutRMW registersWithoutRMW;
+	RMAPTarget targetWithoutRMW;
+	targetWithoutRMW.addAddressRangeAndAssociatedAction(
+			new RMAPAddressRange(ChannelManager::ChMgrBA, ChannelManager::ChMgrBA + 0xff), &registersWithoutRMW);
+	TargetServer serverWithoutRMW(portNumber + 1, &targetWithoutRMW);
+	RMAPHandler* rmapHandlerWithoutRMW = connect(portNumber + 1, adcRMAPTargetNode, serverWithoutRMW);
+	ChannelManager channelManagerWithoutRMW(rmapHandlerWithoutRMW, adcRMAPTargetNode);
+	channelManagerWithoutRMW.startAcquisitionOfChannel(1);
+	channelManagerWithoutRMW.startAcquisitionOfChannel(3);
+	channelManagerWithoutRMW.stopAcquisitionOfChannel(1);
+	uint8_t* p = &registersWithoutRMW.memory[ChannelManager::AddressOf_StartStopRegister - ChannelManager::ChMgrBA];
+	value = getValue(p);
+	cout << "Non-RMW target: StartStopRegister = 0x" << hex << value << dec << ", semaphore writes = "
+			<< registersWithoutRMW.nSemaphoreWrites << ", RMW used = " << rmapHandlerWithoutRMW->isReadModifyWriteUsed()
+			<< endl;
+	//each of the three updates requests and releases the semaphore (one write each)
+	if (value != 0x0008 || registersWithoutRMW.nSemaphoreWrites != 6 || rmapHandlerWithoutRMW->isReadModifyWriteUsed()) {
+		nErrors++;
+	}
+	rmapHandlerWithoutRMW->disconnectSpWGbE();
+
+	cout << nErrors << " errors" << endl;
+	return (nErrors == 0) ? 0 : 1;
+}
@@ -1,6 +1,11 @@
 #include "SpaceWireR/SpaceWireRPacket.hh"
 int main(int argc, char* argv[]){
+using namespace std;
 SpaceWireRPacket packet;
+packet.setDestinationLogicalAddress(0xFE);
+packet.setChannelNumber(0x0102);
+packet.setSequenceNumber(3);
+packet.setCompleteSegmentFlag();
 
 std::vector<uint8_t> payload;
 for(size_t i=0;i<10;i++){
@@ -8,6 +13,23 @@ for(size_t i=0;i<10;i++){
 }
 
 packet.setPayload(payload);
-SpaceWireUtilities::dumpPacket(packet.getPacketAsVectorPointer());
+std::vector<uint8_t>* copiedPacket=packet.getPacketBufferPointer();
+SpaceWireUtilities::dumpPacket(copiedPacket);
 
+//encode the same payload without copying it
+packet.setPayloadReference(&(payload[0]), payload.size());
+struct iovec iovecs[SpaceWireRPacket::NumberOfIOVectors];
+size_t nIOVecs=packet.encodeToIOVectors(iovecs);
+std::vector<uint8_t> gatheredPacket;
+for(size_t i=0;i<nIOVecs;i++){
+ gatheredPacket.insert(gatheredPacket.end(), (uint8_t*)iovecs[i].iov_base, (uint8_t*)iovecs[i].iov_base+iovecs[i].iov_len);
+}
+SpaceWireUtilities::dumpPacket(&gatheredPacket);
+cout << ((*copiedPacket==gatheredPacket)? "the same" : "different") << endl;
+
+//interpret
+SpaceWireRPacket packet2;
+packet2.interpretPacket(&gatheredPacket);
+cout << ((*packet2.getPayload()==payload)? "payload OK" : "payload NG") << endl;
+delete copiedPacket;
 }
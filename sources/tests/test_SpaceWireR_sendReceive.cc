@@ -178,18 +178,19 @@ public:
 			tep->enableFlowControl();
 		}
 
+		//setting (proposed to ReceiveTEP in the Open command)
+		tep->setSegmentSize(SegmentSize);
+		tep->setSlidingWindowSize(SlidingWindowSize);
+
 		tep->open();
-		cout << "SpaceWireRTransmitTEP opened." << endl;
+		cout << "SpaceWireRTransmitTEP opened (slidingWindowSize=" << (uint32_t) tep->getSlidingWindowSize()
+				<< " segmentSize=" << tep->getSegmentSize() << ")." << endl;
 
 		std::vector<uint8_t> data;
 		for (size_t i = 0; i < SendSize; i++) {
 			data.push_back(i);
 		}
 
-		//setting
-		tep->setSegmentSize(SegmentSize);
-		tep->setSlidingWindowSize(SlidingWindowSize);
-
 		sendloop: try {
 			while (!stopped) {
 				if (waitDurationBetweenEverySend != 0) {
@@ -0,0 +1,248 @@
+/*
+ * test_SpaceWireR_throughputVsRTT.cc
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+/* Measures SpaceWire-R throughput as a function of round-trip time (RTT)
+ * for several sliding window/segment size settings.
+ * TransmitTEP and ReceiveTEP are connected via an in-memory link which
+ * delays every packet by RTT/2, and the window/segment sizes are negotiated
+ * in the Open command.
+ *
+ * Usage: test_SpaceWireR_throughputVsRTT [measurement duration per point in ms]
+ */
+
+#include "SpaceWireR.hh"
+#include "CxxUtilities/CxxUtilities.hh"
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+/** In-memory SpaceWire link with a fixed one-way delay.
+ * Packets sent via send() are delivered to the peer instance after the delay.
+ */
+class DelayedLoopbackSpaceWireIF: public SpaceWireIF {
+private:
+	typedef std::chrono::steady_clock Clock;
+
+private:
+	DelayedLoopbackSpaceWireIF* peer;
+	std::deque<std::pair<Clock::time_point, std::vector<uint8_t>*> > queue;
+	std::mutex queueMutex;
+	std::condition_variable queueCondition;
+	std::chrono::microseconds delay;
+	std::chrono::microseconds timeoutDuration;
+
+public:
+	DelayedLoopbackSpaceWireIF(double delayInMilliSec) :
+			peer(NULL), delay((long) (delayInMilliSec * 1000)), timeoutDuration(1000000) {
+	}
+
+public:
+	~DelayedLoopbackSpaceWireIF() {
+		while (queue.size() != 0) {
+			delete queue.front().second;
+			queue.pop_front();
+		}
+	}
+
+public:
+	void connect(DelayedLoopbackSpaceWireIF* peer) {
+		this->peer = peer;
+	}
+
+public:
+	void open() throw (SpaceWireIFException) {
+		state = Opened;
+	}
+
+public:
+	void send(uint8_t* data, size_t length, SpaceWireEOPMarker::EOPType eopType = SpaceWireEOPMarker::EOP)
+			throw (SpaceWireIFException) {
+		std::vector<uint8_t>* packet = new std::vector<uint8_t>(data, data + length);
+		std::lock_guard<std::mutex> lock(peer->queueMutex);
+		peer->queue.push_back(std::make_pair(Clock::now() + delay, packet));
+		peer->queueCondition.notify_one();
+	}
+
+public:
+	void receive(std::vector<uint8_t>* buffer) throw (SpaceWireIFException) {
+		std::unique_lock<std::mutex> lock(queueMutex);
+		if (!queueCondition.wait_for(lock, timeoutDuration, [this] {return queue.size()!=0;})) {
+			throw SpaceWireIFException(SpaceWireIFException::Timeout);
+		}
+		Clock::time_point deliveryTime = queue.front().first;
+		std::vector<uint8_t>* packet = queue.front().second;
+		queue.pop_front();
+		lock.unlock();
+		std::this_thread::sleep_until(deliveryTime);
+		buffer->swap(*packet);
+		delete packet;
+	}
+
+public:
+	void emitTimecode(uint8_t timeIn, uint8_t controlFlagIn = 0x00) throw (SpaceWireIFException) {
+	}
+
+public:
+	void setTxLinkRate(uint32_t linkRateType) throw (SpaceWireIFException) {
+	}
+
+public:
+	uint32_t getTxLinkRateType() throw (SpaceWireIFException) {
+		return 0;
+	}
+
+public:
+	void setTimeoutDuration(double microsecond) throw (SpaceWireIFException) {
+		timeoutDuration = std::chrono::microseconds((long) microsecond);
+	}
+
+public:
+	void cancelReceive() {
+	}
+};
+
+class ReceiveTEPOpener: public CxxUtilities::StoppableThread {
+private:
+	SpaceWireRReceiveTEP* tep;
+
+public:
+	ReceiveTEPOpener(SpaceWireRReceiveTEP* tep) {
+		this->tep = tep;
+	}
+
+public:
+	void run() {
+		tep->open();
+	}
+};
+
+class Receiver: public CxxUtilities::StoppableThread {
+private:
+	SpaceWireRReceiveTEP* tep;
+
+public:
+	size_t nReceivedBytes;
+
+public:
+	Receiver(SpaceWireRReceiveTEP* tep) {
+		this->tep = tep;
+		nReceivedBytes = 0;
+	}
+
+public:
+	void run() {
+		while (!stopped) {
+			try {
+				std::vector<uint8_t>* data = tep->receive(100);
+				nReceivedBytes += data->size();
+				delete data;
+			} catch (SpaceWireRTEPException& e) {
+			}
+		}
+	}
+};
+
+/** Returns throughput in MB/s.
+ */
+double measureThroughput(double rttInMilliSec, size_t windowSize, size_t segmentSize, uint16_t channel,
+		double durationInMilliSec) {
+	using namespace std;
+	const size_t SendSize = 256 * 1024;
+	const uint8_t LogicalAddress = 0xFE;
+	std::vector<uint8_t> noPathAddress;
+
+	//instances are not deleted because TEP/engine threads may still refer to them
+	DelayedLoopbackSpaceWireIF* transmitSide = new DelayedLoopbackSpaceWireIF(rttInMilliSec / 2);
+	DelayedLoopbackSpaceWireIF* receiveSide = new DelayedLoopbackSpaceWireIF(rttInMilliSec / 2);
+	transmitSide->connect(receiveSide);
+	receiveSide->connect(transmitSide);
+	transmitSide->open();
+	receiveSide->open();
+	SpaceWireREngine* transmitEngine = new SpaceWireREngine(transmitSide);
+	SpaceWireREngine* receiveEngine = new SpaceWireREngine(receiveSide);
+	transmitEngine->start();
+	receiveEngine->start();
+
+	SpaceWireRReceiveTEP* receiveTEP = new SpaceWireRReceiveTEP(receiveEngine, channel);
+	SpaceWireRTransmitTEP* transmitTEP = new SpaceWireRTransmitTEP(transmitEngine, channel, LogicalAddress,
+			noPathAddress, LogicalAddress, noPathAddress);
+	receiveTEP->disableFlowControl();
+	transmitTEP->disableFlowControl();
+	transmitTEP->setSlidingWindowSize(windowSize);
+	transmitTEP->setSegmentSize(segmentSize);
+
+	ReceiveTEPOpener opener(receiveTEP);
+	opener.start();
+	transmitTEP->open();
+	opener.waitUntilRunMethodComplets();
+
+	Receiver* receiver = new Receiver(receiveTEP);
+	receiver->start();
+
+	std::vector<uint8_t> data(SendSize);
+	for (size_t i = 0; i < SendSize; i++) {
+		data[i] = (uint8_t) i;
+	}
+	double startTime = CxxUtilities::Time::getClockValueInMilliSec();
+	double elapsedTime = 0;
+	while (elapsedTime < durationInMilliSec) {
+		transmitTEP->send(&data, 60000);
+		elapsedTime = CxxUtilities::Time::getClockValueInMilliSec() - startTime;
+	}
+	double throughput = transmitTEP->nSentUserDataInBytes / 1024.0 / 1024.0 / (elapsedTime / 1000.0);
+
+	receiver->stop();
+	receiver->waitUntilRunMethodComplets();
+	if (receiver->nReceivedBytes != transmitTEP->nSentUserDataInBytes) {
+		cerr << "Received " << receiver->nReceivedBytes << " bytes while " << transmitTEP->nSentUserDataInBytes
+				<< " bytes were sent." << endl;
+	}
+	transmitTEP->close();
+	return throughput;
+}
+
+int main(int argc, char* argv[]) {
+	using namespace std;
+	double durationInMilliSec = 1000;
+	if (argc > 1) {
+		durationInMilliSec = atof(argv[1]);
+	}
+
+	const double rtts[] = { 0.2, 1, 2, 5 }; //ms
+	const size_t settings[][2] = { //window size, segment size
+			{ 8, 256 }, { 32, 1024 }, { 64, 4096 }, { 128, 16384 } };
+	const size_t nRTTs = sizeof(rtts) / sizeof(rtts[0]);
+	const size_t nSettings = sizeof(settings) / sizeof(settings[0]);
+
+	cout << "Throughput (MB/s) vs RTT" << endl;
+	cout << setw(18) << "window x segment";
+	for (size_t i = 0; i < nRTTs; i++) {
+		cout << setw(10) << rtts[i] << "ms";
+	}
+	cout << endl;
+
+	uint16_t channel = 0x100;
+	for (size_t s = 0; s < nSettings; s++) {
+		stringstream ss;
+		ss << settings[s][0] << " x " << settings[s][1];
+		cout << setw(18) << ss.str();
+		for (size_t i = 0; i < nRTTs; i++) {
+			try {
+				double throughput = measureThroughput(rtts[i], settings[s][0], settings[s][1], channel++,
+						durationInMilliSec);
+				cout << setw(12) << setprecision(4) << throughput << flush;
+			} catch (SpaceWireRTEPException& e) {
+				cout << setw(12) << "error" << flush;
+				cerr << e.toString() << endl;
+			}
+		}
+		cout << endl;
+	}
+	_exit(0);
+}